@@ -0,0 +1,24 @@
+#pragma once
+
+#include "../Source/Primitives.hpp"
+
+// std
+#include <cmath>
+
+namespace DaisyEngine
+{
+	// The plane primitive with quadsPerSide * quadsPerSide quads raised in waves of the given amplitude, colored by its
+	// position on the plane. The rows stay in order, quadsPerSide * 6 indices each
+	inline Model::Builder CreateBenchmarkHeightField(uint32_t quadsPerSide, float amplitude)
+	{
+		Model::Builder builder = CreatePlane(quadsPerSide);
+		for (Model::Vertex& vertex : builder.vertices)
+		{
+			float u = vertex.position.x + 0.5f;
+			float v = vertex.position.z + 0.5f;
+			vertex.position.y = amplitude * std::sin(u * 20.0f) * std::cos(v * 20.0f);
+			vertex.color = { u, v, 0.5f };
+		}
+		return builder;
+	}
+} // namespace DaisyEngine
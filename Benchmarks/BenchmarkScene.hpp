@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../Source/Components.hpp"
+#include "../Source/FrameInfo.hpp"
+#include "../Source/Renderer.hpp"
+#include "../Source/Window.hpp"
+#include "../Source/World.hpp"
+
+// std
+#include <chrono>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The BenchmarkSceneBounds struct is the part of clip space the entities of CreateBenchmarkEntities are spread over.
+	/// Bounds past [-1, 1] or [0, 1] leave part of the objects outside of the frustum, to be culled.
+	/// </summary>
+	struct BenchmarkSceneBounds
+	{
+		float halfExtent = 1.0f; // Along x and y
+		float minDepth = 0.1f;
+		float maxDepth = 0.9f;
+	};
+
+	/// <summary>
+	/// The BenchmarkFrameOptions struct describes how MeasureFrames records its frames.
+	/// </summary>
+	struct BenchmarkFrameOptions
+	{
+		int warmupFrames = 10;
+		int measuredFrames = 100;
+		bool pollEvents = true; // Only with a window
+
+		// Passed on in the FrameInfo
+		JobSystem* jobSystem = nullptr;
+		ParallelCommandRecorder* commandRecorder = nullptr;
+		// VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS when inPass records secondary command buffers
+		VkSubpassContents subpassContents = VK_SUBPASS_CONTENTS_INLINE;
+	};
+
+	// Small objects with random positions, the same for every run since the seed is fixed. The models are used in turn
+	inline void CreateBenchmarkEntities(World& world, const std::vector<Model*>& models, size_t count, const BenchmarkSceneBounds& bounds = {})
+	{
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<float> position(-bounds.halfExtent, bounds.halfExtent);
+		std::uniform_real_distribution<float> depth(bounds.minDepth, bounds.maxDepth);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			Entity entity = world.CreateEntity();
+			Transform transform{};
+			transform.translation = { position(rng), position(rng), depth(rng) };
+			transform.scale = { 0.02f, 0.02f, 0.02f };
+			world.AddComponent(entity, transform);
+			world.AddComponent(entity, RenderComponent{ models[i % models.size()], {} });
+		}
+	}
+
+	// Runs the frames and returns the average time spent in the recording functions, in microseconds. beforePass is
+	// recorded outside of the swap chain render pass and may be empty, inPass inside of it
+	inline double MeasureFrames(Renderer& renderer, const BenchmarkFrameOptions& options,
+		const std::function<void(FrameInfo&)>& beforePass, const std::function<void(FrameInfo&)>& inPass)
+	{
+		double totalMicroseconds = 0.0;
+		int frame = 0;
+
+		while (frame < options.warmupFrames + options.measuredFrames)
+		{
+			if (options.pollEvents)
+			{
+				glfwPollEvents();
+			}
+
+			VkCommandBuffer commandBuffer = renderer.BeginFrame();
+			if (commandBuffer == nullptr)
+			{
+				continue;
+			}
+
+			FrameInfo frameInfo{ renderer.GetFrameIndex(), commandBuffer };
+			frameInfo.renderPass = renderer.GetSwapChainRenderPass();
+			frameInfo.framebuffer = renderer.GetCurrentFramebuffer();
+			frameInfo.extent = renderer.GetSwapChainExtent();
+			frameInfo.commandRecorder = options.commandRecorder;
+			frameInfo.jobSystem = options.jobSystem;
+
+			double microseconds = 0.0;
+			if (beforePass)
+			{
+				auto start = std::chrono::high_resolution_clock::now();
+				beforePass(frameInfo);
+				auto end = std::chrono::high_resolution_clock::now();
+				microseconds += std::chrono::duration<double, std::micro>(end - start).count();
+			}
+
+			renderer.BeginSwapChainRenderPass(commandBuffer, options.subpassContents);
+			auto start = std::chrono::high_resolution_clock::now();
+			inPass(frameInfo);
+			auto end = std::chrono::high_resolution_clock::now();
+			microseconds += std::chrono::duration<double, std::micro>(end - start).count();
+			renderer.EndSwapChainRenderPass(commandBuffer);
+			renderer.EndFrame();
+
+			if (frame++ >= options.warmupFrames)
+			{
+				totalMicroseconds += microseconds;
+			}
+		}
+
+		return totalMicroseconds / options.measuredFrames;
+	}
+} // namespace DaisyEngine
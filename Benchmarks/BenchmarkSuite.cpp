@@ -0,0 +1,443 @@
+// Runs a reproducible stress scene headless for a fixed number of frames and reports p50/p95/p99 of the CPU frame time,
+// the recording time and the GPU frame time as JSON. With --baseline, the run is compared to a previous report and the
+// program exits with 1 if any percentile regressed by more than the tolerance, so it can gate CI.
+// The spheres scene draws one dense sphere with a LOD chain at scales spread over two orders of magnitude. With --lod, the
+// level of each object is selected every frame; the triangles submitted per frame are reported with and without LODs.
+//
+// Usage: BenchmarkSuite [--scene cubes|unique-models|pipelines|spheres] [--count N] [--pipelines N] [--frames N] [--warmup N]
+//                       [--mode per-object|instanced|parallel] [--lod] [--output report.json] [--baseline baseline.json]
+//                       [--tolerance 0.1]
+
+#include "../Source/Application.hpp"
+#include "../Source/Device.hpp"
+#include "../Source/JobSystem.hpp"
+#include "../Source/LodSelector.hpp"
+#include "../Source/MeshSimplifier.hpp"
+#include "../Source/Primitives.hpp"
+#include "../Source/Renderer.hpp"
+#include "../Source/SimpleRenderSystem.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace DaisyEngine;
+
+namespace
+{
+	constexpr VkExtent2D EXTENT = { 1280, 720 };
+	constexpr uint32_t SPHERE_SEGMENTS = 128; // 16128 triangles at full detail
+	constexpr float MIN_SPHERE_SCALE = 0.01f;
+	constexpr float MAX_SPHERE_SCALE = 0.5f;
+
+	struct Options
+	{
+		std::string scene = "cubes";
+		size_t objectCount = 10000;
+		size_t pipelineCount = 16;
+		int frames = 500;
+		int warmupFrames = 50;
+		std::string mode = "instanced";
+		bool lod = false;
+		std::string outputPath;
+		std::string baselinePath;
+		double tolerance = 0.10;
+	};
+
+	struct Percentiles
+	{
+		double p50 = 0.0;
+		double p95 = 0.0;
+		double p99 = 0.0;
+		double mean = 0.0;
+		size_t samples = 0;
+	};
+
+	// Nearest rank percentiles
+	Percentiles ComputePercentiles(std::vector<double> samples)
+	{
+		Percentiles result{};
+		result.samples = samples.size();
+		if (samples.empty())
+		{
+			return result;
+		}
+
+		std::sort(samples.begin(), samples.end());
+		auto rank = [&](double percentile)
+		{
+			size_t index = static_cast<size_t>(std::ceil(percentile * samples.size())) - 1;
+			return samples[std::min(index, samples.size() - 1)];
+		};
+
+		result.p50 = rank(0.50);
+		result.p95 = rank(0.95);
+		result.p99 = rank(0.99);
+
+		double sum = 0.0;
+		for (double sample : samples)
+		{
+			sum += sample;
+		}
+		result.mean = sum / samples.size();
+
+		return result;
+	}
+
+	bool ParseOptions(int argc, char** argv, Options& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const bool hasValue = i + 1 < argc;
+			if (strcmp(argv[i], "--scene") == 0 && hasValue) options.scene = argv[++i];
+			else if (strcmp(argv[i], "--count") == 0 && hasValue) options.objectCount = std::stoul(argv[++i]);
+			else if (strcmp(argv[i], "--pipelines") == 0 && hasValue) options.pipelineCount = std::max<size_t>(1, std::stoul(argv[++i]));
+			else if (strcmp(argv[i], "--frames") == 0 && hasValue) options.frames = std::stoi(argv[++i]);
+			else if (strcmp(argv[i], "--warmup") == 0 && hasValue) options.warmupFrames = std::stoi(argv[++i]);
+			else if (strcmp(argv[i], "--mode") == 0 && hasValue) options.mode = argv[++i];
+			else if (strcmp(argv[i], "--lod") == 0) options.lod = true;
+			else if (strcmp(argv[i], "--output") == 0 && hasValue) options.outputPath = argv[++i];
+			else if (strcmp(argv[i], "--baseline") == 0 && hasValue) options.baselinePath = argv[++i];
+			else if (strcmp(argv[i], "--tolerance") == 0 && hasValue) options.tolerance = std::stod(argv[++i]);
+			else
+			{
+				std::fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+				return false;
+			}
+		}
+
+		if (options.scene != "cubes" && options.scene != "unique-models" && options.scene != "pipelines" && options.scene != "spheres")
+		{
+			std::fprintf(stderr, "Unknown scene: %s\n", options.scene.c_str());
+			return false;
+		}
+
+		return true;
+	}
+
+	bool ParseRenderMode(const std::string& name, SimpleRenderSystem::RenderMode& renderMode)
+	{
+		if (name == "per-object") renderMode = SimpleRenderSystem::RenderMode::PerObject;
+		else if (name == "instanced") renderMode = SimpleRenderSystem::RenderMode::Instanced;
+		else if (name == "parallel") renderMode = SimpleRenderSystem::RenderMode::Parallel;
+		else return false;
+
+		return true;
+	}
+
+	// Built once per run, the chain is the same every time
+	std::unique_ptr<Model> CreateSphereModel(Device& device)
+	{
+		Model::Builder builder = CreateSphere(SPHERE_SEGMENTS, SPHERE_SEGMENTS / 2);
+		BuildLods(builder, DEFAULT_LOD_ERRORS, std::size(DEFAULT_LOD_ERRORS));
+		return std::make_unique<Model>(device, builder);
+	}
+
+	// Objects are spread over clip space with a fixed seed, every run of a scene draws exactly the same frame
+	void CreateScene(Device& device, const Options& options, World& world, std::vector<std::unique_ptr<Model>>& models)
+	{
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> depth(0.1f, 0.9f);
+		std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+		std::uniform_real_distribution<float> logScale(std::log(MIN_SPHERE_SCALE), std::log(MAX_SPHERE_SCALE));
+
+		const bool isSpheres = options.scene == "spheres";
+		const bool isSharedModel = options.scene != "unique-models";
+		for (size_t i = 0; i < options.objectCount; ++i)
+		{
+			if (!isSharedModel || models.empty())
+			{
+				models.push_back(isSpheres ? CreateSphereModel(device) : CreateCubeModel(device, { 0.0f, 0.0f, 0.0f }));
+			}
+
+			Entity entity = world.CreateEntity();
+			Transform transform{};
+			transform.translation = { position(rng), position(rng), depth(rng) };
+			transform.scale = { 0.02f, 0.02f, 0.02f };
+			transform.rotation = { angle(rng), angle(rng), 0.0f };
+
+			// Without a camera the size on screen is the scale, spread evenly over its logarithm like distances in a world
+			if (isSpheres)
+			{
+				transform.scale = glm::vec3{ std::exp(logScale(rng)) };
+			}
+			world.AddComponent(entity, transform);
+			world.AddComponent(entity, RenderComponent{ models.back().get(), {} });
+		}
+
+		device.GetUploadService().WaitIdle();
+	}
+
+	void WritePercentiles(std::ostream& stream, const char* name, const Percentiles& percentiles, bool isLast)
+	{
+		stream << "    \"" << name << "\": { \"p50\": " << percentiles.p50 << ", \"p95\": " << percentiles.p95
+			<< ", \"p99\": " << percentiles.p99 << ", \"mean\": " << percentiles.mean << ", \"samples\": " << percentiles.samples
+			<< " }" << (isLast ? "\n" : ",\n");
+	}
+
+	// Only reads back reports written by this program: finds "metric": { ... "key": value }
+	bool ReadBaselineValue(const std::string& json, const char* metric, const char* key, double& value)
+	{
+		size_t metricPosition = json.find(std::string("\"") + metric + "\"");
+		if (metricPosition == std::string::npos)
+		{
+			return false;
+		}
+
+		size_t end = json.find('}', metricPosition);
+		size_t keyPosition = json.find(std::string("\"") + key + "\":", metricPosition);
+		if (keyPosition == std::string::npos || keyPosition > end)
+		{
+			return false;
+		}
+
+		value = std::strtod(json.c_str() + keyPosition + strlen(key) + 3, nullptr);
+		return true;
+	}
+
+	// Returns the number of regressed values, or -1 if the baseline cannot be read
+	int CompareToBaseline(const Options& options, const char* const metricNames[], const Percentiles metrics[], size_t metricCount)
+	{
+		std::ifstream file(options.baselinePath);
+		if (!file.is_open())
+		{
+			std::fprintf(stderr, "Failed to open baseline: %s\n", options.baselinePath.c_str());
+			return -1;
+		}
+
+		std::stringstream buffer;
+		buffer << file.rdbuf();
+		const std::string json = buffer.str();
+
+		if (json.find("\"scene\": \"" + options.scene + "\"") == std::string::npos
+			|| json.find("\"objectCount\": " + std::to_string(options.objectCount) + ",") == std::string::npos)
+		{
+			std::fprintf(stderr, "Warning: the baseline was recorded with another scene or object count\n");
+		}
+
+		int regressions = 0;
+		std::printf("\n%-16s %-4s %12s %12s %9s\n", "metric", "", "baseline", "current", "change");
+		for (size_t i = 0; i < metricCount; ++i)
+		{
+			if (metrics[i].samples == 0)
+			{
+				continue;
+			}
+
+			const char* keys[] = { "p50", "p95", "p99" };
+			const double values[] = { metrics[i].p50, metrics[i].p95, metrics[i].p99 };
+			for (int k = 0; k < 3; ++k)
+			{
+				double baseline = 0.0;
+				if (!ReadBaselineValue(json, metricNames[i], keys[k], baseline) || baseline <= 0.0)
+				{
+					continue;
+				}
+
+				double change = values[k] / baseline - 1.0;
+				bool isRegression = change > options.tolerance;
+				regressions += isRegression ? 1 : 0;
+
+				std::printf("%-16s %-4s %12.4f %12.4f %+8.1f%%%s\n", metricNames[i], keys[k], baseline, values[k], change * 100.0,
+					isRegression ? "  REGRESSION" : "");
+			}
+		}
+
+		return regressions;
+	}
+}
+
+static int RunBenchmark(int argc, char** argv)
+{
+	Options options{};
+	SimpleRenderSystem::RenderMode renderMode{};
+	if (!ParseOptions(argc, argv, options) || !ParseRenderMode(options.mode, renderMode))
+	{
+		return 2;
+	}
+
+	// Headless: no window, no present, no vsync, frames are only limited by the CPU and the GPU
+	JobSystem jobSystem{};
+	Device device{};
+	Renderer renderer{ device, jobSystem, EXTENT };
+
+	std::vector<std::unique_ptr<Model>> models;
+	World world;
+	CreateScene(device, options, world, models);
+	RenderQuery& entities = world.GetQuery<Transform, RenderComponent>();
+
+	// The pipelines scene splits the objects between render systems that each own their pipelines
+	const size_t systemCount = options.scene == "pipelines" ? std::min(options.pipelineCount, std::max<size_t>(options.objectCount, 1)) : 1;
+	std::vector<std::unique_ptr<SimpleRenderSystem>> renderSystems;
+	std::vector<std::vector<uint32_t>> systemObjects(systemCount);
+	for (size_t i = 0; i < systemCount; ++i)
+	{
+		renderSystems.push_back(std::make_unique<SimpleRenderSystem>(device, renderer.GetSwapChainRenderPass(), renderMode));
+	}
+	for (size_t i = 0; i < entities.Size(); ++i)
+	{
+		systemObjects[i % systemCount].push_back(static_cast<uint32_t>(i));
+	}
+
+	// The scene does not move, the triangles without LODs are the same every frame
+	std::vector<uint32_t> allObjects(entities.Size());
+	uint64_t fullDetailTriangleCount = 0;
+	for (uint32_t i = 0; i < allObjects.size(); ++i)
+	{
+		allObjects[i] = i;
+		fullDetailTriangleCount += entities.Data<RenderComponent>()[i].model->GetTriangleCount();
+	}
+	LodSelector lodSelector;
+
+	// Secondary command buffers are executed once per render system, the parallel recorder only supports one call per frame
+	if (renderMode == SimpleRenderSystem::RenderMode::Parallel && systemCount > 1)
+	{
+		std::fprintf(stderr, "The parallel mode records one render system per frame, use --scene pipelines with another mode\n");
+		return 2;
+	}
+
+	std::vector<double> cpuFrameTimes;
+	std::vector<double> recordingTimes;
+	std::vector<double> gpuFrameTimes;
+	cpuFrameTimes.reserve(options.frames);
+	recordingTimes.reserve(options.frames);
+	gpuFrameTimes.reserve(options.frames);
+
+	GpuProfiler& gpuProfiler = renderer.GetGpuProfiler();
+	uint64_t lastGpuFrame = UINT64_MAX;
+	int frame = 0;
+
+	while (frame < options.warmupFrames + options.frames)
+	{
+		auto frameStart = std::chrono::steady_clock::now();
+
+		VkCommandBuffer commandBuffer = renderer.BeginFrame();
+		if (commandBuffer == nullptr)
+		{
+			continue;
+		}
+
+		FrameInfo frameInfo{ renderer.GetFrameIndex(), commandBuffer };
+		frameInfo.renderPass = renderer.GetSwapChainRenderPass();
+		frameInfo.framebuffer = renderer.GetCurrentFramebuffer();
+		frameInfo.extent = renderer.GetSwapChainExtent();
+		frameInfo.commandRecorder = &renderer.GetCommandRecorder();
+		frameInfo.gpuProfiler = &gpuProfiler;
+		frameInfo.jobSystem = &jobSystem;
+
+		// Part of the CPU frame, not of the recording
+		if (options.lod)
+		{
+			lodSelector.Select(glm::mat4{ 1.0f }, frameInfo.extent, entities, allObjects, &jobSystem);
+			frameInfo.lodSelector = &lodSelector;
+		}
+
+		renderer.BeginSwapChainRenderPass(commandBuffer, renderSystems[0]->GetSubpassContents());
+
+		auto recordStart = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < systemCount; ++i)
+		{
+			renderSystems[i]->RenderEntities(frameInfo, entities, systemObjects[i]);
+		}
+		auto recordEnd = std::chrono::steady_clock::now();
+
+		renderer.EndSwapChainRenderPass(commandBuffer);
+		renderer.EndFrame();
+
+		auto frameEnd = std::chrono::steady_clock::now();
+
+		if (frame++ < options.warmupFrames)
+		{
+			continue;
+		}
+
+		cpuFrameTimes.push_back(std::chrono::duration<double, std::milli>(frameEnd - frameStart).count());
+		recordingTimes.push_back(std::chrono::duration<double, std::milli>(recordEnd - recordStart).count());
+
+		// GPU results arrive MAX_FRAMES_IN_FLIGHT frames late, each resolved frame is counted once
+		const GpuFrameStats& gpuStats = gpuProfiler.GetLastFrameStats();
+		if (gpuProfiler.IsSupported() && !gpuStats.scopes.empty() && gpuStats.frameNumber != lastGpuFrame)
+		{
+			gpuFrameTimes.push_back(gpuStats.frameMilliseconds);
+			lastGpuFrame = gpuStats.frameNumber;
+		}
+	}
+
+	vkDeviceWaitIdle(device.GetDevice());
+
+	const char* const metricNames[] = { "cpuFrameMs", "recordingMs", "gpuFrameMs" };
+	const Percentiles metrics[] = { ComputePercentiles(cpuFrameTimes), ComputePercentiles(recordingTimes), ComputePercentiles(gpuFrameTimes) };
+	constexpr size_t metricCount = sizeof(metrics) / sizeof(metrics[0]);
+
+	std::ostringstream report;
+	report << "{\n";
+	report << "  \"scene\": \"" << options.scene << "\",\n";
+	report << "  \"objectCount\": " << options.objectCount << ",\n";
+	report << "  \"renderSystems\": " << systemCount << ",\n";
+	report << "  \"mode\": \"" << options.mode << "\",\n";
+	report << "  \"lod\": " << (options.lod ? "true" : "false") << ",\n";
+	report << "  \"trianglesPerFrame\": " << (options.lod ? lodSelector.GetStats().triangleCount : fullDetailTriangleCount) << ",\n";
+	report << "  \"fullDetailTrianglesPerFrame\": " << fullDetailTriangleCount << ",\n";
+	report << "  \"frames\": " << options.frames << ",\n";
+	report << "  \"device\": \"" << device._properties.deviceName << "\",\n";
+	report << "  \"metrics\": {\n";
+	for (size_t i = 0; i < metricCount; ++i)
+	{
+		WritePercentiles(report, metricNames[i], metrics[i], i + 1 == metricCount);
+	}
+	report << "  }\n}\n";
+
+	std::printf("%s", report.str().c_str());
+
+	if (!options.outputPath.empty())
+	{
+		std::ofstream file(options.outputPath, std::ios::trunc);
+		file << report.str();
+		if (!file.good())
+		{
+			std::fprintf(stderr, "Failed to write report: %s\n", options.outputPath.c_str());
+			return 2;
+		}
+	}
+
+	if (!options.baselinePath.empty())
+	{
+		int regressions = CompareToBaseline(options, metricNames, metrics, metricCount);
+		if (regressions < 0)
+		{
+			return 2;
+		}
+		if (regressions > 0)
+		{
+			std::printf("%d value(s) regressed by more than %.0f%%\n", regressions, options.tolerance * 100.0);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		return RunBenchmark(argc, argv);
+	}
+	catch (const std::exception& e)
+	{
+		std::fprintf(stderr, "%s\n", e.what());
+		return 2;
+	}
+}
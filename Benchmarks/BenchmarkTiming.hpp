@@ -0,0 +1,43 @@
+#pragma once
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The BenchmarkTiming struct holds the wall clock time of the timed runs of a MeasureTiming call.
+	/// </summary>
+	struct BenchmarkTiming
+	{
+		double averageMilliseconds = 0.0;
+		double fastestMilliseconds = 0.0;
+
+		inline double GetAverageMicroseconds() const { return averageMilliseconds * 1000.0; }
+	};
+
+	// Calls function warmUpCount times untimed, to fault the memory it touches in, then times runCount calls one by one
+	template<typename Function>
+	BenchmarkTiming MeasureTiming(Function function, uint32_t runCount = 1, uint32_t warmUpCount = 0)
+	{
+		for (uint32_t run = 0; run < warmUpCount; ++run)
+		{
+			function();
+		}
+
+		BenchmarkTiming timing{};
+		for (uint32_t run = 0; run < runCount; ++run)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			function();
+			auto end = std::chrono::high_resolution_clock::now();
+
+			double milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+			timing.averageMilliseconds += milliseconds / runCount;
+			timing.fastestMilliseconds = run == 0 ? milliseconds : std::min(timing.fastestMilliseconds, milliseconds);
+		}
+		return timing;
+	}
+} // namespace DaisyEngine
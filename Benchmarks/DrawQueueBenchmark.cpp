@@ -0,0 +1,116 @@
+// Sorts draw queues the size of a crowded frame with the radix sort of DrawQueue, on one thread and on the JobSystem, and
+// with std::stable_sort. The keys mix a few pipelines, a few hundred meshes submitted in a random order and random depths.
+// Also counts the pipeline and mesh changes a DrawCommandBuffer would record in submission order and in sorted order.
+// Exits with 1 if a sort does not give the same order as std::stable_sort.
+
+#include "../Source/DrawQueue.hpp"
+#include "../Source/JobSystem.hpp"
+#include "BenchmarkTiming.hpp"
+
+// std
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace DaisyEngine;
+
+namespace
+{
+	constexpr uint32_t PIPELINE_COUNT = 4;
+	constexpr uint32_t MESH_COUNT = 300;
+	constexpr uint32_t RUN_COUNT = 10; // The fastest run is reported
+	constexpr uint32_t PACKET_COUNTS[] = { 1000, 10000, 100000, 1000000 };
+
+	void FillQueue(DrawQueue& drawQueue, const std::vector<uint64_t>& keys)
+	{
+		drawQueue.Clear();
+		for (uint32_t object = 0; object < keys.size(); ++object)
+		{
+			drawQueue.Submit(keys[object], object);
+		}
+	}
+
+	bool IsSameOrder(const std::vector<DrawPacket>& a, const std::vector<DrawPacket>& b)
+	{
+		return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const DrawPacket& x, const DrawPacket& y)
+			{
+				return x.sortKey == y.sortKey && x.object == y.object;
+			});
+	}
+
+	// The binds of a DrawCommandBuffer fed in this order: one per pipeline change, one per mesh change
+	uint32_t CountStateChanges(const std::vector<DrawPacket>& packets)
+	{
+		uint32_t changeCount = 0;
+		uint64_t previousKey = ~0ull;
+		for (const DrawPacket& packet : packets)
+		{
+			bool isFirst = previousKey == ~0ull;
+			changeCount += isFirst || DrawQueue::GetPipeline(packet.sortKey) != DrawQueue::GetPipeline(previousKey) ? 1 : 0;
+			changeCount += isFirst || DrawQueue::GetMesh(packet.sortKey) != DrawQueue::GetMesh(previousKey) ? 1 : 0;
+			previousKey = packet.sortKey;
+		}
+		return changeCount;
+	}
+}
+
+int main()
+{
+	bool isValid = true;
+	std::mt19937 random{ 42 };
+	std::uniform_int_distribution<uint32_t> meshDistribution{ 0, MESH_COUNT - 1 };
+	std::uniform_real_distribution<float> depthDistribution{ 0.0f, 1.0f };
+
+	JobSystem jobSystem{ std::max(1u, std::thread::hardware_concurrency()) };
+
+	std::printf("%10s %14s %14s %14s %10s %16s %16s\n", "packets", "radix (ms)", "parallel (ms)", "stable (ms)", "speedup",
+		"changes before", "changes after");
+
+	for (uint32_t packetCount : PACKET_COUNTS)
+	{
+		// The pipeline follows the mesh, like the vertex format of a model
+		std::vector<uint64_t> keys(packetCount);
+		for (uint64_t& key : keys)
+		{
+			uint32_t mesh = meshDistribution(random);
+			key = DrawQueue::MakeSortKey(mesh % PIPELINE_COUNT, 0, mesh, DrawQueue::GetDepthBucket(depthDistribution(random)));
+		}
+
+		DrawQueue drawQueue;
+		FillQueue(drawQueue, keys);
+		std::vector<DrawPacket> expected = drawQueue.GetPackets();
+		const uint32_t changesBefore = CountStateChanges(expected);
+
+		double stableMilliseconds = MeasureTiming([&]()
+			{
+				expected = drawQueue.GetPackets();
+				std::stable_sort(expected.begin(), expected.end(), [](const DrawPacket& a, const DrawPacket& b) { return a.sortKey < b.sortKey; });
+			}, RUN_COUNT).fastestMilliseconds;
+
+		double radixMilliseconds = 0.0;
+		double parallelMilliseconds = 0.0;
+		for (JobSystem* sortJobSystem : { static_cast<JobSystem*>(nullptr), &jobSystem })
+		{
+			// The refill is timed with the sort, like a frame that submits then sorts
+			double milliseconds = MeasureTiming([&]()
+				{
+					FillQueue(drawQueue, keys);
+					drawQueue.Sort(sortJobSystem);
+				}, RUN_COUNT).fastestMilliseconds;
+
+			if (!IsSameOrder(drawQueue.GetPackets(), expected))
+			{
+				std::printf("%u packets, %s sort: FAILED\n", packetCount, sortJobSystem != nullptr ? "parallel" : "radix");
+				isValid = false;
+			}
+			(sortJobSystem != nullptr ? parallelMilliseconds : radixMilliseconds) = milliseconds;
+		}
+
+		std::printf("%10u %14.3f %14.3f %14.3f %9.2fx %16u %16u\n", packetCount, radixMilliseconds, parallelMilliseconds,
+			stableMilliseconds, stableMilliseconds / parallelMilliseconds, changesBefore, CountStateChanges(drawQueue.GetPackets()));
+	}
+
+	return isValid ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+// Compares iterating the World's component arrays with iterating a vector of GameObject-like structs, at 100k and 1M entities.
+// The update pass rotates every transform, the gather pass reads what the SimpleRenderSystem reads for the rendered entities.
+// Half of the entities can be left without a render component, the query then skips them without touching their memory.
+// A quarter of the entities are destroyed and recreated in random order before timing again, then the query is checked
+// against the World; the program exits with 1 if an entity is missing or out of place.
+
+#include "../Source/Components.hpp"
+#include "../Source/TransformStore.hpp"
+#include "../Source/World.hpp"
+#include "BenchmarkTiming.hpp"
+
+// std
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace DaisyEngine;
+
+namespace
+{
+	constexpr int ITERATIONS = 50;
+
+	// The layout of the GameObject the World replaced
+	struct LegacyObject
+	{
+		std::shared_ptr<Model> model;
+		glm::vec3 color{};
+		Transform transform{};
+		unsigned int id = 0;
+	};
+
+	Transform RandomTransform(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+
+		Transform transform{};
+		transform.translation = { position(rng), position(rng), position(rng) };
+		transform.scale = { 0.02f, 0.02f, 0.02f };
+		return transform;
+	}
+
+	void Rotate(Transform& transform)
+	{
+		transform.rotation.y = glm::mod<float>(transform.rotation.y + 0.01f, glm::two_pi<float>());
+		transform.rotation.x = glm::mod<float>(transform.rotation.x + 0.005f, glm::two_pi<float>());
+	}
+
+	// Every entity of the query must have both components, and every such entity must be in the query
+	bool CheckQuery(World& world, RenderQuery& entities, const std::vector<Entity>& alive)
+	{
+		size_t expectedSize = 0;
+		for (Entity entity : alive)
+		{
+			expectedSize += world.HasComponent<RenderComponent>(entity) ? 1 : 0;
+		}
+
+		bool isValid = entities.Size() == expectedSize;
+		for (size_t i = 0; i < entities.Size() && isValid; ++i)
+		{
+			Entity entity = entities.GetEntity(i);
+			isValid = world.IsAlive(entity)
+				&& &world.GetComponent<Transform>(entity) == &entities.Get<Transform>(i)
+				&& &world.GetComponent<RenderComponent>(entity) == &entities.Get<RenderComponent>(i);
+		}
+
+		std::printf("query check %s (%zu entities)\n", isValid ? "OK" : "FAILED", entities.Size());
+		return isValid;
+	}
+}
+
+int main()
+{
+	// Stands in for a loaded model, the pointer is compared but never dereferenced
+	std::shared_ptr<int> modelOwner = std::make_shared<int>(0);
+	std::shared_ptr<Model> model(modelOwner, reinterpret_cast<Model*>(modelOwner.get()));
+
+	std::printf("%10s %9s %-8s %16s %12s %10s\n", "entities", "rendered", "pass", "GameObject (us)", "World (us)", "speedup");
+
+	bool isValid = true;
+	for (size_t count : { 100000, 1000000 })
+	{
+		for (int renderedPercent : { 100, 50 })
+		{
+			std::mt19937 rng(42);
+			std::bernoulli_distribution isRendered(renderedPercent / 100.0);
+
+			std::vector<LegacyObject> objects(count);
+			World world;
+			std::vector<Entity> alive;
+			alive.reserve(count);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				Transform transform = RandomTransform(rng);
+				bool hasModel = isRendered(rng);
+
+				objects[i].id = static_cast<unsigned int>(i);
+				objects[i].transform = transform;
+				objects[i].model = hasModel ? model : nullptr;
+
+				Entity entity = world.CreateEntity();
+				world.AddComponent(entity, transform);
+				if (hasModel)
+				{
+					world.AddComponent(entity, RenderComponent{ model.get(), {} });
+				}
+				alive.push_back(entity);
+			}
+
+			RenderQuery& entities = world.GetQuery<Transform, RenderComponent>();
+			TransformStore store;
+			std::vector<Model*> models;
+
+			double legacyUpdate = MeasureTiming([&]()
+				{
+					for (LegacyObject& object : objects)
+					{
+						Rotate(object.transform);
+					}
+				}, ITERATIONS, 1).GetAverageMicroseconds();
+			double worldUpdate = MeasureTiming([&]()
+				{
+					for (Transform& transform : world.GetPool<Transform>())
+					{
+						Rotate(transform);
+					}
+				}, ITERATIONS, 1).GetAverageMicroseconds();
+
+			double legacyGather = MeasureTiming([&]()
+				{
+					store.Clear();
+					models.clear();
+					for (const LegacyObject& object : objects)
+					{
+						if (object.model != nullptr)
+						{
+							store.Add(object.transform);
+							models.push_back(object.model.get());
+						}
+					}
+				}, ITERATIONS, 1).GetAverageMicroseconds();
+			double worldGather = MeasureTiming([&]()
+				{
+					store.Clear();
+					models.clear();
+					entities.Each([&](Transform& transform, RenderComponent& renderComponent)
+						{
+							store.Add(transform);
+							models.push_back(renderComponent.model);
+						});
+				}, ITERATIONS, 1).GetAverageMicroseconds();
+
+			// Slots freed in random order are reused by the new entities, the query must stay packed
+			std::shuffle(alive.begin(), alive.end(), rng);
+			size_t churnCount = count / 4;
+			for (size_t i = 0; i < churnCount; ++i)
+			{
+				world.DestroyEntity(alive[i]);
+			}
+			for (size_t i = 0; i < churnCount; ++i)
+			{
+				Entity entity = world.CreateEntity();
+				world.AddComponent(entity, RandomTransform(rng));
+				if (isRendered(rng))
+				{
+					world.AddComponent(entity, RenderComponent{ model.get(), {} });
+				}
+				alive[i] = entity;
+			}
+
+			double churnedGather = MeasureTiming([&]()
+				{
+					store.Clear();
+					models.clear();
+					entities.Each([&](Transform& transform, RenderComponent& renderComponent)
+						{
+							store.Add(transform);
+							models.push_back(renderComponent.model);
+						});
+				}, ITERATIONS, 1).GetAverageMicroseconds();
+
+			std::printf("%10zu %8d%% %-8s %16.1f %12.1f %9.1fx\n", count, renderedPercent, "update", legacyUpdate, worldUpdate, legacyUpdate / worldUpdate);
+			std::printf("%10zu %8d%% %-8s %16.1f %12.1f %9.1fx\n", count, renderedPercent, "gather", legacyGather, worldGather, legacyGather / worldGather);
+			std::printf("%10zu %8d%% %-8s %16s %12.1f\n", count, renderedPercent, "churned", "", churnedGather);
+
+			isValid &= CheckQuery(world, entities, alive);
+		}
+	}
+
+	return isValid ? 0 : 1;
+}
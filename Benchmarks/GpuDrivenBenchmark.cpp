@@ -0,0 +1,138 @@
+// Compares the CPU frame cost of the CPU driven path, FrustumCuller and SimpleRenderSystem in instanced mode, with the
+// GpuDrivenRenderSystem on scenes of 10k to 1M objects sharing the built in primitives. The GPU driven path is measured on
+// a static scene and with 1% of the objects moving each frame, only the moved ones being uploaded.
+// Exits with 1 if the GPU does not find the same visible objects as the FrustumCuller, or if the CPU cost of the static
+// GPU driven frame grows with the number of objects.
+
+#include "../Source/Device.hpp"
+#include "../Source/FrustumCuller.hpp"
+#include "../Source/GpuDrivenRenderSystem.hpp"
+#include "../Source/JobSystem.hpp"
+#include "../Source/Primitives.hpp"
+#include "../Source/Renderer.hpp"
+#include "../Source/SimpleRenderSystem.hpp"
+#include "BenchmarkScene.hpp"
+#include "BenchmarkTiming.hpp"
+
+// std
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace DaisyEngine;
+
+namespace
+{
+	constexpr VkExtent2D EXTENT = { 1280, 720 };
+	constexpr uint32_t MOVING_OBJECTS_PER_THOUSAND = 10;
+	constexpr double FLAT_FACTOR = 2.0; // The static frame at 1M objects may cost this much of the one at 10k...
+	constexpr double FLAT_SLACK_MICROSECONDS = 100.0; // ...plus this, for the timer noise of frames that short
+}
+
+int main()
+{
+	// Headless: no window, no present, no vsync
+	JobSystem jobSystem{};
+	Device device{};
+	Renderer renderer{ device, jobSystem, EXTENT };
+
+	std::vector<std::unique_ptr<Model>> models;
+	std::vector<Model*> sceneModels;
+	for (uint32_t i = 0; i < PRIMITIVE_COUNT; ++i)
+	{
+		models.push_back(std::make_unique<Model>(device, CreatePrimitive(static_cast<Primitive>(i))));
+		sceneModels.push_back(models.back().get());
+	}
+	device.GetUploadService().WaitIdle();
+
+	// Headless, and part of the objects lies outside of clip space and is culled
+	BenchmarkFrameOptions frameOptions{};
+	frameOptions.pollEvents = false;
+	frameOptions.jobSystem = &jobSystem;
+	const BenchmarkSceneBounds sceneBounds{ 1.5f, -0.2f, 1.2f };
+
+	SimpleRenderSystem simpleRenderSystem{ device, renderer.GetSwapChainRenderPass(), SimpleRenderSystem::RenderMode::Instanced };
+	const glm::mat4 viewProjection{ 1.0f }; // No camera, the transforms go straight to clip space
+
+	std::printf("Draw indirect count: %s, multi draw indirect: %s\n", device.IsDrawIndirectCountSupported() ? "yes" : "no",
+		device.GetEnabledFeatures().multiDrawIndirect ? "yes" : "no");
+	std::printf("%10s %16s %16s %16s %12s %10s %10s %10s\n", "objects", "CPU driven (us)", "GPU static (us)", "GPU 1% moving (us)",
+		"upload (ms)", "draws", "visible", "GPU visible");
+
+	bool isValid = true;
+	double firstStaticMicroseconds = 0.0;
+	for (size_t count : { 10000, 100000, 1000000 })
+	{
+		World world;
+		CreateBenchmarkEntities(world, sceneModels, count, sceneBounds);
+		RenderQuery& query = world.GetQuery<Transform, RenderComponent>();
+		RenderView entities = query;
+
+		FrustumCuller frustumCuller;
+		double cpuDriven = MeasureFrames(renderer, frameOptions,
+			[&](FrameInfo&)
+			{
+				frustumCuller.Cull(viewProjection, entities, &jobSystem);
+			},
+			[&](FrameInfo& frameInfo)
+			{
+				simpleRenderSystem.RenderEntities(frameInfo, entities, frustumCuller.GetVisibleObjects());
+			});
+
+		GpuDrivenRenderSystem gpuDrivenRenderSystem{ device, renderer.GetSwapChainRenderPass(), static_cast<uint32_t>(count) };
+		double uploadMilliseconds = MeasureTiming([&]() { gpuDrivenRenderSystem.SetEntities(entities, &jobSystem); }).averageMilliseconds;
+
+		auto cull = [&](FrameInfo& frameInfo) { gpuDrivenRenderSystem.Cull(frameInfo, viewProjection); };
+		auto render = [&](FrameInfo& frameInfo) { gpuDrivenRenderSystem.Render(frameInfo); };
+		double gpuStatic = MeasureFrames(renderer, frameOptions, cull, render);
+
+		// The scene has not changed for more frames than are in flight, the count read back is the one of this scene
+		vkDeviceWaitIdle(device.GetDevice());
+		const GpuDrivenStats staticStats = gpuDrivenRenderSystem.GetStats();
+
+		// A different 1% of the objects moves each frame
+		std::vector<uint32_t> movingEntities;
+		uint32_t nextMoving = 0;
+		double gpuMoving = MeasureFrames(renderer, frameOptions,
+			[&](FrameInfo& frameInfo)
+			{
+				movingEntities.clear();
+				for (size_t i = 0; i < count * MOVING_OBJECTS_PER_THOUSAND / 1000; ++i)
+				{
+					uint32_t entity = nextMoving;
+					nextMoving = (nextMoving + 1) % static_cast<uint32_t>(count);
+					entities.transforms[entity].rotation.y += 0.01f;
+					movingEntities.push_back(entity);
+				}
+				gpuDrivenRenderSystem.UpdateEntities(entities, movingEntities);
+				cull(frameInfo);
+			}, render);
+
+		std::printf("%10zu %16.1f %16.1f %18.1f %12.2f %10u %10u %10u\n", count, cpuDriven, gpuStatic, gpuMoving, uploadMilliseconds,
+			staticStats.drawCallCount, frustumCuller.GetStats().visibleCount, staticStats.visibleCount);
+
+		// Float rounding may differ on the spheres that touch a plane, no more than a handful of them
+		const int64_t visibleDifference = static_cast<int64_t>(staticStats.visibleCount) - static_cast<int64_t>(frustumCuller.GetStats().visibleCount);
+		if (std::llabs(visibleDifference) > static_cast<int64_t>(count / 10000))
+		{
+			std::printf("GPU culling does not match the FrustumCuller: FAILED\n");
+			isValid = false;
+		}
+
+		if (firstStaticMicroseconds == 0.0)
+		{
+			firstStaticMicroseconds = gpuStatic;
+		}
+		else if (gpuStatic > firstStaticMicroseconds * FLAT_FACTOR + FLAT_SLACK_MICROSECONDS)
+		{
+			std::printf("The static GPU driven frame grows with the scene: FAILED\n");
+			isValid = false;
+		}
+
+		vkDeviceWaitIdle(device.GetDevice());
+	}
+
+	vkDeviceWaitIdle(device.GetDevice());
+	return isValid ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+// Compares the CPU recording time of SimpleRenderSystem's per object and instanced paths.
+// Every object shares the same model, which is the best case for instancing.
+
+#include "../Source/Window.hpp"
+#include "../Source/Device.hpp"
+#include "../Source/JobSystem.hpp"
+#include "../Source/Model.hpp"
+#include "../Source/Renderer.hpp"
+#include "../Source/SimpleRenderSystem.hpp"
+#include "BenchmarkScene.hpp"
+
+// std
+#include <cstdio>
+#include <vector>
+
+using namespace DaisyEngine;
+
+int main()
+{
+	Window window{ 800, 600, "Daisy Engine - Instancing benchmark" };
+	Device device{ window };
+	JobSystem jobSystem{};
+	Renderer renderer{ window, device, jobSystem };
+
+	Model::Builder builder{};
+	builder.vertices = {
+		{{0.0f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+		{{0.5f, 0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+		{{-0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+	};
+	std::unique_ptr<Model> model = std::make_unique<Model>(device, builder);
+	device.GetUploadService().WaitIdle();
+
+	SimpleRenderSystem renderSystem{ device, renderer.GetSwapChainRenderPass() };
+
+	std::printf("%10s %20s %20s %10s\n", "objects", "per object (us)", "instanced (us)", "speedup");
+	for (size_t count : { 1000, 10000, 100000 })
+	{
+		World world;
+		CreateBenchmarkEntities(world, { model.get() }, count);
+		RenderQuery& entities = world.GetQuery<Transform, RenderComponent>();
+		auto record = [&](FrameInfo& frameInfo) { renderSystem.RenderEntities(frameInfo, entities); };
+
+		renderSystem.SetRenderMode(SimpleRenderSystem::RenderMode::PerObject);
+		double perObject = MeasureFrames(renderer, {}, nullptr, record);
+
+		renderSystem.SetRenderMode(SimpleRenderSystem::RenderMode::Instanced);
+		double instanced = MeasureFrames(renderer, {}, nullptr, record);
+
+		std::printf("%10zu %20.1f %20.1f %9.1fx\n", count, perObject, instanced, perObject / instanced);
+	}
+
+	vkDeviceWaitIdle(device.GetDevice());
+	return 0;
+}
@@ -0,0 +1,171 @@
+// Measures the task throughput of the JobSystem for every worker count from 1 to the number of hardware threads:
+// - empty jobs submitted by the main thread, the cost of the scheduler alone;
+// - a tree of jobs spawning jobs, where the work starts on one worker and has to be stolen by the others;
+// - stages of jobs that each depend on the previous stage's counter;
+// - ParallelFor over a large array with a few grain sizes, against a plain loop.
+// Every scenario checks its result, the program exits with 1 if a job was lost or ran twice.
+
+#include "../Source/JobSystem.hpp"
+#include "BenchmarkTiming.hpp"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace DaisyEngine;
+
+namespace
+{
+	constexpr uint32_t EMPTY_JOB_COUNT = 100000;
+	constexpr uint32_t TREE_DEPTH = 14; // 2^15 - 1 jobs
+	constexpr uint32_t STAGE_COUNT = 1000;
+	constexpr uint32_t JOBS_PER_STAGE = 64;
+	constexpr uint32_t ELEMENT_COUNT = 4000000;
+
+	bool Check(bool isValid, const char* scenario)
+	{
+		if (!isValid)
+		{
+			std::printf("%s: FAILED\n", scenario);
+		}
+		return isValid;
+	}
+
+	void SpawnTree(JobSystem& jobSystem, JobCounter& counter, std::atomic<uint32_t>& visited, uint32_t depth)
+	{
+		visited.fetch_add(1, std::memory_order_relaxed);
+		if (depth == 0)
+		{
+			return;
+		}
+
+		for (int child = 0; child < 2; ++child)
+		{
+			jobSystem.Submit([&jobSystem, &counter, &visited, depth]() { SpawnTree(jobSystem, counter, visited, depth - 1); }, &counter);
+		}
+	}
+
+	// Enough arithmetic per element that the loop is not only bound by memory bandwidth
+	void Process(const std::vector<float>& input, std::vector<float>& output, uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			output[i] = std::sqrt(input[i]) * std::sin(input[i]) + std::cos(input[i]);
+		}
+	}
+}
+
+int main()
+{
+	bool isValid = true;
+
+	std::vector<float> input(ELEMENT_COUNT);
+	for (uint32_t i = 0; i < ELEMENT_COUNT; ++i)
+	{
+		input[i] = static_cast<float>(i % 1000) * 0.01f;
+	}
+
+	// The first run also faults the pages of expected in, only the second one is timed
+	std::vector<float> expected(ELEMENT_COUNT);
+	Process(input, expected, 0, ELEMENT_COUNT);
+	double serialMilliseconds = MeasureTiming([&]() { Process(input, expected, 0, ELEMENT_COUNT); }).averageMilliseconds;
+	std::vector<float> output(ELEMENT_COUNT);
+
+	std::printf("%8s %16s %16s %16s %14s %14s %14s %14s\n", "workers", "empty (Mjobs/s)", "tree (Mjobs/s)", "stages (Mjobs/s)",
+		"for 256 (x)", "for 4096 (x)", "for 65536 (x)", "stolen (%)");
+
+	// Powers of two, then every hardware thread
+	uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<uint32_t> workerCounts;
+	for (uint32_t workerCount = 1; workerCount < hardwareThreads; workerCount *= 2)
+	{
+		workerCounts.push_back(workerCount);
+	}
+	workerCounts.push_back(hardwareThreads);
+
+	for (uint32_t workerCount : workerCounts)
+	{
+		JobSystem jobSystem{ workerCount };
+
+		// Empty jobs from the main thread
+		std::atomic<uint32_t> emptyRuns{ 0 };
+		double emptyMilliseconds = MeasureTiming([&]()
+			{
+				JobCounter counter;
+				for (uint32_t i = 0; i < EMPTY_JOB_COUNT; ++i)
+				{
+					jobSystem.Submit([&emptyRuns]() { emptyRuns.fetch_add(1, std::memory_order_relaxed); }, &counter);
+				}
+				jobSystem.Wait(counter);
+			}).averageMilliseconds;
+		isValid &= Check(emptyRuns == EMPTY_JOB_COUNT, "empty jobs");
+
+		// Jobs spawning jobs
+		std::atomic<uint32_t> visited{ 0 };
+		const uint32_t treeJobCount = (2u << TREE_DEPTH) - 1;
+		double treeMilliseconds = MeasureTiming([&]()
+			{
+				JobCounter counter;
+				jobSystem.Submit([&]() { SpawnTree(jobSystem, counter, visited, TREE_DEPTH); }, &counter);
+				jobSystem.Wait(counter);
+			}).averageMilliseconds;
+		isValid &= Check(visited == treeJobCount, "job tree");
+
+		// Each stage only starts once the previous one is done
+		std::atomic<uint32_t> stageErrors{ 0 };
+		std::atomic<uint32_t> completed{ 0 };
+		double stageMilliseconds = MeasureTiming([&]()
+			{
+				std::vector<JobCounter> counters(STAGE_COUNT);
+				for (uint32_t stage = 0; stage < STAGE_COUNT; ++stage)
+				{
+					JobCounter* dependency = stage > 0 ? &counters[stage - 1] : nullptr;
+					for (uint32_t i = 0; i < JOBS_PER_STAGE; ++i)
+					{
+						jobSystem.Submit([&completed, &stageErrors, stage]()
+							{
+								if (completed.load() < stage * JOBS_PER_STAGE)
+								{
+									stageErrors.fetch_add(1);
+								}
+								completed.fetch_add(1);
+							}, &counters[stage], dependency);
+					}
+				}
+
+				// Waiting on each counter in turn, so none is destroyed while a job of its stage is still finishing
+				for (JobCounter& counter : counters)
+				{
+					jobSystem.Wait(counter);
+				}
+			}).averageMilliseconds;
+		isValid &= Check(stageErrors == 0 && completed == STAGE_COUNT * JOBS_PER_STAGE, "dependent stages");
+
+		// ParallelFor against the serial loop
+		double speedups[3];
+		const uint32_t grainSizes[3] = { 256, 4096, 65536 };
+		for (int g = 0; g < 3; ++g)
+		{
+			std::fill(output.begin(), output.end(), 0.0f);
+			double milliseconds = MeasureTiming([&]()
+				{
+					jobSystem.ParallelFor(ELEMENT_COUNT, grainSizes[g], [&](uint32_t begin, uint32_t end) { Process(input, output, begin, end); });
+				}).averageMilliseconds;
+			isValid &= Check(output == expected, "ParallelFor");
+			speedups[g] = serialMilliseconds / milliseconds;
+		}
+
+		double stolenPercent = 100.0 * jobSystem.GetStolenJobCount() / std::max<uint64_t>(1, jobSystem.GetExecutedJobCount());
+		std::printf("%8u %16.2f %16.2f %16.2f %14.2f %14.2f %14.2f %14.1f\n", workerCount,
+			EMPTY_JOB_COUNT / emptyMilliseconds / 1000.0,
+			treeJobCount / treeMilliseconds / 1000.0,
+			STAGE_COUNT * JOBS_PER_STAGE / stageMilliseconds / 1000.0,
+			speedups[0], speedups[1], speedups[2], stolenPercent);
+	}
+
+	return isValid ? 0 : 1;
+}
@@ -0,0 +1,231 @@
+// Compares loading the same mesh from OBJ, glTF (.gltf with an external .bin, and .glb) and the binary mesh format.
+// Each load ends with the vertices and indices copied into a buffer standing in for the mapped staging ring of the
+// UploadService, which is where Model copies them from. The files are read once before timing, so every format is
+// measured with the file in the OS cache and the numbers compare the parsing, not the disk.
+// Every import is checked against the generated mesh; the program exits with 1 if one differs.
+
+#include "../Source/MeshFile.hpp"
+#include "../Source/MeshImporter.hpp"
+#include "BenchmarkMeshes.hpp"
+#include "BenchmarkTiming.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace DaisyEngine;
+
+namespace
+{
+	constexpr uint32_t GRID_SIZE = 400; // Quads per side, 161k vertices: the indices need 32 bits
+	constexpr uint32_t SUBMESH_COUNT = 4;
+	constexpr int ITERATIONS = 5;
+
+	// A height field split in horizontal bands of rows
+	Model::Builder CreateGrid()
+	{
+		Model::Builder builder = CreateBenchmarkHeightField(GRID_SIZE, 0.1f);
+		const uint32_t submeshIndexCount = GRID_SIZE / SUBMESH_COUNT * GRID_SIZE * 6;
+		for (uint32_t submesh = 0; submesh < SUBMESH_COUNT; ++submesh)
+		{
+			builder.submeshes.push_back({ submesh * submeshIndexCount, submeshIndexCount });
+		}
+		return builder;
+	}
+
+	void WriteObj(const std::string& path, const Model::Builder& builder)
+	{
+		FILE* file = std::fopen(path.c_str(), "w");
+		for (const Model::Vertex& vertex : builder.vertices)
+		{
+			// 9 significant digits round trip a float exactly
+			std::fprintf(file, "v %.9g %.9g %.9g %.9g %.9g %.9g\n", vertex.position.x, vertex.position.y, vertex.position.z,
+				vertex.color.x, vertex.color.y, vertex.color.z);
+		}
+
+		for (size_t submesh = 0; submesh < builder.submeshes.size(); ++submesh)
+		{
+			std::fprintf(file, "g band%zu\n", submesh);
+			const Model::Submesh& range = builder.submeshes[submesh];
+			for (uint32_t i = range.firstIndex; i < range.firstIndex + range.indexCount; i += 3)
+			{
+				std::fprintf(file, "f %u %u %u\n", builder.indices[i] + 1, builder.indices[i + 1] + 1, builder.indices[i + 2] + 1);
+			}
+		}
+		std::fclose(file);
+	}
+
+	// A single primitive: the importer gives every primitive its own copy of the vertices, sharing them between submeshes
+	// would make the glTF loads copy several times the data of the others
+	std::string CreateGltfJson(const Model::Builder& builder, const std::string& bufferUri, size_t bufferSize)
+	{
+		const size_t vertexBytes = builder.vertices.size() * sizeof(Model::Vertex);
+		std::string json = "{\"asset\":{\"version\":\"2.0\"},\"buffers\":[{";
+		if (!bufferUri.empty())
+		{
+			json += "\"uri\":\"" + bufferUri + "\",";
+		}
+		json += "\"byteLength\":" + std::to_string(bufferSize) + "}],";
+
+		json += "\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":" + std::to_string(vertexBytes) + ",\"byteStride\":"
+			+ std::to_string(sizeof(Model::Vertex)) + "},{\"buffer\":0,\"byteOffset\":" + std::to_string(vertexBytes)
+			+ ",\"byteLength\":" + std::to_string(builder.indices.size() * sizeof(uint32_t)) + "}],";
+
+		json += "\"accessors\":[{\"bufferView\":0,\"byteOffset\":0,\"componentType\":5126,\"count\":" + std::to_string(builder.vertices.size())
+			+ ",\"type\":\"VEC3\",\"min\":[-0.5,-0.1,-0.5],\"max\":[0.5,0.1,0.5]},"
+			+ "{\"bufferView\":0,\"byteOffset\":12,\"componentType\":5126,\"count\":" + std::to_string(builder.vertices.size()) + ",\"type\":\"VEC3\"},"
+			+ "{\"bufferView\":1,\"byteOffset\":0,\"componentType\":5125,\"count\":" + std::to_string(builder.indices.size()) + ",\"type\":\"SCALAR\"}],";
+
+		json += "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"COLOR_0\":1},\"indices\":2}]}]}";
+		return json;
+	}
+
+	void WriteGltf(const std::string& gltfPath, const std::string& binaryPath, const std::string& binaryName, const std::string& glbPath,
+		const Model::Builder& builder)
+	{
+		std::vector<char> buffer(builder.vertices.size() * sizeof(Model::Vertex) + builder.indices.size() * sizeof(uint32_t));
+		memcpy(buffer.data(), builder.vertices.data(), builder.vertices.size() * sizeof(Model::Vertex));
+		memcpy(buffer.data() + builder.vertices.size() * sizeof(Model::Vertex), builder.indices.data(), builder.indices.size() * sizeof(uint32_t));
+
+		std::ofstream(gltfPath, std::ios::binary) << CreateGltfJson(builder, binaryName, buffer.size());
+		std::ofstream(binaryPath, std::ios::binary).write(buffer.data(), buffer.size());
+
+		// Same document in a binary container, the JSON chunk padded with spaces to 4 bytes
+		std::string json = CreateGltfJson(builder, "", buffer.size());
+		json.resize((json.size() + 3) & ~size_t(3), ' ');
+		uint32_t header[3] = { 0x46546C67, 2, static_cast<uint32_t>(12 + 8 + json.size() + 8 + buffer.size()) };
+		uint32_t jsonChunk[2] = { static_cast<uint32_t>(json.size()), 0x4E4F534A };
+		uint32_t binaryChunk[2] = { static_cast<uint32_t>(buffer.size()), 0x004E4942 };
+
+		std::ofstream glb(glbPath, std::ios::binary);
+		glb.write(reinterpret_cast<const char*>(header), sizeof(header));
+		glb.write(reinterpret_cast<const char*>(jsonChunk), sizeof(jsonChunk));
+		glb.write(json.data(), json.size());
+		glb.write(reinterpret_cast<const char*>(binaryChunk), sizeof(binaryChunk));
+		glb.write(buffer.data(), buffer.size());
+	}
+
+	// What Model does with a builder: 16 bit indices when possible, then vertices and indices copied to the staging memory
+	size_t CopyToStaging(const Model::Builder& builder, std::vector<uint8_t>& staging)
+	{
+		size_t vertexBytes = builder.vertices.size() * sizeof(Model::Vertex);
+		memcpy(staging.data(), builder.vertices.data(), vertexBytes);
+
+		if (builder.vertices.size() <= Model::MAX_UINT16_VERTEX_COUNT)
+		{
+			std::vector<uint16_t> shortIndices(builder.indices.begin(), builder.indices.end());
+			memcpy(staging.data() + vertexBytes, shortIndices.data(), shortIndices.size() * sizeof(uint16_t));
+			return vertexBytes + shortIndices.size() * sizeof(uint16_t);
+		}
+
+		memcpy(staging.data() + vertexBytes, builder.indices.data(), builder.indices.size() * sizeof(uint32_t));
+		return vertexBytes + builder.indices.size() * sizeof(uint32_t);
+	}
+
+	bool IsSameMesh(const Model::Builder& a, const Model::Builder& b)
+	{
+		return a.vertices == b.vertices && a.indices == b.indices;
+	}
+
+	// Welded the way the converter welds, every importer must then produce the reference
+	bool CheckImport(Model::Builder builder, const Model::Builder& reference, bool hasSubmeshes, const char* name)
+	{
+		builder.WeldVertices();
+
+		bool isValid = IsSameMesh(builder, reference) && builder.submeshes.size() == (hasSubmeshes ? reference.submeshes.size() : 0);
+		for (size_t i = 0; isValid && hasSubmeshes && i < builder.submeshes.size(); ++i)
+		{
+			isValid = builder.submeshes[i].firstIndex == reference.submeshes[i].firstIndex
+				&& builder.submeshes[i].indexCount == reference.submeshes[i].indexCount;
+		}
+
+		if (!isValid)
+		{
+			std::printf("%s import differs from the generated mesh: FAILED\n", name);
+		}
+		return isValid;
+	}
+}
+
+int main()
+{
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "DaisyMeshLoadBenchmark";
+	std::filesystem::create_directories(directory);
+	const std::string objPath = (directory / "grid.obj").string();
+	const std::string gltfPath = (directory / "grid.gltf").string();
+	const std::string binaryPath = (directory / "grid.bin").string();
+	const std::string glbPath = (directory / "grid.glb").string();
+	const std::string meshPath = (directory / "grid.dmesh").string();
+
+	Model::Builder reference = CreateGrid();
+	WriteObj(objPath, reference);
+	WriteGltf(gltfPath, binaryPath, "grid.bin", glbPath, reference);
+	reference.WeldVertices();
+	MeshFile::Write(meshPath, reference);
+
+	bool isValid = true;
+	isValid &= CheckImport(ImportObj(objPath), reference, true, "OBJ");
+	isValid &= CheckImport(ImportGltf(gltfPath), reference, false, "glTF");
+	isValid &= CheckImport(ImportGltf(glbPath), reference, false, "GLB");
+
+	std::vector<uint8_t> staging(reference.vertices.size() * sizeof(Model::Vertex) + reference.indices.size() * sizeof(uint32_t));
+	{
+		// Same bytes as the reference would upload
+		MeshFile meshFile{ meshPath };
+		size_t referenceBytes = CopyToStaging(reference, staging);
+		std::vector<uint8_t> expected(staging.begin(), staging.begin() + referenceBytes);
+
+		size_t vertexBytes = meshFile.GetVertexCount() * sizeof(Model::Vertex);
+		size_t indexBytes = static_cast<size_t>(meshFile.GetIndexCount()) * meshFile.GetIndexSize();
+		bool isSame = vertexBytes + indexBytes == referenceBytes && meshFile.GetSubmeshCount() == reference.submeshes.size()
+			&& memcmp(meshFile.GetVertices(), expected.data(), vertexBytes) == 0
+			&& memcmp(meshFile.GetIndices(), expected.data() + vertexBytes, indexBytes) == 0;
+		if (!isSame)
+		{
+			std::printf("Mesh file differs from the generated mesh: FAILED\n");
+		}
+		isValid &= isSame;
+	}
+
+	if (!isValid)
+	{
+		return 1;
+	}
+
+	size_t payloadBytes = 0;
+	double objMilliseconds = MeasureTiming([&]() { payloadBytes = CopyToStaging(ImportObj(objPath), staging); }, ITERATIONS).fastestMilliseconds;
+	double gltfMilliseconds = MeasureTiming([&]() { CopyToStaging(ImportGltf(gltfPath), staging); }, ITERATIONS).fastestMilliseconds;
+	double glbMilliseconds = MeasureTiming([&]() { CopyToStaging(ImportGltf(glbPath), staging); }, ITERATIONS).fastestMilliseconds;
+	double meshMilliseconds = MeasureTiming([&]()
+		{
+			MeshFile meshFile{ meshPath };
+			size_t vertexBytes = meshFile.GetVertexCount() * sizeof(Model::Vertex);
+			memcpy(staging.data(), meshFile.GetVertices(), vertexBytes);
+			memcpy(staging.data() + vertexBytes, meshFile.GetIndices(), static_cast<size_t>(meshFile.GetIndexCount()) * meshFile.GetIndexSize());
+		}, ITERATIONS).fastestMilliseconds;
+
+	auto fileMegabytes = [](const std::string& path) { return std::filesystem::file_size(path) / (1024.0 * 1024.0); };
+	auto print = [&](const char* name, double fileSize, double milliseconds)
+		{
+			std::printf("%-14s %14.2f %12.2f %14.0f %9.1fx\n", name, fileSize, milliseconds,
+				payloadBytes / (1024.0 * 1024.0) / (milliseconds / 1000.0), objMilliseconds / milliseconds);
+		};
+
+	std::printf("%zu vertices, %zu indices, %zu submeshes, best of %d loads\n", reference.vertices.size(), reference.indices.size(),
+		reference.submeshes.size(), ITERATIONS);
+	std::printf("%-14s %14s %12s %14s %10s\n", "format", "file (MB)", "load (ms)", "upload (MB/s)", "speedup");
+	print("OBJ", fileMegabytes(objPath), objMilliseconds);
+	print("glTF + .bin", fileMegabytes(gltfPath) + fileMegabytes(binaryPath), gltfMilliseconds);
+	print("GLB", fileMegabytes(glbPath), glbMilliseconds);
+	print("mesh file", fileMegabytes(meshPath), meshMilliseconds);
+
+	std::error_code error;
+	std::filesystem::remove_all(directory, error);
+	return 0;
+}
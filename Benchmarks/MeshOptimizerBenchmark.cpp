@@ -0,0 +1,223 @@
+// Runs OptimizeMesh on meshes in the order an exporter may leave them: a grid and nested spheres with shuffled triangles and
+// vertices, and the built in primitives merged with a submesh each. Reports the simulated vertex cache (ACMR, ATVR), vertex
+// fetch and overdraw before and after, with the optimization time.
+// Exits with 1 if a mesh loses or changes a triangle, a triangle leaves its submesh, or the cache or fetch get worse.
+// The overdraw is reported only, the view independent order trades it against the cache and cannot promise it for every mesh.
+
+#include "../Source/MeshOptimizer.hpp"
+#include "../Source/Primitives.hpp"
+#include "BenchmarkMeshes.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DaisyEngine;
+
+namespace
+{
+	constexpr uint32_t GRID_SIZE = 200; // Quads per side
+	constexpr uint32_t SHELL_COUNT = 4; // Nested spheres, each hidden by the next one out
+	constexpr uint32_t SHELL_SEGMENTS = 96;
+	constexpr uint32_t SHELL_RINGS = 48;
+	constexpr float FETCH_TOLERANCE = 1.05f; // A mesh already in row order may give a little fetch locality to the cache order
+
+	/// <summary>
+	/// A triangle by the contents of its vertices, rotated to start at its smallest corner so the winding is kept.
+	/// </summary>
+	using TriangleKey = std::array<Model::Vertex, 3>;
+
+	bool IsLess(const Model::Vertex& a, const Model::Vertex& b)
+	{
+		return std::memcmp(&a, &b, sizeof(Model::Vertex)) < 0;
+	}
+
+	std::vector<TriangleKey> GetTriangles(const Model::Builder& builder, uint32_t firstIndex, uint32_t indexCount)
+	{
+		std::vector<TriangleKey> triangles;
+		for (uint32_t i = firstIndex; i + 2 < firstIndex + indexCount; i += 3)
+		{
+			TriangleKey triangle{ builder.vertices[builder.indices[i]], builder.vertices[builder.indices[i + 1]], builder.vertices[builder.indices[i + 2]] };
+			auto first = std::min_element(triangle.begin(), triangle.end(), IsLess);
+			std::rotate(triangle.begin(), first, triangle.end());
+			triangles.push_back(triangle);
+		}
+
+		std::sort(triangles.begin(), triangles.end(), [](const TriangleKey& a, const TriangleKey& b)
+			{
+				return std::memcmp(a.data(), b.data(), sizeof(TriangleKey)) < 0;
+			});
+		return triangles;
+	}
+
+	bool HasSameTriangles(const std::vector<TriangleKey>& a, const std::vector<TriangleKey>& b)
+	{
+		return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(TriangleKey)) == 0;
+	}
+
+	// Shuffles the triangles and renumbers the vertices at random, the worst order for both caches
+	void Shuffle(Model::Builder& builder, std::mt19937& rng)
+	{
+		std::vector<std::array<uint32_t, 3>> triangles(builder.indices.size() / 3);
+		std::memcpy(triangles.data(), builder.indices.data(), builder.indices.size() * sizeof(uint32_t));
+		std::shuffle(triangles.begin(), triangles.end(), rng);
+		std::memcpy(builder.indices.data(), triangles.data(), builder.indices.size() * sizeof(uint32_t));
+
+		std::vector<uint32_t> remap(builder.vertices.size());
+		std::iota(remap.begin(), remap.end(), 0u);
+		std::shuffle(remap.begin(), remap.end(), rng);
+
+		std::vector<Model::Vertex> vertices(builder.vertices.size());
+		for (size_t i = 0; i < remap.size(); ++i)
+		{
+			vertices[remap[i]] = builder.vertices[i];
+		}
+		builder.vertices.swap(vertices);
+		for (uint32_t& index : builder.indices)
+		{
+			index = remap[index];
+		}
+	}
+
+	// Closed spheres one inside the other, the inner ones invisible from every view once the outer one is drawn
+	Model::Builder CreateShells()
+	{
+		Model::Builder builder{};
+		for (uint32_t shell = 0; shell < SHELL_COUNT; ++shell)
+		{
+			float radius = 0.2f + 0.3f * static_cast<float>(shell) / SHELL_COUNT;
+			uint32_t firstVertex = static_cast<uint32_t>(builder.vertices.size());
+			for (uint32_t ring = 0; ring <= SHELL_RINGS; ++ring)
+			{
+				float polar = 3.14159265f * ring / SHELL_RINGS;
+				for (uint32_t segment = 0; segment <= SHELL_SEGMENTS; ++segment)
+				{
+					float azimuth = 6.28318531f * segment / SHELL_SEGMENTS;
+					glm::vec3 normal{ std::sin(polar) * std::cos(azimuth), -std::cos(polar), std::sin(polar) * std::sin(azimuth) };
+					builder.vertices.push_back({ normal * radius, glm::vec3{ static_cast<float>(shell) / SHELL_COUNT } });
+				}
+			}
+
+			for (uint32_t ring = 0; ring < SHELL_RINGS; ++ring)
+			{
+				for (uint32_t segment = 0; segment < SHELL_SEGMENTS; ++segment)
+				{
+					uint32_t a = firstVertex + ring * (SHELL_SEGMENTS + 1) + segment;
+					uint32_t b = a + SHELL_SEGMENTS + 1;
+					builder.indices.insert(builder.indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+				}
+			}
+		}
+		return builder;
+	}
+
+	Model::Builder CreatePrimitiveStack()
+	{
+		Model::Builder stack{};
+		for (uint32_t i = 0; i < PRIMITIVE_COUNT; ++i)
+		{
+			Model::Builder part = CreatePrimitive(static_cast<Primitive>(i));
+			uint32_t firstVertex = static_cast<uint32_t>(stack.vertices.size());
+			stack.submeshes.push_back({ static_cast<uint32_t>(stack.indices.size()), static_cast<uint32_t>(part.indices.size()) });
+			for (Model::Vertex vertex : part.vertices)
+			{
+				vertex.position.y += static_cast<float>(i);
+				stack.vertices.push_back(vertex);
+			}
+			for (uint32_t index : part.indices)
+			{
+				stack.indices.push_back(firstVertex + index);
+			}
+		}
+		return stack;
+	}
+
+	bool Run(const char* name, Model::Builder builder)
+	{
+		std::vector<Model::Submesh> parts = builder.submeshes;
+		if (parts.empty())
+		{
+			parts.push_back({ 0, static_cast<uint32_t>(builder.indices.size()) });
+		}
+
+		std::vector<std::vector<TriangleKey>> trianglesBefore;
+		for (const Model::Submesh& part : parts)
+		{
+			trianglesBefore.push_back(GetTriangles(builder, part.firstIndex, part.indexCount));
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		MeshOptimizationStats stats = OptimizeMesh(builder);
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		std::printf("%-16s %8zu %6.3f -> %5.3f %6.3f -> %5.3f %6.2f -> %5.2f %6.3f -> %5.3f %10.1f\n", name, builder.indices.size() / 3,
+			stats.cacheBefore.acmr, stats.cacheAfter.acmr, stats.cacheBefore.atvr, stats.cacheAfter.atvr,
+			stats.fetchBefore.overfetch, stats.fetchAfter.overfetch, stats.overdrawBefore.overdraw, stats.overdrawAfter.overdraw, milliseconds);
+
+		bool isValid = true;
+		for (size_t i = 0; i < parts.size(); ++i)
+		{
+			if (!HasSameTriangles(trianglesBefore[i], GetTriangles(builder, parts[i].firstIndex, parts[i].indexCount)))
+			{
+				std::printf("%s submesh %zu does not hold the same triangles: FAILED\n", name, i);
+				isValid = false;
+			}
+		}
+
+		if (stats.cacheAfter.acmr > stats.cacheBefore.acmr || stats.fetchAfter.overfetch > stats.fetchBefore.overfetch * FETCH_TOLERANCE)
+		{
+			std::printf("%s got worse: FAILED\n", name);
+			isValid = false;
+		}
+		return isValid;
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(42);
+
+	Model::Builder grid = CreateBenchmarkHeightField(GRID_SIZE, 0.05f);
+	Model::Builder shells = CreateShells();
+	Model::Builder shuffledGrid = grid;
+	Model::Builder shuffledShells = shells;
+	Model::Builder shuffledStack = CreatePrimitiveStack();
+	Shuffle(shuffledGrid, rng);
+	Shuffle(shuffledShells, rng);
+
+	// Only the vertices are shuffled, the submeshes keep their triangles
+	std::vector<uint32_t> stackRemap(shuffledStack.vertices.size());
+	std::iota(stackRemap.begin(), stackRemap.end(), 0u);
+	std::shuffle(stackRemap.begin(), stackRemap.end(), rng);
+	std::vector<Model::Vertex> stackVertices(shuffledStack.vertices.size());
+	for (size_t i = 0; i < stackRemap.size(); ++i)
+	{
+		stackVertices[stackRemap[i]] = shuffledStack.vertices[i];
+	}
+	shuffledStack.vertices.swap(stackVertices);
+	for (uint32_t& index : shuffledStack.indices)
+	{
+		index = stackRemap[index];
+	}
+
+	std::printf("Vertex cache of %u entries, fetch in %u lines of %u bytes, overdraw over 6 views of %ux%u\n",
+		VERTEX_CACHE_SIZE, VERTEX_FETCH_LINE_COUNT, VERTEX_FETCH_LINE_SIZE, OVERDRAW_GRID_SIZE, OVERDRAW_GRID_SIZE);
+	std::printf("%-16s %8s %14s %14s %14s %14s %10s\n", "mesh", "tris", "ACMR", "ATVR", "overfetch", "overdraw", "time (ms)");
+
+	bool isValid = true;
+	isValid &= Run("grid", grid);
+	isValid &= Run("grid shuffled", shuffledGrid);
+	isValid &= Run("shells", shells);
+	isValid &= Run("shells shuffled", shuffledShells);
+	isValid &= Run("primitives", shuffledStack);
+
+	return isValid ? 0 : 1;
+}
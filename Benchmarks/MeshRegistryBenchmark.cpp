@@ -0,0 +1,182 @@
+// Builds an instancing heavy scene, every object drawing one of the built in primitives or one of a few copies of the same
+// mesh file, once with a model per object and once through the MeshRegistry. Reports the creation time and the vertex and
+// index buffer memory of both, with the hit rate of the registry.
+// Exits with 1 if the registry shares different geometry, duplicates identical geometry or miscounts what it saved.
+
+#include "../Source/Device.hpp"
+#include "../Source/MeshFile.hpp"
+#include "../Source/MeshRegistry.hpp"
+
+// std
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DaisyEngine;
+
+namespace
+{
+	constexpr uint32_t OBJECT_COUNT = 4096;
+	constexpr uint32_t MESH_FILE_COPIES = 4; // Same content under different names, as assets duplicated across folders are
+
+	VkDeviceSize GetSize(const Model::Builder& builder)
+	{
+		VkDeviceSize indexSize = builder.vertices.size() <= Model::MAX_UINT16_VERTEX_COUNT ? sizeof(uint16_t) : sizeof(uint32_t);
+		return builder.vertices.size() * sizeof(Model::Vertex) + builder.indices.size() * indexSize;
+	}
+
+	Model::Builder CreateProp()
+	{
+		// A stack of the primitives, merged in one mesh with a submesh each
+		Model::Builder prop{};
+		for (uint32_t i = 0; i < PRIMITIVE_COUNT; ++i)
+		{
+			Model::Builder part = CreatePrimitive(static_cast<Primitive>(i));
+			uint32_t firstVertex = static_cast<uint32_t>(prop.vertices.size());
+			prop.submeshes.push_back({ static_cast<uint32_t>(prop.indices.size()), static_cast<uint32_t>(part.indices.size()) });
+			for (Model::Vertex vertex : part.vertices)
+			{
+				vertex.position.y += static_cast<float>(i);
+				prop.vertices.push_back(vertex);
+			}
+			for (uint32_t index : part.indices)
+			{
+				prop.indices.push_back(firstVertex + index);
+			}
+		}
+		return prop;
+	}
+}
+
+int main()
+{
+	Device device{};
+
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "DaisyMeshRegistryBenchmark";
+	std::filesystem::create_directories(directory);
+
+	Model::Builder prop = CreateProp();
+	std::vector<std::string> propPaths;
+	for (uint32_t i = 0; i < MESH_FILE_COPIES; ++i)
+	{
+		propPaths.push_back((directory / ("prop" + std::to_string(i) + ".dmesh")).string());
+		MeshFile::Write(propPaths.back(), prop);
+	}
+
+	// Each object draws a random primitive, or the prop from one of its files
+	std::mt19937 rng(42);
+	std::vector<int> objectMeshes(OBJECT_COUNT);
+	for (int& mesh : objectMeshes)
+	{
+		mesh = rng() % (PRIMITIVE_COUNT + 1);
+	}
+
+	std::vector<Model::Builder> primitives;
+	for (uint32_t i = 0; i < PRIMITIVE_COUNT; ++i)
+	{
+		primitives.push_back(CreatePrimitive(static_cast<Primitive>(i)));
+	}
+
+	// A model per object, the way CreateCubeModel is used
+	VkDeviceSize unsharedBytes = 0;
+	double unsharedMilliseconds = 0.0;
+	{
+		std::vector<std::unique_ptr<Model>> models;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < OBJECT_COUNT; ++i)
+		{
+			if (objectMeshes[i] == static_cast<int>(PRIMITIVE_COUNT))
+			{
+				models.push_back(Model::LoadFromFile(device, propPaths[rng() % MESH_FILE_COPIES]));
+				unsharedBytes += GetSize(prop);
+			}
+			else
+			{
+				models.push_back(std::make_unique<Model>(device, CreatePrimitive(static_cast<Primitive>(objectMeshes[i]))));
+				unsharedBytes += GetSize(primitives[objectMeshes[i]]);
+			}
+		}
+		device.GetUploadService().WaitIdle();
+		unsharedMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	bool isValid = true;
+	double sharedMilliseconds = 0.0;
+	MeshRegistryStats stats{};
+	{
+		MeshRegistry registry{ device };
+		std::vector<Model*> models;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < OBJECT_COUNT; ++i)
+		{
+			models.push_back(objectMeshes[i] == static_cast<int>(PRIMITIVE_COUNT)
+				? registry.Load(propPaths[rng() % MESH_FILE_COPIES])
+				: registry.GetPrimitive(static_cast<Primitive>(objectMeshes[i])));
+		}
+		device.GetUploadService().WaitIdle();
+		sharedMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		// One model per distinct mesh, whatever the path or the way it was requested
+		std::vector<Model*> meshModels(PRIMITIVE_COUNT + 1, nullptr);
+		for (uint32_t i = 0; i < OBJECT_COUNT; ++i)
+		{
+			Model*& meshModel = meshModels[objectMeshes[i]];
+			if (meshModel == nullptr)
+			{
+				meshModel = models[i];
+			}
+			else if (meshModel != models[i])
+			{
+				std::printf("Object %u duplicates the mesh of an earlier object: FAILED\n", i);
+				isValid = false;
+			}
+		}
+
+		for (size_t i = 0; i < meshModels.size(); ++i)
+		{
+			for (size_t j = i + 1; j < meshModels.size(); ++j)
+			{
+				if (meshModels[i] != nullptr && meshModels[i] == meshModels[j])
+				{
+					std::printf("Meshes %zu and %zu share a model: FAILED\n", i, j);
+					isValid = false;
+				}
+			}
+		}
+
+		// The builder and the file it was converted to are the same geometry
+		Model* propModel = registry.GetOrCreate(prop);
+		for (uint32_t i = 0; i < OBJECT_COUNT; ++i)
+		{
+			if (objectMeshes[i] == static_cast<int>(PRIMITIVE_COUNT) && models[i] != propModel)
+			{
+				std::printf("The prop builder and its mesh file have different models: FAILED\n");
+				isValid = false;
+				break;
+			}
+		}
+
+		stats = registry.GetStats();
+		if (stats.hitCount + stats.missCount != OBJECT_COUNT + 1 || stats.residentBytes + stats.savedBytes != unsharedBytes + GetSize(prop))
+		{
+			std::printf("Registry stats do not add up to the requests: FAILED\n");
+			isValid = false;
+		}
+	}
+
+	const double kilobyte = 1024.0;
+	std::printf("%u objects, %u primitives and %u copies of a %.1f KB mesh file\n", OBJECT_COUNT, PRIMITIVE_COUNT, MESH_FILE_COPIES,
+		GetSize(prop) / kilobyte);
+	std::printf("%-18s %12s %14s\n", "", "create (ms)", "buffers (KB)");
+	std::printf("%-18s %12.2f %14.1f\n", "model per object", unsharedMilliseconds, unsharedBytes / kilobyte);
+	std::printf("%-18s %12.2f %14.1f\n", "mesh registry", sharedMilliseconds, stats.residentBytes / kilobyte);
+	std::printf("%u unique meshes, %.2f%% hits, %.1f KB saved\n", stats.meshCount, stats.GetHitRate() * 100.0, stats.savedBytes / kilobyte);
+
+	std::error_code error;
+	std::filesystem::remove_all(directory, error);
+	return isValid ? 0 : 1;
+}
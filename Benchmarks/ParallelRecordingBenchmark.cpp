@@ -0,0 +1,76 @@
+// Measures how the CPU recording time of SimpleRenderSystem's per object path scales with the number of recording threads.
+// The single threaded row records inline into the primary command buffer, the others record secondary command buffers.
+
+#include "../Source/Window.hpp"
+#include "../Source/Device.hpp"
+#include "../Source/Renderer.hpp"
+#include "../Source/JobSystem.hpp"
+#include "../Source/Model.hpp"
+#include "../Source/ParallelCommandRecorder.hpp"
+#include "../Source/SimpleRenderSystem.hpp"
+#include "BenchmarkScene.hpp"
+
+// std
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace DaisyEngine;
+
+namespace
+{
+	constexpr size_t OBJECT_COUNT = 100000;
+}
+
+int main()
+{
+	Window window{ 800, 600, "Daisy Engine - Parallel recording benchmark" };
+	Device device{ window };
+
+	// The renderer's own recorder is not used, each row below records with a job system of its size
+	JobSystem rendererJobSystem{ 1 };
+	Renderer renderer{ window, device, rendererJobSystem };
+
+	Model::Builder builder{};
+	builder.vertices = {
+		{{0.0f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+		{{0.5f, 0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+		{{-0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+	};
+	std::unique_ptr<Model> model = std::make_unique<Model>(device, builder);
+	device.GetUploadService().WaitIdle();
+
+	SimpleRenderSystem renderSystem{ device, renderer.GetSwapChainRenderPass(), SimpleRenderSystem::RenderMode::PerObject };
+	World world;
+	CreateBenchmarkEntities(world, { model.get() }, OBJECT_COUNT);
+	RenderQuery& entities = world.GetQuery<Transform, RenderComponent>();
+	auto record = [&](FrameInfo& frameInfo) { renderSystem.RenderEntities(frameInfo, entities); };
+
+	double singleThreaded = MeasureFrames(renderer, {}, nullptr, record);
+
+	std::printf("%zu objects\n", OBJECT_COUNT);
+	std::printf("%10s %20s %10s\n", "threads", "recording (us)", "speedup");
+	std::printf("%10s %20.1f %9.1fx\n", "inline", singleThreaded, 1.0);
+
+	renderSystem.SetRenderMode(SimpleRenderSystem::RenderMode::Parallel);
+	uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	for (uint32_t workerCount = 1; workerCount <= hardwareThreads; workerCount *= 2)
+	{
+		JobSystem jobSystem{ workerCount };
+		ParallelCommandRecorder commandRecorder{ device, jobSystem };
+
+		BenchmarkFrameOptions options{};
+		options.commandRecorder = &commandRecorder;
+		options.subpassContents = renderSystem.GetSubpassContents();
+		double parallel = MeasureFrames(renderer, options, nullptr, record);
+
+		std::printf("%10u %20.1f %9.1fx\n", workerCount, parallel, singleThreaded / parallel);
+
+		// The recorder's command pools may still be in use by the frames in flight
+		vkDeviceWaitIdle(device.GetDevice());
+	}
+
+	vkDeviceWaitIdle(device.GetDevice());
+	return 0;
+}
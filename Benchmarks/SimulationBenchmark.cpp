@@ -0,0 +1,182 @@
+// Checks that the fixed timestep simulation moves at the same speed whatever the frame rate, then measures what running it on
+// its own thread saves the main thread.
+// - Accuracy: entities rotate at a constant speed, frames come at several fixed and jittered rates. Every frame the interpolated
+//   rotation must match the analytic one at the render time, one step behind real time.
+// - Throughput: a heavy step and a render pass reading the interpolated view, one step per frame, inline and threaded.
+// The program exits with 1 if an interpolated state or a step count is off.
+
+#include "../Source/Simulation.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DaisyEngine;
+
+namespace
+{
+	constexpr float ROTATION_SPEED = 2.0f; // Radians per second, wraps around several times during the run
+	constexpr double RUN_SECONDS = 10.0;
+	constexpr size_t ACCURACY_ENTITY_COUNT = 1000;
+	constexpr float TOLERANCE = 1e-3f;
+
+	constexpr size_t THROUGHPUT_ENTITY_COUNT = 100000;
+	constexpr int THROUGHPUT_FRAMES = 120;
+
+	void Populate(World& world, size_t count)
+	{
+		// Stands in for a loaded model, never dereferenced
+		static int model = 0;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			Entity entity = world.CreateEntity();
+			Transform& transform = world.AddComponent<Transform>(entity);
+			transform.translation = { static_cast<float>(i), 0.0f, 0.0f };
+			world.AddComponent<RenderComponent>(entity, { reinterpret_cast<Model*>(&model), {} });
+		}
+	}
+
+	void Rotate(World& world, float timestep)
+	{
+		for (Transform& transform : world.GetPool<Transform>())
+		{
+			transform.rotation.y = glm::mod<float>(transform.rotation.y + ROTATION_SPEED * timestep, glm::two_pi<float>());
+		}
+	}
+
+	// Many arithmetic operations per entity, so the step costs about as much as a real one would
+	void HeavyStep(World& world, float timestep)
+	{
+		for (Transform& transform : world.GetPool<Transform>())
+		{
+			float angle = transform.rotation.y + ROTATION_SPEED * timestep;
+			for (int i = 0; i < 8; ++i)
+			{
+				angle += 0.001f * std::sin(angle) * std::cos(angle);
+			}
+			transform.rotation.y = glm::mod<float>(angle, glm::two_pi<float>());
+			transform.translation.y = std::sin(transform.rotation.y);
+		}
+	}
+
+	// What the renderer reads of every entity
+	float RenderPass(const RenderView& view)
+	{
+		float sum = 0.0f;
+		for (size_t i = 0; i < view.Size(); ++i)
+		{
+			sum += view.transforms[i].mat4()[3][1];
+		}
+		return sum;
+	}
+
+	float AngleError(float angle, float expected)
+	{
+		return std::fabs(std::remainder(angle - expected, glm::two_pi<float>()));
+	}
+
+	// frameSeconds gives the duration of each frame
+	template<typename FrameDuration>
+	bool CheckAccuracy(const char* name, FrameDuration frameSeconds)
+	{
+		World world;
+		Populate(world, ACCURACY_ENTITY_COUNT);
+		Simulation simulation{ world, Rotate };
+
+		double time = 0.0;
+		float maxError = 0.0f;
+		uint32_t frameCount = 0;
+		while (time < RUN_SECONDS)
+		{
+			double elapsed = frameSeconds();
+			time += elapsed;
+			simulation.Advance(elapsed);
+			RenderView view = simulation.Interpolate();
+
+			float expected = ROTATION_SPEED * static_cast<float>(std::max(0.0, time - simulation.GetTimestep()));
+			for (size_t i = 0; i < view.Size(); ++i)
+			{
+				maxError = std::max(maxError, AngleError(view.transforms[i].rotation.y, expected));
+			}
+			frameCount++;
+		}
+
+		double expectedSteps = time / simulation.GetTimestep();
+		bool isValid = maxError <= TOLERANCE && std::fabs(expectedSteps - static_cast<double>(simulation.GetStepCount())) < 1.0;
+		std::printf("%-16s %8u %8llu %14.2e %s\n", name, frameCount, static_cast<unsigned long long>(simulation.GetStepCount()), maxError,
+			isValid ? "OK" : "FAILED");
+		return isValid;
+	}
+
+	// Average main thread milliseconds per frame. A simulation thread slower than the frames falls behind, stepCount tells by how much
+	double MeasureFrames(bool isThreaded, float& checksum, uint64_t& stepCount)
+	{
+		World world;
+		Populate(world, THROUGHPUT_ENTITY_COUNT);
+		Simulation simulation{ world, HeavyStep };
+		if (isThreaded)
+		{
+			simulation.StartThread();
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int frame = 0; frame < THROUGHPUT_FRAMES; ++frame)
+		{
+			simulation.Advance(simulation.GetTimestep());
+			checksum += RenderPass(simulation.Interpolate());
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+
+		stepCount = simulation.GetStepCount();
+		simulation.StopThread();
+		return std::chrono::duration<double, std::milli>(end - start).count() / THROUGHPUT_FRAMES;
+	}
+}
+
+int main()
+{
+	bool isValid = true;
+
+	std::printf("%-16s %8s %8s %14s\n", "frame rate", "frames", "steps", "max error");
+	for (double hertz : { 30.0, 60.0, 75.0, 144.0, 240.0 })
+	{
+		char name[32];
+		std::snprintf(name, sizeof(name), "%.0f Hz", hertz);
+		isValid &= CheckAccuracy(name, [hertz]() { return 1.0 / hertz; });
+	}
+
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<double> jitter(1.0 / 200.0, 1.0 / 40.0);
+	isValid &= CheckAccuracy("40 to 200 Hz", [&]() { return jitter(rng); });
+
+	// A one second stall must not be caught up all at once
+	{
+		World world;
+		Populate(world, 1);
+		Simulation simulation{ world, Rotate };
+		simulation.Advance(1.0);
+		bool isClamped = simulation.GetStepCount() == Simulation::MAX_STEPS_BEHIND;
+		std::printf("%-16s %8s %8llu %14s %s\n", "1 s stall", "1", static_cast<unsigned long long>(simulation.GetStepCount()), "",
+			isClamped ? "OK" : "FAILED");
+		isValid &= isClamped;
+	}
+
+	float checksum = 0.0f;
+	uint64_t inlineSteps = 0;
+	uint64_t threadedSteps = 0;
+	double inlineMilliseconds = MeasureFrames(false, checksum, inlineSteps);
+	double threadedMilliseconds = MeasureFrames(true, checksum, threadedSteps);
+
+	std::printf("\n%zu entities, %d frames of one step each (checksum %.1f)\n", THROUGHPUT_ENTITY_COUNT, THROUGHPUT_FRAMES, checksum);
+	std::printf("%-16s %16s %10s %8s\n", "simulation", "frame (ms)", "speedup", "steps");
+	std::printf("%-16s %16.3f %9.1fx %8llu\n", "inline", inlineMilliseconds, 1.0, static_cast<unsigned long long>(inlineSteps));
+	std::printf("%-16s %16.3f %9.1fx %8llu\n", "own thread", threadedMilliseconds, inlineMilliseconds / threadedMilliseconds,
+		static_cast<unsigned long long>(threadedSteps));
+
+	return isValid ? 0 : 1;
+}
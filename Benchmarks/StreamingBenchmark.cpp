@@ -0,0 +1,197 @@
+// Walks a camera along a row of unique meshes, streamed by the MeshStreamer under a budget of a quarter of their total size,
+// and compares it with loading every mesh up front. Frames are paced at 60 Hz, each one resolves the entities, treats the
+// resident ones near the camera as visible and updates the streamer, as the application does.
+// Reports the time until the first view is complete, the cost of Update, the frames showing a hole near the camera, and
+// exits with 1 if the resident memory ever exceeds the budget or the meshes around the camera are not resident at the end.
+
+#include "../Source/Device.hpp"
+#include "../Source/MeshFile.hpp"
+#include "../Source/MeshStreamer.hpp"
+#include "../Source/Primitives.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DaisyEngine;
+
+namespace
+{
+	constexpr uint32_t MESH_COUNT = 48;
+	constexpr float MESH_SPACING = 2.0f;
+	constexpr float VIEW_DISTANCE = 5.0f; // Entities closer than this to the camera count as visible
+	constexpr int FRAME_COUNT = 240;
+	constexpr double FRAME_SECONDS = 1.0 / 60.0;
+
+	double Median(std::vector<double> samples)
+	{
+		std::sort(samples.begin(), samples.end());
+		return samples.empty() ? 0.0 : samples[samples.size() / 2];
+	}
+}
+
+int main()
+{
+	Device device{};
+
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "DaisyStreamingBenchmark";
+	std::filesystem::create_directories(directory);
+
+	std::vector<std::string> paths;
+	for (uint32_t i = 0; i < MESH_COUNT; ++i)
+	{
+		paths.push_back((directory / ("mesh" + std::to_string(i) + ".dmesh")).string());
+		MeshFile::Write(paths.back(), CreatePlane(64 + (i * 37) % 160));
+	}
+
+	// Everything loaded on the main thread before the first frame, the way LoadEntities used to work
+	VkDeviceSize totalBytes = 0;
+	double synchronousMilliseconds = 0.0;
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		std::vector<std::unique_ptr<Model>> models;
+		for (const std::string& path : paths)
+		{
+			models.push_back(Model::LoadFromFile(device, path));
+		}
+		device.GetUploadService().WaitIdle();
+		auto end = std::chrono::high_resolution_clock::now();
+		synchronousMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+		for (const std::string& path : paths)
+		{
+			MeshFile meshFile{ path };
+			totalBytes += static_cast<VkDeviceSize>(meshFile.GetVertexCount()) * sizeof(Model::Vertex)
+				+ static_cast<VkDeviceSize>(meshFile.GetIndexCount()) * meshFile.GetIndexSize();
+		}
+	}
+
+	const VkDeviceSize budget = totalBytes / 4;
+	bool isValid = true;
+
+	std::vector<double> updateMicroseconds;
+	uint32_t framesWithHoles = 0;
+	double firstCompleteViewMilliseconds = -1.0;
+	VkDeviceSize maxResidentBytes = 0;
+	StreamingStats stats{};
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		MeshStreamer streamer{ device, budget };
+
+		std::vector<Transform> transforms(MESH_COUNT);
+		std::vector<RenderComponent> renderComponents(MESH_COUNT);
+		for (uint32_t i = 0; i < MESH_COUNT; ++i)
+		{
+			transforms[i].translation = { i * MESH_SPACING, 0.0f, 0.0f };
+			renderComponents[i].mesh = streamer.Register(paths[i]);
+		}
+		RenderView entities{ transforms.data(), renderComponents.data(), MESH_COUNT };
+
+		// The camera walks the row once, from the first mesh to the last
+		glm::vec3 cameraPosition{ 0.0f, 1.0f, 0.0f };
+		std::vector<uint32_t> visibleEntities;
+		auto frameStart = std::chrono::steady_clock::now();
+
+		for (int frame = 0; frame <= FRAME_COUNT; ++frame)
+		{
+			cameraPosition.x = (MESH_COUNT - 1) * MESH_SPACING * static_cast<float>(frame) / FRAME_COUNT;
+			streamer.Resolve(entities);
+
+			visibleEntities.clear();
+			bool hasHole = false;
+			for (uint32_t i = 0; i < MESH_COUNT; ++i)
+			{
+				if (std::fabs(transforms[i].translation.x - cameraPosition.x) < VIEW_DISTANCE)
+				{
+					if (renderComponents[i].model != nullptr)
+					{
+						visibleEntities.push_back(i);
+					}
+					hasHole |= renderComponents[i].model == nullptr;
+				}
+			}
+
+			framesWithHoles += hasHole ? 1 : 0;
+			if (!hasHole && firstCompleteViewMilliseconds < 0.0)
+			{
+				firstCompleteViewMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			}
+
+			auto updateStart = std::chrono::high_resolution_clock::now();
+			streamer.Update(entities, visibleEntities, cameraPosition);
+			auto updateEnd = std::chrono::high_resolution_clock::now();
+			updateMicroseconds.push_back(std::chrono::duration<double, std::micro>(updateEnd - updateStart).count());
+
+			// The renderer flushes the pending uploads at the start of each frame
+			device.GetUploadService().Flush();
+
+			maxResidentBytes = std::max(maxResidentBytes, streamer.GetStats().residentBytes);
+			frameStart += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(FRAME_SECONDS));
+			std::this_thread::sleep_until(frameStart);
+		}
+
+		// Settled at the end of the row: once the last requests are loaded and uploaded, every mesh around the camera is resident
+		for (uint32_t settle = 0; settle < MESH_COUNT; ++settle)
+		{
+			streamer.Resolve(entities);
+			visibleEntities.clear();
+			for (uint32_t i = 0; i < MESH_COUNT; ++i)
+			{
+				if (std::fabs(transforms[i].translation.x - cameraPosition.x) < VIEW_DISTANCE && renderComponents[i].model != nullptr)
+				{
+					visibleEntities.push_back(i);
+				}
+			}
+
+			// The far meshes stay queued for want of budget, the walk has settled once an update starts no load
+			uint64_t loadCount = streamer.GetStats().loadCount;
+			streamer.Update(entities, visibleEntities, cameraPosition);
+			streamer.WaitIdle();
+			maxResidentBytes = std::max(maxResidentBytes, streamer.GetStats().residentBytes);
+			if (settle > 0 && streamer.GetStats().loadCount == loadCount)
+			{
+				break;
+			}
+		}
+
+		device.GetUploadService().Flush();
+		device.GetUploadService().WaitIdle();
+		for (uint32_t i = 0; i < MESH_COUNT; ++i)
+		{
+			if (std::fabs(transforms[i].translation.x - cameraPosition.x) < VIEW_DISTANCE && !streamer.IsResident(renderComponents[i].mesh))
+			{
+				std::printf("Mesh %u near the camera is not resident at the end of the walk: FAILED\n", i);
+				isValid = false;
+			}
+		}
+
+		stats = streamer.GetStats();
+	}
+
+	if (maxResidentBytes > budget)
+	{
+		std::printf("Resident memory reached %llu bytes over a budget of %llu: FAILED\n",
+			static_cast<unsigned long long>(maxResidentBytes), static_cast<unsigned long long>(budget));
+		isValid = false;
+	}
+
+	const double megabyte = 1024.0 * 1024.0;
+	std::printf("%u meshes, %.1f MB of vertices and indices, budget %.1f MB\n", MESH_COUNT, totalBytes / megabyte, budget / megabyte);
+	std::printf("Synchronous load of every mesh: %.2f ms before the first frame\n", synchronousMilliseconds);
+	std::printf("Streaming: first complete view after %.2f ms, %u/%d frames with a hole near the camera\n",
+		firstCompleteViewMilliseconds, framesWithHoles, FRAME_COUNT + 1);
+	std::printf("Update: median %.1f us, max %.1f us\n", Median(updateMicroseconds),
+		*std::max_element(updateMicroseconds.begin(), updateMicroseconds.end()));
+	std::printf("Peak resident %.1f MB, %llu loads, %llu evictions\n", maxResidentBytes / megabyte,
+		static_cast<unsigned long long>(stats.loadCount), static_cast<unsigned long long>(stats.evictionCount));
+
+	std::error_code error;
+	std::filesystem::remove_all(directory, error);
+	return isValid ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+// Compares Transform::mat4() called per object with the batched structure of arrays kernel, for every instruction set the CPU supports.
+// Before timing, each path is checked against Transform::mat4(); the program exits with 1 if a matrix is out of tolerance.
+
+#include "../Source/Transform.hpp"
+#include "../Source/TransformBatch.hpp"
+#include "../Source/TransformStore.hpp"
+#include "BenchmarkTiming.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DaisyEngine;
+
+namespace
+{
+	constexpr size_t TRANSFORM_COUNT = 100000;
+	constexpr int ITERATIONS = 50;
+
+	// Relative to the magnitude of the element, the vectorized sincos is accurate to a few ulps
+	constexpr float TOLERANCE = 1e-5f;
+
+	// Same layout as SimpleRenderSystem::InstanceData, so the kernel is timed with its real output stride
+	struct InstanceData
+	{
+		glm::mat4 transform{ 1.0f };
+	};
+
+	bool CheckAccuracy(const std::vector<Transform>& transforms, const std::vector<InstanceData>& instances, const char* name)
+	{
+		float maxError = 0.0f;
+		for (size_t i = 0; i < transforms.size(); ++i)
+		{
+			glm::mat4 expected = Transform{ transforms[i] }.mat4();
+			for (int column = 0; column < 4; ++column)
+			{
+				for (int row = 0; row < 4; ++row)
+				{
+					float reference = expected[column][row];
+					float error = std::fabs(instances[i].transform[column][row] - reference) / std::max(1.0f, std::fabs(reference));
+					maxError = std::max(maxError, error);
+				}
+			}
+		}
+
+		bool isAccurate = maxError <= TOLERANCE;
+		std::printf("%-8s max relative error %.3g %s\n", name, maxError, isAccurate ? "OK" : "FAILED");
+		return isAccurate;
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> scale(0.1f, 3.0f);
+	std::uniform_real_distribution<float> angle(0.0f, glm::two_pi<float>());
+
+	std::vector<Transform> transforms(TRANSFORM_COUNT);
+	TransformStore store;
+	for (Transform& transform : transforms)
+	{
+		transform.translation = { position(rng), position(rng), position(rng) };
+		transform.scale = { scale(rng), scale(rng), scale(rng) };
+		transform.rotation = { angle(rng), angle(rng), angle(rng) };
+		store.Add(transform);
+	}
+
+	std::vector<InstanceData> instances(TRANSFORM_COUNT);
+
+	// Every level the CPU supports, from scalar to the best one
+	bool isAccurate = true;
+	for (int level = 0; level <= static_cast<int>(GetSimdLevel()); ++level)
+	{
+		std::fill(instances.begin(), instances.end(), InstanceData{});
+		ComputeTransformMatrices(static_cast<SimdLevel>(level), store, 0, TRANSFORM_COUNT, &instances[0].transform, sizeof(InstanceData));
+		isAccurate &= CheckAccuracy(transforms, instances, GetSimdLevelName(static_cast<SimdLevel>(level)));
+	}
+
+	if (!isAccurate)
+	{
+		return 1;
+	}
+
+	double perObject = MeasureTiming([&]()
+		{
+			for (size_t i = 0; i < TRANSFORM_COUNT; ++i)
+			{
+				instances[i].transform = transforms[i].mat4();
+			}
+		}, ITERATIONS, 1).GetAverageMicroseconds();
+
+	std::printf("\n%zu transforms\n", TRANSFORM_COUNT);
+	std::printf("%-12s %16s %10s\n", "path", "time (us)", "speedup");
+	std::printf("%-12s %16.1f %9.1fx\n", "mat4()", perObject, 1.0);
+
+	for (int level = 0; level <= static_cast<int>(GetSimdLevel()); ++level)
+	{
+		SimdLevel simdLevel = static_cast<SimdLevel>(level);
+		double batched = MeasureTiming([&]()
+			{
+				ComputeTransformMatrices(simdLevel, store, 0, TRANSFORM_COUNT, &instances[0].transform, sizeof(InstanceData));
+			}, ITERATIONS, 1).GetAverageMicroseconds();
+
+		std::printf("%-12s %16.1f %9.1fx\n", GetSimdLevelName(simdLevel), batched, perObject / batched);
+	}
+
+	return 0;
+}
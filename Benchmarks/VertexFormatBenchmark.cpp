@@ -0,0 +1,129 @@
+// Encodes a dense sphere in the quantized vertex format and compares its memory and vertex fetch with Model::Vertex, the
+// two layouts the pipelines read. The fetch is what one draw of the mesh reads from the vertex buffer, each unique vertex
+// once as with a perfect post transform cache.
+// Every vertex is decoded back and checked against the precision of its format, along with the generated descriptions;
+// the program exits with 1 if one is off.
+
+#include "../Source/Model.hpp"
+#include "../Source/VertexFormat.hpp"
+#include "BenchmarkTiming.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+using namespace DaisyEngine;
+
+namespace
+{
+	constexpr uint32_t SEGMENTS = 256;
+	constexpr uint32_t RINGS = 128; // 33k vertices, 16 bit indices
+	constexpr float SPHERE_RADIUS = 3.0f;
+	constexpr uint32_t ITERATIONS = 10;
+
+	Model::Builder CreateSphere()
+	{
+		Model::Builder builder{};
+		for (uint32_t ring = 0; ring <= RINGS; ++ring)
+		{
+			float polar = 3.14159265f * ring / RINGS;
+			for (uint32_t segment = 0; segment <= SEGMENTS; ++segment)
+			{
+				float azimuth = 6.28318531f * segment / SEGMENTS;
+				glm::vec3 normal{ std::sin(polar) * std::cos(azimuth), -std::cos(polar), std::sin(polar) * std::sin(azimuth) };
+
+				// Off center, so the box of the mesh is not symmetric around the origin
+				builder.vertices.push_back({ normal * SPHERE_RADIUS + glm::vec3{ 10.0f, -2.0f, 5.0f }, normal * 0.5f + glm::vec3{ 0.5f } });
+			}
+		}
+
+		for (uint32_t ring = 0; ring < RINGS; ++ring)
+		{
+			for (uint32_t segment = 0; segment < SEGMENTS; ++segment)
+			{
+				uint32_t a = ring * (SEGMENTS + 1) + segment;
+				uint32_t b = a + SEGMENTS + 1;
+				builder.indices.insert(builder.indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+			}
+		}
+		return builder;
+	}
+
+	bool CheckDescriptions()
+	{
+		std::vector<VkVertexInputBindingDescription> bindings = Model::GetBindingDescriptions(VertexFormat::Quantized);
+		std::vector<VkVertexInputAttributeDescription> attributes = Model::GetAttributeDescriptions(VertexFormat::Quantized);
+		bool isValid = bindings.size() == 1 && bindings[0].stride == sizeof(QuantizedVertex) && attributes.size() == 2
+			&& attributes[0].location == 0 && attributes[0].format == VK_FORMAT_R16G16B16A16_SNORM
+			&& attributes[1].location == 1 && attributes[1].format == VK_FORMAT_R8G8B8A8_UNORM && attributes[1].offset == 8;
+
+		std::vector<VkVertexInputAttributeDescription> floatAttributes = Model::Vertex::GetAttributeDescriptions();
+		isValid = isValid && floatAttributes.size() == 2 && floatAttributes[1].offset == offsetof(Model::Vertex, color)
+			&& Model::Vertex::GetBindingDescriptions()[0].stride == sizeof(Model::Vertex);
+
+		if (!isValid)
+		{
+			std::printf("Generated descriptions do not match the vertex types: FAILED\n");
+		}
+		return isValid;
+	}
+
+	void PrintLayout(const char* name, uint32_t stride, uint32_t fetchSize, size_t vertexCount, double encodeMilliseconds)
+	{
+		const double kilobyte = 1024.0;
+		std::printf("%-16s %8u %10u %12.1f", name, stride, fetchSize, vertexCount * fetchSize / kilobyte);
+		if (encodeMilliseconds >= 0.0)
+		{
+			std::printf(" %12.3f", encodeMilliseconds);
+		}
+		std::printf("\n");
+	}
+}
+
+int main()
+{
+	bool isValid = CheckDescriptions();
+
+	Model::Builder sphere = CreateSphere();
+	const size_t vertexCount = sphere.vertices.size();
+
+	std::vector<QuantizedVertex> vertices;
+	PositionQuantization quantization{};
+	double encodeMilliseconds = MeasureTiming([&]() { quantization = Model::QuantizeVertices(sphere, vertices); }, ITERATIONS).averageMilliseconds;
+
+	// Each attribute within half a step of its format, plus float rounding
+	const glm::vec3 positionTolerance = quantization.scale * (0.5f / 32767.0f) + glm::vec3{ 1e-5f };
+	const float colorTolerance = 0.5f / 255.0f + 1e-6f;
+
+	float maxPositionError = 0.0f;
+	for (size_t i = 0; i < vertexCount && isValid; ++i)
+	{
+		VertexAttributes decoded = DequantizeVertex(vertices[i], quantization);
+		glm::vec3 positionError = glm::abs(decoded.position - sphere.vertices[i].position);
+		glm::vec3 colorError = glm::abs(decoded.color - sphere.vertices[i].color);
+		maxPositionError = std::max({ maxPositionError, positionError.x, positionError.y, positionError.z });
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (positionError[axis] > positionTolerance[axis] || colorError[axis] > colorTolerance)
+			{
+				std::printf("Vertex %zu position or color decodes too far: FAILED\n", i);
+				isValid = false;
+			}
+		}
+	}
+
+	std::printf("%zu vertices, %zu indices\n", vertexCount, sphere.indices.size());
+	std::printf("%-16s %8s %10s %12s %12s\n", "layout", "stride", "fetch (B)", "fetch (KB)", "encode (ms)");
+	PrintLayout("Model::Vertex", POSITION_COLOR_VERTEX_LAYOUT.GetStride(), POSITION_COLOR_VERTEX_LAYOUT.GetFetchSize(), vertexCount, -1.0);
+	PrintLayout("quantized", QUANTIZED_VERTEX_LAYOUT.GetStride(), QUANTIZED_VERTEX_LAYOUT.GetFetchSize(), vertexCount, encodeMilliseconds);
+	std::printf("quantized vs Model::Vertex: %.1f%% of the memory and fetch\n",
+		100.0 * QUANTIZED_VERTEX_LAYOUT.GetFetchSize() / POSITION_COLOR_VERTEX_LAYOUT.GetFetchSize());
+	std::printf("max position error %.2e (box half extent %.2f)\n", maxPositionError,
+		std::max({ quantization.scale.x, quantization.scale.y, quantization.scale.z }));
+
+	return isValid ? 0 : 1;
+}
@@ -1,7 +1,61 @@
 #version 450
 
+#ifndef VERTEX_PULLING
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 color;
+#endif
+
+#ifdef INSTANCED
+// Per instance data, a mat4 input takes locations 2 to 5
+layout(location = 2) in mat4 instanceTransform;
+#endif
+
+#ifdef GPU_DRIVEN
+// Written by GpuDrivenRenderSystem, the first instance of each draw is the range of its mesh in the visible object list
+struct ObjectData
+{
+    mat4 transform;
+    vec4 boundingSphere;
+    uint meshIndex;
+};
+
+struct MeshData
+{
+    uint firstInstance;
+    uint commandOffset;
+    uint commandCount;
+    uint objectCount;
+    vec4 positionScale; // Quantized positions are snorm in the box of their mesh, identity for float positions
+    vec4 positionBias;
+    uint vertexFormat; // VertexFormat
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer ObjectBuffer { ObjectData objects[]; };
+layout(std430, set = 0, binding = 1) readonly buffer MeshBuffer { MeshData meshes[]; };
+layout(std430, set = 0, binding = 3) readonly buffer VisibleObjectBuffer { uint visibleObjects[]; };
+#endif
+
+#ifdef VERTEX_PULLING
+// The vertex buffer of the MeshArena, vertices of every format side by side. gl_VertexIndex already includes the vertex
+// offset of the mesh, which counts vertices of its own format
+layout(std430, set = 0, binding = 10) readonly buffer VertexBuffer { uint vertexWords[]; };
+
+void FetchVertex(uint vertexFormat, out vec3 position, out vec3 color)
+{
+    if (vertexFormat == 0u) // PositionColor, two float vec3
+    {
+        uint base = uint(gl_VertexIndex) * 6u;
+        position = uintBitsToFloat(uvec3(vertexWords[base], vertexWords[base + 1u], vertexWords[base + 2u]));
+        color = uintBitsToFloat(uvec3(vertexWords[base + 3u], vertexWords[base + 4u], vertexWords[base + 5u]));
+    }
+    else // Quantized, 16 bit snorm position then RGBA8 unorm color
+    {
+        uint base = uint(gl_VertexIndex) * 3u;
+        position = vec3(unpackSnorm2x16(vertexWords[base]), unpackSnorm2x16(vertexWords[base + 1u]).x);
+        color = unpackUnorm4x8(vertexWords[base + 2u]).rgb;
+    }
+}
+#endif
 
 layout(location = 0) out vec3 fragColor;
 
@@ -9,10 +63,29 @@ layout(push_constant) uniform Push
 {
     mat4 transform;
     vec3 color;
+    vec4 positionScale; // Quantized positions are snorm in the box of their mesh, identity for float positions
+    vec4 positionBias;
 }push;
 
 void main() 
 {
-    gl_Position = push.transform * vec4(position, 1.0);
+#ifdef GPU_DRIVEN
+    ObjectData object = objects[visibleObjects[gl_InstanceIndex]];
+    MeshData mesh = meshes[object.meshIndex];
+#ifdef VERTEX_PULLING
+    vec3 position;
+    vec3 color;
+    FetchVertex(mesh.vertexFormat, position, color);
+#endif
+    vec3 localPosition = position * mesh.positionScale.xyz + mesh.positionBias.xyz;
+    gl_Position = object.transform * vec4(localPosition, 1.0);
+#else
+    vec3 localPosition = position * push.positionScale.xyz + push.positionBias.xyz;
+#ifdef INSTANCED
+    gl_Position = instanceTransform * vec4(localPosition, 1.0);
+#else
+    gl_Position = push.transform * vec4(localPosition, 1.0);
+#endif
+#endif
     fragColor = color;
-}
\ No newline at end of file
+}
@@ -1,4 +1,5 @@
 #include "Application.hpp"
+#include "CpuProfiler.hpp"
 
 // Libs
 #define GLM_FORCE_RADIANS
@@ -7,128 +8,395 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 // std
+#include <algorithm>
 #include <stdexcept>
 #include <array>
-
-// ImGUI
-#include <imgui.h>
-#include <imgui_impl_vulkan.h>
-#include <imgui_impl_glfw.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
 
 namespace DaisyEngine
 {
-	static void check_vk_result(VkResult err)
+	Application::Application(const ApplicationOptions& options)
+		: _options(options)
 	{
-		if (err == 0)
+		if (_options.headless)
+		{
+			// No window means GLFW is never initialized, this runs on machines without a display
+			_device = std::make_unique<Device>();
+			_renderer = std::make_unique<Renderer>(*_device, _jobSystem, VkExtent2D{ WIDTH, HEIGHT });
+
+			if (_options.frameCount == 0)
+			{
+				_options.frameCount = DEFAULT_HEADLESS_FRAME_COUNT;
+			}
+		}
+		else
 		{
-			return;
+			_window = std::make_unique<Window>(WIDTH, HEIGHT, "Daisy Engine");
+			_device = std::make_unique<Device>(*_window);
+			_renderer = std::make_unique<Renderer>(*_window, *_device, _jobSystem);
 		}
 
-		fprintf(stderr, "[Vulkan] Error : VkResult = %d\n", err);
-		
-		if (err < 0)
+		if (_options.meshArena)
 		{
-			abort();
+			_meshArena = std::make_unique<MeshArena>(*_device);
 		}
-	}
+		_meshRegistry = std::make_unique<MeshRegistry>(*_device, _options.vertexFormat, _meshArena.get());
 
-	Application::Application()
-	{
-		LoadGameObjects();
+		VkDeviceSize meshBudget = _options.meshBudgetMegabytes == 0 ? MeshStreamer::DEFAULT_BUDGET : _options.meshBudgetMegabytes * 1024ull * 1024ull;
+		_meshStreamer = std::make_unique<MeshStreamer>(*_device, meshBudget);
+
+		LoadEntities();
+		_simulation = std::make_unique<Simulation>(_world, [this](World&, float timestep) { UpdateEntities(timestep); });
 	}
 
 	Application::~Application() {}
 
 	void Application::Run()
 	{
-		SimpleRenderSystem simpleRenderSystem{ _device, _renderer.GetSwapChainRenderPass() };
+		SimpleRenderSystem simpleRenderSystem{ *_device, _renderer->GetSwapChainRenderPass(), _options.renderMode };
+
+		std::unique_ptr<GpuDrivenRenderSystem> gpuDrivenRenderSystem;
+		if (_options.gpuDriven)
+		{
+			uint32_t entityCount = static_cast<uint32_t>(_world.GetQuery<Transform, RenderComponent>().Size());
+			gpuDrivenRenderSystem = std::make_unique<GpuDrivenRenderSystem>(*_device, _renderer->GetSwapChainRenderPass(),
+				std::max(entityCount, GpuDrivenRenderSystem::DEFAULT_MAX_OBJECT_COUNT), _meshArena.get(), _options.vertexPulling);
+			gpuDrivenRenderSystem->SetOcclusionCulling(_options.occlusionCulling);
+		}
+
+		// The GPU driven path culls on the GPU, the CPU culling is then only kept to prioritize the streamed meshes
+		const bool cullOnCpu = gpuDrivenRenderSystem == nullptr || !_options.streamedMeshPaths.empty();
+		const VkSubpassContents subpassContents = gpuDrivenRenderSystem != nullptr ? VK_SUBPASS_CONTENTS_INLINE : simpleRenderSystem.GetSubpassContents();
+
+		const PipelineCacheStats& cacheStats = _device->GetPipelineCacheStats();
+		std::cout << "Created " << cacheStats.pipelineCount << " pipeline(s) in " << cacheStats.creationMilliseconds
+			<< " ms with a " << (cacheStats.isWarm ? "warm" : "cold") << " pipeline cache" << std::endl;
+
+		const MeshRegistryStats& registryStats = _meshRegistry->GetStats();
+		std::cout << "Mesh registry: " << registryStats.meshCount << " unique mesh(es), " << registryStats.GetHitRate() * 100.0
+			<< "% hits over " << registryStats.hitCount + registryStats.missCount << " request(s), "
+			<< registryStats.savedBytes / 1024 << " KB saved" << std::endl;
 
-		while (!_window.ShouldClose())
+		if (_meshArena != nullptr)
 		{
-			glfwPollEvents();
+			MeshArenaStats arenaStats = _meshArena->GetStats();
+			std::cout << "Mesh arena: " << arenaStats.meshCount << " mesh(es), " << arenaStats.vertexBytes / 1024 << "/"
+				<< arenaStats.vertexCapacity / 1024 << " KB of vertices, " << arenaStats.indexBytes / 1024 << "/"
+				<< arenaStats.indexCapacity / 1024 << " KB of indices" << std::endl;
+		}
+
+		std::unique_ptr<GpuProfilerOverlay> gpuProfilerOverlay;
+		if (_options.showGpuProfiler && _window != nullptr)
+		{
+			gpuProfilerOverlay = std::make_unique<GpuProfilerOverlay>(*_window, *_device, _renderer->GetSwapChainRenderPass(),
+				static_cast<uint32_t>(_renderer->GetImageCount()));
+		}
+
+		auto lastStatsTime = std::chrono::steady_clock::now();
+		auto lastFrameTime = lastStatsTime;
+		uint32_t frameCount = 0;
+
+		DAISY_PROFILE_THREAD("Main thread");
+		if (!_options.tracePath.empty())
+		{
+			DAISY_PROFILE_BEGIN_CAPTURE();
+		}
+
+		if (_options.simulationThread)
+		{
+			_simulation->StartThread();
+		}
+
+		while (ShouldRun(frameCount))
+		{
+			DAISY_PROFILE_FRAME();
+
+			if (_window != nullptr)
+			{
+				DAISY_PROFILE_ZONE("glfwPollEvents");
+				glfwPollEvents();
+			}
+
+			auto frameTime = std::chrono::steady_clock::now();
+			double elapsedSeconds = _renderer->IsHeadless() ? _simulation->GetTimestep() : std::chrono::duration<double>(frameTime - lastFrameTime).count();
+			lastFrameTime = frameTime;
+			{
+				DAISY_PROFILE_ZONE("Advance simulation");
+				_simulation->Advance(elapsedSeconds);
+			}
+
+			// The render thread's own copy of the world, the simulation thread can step on while it is culled and recorded
+			RenderView renderedEntities = _simulation->Interpolate();
+			_meshStreamer->Resolve(renderedEntities);
+
+			// No camera yet, the transforms go straight to clip space
+			const std::vector<uint32_t>* visibleObjects = &_frustumCuller.GetVisibleObjects();
+			if (cullOnCpu)
+			{
+				DAISY_PROFILE_ZONE("Frustum culling");
+				visibleObjects = &_frustumCuller.Cull(glm::mat4{ 1.0f }, renderedEntities, &_jobSystem);
+			}
+
+			// The GPU driven path draws every object at full detail
+			const bool selectLods = _options.lod && gpuDrivenRenderSystem == nullptr;
+			if (selectLods)
+			{
+				DAISY_PROFILE_ZONE("LOD selection");
+				_lodSelector.Select(glm::mat4{ 1.0f }, _renderer->GetSwapChainExtent(), renderedEntities, *visibleObjects, &_jobSystem);
+			}
+
+			// Every entity rotates, so every object is uploaded again; a static scene would only update the ones that move
+			if (gpuDrivenRenderSystem != nullptr)
+			{
+				DAISY_PROFILE_ZONE("Update GPU objects");
+				gpuDrivenRenderSystem->SetEntities(renderedEntities, &_jobSystem);
+			}
 
-			if (VkCommandBuffer commandBuffer = _renderer.BeginFrame())
+			auto now = std::chrono::steady_clock::now();
+			if (now - lastStatsTime >= std::chrono::seconds(1))
 			{
-				_renderer.BeginSwapChainRenderPass(commandBuffer);
-				simpleRenderSystem.RenderGameObjects(commandBuffer, _gameObjects);
-				_renderer.EndSwapChainRenderPass(commandBuffer);
-				_renderer.EndFrame();
+				PrintStats(simpleRenderSystem, gpuDrivenRenderSystem.get());
+				lastStatsTime = now;
 			}
+
+			if (VkCommandBuffer commandBuffer = _renderer->BeginFrame())
+			{
+				FrameInfo frameInfo{ _renderer->GetFrameIndex(), commandBuffer };
+				frameInfo.renderPass = _renderer->GetSwapChainRenderPass();
+				frameInfo.framebuffer = _renderer->GetCurrentFramebuffer();
+				frameInfo.extent = _renderer->GetSwapChainExtent();
+				frameInfo.commandRecorder = &_renderer->GetCommandRecorder();
+				frameInfo.gpuProfiler = &_renderer->GetGpuProfiler();
+				frameInfo.jobSystem = &_jobSystem;
+				frameInfo.lodSelector = selectLods ? &_lodSelector : nullptr;
+
+				if (gpuDrivenRenderSystem != nullptr)
+				{
+					DAISY_PROFILE_ZONE("Record GPU culling");
+					gpuDrivenRenderSystem->Cull(frameInfo, glm::mat4{ 1.0f });
+				}
+
+				{
+					DAISY_PROFILE_ZONE("Record main pass");
+					_renderer->BeginSwapChainRenderPass(commandBuffer, subpassContents);
+					if (gpuDrivenRenderSystem != nullptr)
+					{
+						gpuDrivenRenderSystem->Render(frameInfo);
+					}
+					else
+					{
+						simpleRenderSystem.RenderEntities(frameInfo, renderedEntities, *visibleObjects);
+					}
+
+					// The objects hidden last frame are tested against what was just drawn, the ones that appeared are drawn
+					// in a second pass that keeps the first one's images
+					if (gpuDrivenRenderSystem != nullptr && gpuDrivenRenderSystem->IsOcclusionCullingEnabled())
+					{
+						_renderer->EndSwapChainRenderPass(commandBuffer);
+						DepthPyramid& depthPyramid = _renderer->BuildDepthPyramid(commandBuffer);
+						gpuDrivenRenderSystem->CullOccluded(frameInfo, depthPyramid);
+						_renderer->ResumeSwapChainRenderPass(commandBuffer, subpassContents);
+						gpuDrivenRenderSystem->Render(frameInfo);
+					}
+
+					if (gpuProfilerOverlay != nullptr)
+					{
+						gpuProfilerOverlay->Render(frameInfo, _renderer->GetGpuProfiler(), subpassContents);
+					}
+					_renderer->EndSwapChainRenderPass(commandBuffer);
+				}
+				_renderer->EndFrame();
+				frameCount++;
+			}
+
+			// No camera yet, the viewer stands at the clip space origin
+			_meshStreamer->Update(renderedEntities, *visibleObjects, glm::vec3{ 0.0f });
+			if (_renderer->IsHeadless())
+			{
+				// The meshes requested by a frame are loaded before the next one, captures do not depend on the disk speed
+				_meshStreamer->WaitIdle();
+			}
+		}
+
+		_simulation->StopThread();
+
+		if (!_options.tracePath.empty())
+		{
+			DAISY_PROFILE_END_CAPTURE(_options.tracePath);
 		}
 
-		vkDeviceWaitIdle(_device.GetDevice());
+		if (_renderer->IsHeadless() && !_options.capturePath.empty())
+		{
+			CaptureLastFrame();
+		}
+
+		vkDeviceWaitIdle(_device->GetDevice());
+	}
+
+	void Application::PrintStats(const SimpleRenderSystem& simpleRenderSystem, const GpuDrivenRenderSystem* gpuDrivenRenderSystem)
+	{
+		if (gpuDrivenRenderSystem != nullptr)
+		{
+			const GpuDrivenStats& gpuDrivenStats = gpuDrivenRenderSystem->GetStats();
+			std::cout << "Visible objects (GPU): " << gpuDrivenStats.visibleCount << "/" << gpuDrivenStats.objectCount << ", "
+				<< gpuDrivenStats.meshCount << " mesh(es), " << gpuDrivenStats.commandCount << " indirect command(s) in "
+				<< gpuDrivenStats.drawCallCount << " draw call(s), " << gpuDrivenStats.bindCount << " buffer binding(s), "
+				<< gpuDrivenStats.uploadedObjectCount << " object(s) uploaded, "
+				<< "simulation steps: " << _simulation->GetStepCount() << std::endl;
+			if (gpuDrivenRenderSystem->IsOcclusionCullingEnabled())
+			{
+				std::cout << "Occlusion culling: " << gpuDrivenStats.occludedCount << " object(s) occluded, "
+					<< gpuDrivenStats.lateVisibleCount << " drawn by the late pass" << std::endl;
+			}
+		}
+		else
+		{
+			const CullingStats& cullingStats = _frustumCuller.GetStats();
+			std::cout << "Visible objects: " << cullingStats.visibleCount << ", culled: " << cullingStats.culledCount
+				<< ", simulation steps: " << _simulation->GetStepCount() << std::endl;
+
+			const DrawStateStats& drawStats = simpleRenderSystem.GetStats();
+			std::cout << "Draws: " << drawStats.drawCount << ", binds recorded (skipped): "
+				<< drawStats.pipelineBinds << " (" << drawStats.skippedPipelineBinds << ") pipeline, "
+				<< drawStats.descriptorSetBinds << " (" << drawStats.skippedDescriptorSetBinds << ") descriptor set, "
+				<< drawStats.vertexBufferBinds << " (" << drawStats.skippedVertexBufferBinds << ") vertex buffer, "
+				<< drawStats.indexBufferBinds << " (" << drawStats.skippedIndexBufferBinds << ") index buffer, "
+				<< drawStats.pushConstantUpdates << " (" << drawStats.skippedPushConstantUpdates << ") push constants" << std::endl;
+
+			if (_options.lod)
+			{
+				const LodStats& lodStats = _lodSelector.GetStats();
+				std::cout << "Triangles: " << lodStats.triangleCount << " with LODs, " << lodStats.fullDetailTriangleCount
+					<< " without, objects per LOD:";
+				for (uint32_t objectCount : lodStats.objectsPerLod)
+				{
+					std::cout << " " << objectCount;
+				}
+				std::cout << std::endl;
+			}
+		}
+
+		const StreamingStats& streamingStats = _meshStreamer->GetStats();
+		if (streamingStats.meshCount > 0)
+		{
+			std::cout << "Streamed meshes: " << streamingStats.residentCount << "/" << streamingStats.meshCount << " resident, "
+				<< streamingStats.loadingCount << " loading, " << streamingStats.queuedCount << " queued, "
+				<< streamingStats.residentBytes / (1024 * 1024) << "/" << streamingStats.budgetBytes / (1024 * 1024) << " MB, "
+				<< streamingStats.evictionCount << " evictions" << std::endl;
+		}
+
+		const GpuFrameStats& gpuStats = _renderer->GetGpuProfiler().GetLastFrameStats();
+		for (const GpuScopeStats& scope : gpuStats.scopes)
+		{
+			std::cout << std::string(scope.depth * 2 + 2, ' ') << scope.name << ": " << scope.milliseconds << " ms";
+			if (scope.hasPipelineStatistics)
+			{
+				std::cout << ", " << scope.inputAssemblyPrimitives << " primitives, "
+					<< scope.fragmentShaderInvocations << " fragment invocations";
+			}
+			std::cout << std::endl;
+		}
+	}
+
+	bool Application::ShouldRun(uint32_t frameCount) const
+	{
+		if (_options.frameCount != 0 && frameCount >= _options.frameCount)
+		{
+			return false;
+		}
+
+		return _window == nullptr || !_window->ShouldClose();
+	}
+
+	void Application::CaptureLastFrame()
+	{
+		std::vector<uint8_t> pixels;
+		_renderer->ReadbackLastFrame(pixels);
+
+		const VkExtent2D extent = _renderer->GetSwapChainExtent();
+
+		std::ofstream file(_options.capturePath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			throw std::runtime_error("Failed to open capture file: " + _options.capturePath);
+		}
+
+		// Binary PPM, RGB only: the alpha channel of each RGBA8 pixel is dropped
+		file << "P6\n" << extent.width << " " << extent.height << "\n255\n";
+		for (size_t i = 0; i < pixels.size(); i += 4)
+		{
+			file.write(reinterpret_cast<const char*>(&pixels[i]), 3);
+		}
+
+		std::cout << "Captured frame to " << _options.capturePath << std::endl;
 	}
 
 	// temporary helper function, creates a 1x1x1 cube centered at offset
 	std::unique_ptr<Model> CreateCubeModel(Device& device, glm::vec3 offset)
 	{
-		std::vector<Model::Vertex> vertices{
-
-			// left face (white)
-			{{-.5f, -.5f, -.5f}, {.9f, .9f, .9f}},
-			{{-.5f, .5f, .5f}, {.9f, .9f, .9f}},
-			{{-.5f, -.5f, .5f}, {.9f, .9f, .9f}},
-			{{-.5f, -.5f, -.5f}, {.9f, .9f, .9f}},
-			{{-.5f, .5f, -.5f}, {.9f, .9f, .9f}},
-			{{-.5f, .5f, .5f}, {.9f, .9f, .9f}},
-
-			// right face (yellow)
-			{{.5f, -.5f, -.5f}, {.8f, .8f, .1f}},
-			{{.5f, .5f, .5f}, {.8f, .8f, .1f}},
-			{{.5f, -.5f, .5f}, {.8f, .8f, .1f}},
-			{{.5f, -.5f, -.5f}, {.8f, .8f, .1f}},
-			{{.5f, .5f, -.5f}, {.8f, .8f, .1f}},
-			{{.5f, .5f, .5f}, {.8f, .8f, .1f}},
-
-			// top face (orange, remember y axis points down)
-			{{-.5f, -.5f, -.5f}, {.9f, .6f, .1f}},
-			{{.5f, -.5f, .5f}, {.9f, .6f, .1f}},
-			{{-.5f, -.5f, .5f}, {.9f, .6f, .1f}},
-			{{-.5f, -.5f, -.5f}, {.9f, .6f, .1f}},
-			{{.5f, -.5f, -.5f}, {.9f, .6f, .1f}},
-			{{.5f, -.5f, .5f}, {.9f, .6f, .1f}},
-
-			// bottom face (red)
-			{{-.5f, .5f, -.5f}, {.8f, .1f, .1f}},
-			{{.5f, .5f, .5f}, {.8f, .1f, .1f}},
-			{{-.5f, .5f, .5f}, {.8f, .1f, .1f}},
-			{{-.5f, .5f, -.5f}, {.8f, .1f, .1f}},
-			{{.5f, .5f, -.5f}, {.8f, .1f, .1f}},
-			{{.5f, .5f, .5f}, {.8f, .1f, .1f}},
-
-			// nose face (blue)
-			{{-.5f, -.5f, 0.5f}, {.1f, .1f, .8f}},
-			{{.5f, .5f, 0.5f}, {.1f, .1f, .8f}},
-			{{-.5f, .5f, 0.5f}, {.1f, .1f, .8f}},
-			{{-.5f, -.5f, 0.5f}, {.1f, .1f, .8f}},
-			{{.5f, -.5f, 0.5f}, {.1f, .1f, .8f}},
-			{{.5f, .5f, 0.5f}, {.1f, .1f, .8f}},
-
-			// tail face (green)
-			{{-.5f, -.5f, -0.5f}, {.1f, .8f, .1f}},
-			{{.5f, .5f, -0.5f}, {.1f, .8f, .1f}},
-			{{-.5f, .5f, -0.5f}, {.1f, .8f, .1f}},
-			{{-.5f, -.5f, -0.5f}, {.1f, .8f, .1f}},
-			{{.5f, -.5f, -0.5f}, {.1f, .8f, .1f}},
-			{{.5f, .5f, -0.5f}, {.1f, .8f, .1f}},
-
-		};
-
-		for (Model::Vertex& v : vertices) 
+		Model::Builder builder = CreatePrimitive(Primitive::Cube);
+		for (Model::Vertex& v : builder.vertices) 
 		{
 			v.position += offset;
 		}
 
-		return std::make_unique<Model>(device, vertices);
+		return std::make_unique<Model>(device, builder);
+	}
+
+	void Application::UpdateEntities(float timestep)
+	{
+		ComponentPool<Transform>& transforms = _world.GetPool<Transform>();
+		Transform* data = transforms.Data();
+		const uint32_t count = static_cast<uint32_t>(transforms.Size());
+
+		auto rotate = [data, timestep](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; ++i)
+				{
+					data[i].rotation.y = glm::mod<float>(data[i].rotation.y + ROTATION_SPEED_Y * timestep, glm::two_pi<float>());
+					data[i].rotation.x = glm::mod<float>(data[i].rotation.x + ROTATION_SPEED_X * timestep, glm::two_pi<float>());
+				}
+			};
+
+		// The simulation thread is not a worker of the job system, it updates on its own
+		if (_jobSystem.GetCurrentWorkerIndex() == JobSystem::INVALID_WORKER)
+		{
+			rotate(0, count);
+		}
+		else
+		{
+			_jobSystem.ParallelFor(count, TRANSFORMS_PER_JOB, rotate);
+		}
 	}
 
-	void Application::LoadGameObjects()
+	void Application::LoadEntities()
 	{
-		std::shared_ptr<Model> cubeModel = CreateCubeModel(_device, { 0.f, 0.f, 0.f });
-		GameObject cubeObject = GameObject::Instantiate();
-		cubeObject.model = cubeModel;
-		cubeObject.transform.translation = { 0.f, 0.f, 0.5f };
-		cubeObject.transform.scale = { .5f, .5f, .5f};
-		_gameObjects.push_back(std::move(cubeObject));
+
+		Entity cube = _world.CreateEntity();
+		Transform& transform = _world.AddComponent<Transform>(cube);
+		transform.translation = { 0.f, 0.f, 0.5f };
+		transform.scale = { .5f, .5f, .5f };
+		_world.AddComponent<RenderComponent>(cube, { _meshRegistry->GetPrimitive(Primitive::Cube), {} });
+
+		// Only the headers are read here, the geometry streams in once the frames start
+		const size_t streamedCount = _options.streamedMeshPaths.size();
+		for (size_t i = 0; i < streamedCount; ++i)
+		{
+			MeshHandle mesh = _meshStreamer->Register(_options.streamedMeshPaths[i]);
+			const BoundingSphere& sphere = _meshStreamer->GetBoundingSphere(mesh);
+			float scale = sphere.radius > 0.0f ? STREAMED_MESH_RADIUS / sphere.radius : 1.0f;
+
+			Entity entity = _world.CreateEntity();
+			Transform& meshTransform = _world.AddComponent<Transform>(entity);
+			float x = streamedCount == 1 ? 0.0f : -0.75f + 1.5f * static_cast<float>(i) / static_cast<float>(streamedCount - 1);
+			meshTransform.translation = glm::vec3{ x, 0.5f, 0.5f } - sphere.center * scale;
+			meshTransform.scale = { scale, scale, scale };
+
+			RenderComponent renderComponent{};
+			renderComponent.mesh = mesh;
+			_world.AddComponent<RenderComponent>(entity, renderComponent);
+		}
 	}
 } // namespace DaisyEngine
\ No newline at end of file
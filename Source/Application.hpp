@@ -2,25 +2,70 @@
 
 #include "Window.hpp"
 #include "Device.hpp"
-#include "GameObject.hpp"
+#include "Model.hpp"
+#include "MeshArena.hpp"
+#include "MeshStreamer.hpp"
+#include "MeshRegistry.hpp"
+#include "World.hpp"
+#include "Simulation.hpp"
+#include "Components.hpp"
 #include "Renderer.hpp"
 #include "SimpleRenderSystem.hpp"
+#include "GpuDrivenRenderSystem.hpp"
+#include "FrustumCuller.hpp"
+#include "LodSelector.hpp"
+#include "JobSystem.hpp"
+#include "GpuProfilerOverlay.hpp"
 
 // std
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace DaisyEngine
 {
+	/// <summary>
+	/// The ApplicationOptions struct selects between a window and a headless run, parsed from the command line.
+	/// A frame count of 0 runs until the window is closed, headless runs then fall back to DEFAULT_HEADLESS_FRAME_COUNT.
+	/// Headless runs advance the simulation by exactly one step per frame, so captures do not depend on the frame rate.
+	/// </summary>
+	struct ApplicationOptions
+	{
+		bool headless = false;
+		uint32_t frameCount = 0;
+		std::string capturePath; // Headless only, the last frame is written there as a binary PPM
+		bool showGpuProfiler = false; // ImGui overlay, windowed only
+		std::string tracePath; // When set, CPU profiler zones of the whole run are written there as a Chrome trace
+		bool simulationThread = false; // Steps the simulation on its own thread while the main thread renders
+		std::vector<std::string> streamedMeshPaths; // Mesh files placed side by side and streamed in the background
+		uint32_t meshBudgetMegabytes = 0; // 0 keeps MeshStreamer::DEFAULT_BUDGET
+		VertexFormat vertexFormat = VertexFormat::PositionColor; // Of the meshes built at load, streamed mesh files keep theirs
+		SimpleRenderSystem::RenderMode renderMode = SimpleRenderSystem::RenderMode::Instanced; // When not GPU driven
+		bool gpuDriven = false; // Culls and draws with the GpuDrivenRenderSystem instead of the FrustumCuller and SimpleRenderSystem
+		bool occlusionCulling = false; // Two phase occlusion culling against a depth pyramid, implies gpuDriven
+		bool meshArena = false; // The meshes of the registry share the buffers of one MeshArena
+		bool vertexPulling = false; // The GPU driven vertex shader fetches the vertices from the arena, implies gpuDriven and meshArena
+		bool lod = false; // Draws the meshes that have LODs, like the ones converted with MeshConverter --lod, at a level picked per object. Not GPU driven
+	};
+
+	// Creates a 1x1x1 cube centered at offset, one color per face
+	std::unique_ptr<Model> CreateCubeModel(Device& device, glm::vec3 offset);
+
 	class Application
 	{
 	public:
 		// --- Constants ---
 		static constexpr int WIDTH = 800;
 		static constexpr int HEIGHT = 600;
+		static constexpr uint32_t DEFAULT_HEADLESS_FRAME_COUNT = 100;
+		static constexpr uint32_t TRANSFORMS_PER_JOB = 4096;
+		static constexpr float ROTATION_SPEED_X = 0.3f; // Radians per second
+		static constexpr float ROTATION_SPEED_Y = 0.6f;
+		static constexpr float STREAMED_MESH_RADIUS = 0.2f; // Streamed meshes are scaled to this bounding radius in clip space
 
 		// --- Constructors / Destructors ---
-		Application();
+		Application(const ApplicationOptions& options = {});
 		~Application();
 
 		Application(const Application&) = delete;
@@ -31,13 +76,25 @@ namespace DaisyEngine
 
 	private:
 		// --- Methods ---
-		void LoadGameObjects();
+		void LoadEntities();
+		void UpdateEntities(float timestep);
+		bool ShouldRun(uint32_t frameCount) const;
+		void CaptureLastFrame();
+		void PrintStats(const SimpleRenderSystem& simpleRenderSystem, const GpuDrivenRenderSystem* gpuDrivenRenderSystem);
 
 		// --- Variables ---
-		Window _window{ WIDTH, HEIGHT, "Daisy Engine" };
-		Device _device{ _window };
-		Renderer _renderer{ _window, _device };
+		ApplicationOptions _options;
+		JobSystem _jobSystem; // The main thread is its worker 0
+		std::unique_ptr<Window> _window; // Null when headless
+		std::unique_ptr<Device> _device;
+		std::unique_ptr<Renderer> _renderer;
 
-		std::vector<GameObject> _gameObjects;
+		std::unique_ptr<MeshArena> _meshArena; // Null unless enabled, outlives the models of the registry
+		std::unique_ptr<MeshRegistry> _meshRegistry; // Owns the models referenced by the render components
+		std::unique_ptr<MeshStreamer> _meshStreamer;
+		World _world;
+		std::unique_ptr<Simulation> _simulation; // Owns the world while its thread runs
+		FrustumCuller _frustumCuller;
+		LodSelector _lodSelector;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Entity.hpp"
+
+// std
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace DaisyEngine
+{
+	class QueryBase;
+
+	/// <summary>
+	/// The ComponentPoolBase class is the type erased part of a sparse set: the sparse array maps an entity index to a slot in
+	/// the dense arrays, the dense array lists the entity index stored in each slot. Slots are always packed, removing swaps
+	/// the last slot into the hole.
+	/// </summary>
+	class ComponentPoolBase
+	{
+	public:
+		// --- Constants ---
+		static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+		// --- Constructor/ Destructor ---
+		ComponentPoolBase() = default;
+		virtual ~ComponentPoolBase() = default;
+
+		ComponentPoolBase(const ComponentPoolBase&) = delete;
+		ComponentPoolBase& operator=(const ComponentPoolBase&) = delete;
+
+		// --- Methods ---
+		inline bool Contains(uint32_t entityIndex) const { return entityIndex < _sparse.size() && _sparse[entityIndex] != INVALID_SLOT; }
+		inline uint32_t GetSlot(uint32_t entityIndex) const { return Contains(entityIndex) ? _sparse[entityIndex] : INVALID_SLOT; }
+		inline uint32_t GetEntityIndex(uint32_t slot) const { return _dense[slot]; }
+		inline size_t Size() const { return _dense.size(); }
+
+		// Exchanges two slots, the components follow their entity
+		virtual void Swap(uint32_t slotA, uint32_t slotB) = 0;
+		virtual void Remove(uint32_t entityIndex) = 0;
+
+		// The query whose entities are packed at the front of this pool, a pool is owned by at most one query
+		inline QueryBase* GetOwner() const { return _owner; }
+		inline void SetOwner(QueryBase* owner) { _owner = owner; }
+
+	protected:
+		// --- Methods ---
+		uint32_t InsertSlot(uint32_t entityIndex)
+		{
+			if (entityIndex >= _sparse.size())
+			{
+				_sparse.resize(entityIndex + 1, INVALID_SLOT);
+			}
+
+			uint32_t slot = static_cast<uint32_t>(_dense.size());
+			_sparse[entityIndex] = slot;
+			_dense.push_back(entityIndex);
+			return slot;
+		}
+
+		void SwapSlots(uint32_t slotA, uint32_t slotB)
+		{
+			std::swap(_dense[slotA], _dense[slotB]);
+			_sparse[_dense[slotA]] = slotA;
+			_sparse[_dense[slotB]] = slotB;
+		}
+
+		// --- Variables ---
+		std::vector<uint32_t> _sparse;
+		std::vector<uint32_t> _dense;
+		QueryBase* _owner = nullptr;
+	};
+
+	/// <summary>
+	/// The ComponentPool class stores every component of one type in a contiguous array, in the order of the dense array.
+	/// </summary>
+	template <typename T>
+	class ComponentPool : public ComponentPoolBase
+	{
+	public:
+		// --- Methods ---
+		T& Add(uint32_t entityIndex, T component)
+		{
+			assert(!Contains(entityIndex) && "Entity already has this component");
+
+			InsertSlot(entityIndex);
+			_components.push_back(std::move(component));
+			return _components.back();
+		}
+
+		void Remove(uint32_t entityIndex) override
+		{
+			assert(Contains(entityIndex) && "Entity does not have this component");
+
+			uint32_t slot = _sparse[entityIndex];
+			uint32_t last = static_cast<uint32_t>(_dense.size() - 1);
+			if (slot != last)
+			{
+				Swap(slot, last);
+			}
+
+			_sparse[entityIndex] = INVALID_SLOT;
+			_dense.pop_back();
+			_components.pop_back();
+		}
+
+		void Swap(uint32_t slotA, uint32_t slotB) override
+		{
+			SwapSlots(slotA, slotB);
+			std::swap(_components[slotA], _components[slotB]);
+		}
+
+		inline T& Get(uint32_t entityIndex)
+		{
+			assert(Contains(entityIndex) && "Entity does not have this component");
+			return _components[_sparse[entityIndex]];
+		}
+
+		inline T* Data() { return _components.data(); }
+		inline const T* Data() const { return _components.data(); }
+
+		inline typename std::vector<T>::iterator begin() { return _components.begin(); }
+		inline typename std::vector<T>::iterator end() { return _components.end(); }
+
+	private:
+		// --- Variables ---
+		std::vector<T> _components;
+	};
+} // namespace DaisyEngine
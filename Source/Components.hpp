@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Transform.hpp"
+#include "World.hpp"
+
+// Libs
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+
+namespace DaisyEngine
+{
+	class Model;
+
+	/// <summary>
+	/// The MeshHandle struct names a mesh registered to the MeshStreamer. The handle stays valid while the mesh is streamed
+	/// in and out, the model behind it only exists while the mesh is resident.
+	/// </summary>
+	struct MeshHandle
+	{
+		static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+		uint32_t index = INVALID_INDEX;
+
+		inline bool IsValid() const { return index != INVALID_INDEX; }
+		bool operator==(const MeshHandle& other) const { return index == other.index; }
+		bool operator!=(const MeshHandle& other) const { return index != other.index; }
+	};
+
+	/// <summary>
+	/// The RenderComponent struct marks an entity as drawn by the SimpleRenderSystem. The model is not owned, models outlive
+	/// the entities using them. An entity using a streamed mesh sets its handle instead, the MeshStreamer resolves it into the
+	/// model each frame and leaves the model null until the mesh is resident. Entities without a model are neither culled in nor drawn.
+	/// </summary>
+	struct RenderComponent
+	{
+		Model* model = nullptr;
+		glm::vec3 color{};
+		MeshHandle mesh{};
+	};
+
+	// Every entity that is drawn, transforms and render components packed in the same order
+	using RenderQuery = Query<Transform, RenderComponent>;
+
+	/// <summary>
+	/// The RenderView struct is what the render systems read: the transforms and render components of the drawn entities,
+	/// packed in the same order. It views either a RenderQuery of the World or a snapshot interpolated by the Simulation,
+	/// so rendering never needs the World itself. The render components are writable so the streamed models can be resolved in place.
+	/// </summary>
+	struct RenderView
+	{
+		// --- Constructors ---
+		RenderView() = default;
+		RenderView(Transform* transforms, RenderComponent* renderComponents, size_t size)
+			: transforms(transforms), renderComponents(renderComponents), size(size)
+		{
+		}
+
+		// Implicit, every render system accepts a query of the World as is
+		RenderView(RenderQuery& query)
+			: transforms(query.Data<Transform>()), renderComponents(query.Data<RenderComponent>()), size(query.Size())
+		{
+		}
+
+		// --- Methods ---
+		inline size_t Size() const { return size; }
+
+		// --- Variables ---
+		Transform* transforms = nullptr;
+		RenderComponent* renderComponents = nullptr;
+		size_t size = 0;
+	};
+} // namespace DaisyEngine
@@ -0,0 +1,175 @@
+#include "CpuProfiler.hpp"
+
+#if DAISY_PROFILER
+
+// std
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+namespace DaisyEngine
+{
+	std::atomic<bool> CpuProfiler::s_isCapturing{ false };
+	const std::chrono::steady_clock::time_point CpuProfiler::s_epoch = std::chrono::steady_clock::now();
+
+	// Zone names come from string literals and __FUNCTION__, only quotes and backslashes need escaping
+	static void WriteJsonString(std::ostream& stream, const char* text)
+	{
+		stream << '"';
+		for (const char* c = text; *c != '\0'; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				stream << '\\';
+			}
+			stream << *c;
+		}
+		stream << '"';
+	}
+
+	CpuProfiler& CpuProfiler::Get()
+	{
+		static CpuProfiler profiler;
+		return profiler;
+	}
+
+	void CpuProfiler::BeginCapture()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_capturedEvents.clear();
+		_droppedEventCount = 0;
+		_lastFrameMark = 0;
+		s_isCapturing.store(true, std::memory_order_relaxed);
+	}
+
+	bool CpuProfiler::EndCapture(const std::string& path)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		Drain();
+		s_isCapturing.store(false, std::memory_order_relaxed);
+
+		std::ofstream file(path, std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::cerr << "Failed to open trace file: " << path << std::endl;
+			return false;
+		}
+
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+		bool isFirst = true;
+		for (const std::unique_ptr<ThreadBuffer>& threadBuffer : _threadBuffers)
+		{
+			if (threadBuffer->name.empty())
+			{
+				continue;
+			}
+
+			file << (isFirst ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << threadBuffer->threadId << ",\"args\":{\"name\":";
+			WriteJsonString(file, threadBuffer->name.c_str());
+			file << "}}";
+			isFirst = false;
+		}
+
+		char timing[64];
+		for (const CapturedEvent& event : _capturedEvents)
+		{
+			// Complete events, timestamps in microseconds
+			snprintf(timing, sizeof(timing), "%.3f,\"dur\":%.3f", event.zone.begin / 1000.0, (event.zone.end - event.zone.begin) / 1000.0);
+
+			file << (isFirst ? "\n" : ",\n") << "{\"name\":";
+			WriteJsonString(file, event.zone.name);
+			file << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.threadId << ",\"ts\":" << timing << "}";
+			isFirst = false;
+		}
+
+		file << "\n]}\n";
+
+		std::cout << "Wrote " << _capturedEvents.size() << " zones to " << path;
+		if (_droppedEventCount > 0)
+		{
+			std::cout << " (" << _droppedEventCount << " dropped, a thread ring buffer was full)";
+		}
+		std::cout << std::endl;
+
+		_capturedEvents.clear();
+		return file.good();
+	}
+
+	void CpuProfiler::FrameMark()
+	{
+		uint64_t now = Now();
+		if (IsCapturing() && _lastFrameMark != 0)
+		{
+			RecordZone("Frame", _lastFrameMark, now);
+		}
+		_lastFrameMark = now;
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		Drain();
+	}
+
+	void CpuProfiler::SetThreadName(const std::string& name)
+	{
+		ThreadBuffer& threadBuffer = GetThreadBuffer();
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		threadBuffer.name = name;
+	}
+
+	void CpuProfiler::RecordZone(const char* name, uint64_t begin, uint64_t end)
+	{
+		ThreadBuffer& threadBuffer = GetThreadBuffer();
+
+		uint64_t writeIndex = threadBuffer.writeIndex.load(std::memory_order_relaxed);
+		uint64_t readIndex = threadBuffer.readIndex.load(std::memory_order_acquire);
+		if (writeIndex - readIndex >= RING_CAPACITY)
+		{
+			threadBuffer.droppedCount.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		threadBuffer.events[writeIndex & (RING_CAPACITY - 1)] = { name, begin, end };
+		threadBuffer.writeIndex.store(writeIndex + 1, std::memory_order_release);
+	}
+
+	CpuProfiler::ThreadBuffer& CpuProfiler::GetThreadBuffer()
+	{
+		// Buffers outlive their thread, the events of a finished thread are still drained
+		thread_local ThreadBuffer* t_threadBuffer = nullptr;
+		if (t_threadBuffer == nullptr)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_threadBuffers.push_back(std::make_unique<ThreadBuffer>());
+			t_threadBuffer = _threadBuffers.back().get();
+			t_threadBuffer->threadId = static_cast<uint32_t>(_threadBuffers.size() - 1);
+		}
+
+		return *t_threadBuffer;
+	}
+
+	void CpuProfiler::Drain()
+	{
+		const bool isCapturing = IsCapturing();
+
+		for (const std::unique_ptr<ThreadBuffer>& threadBuffer : _threadBuffers)
+		{
+			uint64_t readIndex = threadBuffer->readIndex.load(std::memory_order_relaxed);
+			uint64_t writeIndex = threadBuffer->writeIndex.load(std::memory_order_acquire);
+
+			if (isCapturing)
+			{
+				for (uint64_t i = readIndex; i < writeIndex; ++i)
+				{
+					_capturedEvents.push_back({ threadBuffer->events[i & (RING_CAPACITY - 1)], threadBuffer->threadId });
+				}
+			}
+
+			threadBuffer->readIndex.store(writeIndex, std::memory_order_release);
+			_droppedEventCount += threadBuffer->droppedCount.exchange(0, std::memory_order_relaxed);
+		}
+	}
+} // namespace DaisyEngine
+
+#endif // DAISY_PROFILER
@@ -0,0 +1,153 @@
+#pragma once
+
+// Set DAISY_PROFILER to 0 to compile every profiling macro to nothing
+#ifndef DAISY_PROFILER
+#define DAISY_PROFILER 1
+#endif
+
+#if DAISY_PROFILER
+
+// std
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The ZoneEvent struct is one closed zone, timestamps are nanoseconds since the profiler was created.
+	/// </summary>
+	struct ZoneEvent
+	{
+		const char* name;
+		uint64_t begin;
+		uint64_t end;
+	};
+
+	/// <summary>
+	/// The CpuProfiler class records named zones from any thread and exports them as a Chrome trace
+	/// (chrome://tracing or ui.perfetto.dev). Zones are only recorded while a capture is running.
+	/// Every thread writes to its own single producer ring buffer without locking, the thread calling FrameMark
+	/// is the only consumer and moves the events to the capture once per frame.
+	/// </summary>
+	class CpuProfiler
+	{
+	public:
+		// --- Constants ---
+		static constexpr size_t RING_CAPACITY = 8192; // Events per thread between two frame marks, must be a power of two
+
+		// --- Methods ---
+		static CpuProfiler& Get();
+		static inline bool IsCapturing() { return s_isCapturing.load(std::memory_order_relaxed); }
+		static inline uint64_t Now()
+		{
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_epoch).count());
+		}
+
+		void BeginCapture();
+		// Stops the capture and writes it as Chrome trace JSON, returns false if the file cannot be written
+		bool EndCapture(const std::string& path);
+
+		// Ends the current frame: records a "Frame" zone since the previous mark and drains every thread buffer
+		void FrameMark();
+		void SetThreadName(const std::string& name);
+		void RecordZone(const char* name, uint64_t begin, uint64_t end);
+
+		inline uint64_t GetDroppedEventCount() const { return _droppedEventCount; }
+
+	private:
+		/// <summary>
+		/// Ring buffer owned by one thread, writeIndex is only advanced by that thread and readIndex by the consumer.
+		/// </summary>
+		struct ThreadBuffer
+		{
+			std::array<ZoneEvent, RING_CAPACITY> events;
+			std::atomic<uint64_t> writeIndex{ 0 };
+			std::atomic<uint64_t> readIndex{ 0 };
+			std::atomic<uint64_t> droppedCount{ 0 };
+			uint32_t threadId = 0;
+			std::string name;
+		};
+
+		/// <summary>
+		/// An event moved out of a ring buffer, tagged with the thread it came from.
+		/// </summary>
+		struct CapturedEvent
+		{
+			ZoneEvent zone;
+			uint32_t threadId;
+		};
+
+		// --- Constructor ---
+		CpuProfiler() = default;
+
+		// --- Methods ---
+		ThreadBuffer& GetThreadBuffer();
+		void Drain();
+
+		// --- Variables ---
+		static std::atomic<bool> s_isCapturing;
+		static const std::chrono::steady_clock::time_point s_epoch;
+
+		std::mutex _mutex; // Guards the thread list and the capture, never taken when a zone is recorded
+		std::vector<std::unique_ptr<ThreadBuffer>> _threadBuffers;
+		std::vector<CapturedEvent> _capturedEvents;
+		uint64_t _lastFrameMark = 0;
+		uint64_t _droppedEventCount = 0;
+	};
+
+	/// <summary>
+	/// The ProfileZone class records a zone from its construction to its destruction, use the DAISY_PROFILE_ZONE macros.
+	/// </summary>
+	class ProfileZone
+	{
+	public:
+		inline explicit ProfileZone(const char* name)
+			: _name(name), _isActive(CpuProfiler::IsCapturing()), _begin(_isActive ? CpuProfiler::Now() : 0)
+		{
+		}
+
+		inline ~ProfileZone()
+		{
+			if (_isActive)
+			{
+				CpuProfiler::Get().RecordZone(_name, _begin, CpuProfiler::Now());
+			}
+		}
+
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+
+	private:
+		const char* _name;
+		bool _isActive;
+		uint64_t _begin;
+	};
+} // namespace DaisyEngine
+
+#define DAISY_PROFILE_CONCAT_IMPL(a, b) a##b
+#define DAISY_PROFILE_CONCAT(a, b) DAISY_PROFILE_CONCAT_IMPL(a, b)
+
+// Names must be string literals or outlive the capture
+#define DAISY_PROFILE_ZONE(name) ::DaisyEngine::ProfileZone DAISY_PROFILE_CONCAT(_profileZone, __LINE__)(name)
+#define DAISY_PROFILE_FUNCTION() DAISY_PROFILE_ZONE(__FUNCTION__)
+#define DAISY_PROFILE_FRAME() ::DaisyEngine::CpuProfiler::Get().FrameMark()
+#define DAISY_PROFILE_THREAD(name) ::DaisyEngine::CpuProfiler::Get().SetThreadName(name)
+#define DAISY_PROFILE_BEGIN_CAPTURE() ::DaisyEngine::CpuProfiler::Get().BeginCapture()
+#define DAISY_PROFILE_END_CAPTURE(path) ::DaisyEngine::CpuProfiler::Get().EndCapture(path)
+
+#else
+
+#define DAISY_PROFILE_ZONE(name)
+#define DAISY_PROFILE_FUNCTION()
+#define DAISY_PROFILE_FRAME()
+#define DAISY_PROFILE_THREAD(name)
+#define DAISY_PROFILE_BEGIN_CAPTURE()
+#define DAISY_PROFILE_END_CAPTURE(path)
+
+#endif // DAISY_PROFILER
@@ -0,0 +1,342 @@
+#include "DepthPyramid.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace DaisyEngine
+{
+	struct DepthPyramidPushConstantData
+	{
+		int32_t sourceSize[2];
+		int32_t destinationSize[2];
+	};
+
+	static uint32_t PreviousPowerOfTwo(uint32_t value)
+	{
+		uint32_t result = 1;
+		while (result * 2 <= value)
+		{
+			result *= 2;
+		}
+		return result;
+	}
+
+	static VkImageAspectFlags GetDepthAspect(VkFormat format)
+	{
+		// The layout of a combined format changes for both aspects at once
+		bool hasStencil = format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D16_UNORM_S8_UINT;
+		return hasStencil ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_DEPTH_BIT;
+	}
+
+	DepthPyramid::DepthPyramid(Device& device, RenderTarget& renderTarget)
+		: _device(device), _renderTarget(renderTarget)
+	{
+		VkExtent2D targetExtent = _renderTarget.GetSwapChainExtent();
+		_extent = { PreviousPowerOfTwo(targetExtent.width), PreviousPowerOfTwo(targetExtent.height) };
+		_levelCount = 1;
+		while ((std::max(_extent.width, _extent.height) >> _levelCount) > 0)
+		{
+			_levelCount++;
+		}
+
+		CreateImage();
+		CreateSampler();
+		CreateDescriptorSets();
+		CreatePipeline();
+	}
+
+	DepthPyramid::~DepthPyramid()
+	{
+		_pipeline = nullptr;
+		vkDestroyPipelineLayout(_device.GetDevice(), _pipelineLayout, nullptr);
+		vkDestroyDescriptorPool(_device.GetDevice(), _descriptorPool, nullptr);
+		vkDestroyDescriptorSetLayout(_device.GetDevice(), _descriptorSetLayout, nullptr);
+		vkDestroySampler(_device.GetDevice(), _sampler, nullptr);
+
+		for (VkImageView levelView : _levelViews)
+		{
+			vkDestroyImageView(_device.GetDevice(), levelView, nullptr);
+		}
+		vkDestroyImageView(_device.GetDevice(), _imageView, nullptr);
+		_device.DestroyImage(_image, _allocation);
+	}
+
+	void DepthPyramid::CreateImage()
+	{
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent.width = _extent.width;
+		imageInfo.extent.height = _extent.height;
+		imageInfo.extent.depth = 1;
+		imageInfo.mipLevels = _levelCount;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = FORMAT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.flags = 0;
+
+		_device.CreateImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _image, _allocation);
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = _image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = FORMAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = _levelCount;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(_device.GetDevice(), &viewInfo, nullptr, &_imageView) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create depth pyramid image view!");
+		}
+
+		_levelViews.resize(_levelCount);
+		viewInfo.subresourceRange.levelCount = 1;
+		for (uint32_t level = 0; level < _levelCount; ++level)
+		{
+			viewInfo.subresourceRange.baseMipLevel = level;
+			if (vkCreateImageView(_device.GetDevice(), &viewInfo, nullptr, &_levelViews[level]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create depth pyramid level view!");
+			}
+		}
+
+		// The pyramid never leaves the GENERAL layout, it is written as a storage image and sampled
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = _image;
+		barrier.subresourceRange = viewInfo.subresourceRange;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = _levelCount;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		VkCommandBuffer commandBuffer = _device.BeginSingleTimeCommands();
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		_device.EndSingleTimeCommands(commandBuffer);
+	}
+
+	void DepthPyramid::CreateSampler()
+	{
+		// Only read with texelFetch, the filter never applies
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_NEAREST;
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = static_cast<float>(_levelCount);
+
+		if (vkCreateSampler(_device.GetDevice(), &samplerInfo, nullptr, &_sampler) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create depth pyramid sampler!");
+		}
+	}
+
+	void DepthPyramid::CreateDescriptorSets()
+	{
+		std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+		bindings[0].binding = 0;
+		bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		bindings[0].descriptorCount = 1;
+		bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		bindings[1].binding = 1;
+		bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		bindings[1].descriptorCount = 1;
+		bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		layoutInfo.pBindings = bindings.data();
+
+		if (vkCreateDescriptorSetLayout(_device.GetDevice(), &layoutInfo, nullptr, &_descriptorSetLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create descriptor set layout!");
+		}
+
+		const uint32_t imageCount = static_cast<uint32_t>(_renderTarget.GetImageCount());
+		const uint32_t setCount = imageCount + _levelCount - 1;
+
+		std::array<VkDescriptorPoolSize, 2> poolSizes{};
+		poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSizes[0].descriptorCount = setCount;
+		poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		poolSizes[1].descriptorCount = setCount;
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.maxSets = setCount;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+
+		if (vkCreateDescriptorPool(_device.GetDevice(), &poolInfo, nullptr, &_descriptorPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create descriptor pool!");
+		}
+
+		std::vector<VkDescriptorSetLayout> layouts(setCount, _descriptorSetLayout);
+		std::vector<VkDescriptorSet> descriptorSets(setCount);
+
+		VkDescriptorSetAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.descriptorPool = _descriptorPool;
+		allocateInfo.descriptorSetCount = setCount;
+		allocateInfo.pSetLayouts = layouts.data();
+
+		if (vkAllocateDescriptorSets(_device.GetDevice(), &allocateInfo, descriptorSets.data()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate descriptor set!");
+		}
+
+		// The depth images and the levels never change for the lifetime of the pyramid, the sets are written once
+		_depthDescriptorSets.assign(descriptorSets.begin(), descriptorSets.begin() + imageCount);
+		_levelDescriptorSets.assign(descriptorSets.begin() + imageCount, descriptorSets.end());
+		for (uint32_t image = 0; image < imageCount; ++image)
+		{
+			WriteDescriptorSet(_depthDescriptorSets[image], _renderTarget.GetDepthImageView(image),
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, _levelViews[0]);
+		}
+
+		for (uint32_t level = 1; level < _levelCount; ++level)
+		{
+			WriteDescriptorSet(_levelDescriptorSets[level - 1], _levelViews[level - 1], VK_IMAGE_LAYOUT_GENERAL, _levelViews[level]);
+		}
+	}
+
+	void DepthPyramid::WriteDescriptorSet(VkDescriptorSet descriptorSet, VkImageView source, VkImageLayout sourceLayout, VkImageView destination)
+	{
+		VkDescriptorImageInfo sourceInfo{};
+		sourceInfo.sampler = _sampler;
+		sourceInfo.imageView = source;
+		sourceInfo.imageLayout = sourceLayout;
+
+		VkDescriptorImageInfo destinationInfo{};
+		destinationInfo.imageView = destination;
+		destinationInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		std::array<VkWriteDescriptorSet, 2> writes{};
+		writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[0].dstSet = descriptorSet;
+		writes[0].dstBinding = 0;
+		writes[0].descriptorCount = 1;
+		writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[0].pImageInfo = &sourceInfo;
+		writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[1].dstSet = descriptorSet;
+		writes[1].dstBinding = 1;
+		writes[1].descriptorCount = 1;
+		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		writes[1].pImageInfo = &destinationInfo;
+
+		vkUpdateDescriptorSets(_device.GetDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+
+	void DepthPyramid::CreatePipeline()
+	{
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(DepthPyramidPushConstantData);
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &_descriptorSetLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		if (vkCreatePipelineLayout(_device.GetDevice(), &pipelineLayoutInfo, nullptr, &_pipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create pipeline layout!");
+		}
+
+		_pipeline = std::make_unique<ComputePipeline>(_device, "shaders/depth_pyramid.comp.spv", _pipelineLayout);
+	}
+
+	void DepthPyramid::Build(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+	{
+		VkImageMemoryBarrier depthBarrier{};
+		depthBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		depthBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		depthBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		depthBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		depthBarrier.image = _renderTarget.GetDepthImage(imageIndex);
+		depthBarrier.subresourceRange.aspectMask = GetDepthAspect(_renderTarget.GetDepthFormat());
+		depthBarrier.subresourceRange.baseMipLevel = 0;
+		depthBarrier.subresourceRange.levelCount = 1;
+		depthBarrier.subresourceRange.baseArrayLayer = 0;
+		depthBarrier.subresourceRange.layerCount = 1;
+		depthBarrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		depthBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		// The culling of the previous frame may still read the pyramid overwritten here
+		VkMemoryBarrier pyramidBarrier{};
+		pyramidBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		pyramidBarrier.srcAccessMask = 0;
+		pyramidBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 1, &pyramidBarrier, 0, nullptr, 1, &depthBarrier);
+
+		_pipeline->Bind(commandBuffer);
+
+		VkExtent2D sourceExtent = _renderTarget.GetSwapChainExtent();
+		for (uint32_t level = 0; level < _levelCount; ++level)
+		{
+			VkDescriptorSet descriptorSet = level == 0 ? _depthDescriptorSets[imageIndex] : _levelDescriptorSets[level - 1];
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+
+			VkExtent2D destinationExtent = { std::max(_extent.width >> level, 1u), std::max(_extent.height >> level, 1u) };
+			DepthPyramidPushConstantData push{};
+			push.sourceSize[0] = static_cast<int32_t>(sourceExtent.width);
+			push.sourceSize[1] = static_cast<int32_t>(sourceExtent.height);
+			push.destinationSize[0] = static_cast<int32_t>(destinationExtent.width);
+			push.destinationSize[1] = static_cast<int32_t>(destinationExtent.height);
+			vkCmdPushConstants(commandBuffer, _pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DepthPyramidPushConstantData), &push);
+
+			vkCmdDispatch(commandBuffer,
+				(destinationExtent.width + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+				(destinationExtent.height + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+				1);
+
+			// Each level is read by the next one, the last one by the culling
+			VkMemoryBarrier levelBarrier{};
+			levelBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			levelBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &levelBarrier, 0, nullptr, 0, nullptr);
+
+			sourceExtent = destinationExtent;
+		}
+
+		// The depth goes back to the attachment layout, the load render pass of the target expects it there
+		depthBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depthBarrier.srcAccessMask = 0;
+		depthBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &depthBarrier);
+	}
+} // namespace DaisyEngine
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Device.hpp"
+#include "Pipeline.hpp"
+#include "RenderTarget.hpp"
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The DepthPyramid class reduces the depth buffer of a frame into a mip chain where every texel keeps the farthest depth
+	/// of the area it covers, so one texel fetch tells whether a whole screen rectangle is hidden.
+	/// Level 0 is the largest power of two size that fits in the render target, each following level halves it down to 1x1.
+	/// The pyramid stays in the GENERAL layout and is read with texelFetch from a sampler2D of all its levels.
+	/// </summary>
+	class DepthPyramid
+	{
+	public:
+		// --- Constants ---
+		static constexpr VkFormat FORMAT = VK_FORMAT_R32_SFLOAT;
+		static constexpr uint32_t WORKGROUP_SIZE = 8; // local_size_x and local_size_y of depth_pyramid.comp
+
+		// --- Constructors / Destructors ---
+		// Sized for the extent of the render target, which must be created again with it
+		DepthPyramid(Device& device, RenderTarget& renderTarget);
+		~DepthPyramid();
+
+		DepthPyramid(const DepthPyramid&) = delete;
+		DepthPyramid& operator=(const DepthPyramid&) = delete;
+
+		// Reduces the depth drawn so far into the image of the render target, outside of any render pass. The depth image
+		// is left in DEPTH_STENCIL_ATTACHMENT_OPTIMAL, ready for the load render pass of the target
+		void Build(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+
+		inline VkImageView GetImageView() const { return _imageView; }
+		inline VkSampler GetSampler() const { return _sampler; }
+		inline VkExtent2D GetExtent() const { return _extent; }
+		inline uint32_t GetLevelCount() const { return _levelCount; }
+
+	private:
+		// --- Methods ---
+		void CreateImage();
+		void CreateSampler();
+		void CreateDescriptorSets();
+		void CreatePipeline();
+		void WriteDescriptorSet(VkDescriptorSet descriptorSet, VkImageView source, VkImageLayout sourceLayout, VkImageView destination);
+
+		// --- Variables ---
+		Device& _device;
+		RenderTarget& _renderTarget;
+		VkExtent2D _extent{};
+		uint32_t _levelCount = 0;
+
+		VkImage _image = VK_NULL_HANDLE;
+		Allocation _allocation{};
+		VkImageView _imageView = VK_NULL_HANDLE; // Every level, for the culling
+		std::vector<VkImageView> _levelViews; // One level each, for the reduction
+		VkSampler _sampler = VK_NULL_HANDLE;
+
+		VkDescriptorSetLayout _descriptorSetLayout = VK_NULL_HANDLE;
+		VkDescriptorPool _descriptorPool = VK_NULL_HANDLE;
+		std::vector<VkDescriptorSet> _depthDescriptorSets; // Level 0 from the depth image of each framebuffer
+		std::vector<VkDescriptorSet> _levelDescriptorSets; // Level i + 1 from level i
+
+		VkPipelineLayout _pipelineLayout = VK_NULL_HANDLE;
+		std::unique_ptr<ComputePipeline> _pipeline;
+	};
+} // namespace DaisyEngine
@@ -1,12 +1,46 @@
 #include "Device.hpp"
+#include "UploadService.hpp"
 
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 #include <unordered_set>
 #include <set>
 
 namespace DaisyEngine
 {
+	// Header written in front of the driver's pipeline cache data
+	struct PipelineCacheFileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint32_t driverVersion;
+		uint8_t driverUUID[VK_UUID_SIZE];
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+		uint64_t dataSize;
+		uint64_t dataHash;
+	};
+
+	static constexpr uint32_t PIPELINE_CACHE_MAGIC = 0x48435044; // "DPCH"
+	static constexpr uint32_t PIPELINE_CACHE_FILE_VERSION = 2; // 2 added the driver UUID
+
+	// FNV-1a, only used to detect truncated or corrupted cache files
+	static uint64_t HashBytes(const char* data, size_t size)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= static_cast<uint8_t>(data[i]);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
 	// Local Callback function for the debug messenger
 	static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
 		VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
@@ -48,19 +82,38 @@ namespace DaisyEngine
 	}
 
 
-	Device::Device(Window& window) : _window(window)
+	Device::Device(Window& window) : _window(&window)
+	{
+		_deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+		Init();
+	}
+
+	Device::Device()
+	{
+		Init();
+	}
+
+	void Device::Init()
 	{
 		CreateInstance(); // Create the Vulkan instance
 		SetupDebugMessenger(); // Setup validation layers (To track errors)
 		CreateSurface(); // Create the window surface (Connection between window and Vulkan)
 		PickPhysicalDevice(); // Pick the physical device (GPU) to use
 		CreateLogicalDevice(); // Create the logical device (Connection between application and GPU)
+		CreateAllocator(); // Create the memory allocator (Sub-allocates buffers and images from large memory blocks)
 		CreateCommandPool(); // Create the command pool (Used to allocate command buffers)
+		CreateUploadService(); // Create the upload service (Streams data to device local buffers)
+		CreatePipelineCache(); // Create the pipeline cache (Loaded from disk to skip shader compilation)
 	}
 
 	Device::~Device()
 	{
+		SavePipelineCache();
+		vkDestroyPipelineCache(_device, _pipelineCache, nullptr);
+
+		_uploadService.reset();
 		vkDestroyCommandPool(_device, _commandPool, nullptr);
+		_allocator.reset();
 		vkDestroyDevice(_device, nullptr);
 
 		if (enableValidationLayers)
@@ -68,7 +121,10 @@ namespace DaisyEngine
 			DestroyDebugUtilsMessengerEXT(_instance, _debugMessenger, nullptr);
 		}
 
-		vkDestroySurfaceKHR(_instance, _surface, nullptr);
+		if (_surface != VK_NULL_HANDLE)
+		{
+			vkDestroySurfaceKHR(_instance, _surface, nullptr);
+		}
 		vkDestroyInstance(_instance, nullptr);
 	}
 
@@ -94,7 +150,16 @@ namespace DaisyEngine
 		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
 		createInfo.pApplicationInfo = &appInfo;
 
+		// Optional, only used to read the driver UUID the pipeline cache file is checked against. VkPhysicalDeviceIDProperties
+		// belongs to VK_KHR_external_memory_capabilities, which is queried through VK_KHR_get_physical_device_properties2
 		std::vector<const char*> extensions = GetRequiredExtensions();
+		_isDeviceIDQuerySupported = IsInstanceExtensionSupported(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)
+			&& IsInstanceExtensionSupported(VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME);
+		if (_isDeviceIDQuerySupported)
+		{
+			extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+			extensions.push_back(VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME);
+		}
 		createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
 		createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -140,7 +205,12 @@ namespace DaisyEngine
 
 	void Device::CreateSurface()
 	{
-		_window.CreateWindowSurface(_instance, &_surface);
+		if (IsHeadless())
+		{
+			return;
+		}
+
+		_window->CreateWindowSurface(_instance, &_surface);
 	}
 
 	void Device::PickPhysicalDevice()
@@ -172,14 +242,47 @@ namespace DaisyEngine
 
 		vkGetPhysicalDeviceProperties(_physicalDevice, &_properties);
 		std::cout << "Physical device: " << _properties.deviceName << std::endl;
+
+		QueryDriverUUID();
+	}
+
+	void Device::QueryDriverUUID()
+	{
+		if (!_isDeviceIDQuerySupported)
+		{
+			return;
+		}
+
+		// Vulkan 1.0 instance, the entry point comes from the extension
+		auto getProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2KHR>(
+			vkGetInstanceProcAddr(_instance, "vkGetPhysicalDeviceProperties2KHR"));
+		if (getProperties2 == nullptr)
+		{
+			return;
+		}
+
+		VkPhysicalDeviceIDPropertiesKHR idProperties{};
+		idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES_KHR;
+
+		VkPhysicalDeviceProperties2KHR properties{};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+		properties.pNext = &idProperties;
+		getProperties2(_physicalDevice, &properties);
+
+		memcpy(_driverUUID, idProperties.driverUUID, VK_UUID_SIZE);
 	}
 
 	void Device::CreateLogicalDevice()
 	{
 		QueueFamilyIndices indices = FindQueueFamilies(_physicalDevice);
+		_queueFamilies = indices;
 
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 		std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily };
+		if (indices.transferFamilyHasValue)
+		{
+			uniqueQueueFamilies.insert(indices.transferFamily);
+		}
 
 		float queuePriority = 1.0f;
 		for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -192,9 +295,28 @@ namespace DaisyEngine
 			queueCreateInfos.push_back(queueCreateInfo);
 		}
 
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(_physicalDevice, &supportedFeatures);
+
 		VkPhysicalDeviceFeatures deviceFeatures{};
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
 
+		// Optional, used by the GPU profiler when available
+		deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+		deviceFeatures.inheritedQueries = supportedFeatures.inheritedQueries;
+
+		// Optional, used by the GPU driven render system when available
+		deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+		deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+		_enabledFeatures = deviceFeatures;
+
+		// Optional as well, without it the GPU driven render system draws every command and lets the empty ones cost nothing
+		_isDrawIndirectCountSupported = IsDeviceExtensionSupported(_physicalDevice, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+		if (_isDrawIndirectCountSupported)
+		{
+			_deviceExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+		}
+
 		VkDeviceCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 
@@ -220,8 +342,25 @@ namespace DaisyEngine
 			throw std::runtime_error("Failed to create logical device!");
 		}
 
+		if (_isDrawIndirectCountSupported)
+		{
+			_cmdDrawIndirectCount = (PFN_vkCmdDrawIndirectCountKHR)vkGetDeviceProcAddr(_device, "vkCmdDrawIndirectCountKHR");
+			_cmdDrawIndexedIndirectCount = (PFN_vkCmdDrawIndexedIndirectCountKHR)vkGetDeviceProcAddr(_device, "vkCmdDrawIndexedIndirectCountKHR");
+		}
+
 		vkGetDeviceQueue(_device, indices.graphicsFamily, 0, &_graphicsQueue);
 		vkGetDeviceQueue(_device, indices.presentFamily, 0, &_presentQueue);
+
+		// Without a dedicated transfer family, uploads go through the graphics queue
+		if (indices.transferFamilyHasValue)
+		{
+			vkGetDeviceQueue(_device, indices.transferFamily, 0, &_transferQueue);
+			std::cout << "Dedicated transfer queue family: " << indices.transferFamily << std::endl;
+		}
+		else
+		{
+			_transferQueue = _graphicsQueue;
+		}
 	}
 
 	void Device::CreateCommandPool()
@@ -239,14 +378,187 @@ namespace DaisyEngine
 		}
 	}
 
+	void Device::CreateUploadService()
+	{
+		uint32_t transferFamily = _queueFamilies.transferFamilyHasValue ? _queueFamilies.transferFamily : _queueFamilies.graphicsFamily;
+		_uploadService = std::make_unique<UploadService>(*this, transferFamily, _transferQueue);
+	}
+
+	void Device::CreatePipelineCache()
+	{
+		std::vector<char> initialData;
+		const char* coldReason = "no cache file";
+
+		std::ifstream file(PIPELINE_CACHE_PATH, std::ios::ate | std::ios::binary);
+		if (file.is_open())
+		{
+			size_t fileSize = static_cast<size_t>(file.tellg());
+			std::vector<char> fileData(fileSize);
+			file.seekg(0);
+			file.read(fileData.data(), fileSize);
+			file.close();
+
+			PipelineCacheFileHeader header{};
+			if (fileSize < sizeof(header))
+			{
+				coldReason = "truncated cache file";
+			}
+			else
+			{
+				memcpy(&header, fileData.data(), sizeof(header));
+				const char* data = fileData.data() + sizeof(header);
+				const size_t dataSize = fileSize - sizeof(header);
+
+				if (header.magic != PIPELINE_CACHE_MAGIC || header.version != PIPELINE_CACHE_FILE_VERSION)
+				{
+					coldReason = "unknown cache file format";
+				}
+				else if (header.vendorID != _properties.vendorID
+					|| header.deviceID != _properties.deviceID
+					|| header.driverVersion != _properties.driverVersion
+					|| memcmp(header.driverUUID, _driverUUID, VK_UUID_SIZE) != 0
+					|| memcmp(header.pipelineCacheUUID, _properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+				{
+					coldReason = "cache written by another device or driver";
+				}
+				else if (header.dataSize != dataSize || header.dataHash != HashBytes(data, dataSize))
+				{
+					coldReason = "corrupted cache file";
+				}
+				else
+				{
+					initialData.assign(data, data + dataSize);
+					if (!IsPipelineCacheCompatible(initialData))
+					{
+						coldReason = "incompatible driver cache header";
+						initialData.clear();
+					}
+				}
+			}
+		}
+
+		VkPipelineCacheCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		createInfo.initialDataSize = initialData.size();
+		createInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+		if (vkCreatePipelineCache(_device, &createInfo, nullptr, &_pipelineCache) != VK_SUCCESS)
+		{
+			// The driver can still refuse the data, start from an empty cache in that case
+			createInfo.initialDataSize = 0;
+			createInfo.pInitialData = nullptr;
+			initialData.clear();
+			coldReason = "driver rejected cache data";
+
+			if (vkCreatePipelineCache(_device, &createInfo, nullptr, &_pipelineCache) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create pipeline cache!");
+			}
+		}
+
+		_pipelineCacheStats.isWarm = !initialData.empty();
+		_pipelineCacheStats.loadedBytes = initialData.size();
+		if (_pipelineCacheStats.isWarm)
+		{
+			std::cout << "Pipeline cache: warm (" << initialData.size() << " bytes)" << std::endl;
+		}
+		else
+		{
+			std::cout << "Pipeline cache: cold (" << coldReason << ")" << std::endl;
+		}
+	}
+
+	void Device::SavePipelineCache()
+	{
+		size_t dataSize = 0;
+		if (vkGetPipelineCacheData(_device, _pipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0)
+		{
+			return;
+		}
+
+		std::vector<char> data(dataSize);
+		if (vkGetPipelineCacheData(_device, _pipelineCache, &dataSize, data.data()) != VK_SUCCESS)
+		{
+			std::cerr << "Failed to read pipeline cache data!" << std::endl;
+			return;
+		}
+
+		PipelineCacheFileHeader header{};
+		header.magic = PIPELINE_CACHE_MAGIC;
+		header.version = PIPELINE_CACHE_FILE_VERSION;
+		header.vendorID = _properties.vendorID;
+		header.deviceID = _properties.deviceID;
+		header.driverVersion = _properties.driverVersion;
+		memcpy(header.driverUUID, _driverUUID, VK_UUID_SIZE);
+		memcpy(header.pipelineCacheUUID, _properties.pipelineCacheUUID, VK_UUID_SIZE);
+		header.dataSize = dataSize;
+		header.dataHash = HashBytes(data.data(), dataSize);
+
+		// Write next to the real file then rename it, a crash never leaves a half written cache behind
+		const std::string tempPath = std::string(PIPELINE_CACHE_PATH) + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(data.data(), dataSize);
+			file.flush();
+
+			if (!file.good())
+			{
+				std::cerr << "Failed to write pipeline cache file!" << std::endl;
+				file.close();
+				std::filesystem::remove(tempPath);
+				return;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, PIPELINE_CACHE_PATH, error);
+		if (error)
+		{
+			std::cerr << "Failed to replace pipeline cache file: " << error.message() << std::endl;
+			std::filesystem::remove(tempPath, error);
+		}
+	}
+
+	bool Device::IsPipelineCacheCompatible(const std::vector<char>& data)
+	{
+		// Layout of VkPipelineCacheHeaderVersionOne
+		constexpr size_t headerSize = 16 + VK_UUID_SIZE;
+		if (data.size() < headerSize)
+		{
+			return false;
+		}
+
+		uint32_t header[4];
+		memcpy(header, data.data(), sizeof(header));
+
+		return header[0] >= headerSize
+			&& header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+			&& header[2] == _properties.vendorID
+			&& header[3] == _properties.deviceID
+			&& memcmp(data.data() + 16, _properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+	void Device::RecordPipelineCreation(double milliseconds)
+	{
+		_pipelineCacheStats.pipelineCount++;
+		_pipelineCacheStats.creationMilliseconds += milliseconds;
+	}
+
+	void Device::CreateAllocator()
+	{
+		_allocator = std::make_unique<MemoryAllocator>(_physicalDevice, _device);
+	}
+
 	bool Device::IsDeviceSuitable(VkPhysicalDevice device)
 	{
 		QueueFamilyIndices indices = FindQueueFamilies(device);
 
 		bool extensionsSupported = CheckDeviceExtensionSupport(device);
 
-		bool swapChainAdequate = false;
-		if (extensionsSupported)
+		// Headless devices never present, any device with a graphics queue will do
+		bool swapChainAdequate = IsHeadless();
+		if (extensionsSupported && !IsHeadless())
 		{
 			SwapChainSupportDetails swapChainSupport = QuerySwapChainSupport(device);
 			swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
@@ -263,11 +575,17 @@ namespace DaisyEngine
 
 	std::vector<const char*> Device::GetRequiredExtensions()
 	{
-		uint32_t glfwExtensionCount = 0;
-		const char** glfwExtensions;
-		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+		std::vector<const char*> extensions;
+
+		// GLFW is never initialized in headless mode, the surface extensions are not needed anyway
+		if (!IsHeadless())
+		{
+			uint32_t glfwExtensionCount = 0;
+			const char** glfwExtensions;
+			glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
-		std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+			extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		}
 
 		if (enableValidationLayers)
 		{
@@ -277,6 +595,23 @@ namespace DaisyEngine
 		return extensions;
 	}
 
+	bool Device::IsInstanceExtensionSupported(const char* extensionName)
+	{
+		uint32_t extensionCount = 0;
+		vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+		std::vector<VkExtensionProperties> extensions(extensionCount);
+		vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+
+		for (const VkExtensionProperties& extension : extensions)
+		{
+			if (strcmp(extension.extensionName, extensionName) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
 	bool Device::CheckValidationLayerSupport()
 	{
 		uint32_t layerCount;
@@ -315,25 +650,42 @@ namespace DaisyEngine
 		int i = 0;
 		for (const VkQueueFamilyProperties& queueFamily : queueFamilies)
 		{
-			if (queueFamily.queueCount > 0
-				&& queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+			if (!indices.IsComplete())
 			{
-				indices.graphicsFamily = i;
-				indices.graphicsFamilyHasValue = true;
-			}
+				if (queueFamily.queueCount > 0
+					&& queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+				{
+					indices.graphicsFamily = i;
+					indices.graphicsFamilyHasValue = true;
+				}
 
-			VkBool32 presentSupport = false;
-			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, _surface, &presentSupport);
-			if (queueFamily.queueCount > 0
-				&& presentSupport)
-			{
-				indices.presentFamily = i;
-				indices.presentFamilyHasValue = true;
+				if (IsHeadless())
+				{
+					// Nothing is presented, the present queue aliases the graphics queue
+					indices.presentFamily = indices.graphicsFamily;
+					indices.presentFamilyHasValue = indices.graphicsFamilyHasValue;
+				}
+				else
+				{
+					VkBool32 presentSupport = false;
+					vkGetPhysicalDeviceSurfaceSupportKHR(device, i, _surface, &presentSupport);
+					if (queueFamily.queueCount > 0
+						&& presentSupport)
+					{
+						indices.presentFamily = i;
+						indices.presentFamilyHasValue = true;
+					}
+				}
 			}
 
-			if (indices.IsComplete())
+			// Transfer only families map to the copy engines of discrete GPUs
+			if (queueFamily.queueCount > 0
+				&& !indices.transferFamilyHasValue
+				&& queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT
+				&& !(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
 			{
-				break;
+				indices.transferFamily = i;
+				indices.transferFamilyHasValue = true;
 			}
 
 			i++;
@@ -400,6 +752,24 @@ namespace DaisyEngine
 		return requiredExtensions.empty();
 	}
 
+	bool Device::IsDeviceExtensionSupported(VkPhysicalDevice device, const char* extensionName)
+	{
+		uint32_t extensionCount;
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+		for (const VkExtensionProperties& extension : availableExtensions)
+		{
+			if (strcmp(extension.extensionName, extensionName) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
 	SwapChainSupportDetails Device::QuerySwapChainSupport(VkPhysicalDevice device)
 	{
 		SwapChainSupportDetails details;
@@ -462,7 +832,7 @@ namespace DaisyEngine
 		throw std::runtime_error("Failed to find supported format!");
 	}
 
-	void Device::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+	void Device::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, Allocation& bufferAllocation)
 	{
 		VkBufferCreateInfo bufferInfo{};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -470,6 +840,16 @@ namespace DaisyEngine
 		bufferInfo.usage = usage;
 		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+		// Buffers written by the transfer queue are shared with it, so no ownership transfer is needed
+		uint32_t queueFamilyIndices[] = { _queueFamilies.graphicsFamily, _queueFamilies.transferFamily };
+		if (_queueFamilies.transferFamilyHasValue
+			&& (usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT))
+		{
+			bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			bufferInfo.queueFamilyIndexCount = 2;
+			bufferInfo.pQueueFamilyIndices = queueFamilyIndices;
+		}
+
 		if (vkCreateBuffer(_device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to create vertex buffer!");
@@ -478,17 +858,19 @@ namespace DaisyEngine
 		VkMemoryRequirements memRequirements;
 		vkGetBufferMemoryRequirements(_device, buffer, &memRequirements);
 
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
+		uint32_t memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
+		bufferAllocation = _allocator->Allocate(memRequirements, memoryTypeIndex, MemoryAllocator::ResourceKind::Linear);
 
-		if (vkAllocateMemory(_device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
+		if (vkBindBufferMemory(_device, buffer, bufferAllocation.memory, bufferAllocation.offset) != VK_SUCCESS)
 		{
-			throw std::runtime_error("Failed to allocate vertex buffer memory!");
+			throw std::runtime_error("Failed to bind vertex buffer memory!");
 		}
+	}
 
-		vkBindBufferMemory(_device, buffer, bufferMemory, 0);
+	void Device::DestroyBuffer(VkBuffer buffer, Allocation& bufferAllocation)
+	{
+		vkDestroyBuffer(_device, buffer, nullptr);
+		_allocator->Free(bufferAllocation);
 	}
 
 	VkCommandBuffer Device::BeginSingleTimeCommands()
@@ -519,8 +901,19 @@ namespace DaisyEngine
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &commandBuffer;
 
-		vkQueueSubmit(_graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-		vkQueueWaitIdle(_graphicsQueue);
+		// Wait for this submission only instead of draining the whole graphics queue
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		VkFence fence;
+		if (vkCreateFence(_device, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create single time command fence!");
+		}
+
+		vkQueueSubmit(_graphicsQueue, 1, &submitInfo, fence);
+		vkWaitForFences(_device, 1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+		vkDestroyFence(_device, fence, nullptr);
 
 		vkFreeCommandBuffers(_device, _commandPool, 1, &commandBuffer);
 	}
@@ -560,7 +953,7 @@ namespace DaisyEngine
 		EndSingleTimeCommands(commandBuffer);
 	}
 
-	void Device::CreateImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
+	void Device::CreateImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image, Allocation& imageAllocation)
 	{
 		if (vkCreateImage(_device, &imageInfo, nullptr, &image) != VK_SUCCESS)
 		{
@@ -570,19 +963,21 @@ namespace DaisyEngine
 		VkMemoryRequirements memRequirements;
 		vkGetImageMemoryRequirements(_device, image, &memRequirements);
 
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
+		uint32_t memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
+		MemoryAllocator::ResourceKind kind = imageInfo.tiling == VK_IMAGE_TILING_OPTIMAL
+			? MemoryAllocator::ResourceKind::Optimal
+			: MemoryAllocator::ResourceKind::Linear;
+		imageAllocation = _allocator->Allocate(memRequirements, memoryTypeIndex, kind);
 
-		if (vkAllocateMemory(_device, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
-		{
-			throw std::runtime_error("Failed to allocate image memory!");
-		}
-
-		if (vkBindImageMemory(_device, image, imageMemory, 0) != VK_SUCCESS)
+		if (vkBindImageMemory(_device, image, imageAllocation.memory, imageAllocation.offset) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to bind image memory!");
 		}
 	}
+
+	void Device::DestroyImage(VkImage image, Allocation& imageAllocation)
+	{
+		vkDestroyImage(_device, image, nullptr);
+		_allocator->Free(imageAllocation);
+	}
 } // namespace DaisyEngine
\ No newline at end of file
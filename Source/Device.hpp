@@ -1,10 +1,14 @@
 #pragma once
 #include "Window.hpp"
+#include "MemoryAllocator.hpp"
 
+#include <memory>
 #include <vector>
 
 namespace DaisyEngine
 {
+	class UploadService;
+
 	/// <summary>
 	/// The SwapChainSupportDetails struct is used to store the capabilities of the swap chain, the supported formats, and the supported present modes.
 	/// </summary>
@@ -16,14 +20,16 @@ namespace DaisyEngine
 	};
 
 	/// <summary>
-	/// The QueueFamilyIndices struct is used to store the indices of the graphics and present queues.
+	/// The QueueFamilyIndices struct is used to store the indices of the graphics, present and transfer queues.
 	/// </summary>
 	struct QueueFamilyIndices
 	{
 		uint32_t graphicsFamily{};
 		uint32_t presentFamily{};
+		uint32_t transferFamily{}; // Dedicated transfer family, only valid if transferFamilyHasValue
 		bool graphicsFamilyHasValue = false;
 		bool presentFamilyHasValue = false;
+		bool transferFamilyHasValue = false;
 
 		bool IsComplete()
 		{
@@ -31,6 +37,17 @@ namespace DaisyEngine
 		}
 	};
 
+	/// <summary>
+	/// The PipelineCacheStats struct reports whether the pipeline cache was loaded from disk and the time spent creating pipelines.
+	/// </summary>
+	struct PipelineCacheStats
+	{
+		bool isWarm = false;
+		size_t loadedBytes = 0;
+		uint32_t pipelineCount = 0;
+		double creationMilliseconds = 0.0;
+	};
+
 	/// <summary>
 	/// The Device class is used to create the Vulkan instance, the logical device, and the command pool.
 	/// </summary>
@@ -44,8 +61,12 @@ namespace DaisyEngine
 		const bool enableValidationLayers = true;
 #endif // ! NDEBUG
 
+		static constexpr const char* PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+
 		// --- Constructor/ Destructor ---
 		Device(Window& window);
+		// Headless device: no surface, no swap chain extension, only a graphics queue
+		Device();
 		~Device();
 
 		// Not copyable or movable
@@ -54,11 +75,24 @@ namespace DaisyEngine
 		Device(Device&&) = delete;
 		Device& operator=(Device&&) = delete;
 
+		inline bool IsHeadless() const { return _window == nullptr; }
 		inline VkCommandPool GetCommandPool() { return _commandPool; }
 		inline VkDevice GetDevice() { return _device; }
+		inline VkInstance GetInstance() { return _instance; }
+		inline VkPhysicalDevice GetPhysicalDevice() { return _physicalDevice; }
+		inline const VkPhysicalDeviceFeatures& GetEnabledFeatures() const { return _enabledFeatures; }
+		// VK_KHR_draw_indirect_count, the two functions are null when it is not supported
+		inline bool IsDrawIndirectCountSupported() const { return _isDrawIndirectCountSupported; }
+		inline PFN_vkCmdDrawIndirectCountKHR GetCmdDrawIndirectCount() const { return _cmdDrawIndirectCount; }
+		inline PFN_vkCmdDrawIndexedIndirectCountKHR GetCmdDrawIndexedIndirectCount() const { return _cmdDrawIndexedIndirectCount; }
 		inline VkSurfaceKHR GetSurface() { return _surface; }
 		inline VkQueue GetGraphicsQueue() { return _graphicsQueue; }
 		inline VkQueue GetPresentQueue() { return _presentQueue; }
+		inline VkQueue GetTransferQueue() { return _transferQueue; }
+		inline UploadService& GetUploadService() { return *_uploadService; }
+		inline VkPipelineCache GetPipelineCache() { return _pipelineCache; }
+		inline const PipelineCacheStats& GetPipelineCacheStats() const { return _pipelineCacheStats; }
+		void RecordPipelineCreation(double milliseconds);
 
 		inline SwapChainSupportDetails GetSwapChainSupport() { return QuerySwapChainSupport(_physicalDevice); }
 		inline QueueFamilyIndices FindPhysicalQueueFamilies() { return FindQueueFamilies(_physicalDevice); }
@@ -66,48 +100,75 @@ namespace DaisyEngine
 		VkFormat FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
 		// Buffer helper functions
-		void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+		void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, Allocation& bufferAllocation);
+		void DestroyBuffer(VkBuffer buffer, Allocation& bufferAllocation);
 		VkCommandBuffer BeginSingleTimeCommands();
 		void EndSingleTimeCommands(VkCommandBuffer commandBuffer);
 		void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 		void CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
-		void CreateImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
+		void CreateImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image, Allocation& imageAllocation);
+		void DestroyImage(VkImage image, Allocation& imageAllocation);
+
+		// Memory statistics per heap (usage, fragmentation)
+		inline MemoryStats GetMemoryStats() { return _allocator->GetStats(); }
 
 		VkPhysicalDeviceProperties _properties;
 
 	private:
 		// --- Methods ---
+		void Init();
 		void CreateInstance();
 		void SetupDebugMessenger();
 		void CreateSurface();
 		void PickPhysicalDevice();
 		void CreateLogicalDevice();
 		void CreateCommandPool();
+		void CreateAllocator();
+		void CreateUploadService();
+		void CreatePipelineCache();
+		void SavePipelineCache();
+		bool IsPipelineCacheCompatible(const std::vector<char>& data);
 
 		// --- Helper Methods ---
 		bool IsDeviceSuitable(VkPhysicalDevice device);
 		std::vector<const char*> GetRequiredExtensions();
 		bool CheckValidationLayerSupport();
+		bool IsInstanceExtensionSupported(const char* extensionName);
+		void QueryDriverUUID();
 		QueueFamilyIndices FindQueueFamilies(VkPhysicalDevice device);
 		void PopulateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
 		void HasGlfwRequiredInstanceExtensions();
 		bool CheckDeviceExtensionSupport(VkPhysicalDevice device);
+		bool IsDeviceExtensionSupported(VkPhysicalDevice device, const char* extensionName);
 		SwapChainSupportDetails QuerySwapChainSupport(VkPhysicalDevice device);
 
 		// --- Variables ---
 		VkInstance _instance;
 		VkDebugUtilsMessengerEXT _debugMessenger;
 		VkPhysicalDevice _physicalDevice = VK_NULL_HANDLE;
-		Window& _window;
+		Window* _window = nullptr; // Null when headless
 		VkCommandPool _commandPool;
+		std::unique_ptr<MemoryAllocator> _allocator;
+		std::unique_ptr<UploadService> _uploadService;
+		QueueFamilyIndices _queueFamilies;
+		VkPhysicalDeviceFeatures _enabledFeatures{};
+		bool _isDrawIndirectCountSupported = false;
+		PFN_vkCmdDrawIndirectCountKHR _cmdDrawIndirectCount = nullptr;
+		PFN_vkCmdDrawIndexedIndirectCountKHR _cmdDrawIndexedIndirectCount = nullptr;
+		VkPipelineCache _pipelineCache = VK_NULL_HANDLE;
+		PipelineCacheStats _pipelineCacheStats;
+		// VK_KHR_get_physical_device_properties2 and VK_KHR_external_memory_capabilities, enabled when both are available
+		bool _isDeviceIDQuerySupported = false;
+		uint8_t _driverUUID[VK_UUID_SIZE]{}; // Of VkPhysicalDeviceIDProperties, all zeros without the extensions
 
 		VkDevice _device;
-		VkSurfaceKHR _surface;
+		VkSurfaceKHR _surface = VK_NULL_HANDLE;
 		VkQueue _graphicsQueue;
 		VkQueue _presentQueue;
+		VkQueue _transferQueue;
 
 		// --- Constants ---
 		const std::vector<const char*> _validationLayers = {"VK_LAYER_KHRONOS_validation"};
-		const std::vector<const char*> _deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+		std::vector<const char*> _deviceExtensions; // VK_KHR_swapchain unless headless
 	};
 } // namespace DaisyEngine
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "DrawCommandBuffer.hpp"
+
+// std
+#include <cassert>
+#include <cstring>
+
+namespace DaisyEngine
+{
+	DrawStateStats& DrawStateStats::operator+=(const DrawStateStats& other)
+	{
+		drawCount += other.drawCount;
+		pipelineBinds += other.pipelineBinds;
+		skippedPipelineBinds += other.skippedPipelineBinds;
+		descriptorSetBinds += other.descriptorSetBinds;
+		skippedDescriptorSetBinds += other.skippedDescriptorSetBinds;
+		vertexBufferBinds += other.vertexBufferBinds;
+		skippedVertexBufferBinds += other.skippedVertexBufferBinds;
+		indexBufferBinds += other.indexBufferBinds;
+		skippedIndexBufferBinds += other.skippedIndexBufferBinds;
+		pushConstantUpdates += other.pushConstantUpdates;
+		skippedPushConstantUpdates += other.skippedPushConstantUpdates;
+		return *this;
+	}
+
+	DrawCommandBuffer::DrawCommandBuffer(VkCommandBuffer commandBuffer)
+		: _commandBuffer(commandBuffer)
+	{
+	}
+
+	void DrawCommandBuffer::BindPipeline(VkPipeline pipeline)
+	{
+		if (pipeline == _pipeline)
+		{
+			_stats.skippedPipelineBinds++;
+			return;
+		}
+
+		vkCmdBindPipeline(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		_pipeline = pipeline;
+		_stats.pipelineBinds++;
+	}
+
+	void DrawCommandBuffer::BindDescriptorSet(VkPipelineLayout pipelineLayout, uint32_t set, VkDescriptorSet descriptorSet)
+	{
+		assert(set < MAX_DESCRIPTOR_SETS && "Descriptor set index out of range");
+
+		SetPipelineLayout(pipelineLayout);
+		if (descriptorSet == _descriptorSets[set])
+		{
+			_stats.skippedDescriptorSetBinds++;
+			return;
+		}
+
+		vkCmdBindDescriptorSets(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, set, 1, &descriptorSet, 0, nullptr);
+		_descriptorSets[set] = descriptorSet;
+		_stats.descriptorSetBinds++;
+	}
+
+	void DrawCommandBuffer::BindVertexBuffer(uint32_t binding, VkBuffer buffer, VkDeviceSize offset)
+	{
+		assert(binding < MAX_VERTEX_BINDINGS && "Vertex binding out of range");
+
+		BufferBinding& bound = _vertexBuffers[binding];
+		if (buffer == bound.buffer && offset == bound.offset)
+		{
+			_stats.skippedVertexBufferBinds++;
+			return;
+		}
+
+		vkCmdBindVertexBuffers(_commandBuffer, binding, 1, &buffer, &offset);
+		bound.buffer = buffer;
+		bound.offset = offset;
+		_stats.vertexBufferBinds++;
+	}
+
+	void DrawCommandBuffer::BindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
+	{
+		if (buffer == _indexBuffer.buffer && offset == _indexBuffer.offset && indexType == _indexBuffer.indexType)
+		{
+			_stats.skippedIndexBufferBinds++;
+			return;
+		}
+
+		vkCmdBindIndexBuffer(_commandBuffer, buffer, offset, indexType);
+		_indexBuffer.buffer = buffer;
+		_indexBuffer.offset = offset;
+		_indexBuffer.indexType = indexType;
+		_stats.indexBufferBinds++;
+	}
+
+	void DrawCommandBuffer::PushConstants(VkPipelineLayout pipelineLayout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* values)
+	{
+		assert(offset % 4 == 0 && size % 4 == 0 && "Push constant ranges are multiples of 4 bytes");
+		assert(offset + size <= MAX_PUSH_CONSTANT_SIZE && "Push constant range out of range");
+
+		SetPipelineLayout(pipelineLayout);
+
+		const uint64_t wordMask = ((1ull << (size / 4)) - 1) << (offset / 4);
+		const uint32_t rangeMask = static_cast<uint32_t>(wordMask);
+		if ((_pushConstantMask & rangeMask) == rangeMask && std::memcmp(&_pushConstants[offset], values, size) == 0)
+		{
+			_stats.skippedPushConstantUpdates++;
+			return;
+		}
+
+		vkCmdPushConstants(_commandBuffer, pipelineLayout, stageFlags, offset, size, values);
+		std::memcpy(&_pushConstants[offset], values, size);
+		_pushConstantMask |= rangeMask;
+		_stats.pushConstantUpdates++;
+	}
+
+	void DrawCommandBuffer::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+	{
+		vkCmdDraw(_commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+		_stats.drawCount++;
+	}
+
+	void DrawCommandBuffer::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
+	{
+		vkCmdDrawIndexed(_commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+		_stats.drawCount++;
+	}
+
+	void DrawCommandBuffer::Invalidate()
+	{
+		_pipeline = VK_NULL_HANDLE;
+		_pipelineLayout = VK_NULL_HANDLE;
+		_descriptorSets.fill(VK_NULL_HANDLE);
+		_vertexBuffers.fill(BufferBinding{});
+		_indexBuffer = BufferBinding{};
+		_pushConstantMask = 0;
+	}
+
+	void DrawCommandBuffer::SetPipelineLayout(VkPipelineLayout pipelineLayout)
+	{
+		// A different layout may not be compatible, what was bound with the previous one can no longer be relied on
+		if (pipelineLayout != _pipelineLayout)
+		{
+			_pipelineLayout = pipelineLayout;
+			_descriptorSets.fill(VK_NULL_HANDLE);
+			_pushConstantMask = 0;
+		}
+	}
+} // namespace DaisyEngine
@@ -0,0 +1,100 @@
+#pragma once
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+// std
+#include <array>
+#include <cstdint>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The DrawStateStats struct counts the state changes a DrawCommandBuffer recorded and the ones it skipped because the
+	/// state was already bound.
+	/// </summary>
+	struct DrawStateStats
+	{
+		uint32_t drawCount = 0;
+		uint32_t pipelineBinds = 0;
+		uint32_t skippedPipelineBinds = 0;
+		uint32_t descriptorSetBinds = 0;
+		uint32_t skippedDescriptorSetBinds = 0;
+		uint32_t vertexBufferBinds = 0;
+		uint32_t skippedVertexBufferBinds = 0;
+		uint32_t indexBufferBinds = 0;
+		uint32_t skippedIndexBufferBinds = 0;
+		uint32_t pushConstantUpdates = 0;
+		uint32_t skippedPushConstantUpdates = 0;
+
+		DrawStateStats& operator+=(const DrawStateStats& other);
+	};
+
+	/// <summary>
+	/// The DrawCommandBuffer class records draws in a command buffer and drops the binds of a state that is already bound:
+	/// pipeline, descriptor sets, vertex and index buffers, and push constants whose bytes did not change. It starts with
+	/// nothing bound, like a command buffer that was just begun, and only knows the commands recorded through it.
+	/// Push constants and descriptor sets are kept as long as the pipeline layout stays the same, every pipeline bound
+	/// through one DrawCommandBuffer must then use compatible layouts. Like a command buffer, it is used by one thread at a time.
+	/// </summary>
+	class DrawCommandBuffer
+	{
+	public:
+		// --- Constants ---
+		static constexpr uint32_t MAX_PUSH_CONSTANT_SIZE = 128; // The size every device supports
+		static constexpr uint32_t MAX_DESCRIPTOR_SETS = 4;
+		static constexpr uint32_t MAX_VERTEX_BINDINGS = 4;
+
+		// --- Constructor ---
+		explicit DrawCommandBuffer(VkCommandBuffer commandBuffer);
+
+		DrawCommandBuffer(const DrawCommandBuffer&) = delete;
+		DrawCommandBuffer& operator=(const DrawCommandBuffer&) = delete;
+
+		// --- Methods ---
+		void BindPipeline(VkPipeline pipeline);
+		void BindDescriptorSet(VkPipelineLayout pipelineLayout, uint32_t set, VkDescriptorSet descriptorSet);
+		void BindVertexBuffer(uint32_t binding, VkBuffer buffer, VkDeviceSize offset = 0);
+		void BindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+		// offset and size are multiples of 4, the stages must be the same for every update of a range
+		void PushConstants(VkPipelineLayout pipelineLayout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* values);
+
+		void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
+		void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance);
+
+		// Forgets the bound state, after commands recorded without the DrawCommandBuffer changed it
+		void Invalidate();
+
+		inline VkCommandBuffer GetCommandBuffer() const { return _commandBuffer; }
+		inline const DrawStateStats& GetStats() const { return _stats; }
+
+	private:
+		/// <summary>
+		/// A vertex buffer binding, or the index buffer.
+		/// </summary>
+		struct BufferBinding
+		{
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VkDeviceSize offset = 0;
+			VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+		};
+
+		// --- Methods ---
+		void SetPipelineLayout(VkPipelineLayout pipelineLayout);
+
+		// --- Variables ---
+		VkCommandBuffer _commandBuffer;
+		DrawStateStats _stats;
+
+		VkPipeline _pipeline = VK_NULL_HANDLE;
+		VkPipelineLayout _pipelineLayout = VK_NULL_HANDLE;
+		std::array<VkDescriptorSet, MAX_DESCRIPTOR_SETS> _descriptorSets{};
+		std::array<BufferBinding, MAX_VERTEX_BINDINGS> _vertexBuffers{};
+		BufferBinding _indexBuffer{};
+
+		// The last values pushed, a bit per 4 bytes tells which ones were pushed since the layout was set
+		std::array<uint8_t, MAX_PUSH_CONSTANT_SIZE> _pushConstants{};
+		uint32_t _pushConstantMask = 0;
+		static_assert(MAX_PUSH_CONSTANT_SIZE / 4 <= 32, "The push constant mask holds one bit per 4 bytes");
+	};
+} // namespace DaisyEngine
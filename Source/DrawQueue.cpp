@@ -0,0 +1,137 @@
+#include "DrawQueue.hpp"
+#include "JobSystem.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+
+namespace DaisyEngine
+{
+	// Calls function for every part, on the workers of the job system when there is more than one
+	template<typename Function>
+	static void ForEachPart(JobSystem* jobSystem, uint32_t partCount, const Function& function)
+	{
+		if (partCount == 1)
+		{
+			function(0);
+			return;
+		}
+
+		jobSystem->ParallelFor(partCount, 1, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t part = begin; part < end; ++part)
+				{
+					function(part);
+				}
+			});
+	}
+
+	uint64_t DrawQueue::MakeSortKey(uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t depthBucket)
+	{
+		assert(pipeline < (1u << PIPELINE_BITS) && "Pipeline index does not fit the sort key");
+		assert(material < (1u << MATERIAL_BITS) && "Material index does not fit the sort key");
+		assert(mesh < (1u << MESH_BITS) && "Mesh index does not fit the sort key");
+		assert(depthBucket < (1u << DEPTH_BITS) && "Depth bucket does not fit the sort key");
+
+		return (static_cast<uint64_t>(pipeline) << PIPELINE_SHIFT)
+			| (static_cast<uint64_t>(material) << MATERIAL_SHIFT)
+			| (static_cast<uint64_t>(mesh) << MESH_SHIFT)
+			| (static_cast<uint64_t>(depthBucket) << DEPTH_SHIFT);
+	}
+
+	uint32_t DrawQueue::GetDepthBucket(float depth)
+	{
+		// Also catches NaN
+		if (!(depth > 0.0f))
+		{
+			return 0;
+		}
+
+		const float lastBucket = static_cast<float>((1u << DEPTH_BITS) - 1);
+		return static_cast<uint32_t>(std::min(depth, 1.0f) * lastBucket + 0.5f);
+	}
+
+	void DrawQueue::Sort(JobSystem* jobSystem)
+	{
+		const size_t packetCount = _packets.size();
+		if (packetCount < 2)
+		{
+			return;
+		}
+
+		assert(packetCount <= UINT32_MAX && "Too many packets for the 32 bit digit counts");
+
+		uint32_t partCount = 1;
+		if (jobSystem != nullptr)
+		{
+			size_t usefulPartCount = (packetCount + MIN_PACKETS_PER_JOB - 1) / MIN_PACKETS_PER_JOB;
+			partCount = static_cast<uint32_t>(std::min<size_t>(usefulPartCount, jobSystem->GetWorkerCount()));
+			partCount = std::max(partCount, 1u);
+		}
+
+		_partSize = (packetCount + partCount - 1) / partCount;
+		_histograms.resize(partCount);
+		_sortedPackets.resize(packetCount);
+
+		// The bits that differ between any two keys, a pass over a digit without any of them keeps the order as is
+		const uint64_t firstKey = _packets[0].sortKey;
+		uint64_t differingBits = 0;
+		for (const DrawPacket& packet : _packets)
+		{
+			differingBits |= packet.sortKey ^ firstKey;
+		}
+
+		for (uint32_t pass = 0; pass < PASS_COUNT; ++pass)
+		{
+			const uint32_t shift = pass * RADIX_BITS;
+			if (((differingBits >> shift) & (RADIX_SIZE - 1)) == 0)
+			{
+				continue;
+			}
+
+			ForEachPart(jobSystem, partCount, [&](uint32_t part) { CountDigits(part, shift); });
+
+			// Prefix sum by digit then by part: each part writes a digit after the same digit of the parts before it,
+			// which keeps the sort stable
+			uint32_t offset = 0;
+			for (uint32_t digit = 0; digit < RADIX_SIZE; ++digit)
+			{
+				for (Histogram& histogram : _histograms)
+				{
+					uint32_t count = histogram[digit];
+					histogram[digit] = offset;
+					offset += count;
+				}
+			}
+
+			ForEachPart(jobSystem, partCount, [&](uint32_t part) { ScatterDigits(part, shift); });
+			_packets.swap(_sortedPackets);
+		}
+	}
+
+	void DrawQueue::CountDigits(uint32_t part, uint32_t shift)
+	{
+		Histogram& histogram = _histograms[part];
+		histogram.fill(0);
+
+		const size_t first = part * _partSize;
+		const size_t last = std::min(first + _partSize, _packets.size());
+		for (size_t i = first; i < last; ++i)
+		{
+			histogram[(_packets[i].sortKey >> shift) & (RADIX_SIZE - 1)]++;
+		}
+	}
+
+	void DrawQueue::ScatterDigits(uint32_t part, uint32_t shift)
+	{
+		Histogram& offsets = _histograms[part];
+
+		const size_t first = part * _partSize;
+		const size_t last = std::min(first + _partSize, _packets.size());
+		for (size_t i = first; i < last; ++i)
+		{
+			const DrawPacket& packet = _packets[i];
+			_sortedPackets[offsets[(packet.sortKey >> shift) & (RADIX_SIZE - 1)]++] = packet;
+		}
+	}
+} // namespace DaisyEngine
@@ -0,0 +1,83 @@
+#pragma once
+
+// std
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace DaisyEngine
+{
+	class JobSystem;
+
+	/// <summary>
+	/// The DrawPacket struct is one draw submitted to a DrawQueue: its sort key and the object the render system draws with it.
+	/// </summary>
+	struct DrawPacket
+	{
+		uint64_t sortKey;
+		uint32_t object;
+	};
+
+	/// <summary>
+	/// The DrawQueue class gathers the draws of a render system for one frame and sorts them by key before they are recorded.
+	/// A key holds, from the most significant bits, the pipeline, the material, the mesh and a depth bucket, so draws sharing
+	/// a pipeline are recorded together, then the ones sharing a material and a mesh, front to back inside each mesh.
+	/// The sort is a least significant digit radix sort on 8 bit digits, stable, spread over the job system when one is given:
+	/// every job counts the digits of its part of the queue, then scatters it to the offsets of the prefix sum of all counts.
+	/// Digits equal in every key, like the unused high bits of the pipeline, are skipped.
+	/// </summary>
+	class DrawQueue
+	{
+	public:
+		// --- Constants ---
+		static constexpr uint32_t PIPELINE_BITS = 8;
+		static constexpr uint32_t MATERIAL_BITS = 16;
+		static constexpr uint32_t MESH_BITS = 24;
+		static constexpr uint32_t DEPTH_BITS = 16;
+		static constexpr uint32_t DEPTH_SHIFT = 0;
+		static constexpr uint32_t MESH_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+		static constexpr uint32_t MATERIAL_SHIFT = MESH_SHIFT + MESH_BITS;
+		static constexpr uint32_t PIPELINE_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS;
+		static_assert(PIPELINE_SHIFT + PIPELINE_BITS == 64, "The sort key fields must fill 64 bits");
+
+		static constexpr uint32_t RADIX_BITS = 8;
+		static constexpr uint32_t RADIX_SIZE = 1u << RADIX_BITS;
+		static constexpr uint32_t PASS_COUNT = 64 / RADIX_BITS;
+		static constexpr uint32_t MIN_PACKETS_PER_JOB = 8192; // Smaller parts cost more in counts to merge than they save
+
+		// --- Methods ---
+		// Each field must fit its bits
+		static uint64_t MakeSortKey(uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t depthBucket);
+
+		// A depth between 0 (near) and 1 (far) as a bucket of the key, depths outside are clamped
+		static uint32_t GetDepthBucket(float depth);
+
+		static inline uint32_t GetPipeline(uint64_t sortKey) { return static_cast<uint32_t>(sortKey >> PIPELINE_SHIFT); }
+		static inline uint32_t GetMesh(uint64_t sortKey) { return static_cast<uint32_t>(sortKey >> MESH_SHIFT) & ((1u << MESH_BITS) - 1); }
+
+		inline void Clear() { _packets.clear(); }
+		inline void Reserve(size_t packetCount) { _packets.reserve(packetCount); }
+		inline void Submit(uint64_t sortKey, uint32_t object) { _packets.push_back({ sortKey, object }); }
+
+		// Without a job system the queue is sorted on the calling thread, with one it must be called from one of its workers
+		void Sort(JobSystem* jobSystem = nullptr);
+
+		inline const std::vector<DrawPacket>& GetPackets() const { return _packets; }
+		inline size_t Size() const { return _packets.size(); }
+		inline bool IsEmpty() const { return _packets.empty(); }
+
+	private:
+		using Histogram = std::array<uint32_t, RADIX_SIZE>;
+
+		// --- Methods ---
+		void CountDigits(uint32_t part, uint32_t shift);
+		void ScatterDigits(uint32_t part, uint32_t shift);
+
+		// --- Variables ---
+		std::vector<DrawPacket> _packets;
+		std::vector<DrawPacket> _sortedPackets; // The destination of a pass, swapped with _packets after it
+		std::vector<Histogram> _histograms; // Counts of one pass per part, then the first slot of each digit of the part
+		size_t _partSize = 0;
+	};
+} // namespace DaisyEngine
@@ -0,0 +1,41 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <functional>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The Entity struct is a generational handle into a World. The index slot is reused once the entity is destroyed,
+	/// the generation is bumped at the same time so stale handles to the old entity are detected instead of aliasing the new one.
+	/// </summary>
+	struct Entity
+	{
+		// --- Constants ---
+		static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+		// --- Variables ---
+		uint32_t index = INVALID_INDEX;
+		uint32_t generation = 0;
+
+		// --- Methods ---
+		inline bool IsValid() const { return index != INVALID_INDEX; }
+		inline uint64_t GetId() const { return (static_cast<uint64_t>(generation) << 32) | index; }
+
+		inline bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+		inline bool operator!=(const Entity& other) const { return !(*this == other); }
+	};
+} // namespace DaisyEngine
+
+namespace std
+{
+	template <>
+	struct hash<DaisyEngine::Entity>
+	{
+		size_t operator()(const DaisyEngine::Entity& entity) const
+		{
+			return hash<uint64_t>()(entity.GetId());
+		}
+	};
+} // namespace std
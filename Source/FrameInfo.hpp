@@ -0,0 +1,36 @@
+#pragma once
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+namespace DaisyEngine
+{
+	class ParallelCommandRecorder;
+	class GpuProfiler;
+	class JobSystem;
+	class LodSelector;
+
+	/// <summary>
+	/// The FrameInfo struct gathers what the render systems need to record the current frame.
+	/// </summary>
+	struct FrameInfo
+	{
+		int frameIndex;
+		VkCommandBuffer commandBuffer;
+
+		// Only needed to record secondary command buffers inside the swap chain render pass
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
+		VkExtent2D extent{};
+		ParallelCommandRecorder* commandRecorder = nullptr;
+
+		// Optional, render systems open their GPU profiler scopes in it
+		GpuProfiler* gpuProfiler = nullptr;
+
+		// Optional, render systems spread their CPU work over it. Recording must then happen on one of its workers
+		JobSystem* jobSystem = nullptr;
+
+		// Optional, the level of detail of each object. Without it every object is drawn at full detail
+		const LodSelector* lodSelector = nullptr;
+	};
+} // namespace DaisyEngine
@@ -0,0 +1,172 @@
+#include "FrustumCuller.hpp"
+#include "TransformBatch.hpp"
+#include "Model.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DAISY_CULL_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace DaisyEngine
+{
+	const std::vector<uint32_t>& FrustumCuller::Cull(const glm::mat4& viewProjection, const RenderView& entities, JobSystem* jobSystem)
+	{
+		const size_t count = entities.Size();
+
+		ExtractPlanes(viewProjection, _planes);
+		Resize(count);
+
+		if (jobSystem == nullptr)
+		{
+			PackSpheres(entities, 0, count);
+			TestSpheres(0, count, _visibleObjects);
+		}
+		else
+		{
+			// Every range only writes its own slots and its own list, the lists are joined in range order
+			_jobVisibleObjects.resize((count + OBJECTS_PER_JOB - 1) / OBJECTS_PER_JOB);
+			for (std::vector<uint32_t>& jobVisibleObjects : _jobVisibleObjects)
+			{
+				jobVisibleObjects.clear();
+			}
+
+			jobSystem->ParallelFor(static_cast<uint32_t>(count), OBJECTS_PER_JOB, [&](uint32_t begin, uint32_t end)
+				{
+					PackSpheres(entities, begin, end);
+					TestSpheres(begin, end, _jobVisibleObjects[begin / OBJECTS_PER_JOB]);
+				});
+
+			_visibleObjects.clear();
+			for (const std::vector<uint32_t>& jobVisibleObjects : _jobVisibleObjects)
+			{
+				_visibleObjects.insert(_visibleObjects.end(), jobVisibleObjects.begin(), jobVisibleObjects.end());
+			}
+		}
+
+		_stats.visibleCount = static_cast<uint32_t>(_visibleObjects.size());
+		_stats.culledCount = static_cast<uint32_t>(count - _visibleObjects.size());
+		return _visibleObjects;
+	}
+
+	void FrustumCuller::ExtractPlanes(const glm::mat4& viewProjection, std::array<glm::vec4, PLANE_COUNT>& planes)
+	{
+		// Gribb and Hartmann: each plane is a sum of rows of the matrix, with a depth range of [0, 1]
+		glm::vec4 rows[4];
+		for (int row = 0; row < 4; ++row)
+		{
+			rows[row] = { viewProjection[0][row], viewProjection[1][row], viewProjection[2][row], viewProjection[3][row] };
+		}
+
+		planes[0] = rows[3] + rows[0]; // left
+		planes[1] = rows[3] - rows[0]; // right
+		planes[2] = rows[3] + rows[1]; // top, y points down
+		planes[3] = rows[3] - rows[1]; // bottom
+		planes[4] = rows[2]; // near
+		planes[5] = rows[3] - rows[2]; // far
+
+		for (glm::vec4& plane : planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+	}
+
+	void FrustumCuller::Resize(size_t count)
+	{
+		_transformStore.Resize(count);
+		_worldMatrices.resize(count);
+		_centerX.resize(count);
+		_centerY.resize(count);
+		_centerZ.resize(count);
+		_radius.resize(count);
+	}
+
+	void FrustumCuller::PackSpheres(const RenderView& entities, size_t first, size_t last)
+	{
+		const Transform* transforms = entities.transforms;
+		const RenderComponent* renderComponents = entities.renderComponents;
+
+		for (size_t i = first; i < last; ++i)
+		{
+			_transformStore.Set(i, transforms[i]);
+		}
+
+		ComputeTransformMatrices(_transformStore, first, last - first, &_worldMatrices[first], sizeof(glm::mat4));
+
+		for (size_t i = first; i < last; ++i)
+		{
+			// A streamed mesh that is not resident has nothing to draw, an infinitely negative radius fails every plane
+			if (renderComponents[i].model == nullptr)
+			{
+				_centerX[i] = _centerY[i] = _centerZ[i] = 0.0f;
+				_radius[i] = -std::numeric_limits<float>::infinity();
+				continue;
+			}
+
+			const BoundingSphere& sphere = renderComponents[i].model->GetBoundingSphere();
+			const glm::vec3& scale = transforms[i].scale;
+
+			// Rotation keeps the radius, only the largest scale axis can grow it
+			glm::vec4 center = _worldMatrices[i] * glm::vec4(sphere.center, 1.0f);
+			_centerX[i] = center.x;
+			_centerY[i] = center.y;
+			_centerZ[i] = center.z;
+			_radius[i] = sphere.radius * std::max({ std::fabs(scale.x), std::fabs(scale.y), std::fabs(scale.z) });
+		}
+	}
+
+	void FrustumCuller::TestSpheres(size_t first, size_t last, std::vector<uint32_t>& visibleObjects)
+	{
+		visibleObjects.clear();
+
+		size_t i = first;
+
+#ifdef DAISY_CULL_SSE2
+		// A sphere is visible unless it lies entirely behind one of the planes
+		for (; i + 4 <= last; i += 4)
+		{
+			__m128 centerX = _mm_loadu_ps(&_centerX[i]);
+			__m128 centerY = _mm_loadu_ps(&_centerY[i]);
+			__m128 centerZ = _mm_loadu_ps(&_centerZ[i]);
+			__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&_radius[i]));
+
+			__m128 isVisible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (const glm::vec4& plane : _planes)
+			{
+				__m128 distance = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(plane.x)), _mm_mul_ps(centerY, _mm_set1_ps(plane.y))),
+					_mm_add_ps(_mm_mul_ps(centerZ, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+				isVisible = _mm_and_ps(isVisible, _mm_cmpge_ps(distance, negativeRadius));
+			}
+
+			int mask = _mm_movemask_ps(isVisible);
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				if (mask & (1 << lane))
+				{
+					visibleObjects.push_back(static_cast<uint32_t>(i + lane));
+				}
+			}
+		}
+#endif
+
+		for (; i < last; ++i)
+		{
+			bool isVisible = true;
+			for (const glm::vec4& plane : _planes)
+			{
+				float distance = plane.x * _centerX[i] + plane.y * _centerY[i] + plane.z * _centerZ[i] + plane.w;
+				isVisible &= distance >= -_radius[i];
+			}
+
+			if (isVisible)
+			{
+				visibleObjects.push_back(static_cast<uint32_t>(i));
+			}
+		}
+	}
+} // namespace DaisyEngine
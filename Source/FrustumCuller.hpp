@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Components.hpp"
+#include "TransformStore.hpp"
+#include "JobSystem.hpp"
+
+// Libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The CullingStats struct reports the result of the last FrustumCuller::Cull call.
+	/// </summary>
+	struct CullingStats
+	{
+		uint32_t visibleCount = 0;
+		uint32_t culledCount = 0;
+	};
+
+	/// <summary>
+	/// The FrustumCuller class selects the objects whose world space bounding sphere intersects the view frustum.
+	/// The spheres are packed as a structure of arrays so the plane tests run on four spheres at once.
+	/// With a job system, ranges of entities are packed and tested in parallel and their results appended in order.
+	/// </summary>
+	class FrustumCuller
+	{
+	public:
+		// --- Constants ---
+		static constexpr int PLANE_COUNT = 6;
+		static constexpr uint32_t OBJECTS_PER_JOB = 4096;
+
+		// --- Methods ---
+		// Returns the view indices of the visible entities, in increasing order
+		// Must be called from a worker of the job system when one is given
+		const std::vector<uint32_t>& Cull(const glm::mat4& viewProjection, const RenderView& entities, JobSystem* jobSystem = nullptr);
+
+		inline const std::vector<uint32_t>& GetVisibleObjects() const { return _visibleObjects; }
+		inline const CullingStats& GetStats() const { return _stats; }
+
+		// Normalized planes (normal, distance) of the frustum, the normals point inside it
+		static void ExtractPlanes(const glm::mat4& viewProjection, std::array<glm::vec4, PLANE_COUNT>& planes);
+
+	private:
+		// --- Methods ---
+		void Resize(size_t count);
+		void PackSpheres(const RenderView& entities, size_t first, size_t last);
+		void TestSpheres(size_t first, size_t last, std::vector<uint32_t>& visibleObjects);
+
+		// --- Variables ---
+		// Normalized planes (normal, distance), the normals point inside the frustum
+		std::array<glm::vec4, PLANE_COUNT> _planes;
+
+		TransformStore _transformStore;
+		std::vector<glm::mat4> _worldMatrices;
+
+		// World space spheres, one array per component
+		std::vector<float> _centerX;
+		std::vector<float> _centerY;
+		std::vector<float> _centerZ;
+		std::vector<float> _radius;
+
+		std::vector<uint32_t> _visibleObjects;
+		std::vector<std::vector<uint32_t>> _jobVisibleObjects; // Visible objects of each job range, appended to _visibleObjects
+		CullingStats _stats;
+	};
+} // namespace DaisyEngine
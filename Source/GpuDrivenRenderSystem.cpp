@@ -0,0 +1,969 @@
+#include "GpuDrivenRenderSystem.hpp"
+#include "FrustumCuller.hpp"
+#include "GpuProfiler.hpp"
+#include "JobSystem.hpp"
+#include "TransformBatch.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace DaisyEngine
+{
+	// Same block as simple_shader.vert, the GPU driven variants read the position quantization from the mesh buffer instead
+	struct GpuDrivenPushConstantData
+	{
+		glm::mat4 transform{ 1.0f };
+		alignas(16) glm::vec3 color{};
+		alignas(16) glm::vec4 positionScale{ 1.0f };
+		glm::vec4 positionBias{ 0.0f };
+	};
+
+	// Shared by cull_instances.comp, cull_occluded.comp and build_draw_commands.comp
+	struct CullPushConstantData
+	{
+		glm::vec4 planes[FrustumCuller::PLANE_COUNT];
+		uint32_t objectCount;
+		uint32_t commandCount;
+		uint32_t phase;
+		uint32_t padding;
+	};
+
+	static_assert(sizeof(GpuDrivenRenderSystem::ObjectData) == 96, "ObjectData must match the std430 layout of the shaders");
+	static_assert(sizeof(CullPushConstantData) <= 128, "Push constants are only guaranteed up to 128 bytes");
+	static_assert(sizeof(VkDrawIndexedIndirectCommand) == 5 * sizeof(uint32_t), "The shaders write the draw commands 5 words apart");
+
+	static void RecordMemoryBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkAccessFlags srcAccessMask,
+		VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask)
+	{
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstAccessMask = dstAccessMask;
+		vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	GpuDrivenRenderSystem::GpuDrivenRenderSystem(Device& device, VkRenderPass renderPass, uint32_t maxObjectCount, MeshArena* meshArena, bool useVertexPulling)
+		: _device(device), _maxObjectCount(maxObjectCount), _meshArena(meshArena)
+	{
+		// Each mesh finds its visible objects from the first instance of its commands
+		if (!_device.GetEnabledFeatures().drawIndirectFirstInstance)
+		{
+			throw std::runtime_error("GPU driven rendering needs the drawIndirectFirstInstance feature!");
+		}
+
+		if (useVertexPulling && meshArena == nullptr)
+		{
+			throw std::runtime_error("Vertex pulling needs a mesh arena to fetch the vertices from!");
+		}
+
+		CreateBuffers(maxObjectCount);
+		CreateDescriptorSet();
+		CreatePyramidDescriptorSets();
+		CreatePipelineLayouts();
+		CreatePipelines(renderPass, useVertexPulling);
+	}
+
+	GpuDrivenRenderSystem::~GpuDrivenRenderSystem()
+	{
+		for (FrameResources& frame : _frames)
+		{
+			DestroyBuffer(frame.staging);
+			DestroyBuffer(frame.readback);
+		}
+
+		for (Buffer& buffer : _buffers)
+		{
+			DestroyBuffer(buffer);
+		}
+
+		vkDestroyPipelineLayout(_device.GetDevice(), _pipelineLayout, nullptr);
+		vkDestroyPipelineLayout(_device.GetDevice(), _computePipelineLayout, nullptr);
+		vkDestroyPipelineLayout(_device.GetDevice(), _occlusionPipelineLayout, nullptr);
+		vkDestroyDescriptorPool(_device.GetDevice(), _descriptorPool, nullptr);
+		vkDestroyDescriptorSetLayout(_device.GetDevice(), _descriptorSetLayout, nullptr);
+		vkDestroyDescriptorSetLayout(_device.GetDevice(), _pyramidDescriptorSetLayout, nullptr);
+	}
+
+	void GpuDrivenRenderSystem::CreateBuffers(uint32_t maxObjectCount)
+	{
+		const VkBufferUsageFlags uploaded = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		const VkBufferUsageFlags indirect = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+
+		std::array<VkDeviceSize, BINDING_COUNT> sizes{};
+		std::array<VkBufferUsageFlags, BINDING_COUNT> usages{};
+		sizes[OBJECT_BINDING] = sizeof(ObjectData) * static_cast<VkDeviceSize>(std::max(maxObjectCount, 1u));
+		usages[OBJECT_BINDING] = uploaded;
+		sizes[MESH_BINDING] = sizeof(MeshData) * MAX_MESH_COUNT;
+		usages[MESH_BINDING] = uploaded;
+		sizes[COMMAND_DATA_BINDING] = sizeof(CommandData) * MAX_COMMAND_COUNT;
+		usages[COMMAND_DATA_BINDING] = uploaded;
+		sizes[VISIBLE_OBJECT_BINDING] = sizeof(uint32_t) * static_cast<VkDeviceSize>(std::max(maxObjectCount, 1u));
+		usages[VISIBLE_OBJECT_BINDING] = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		sizes[VISIBLE_COUNT_BINDING] = sizeof(uint32_t) * MAX_MESH_COUNT;
+		usages[VISIBLE_COUNT_BINDING] = uploaded | VK_BUFFER_USAGE_TRANSFER_SRC_BIT; // Cleared each frame and read back for the stats
+		sizes[DRAW_COMMAND_BINDING] = sizeof(VkDrawIndexedIndirectCommand) * MAX_COMMAND_COUNT;
+		usages[DRAW_COMMAND_BINDING] = indirect;
+		sizes[DRAW_COUNT_BINDING] = sizeof(uint32_t) * MAX_MESH_COUNT;
+		usages[DRAW_COUNT_BINDING] = indirect;
+		sizes[VISIBILITY_BINDING] = sizeof(uint32_t) * static_cast<VkDeviceSize>(std::max(maxObjectCount, 1u));
+		usages[VISIBILITY_BINDING] = uploaded; // Cleared once, then only written by the late phase
+		sizes[OCCLUSION_DATA_BINDING] = sizeof(OcclusionData);
+		usages[OCCLUSION_DATA_BINDING] = uploaded;
+		sizes[OCCLUSION_STATS_BINDING] = sizeof(OcclusionStats);
+		usages[OCCLUSION_STATS_BINDING] = uploaded | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+		for (uint32_t binding = 0; binding < BINDING_COUNT; ++binding)
+		{
+			Buffer& buffer = _buffers[binding];
+			_device.CreateBuffer(sizes[binding], usages[binding], VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer.buffer, buffer.allocation);
+			buffer.size = sizes[binding];
+		}
+
+		for (FrameResources& frame : _frames)
+		{
+			_device.CreateBuffer(
+				sizeof(uint32_t) * MAX_MESH_COUNT,
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				frame.readback.buffer,
+				frame.readback.allocation);
+			frame.readback.size = sizeof(uint32_t) * MAX_MESH_COUNT;
+		}
+	}
+
+	void GpuDrivenRenderSystem::CreateDescriptorSet()
+	{
+		// One set for both passes, the vertex shader only reads the objects, the meshes and the visible object list
+		std::array<VkDescriptorSetLayoutBinding, BINDING_COUNT + 1> bindings{};
+		for (uint32_t binding = 0; binding < bindings.size(); ++binding)
+		{
+			bindings[binding].binding = binding;
+			bindings[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			bindings[binding].descriptorCount = 1;
+			bindings[binding].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+		}
+		bindings[ARENA_VERTEX_BINDING].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		layoutInfo.pBindings = bindings.data();
+
+		if (vkCreateDescriptorSetLayout(_device.GetDevice(), &layoutInfo, nullptr, &_descriptorSetLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create descriptor set layout!");
+		}
+
+		// The pyramid sets of the frames in flight come from the same pool
+		std::array<VkDescriptorPoolSize, 2> poolSizes{};
+		poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		poolSizes[0].descriptorCount = BINDING_COUNT + 1;
+		poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSizes[1].descriptorCount = RenderTarget::MAX_FRAMES_IN_FLIGHT;
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.maxSets = 1 + RenderTarget::MAX_FRAMES_IN_FLIGHT;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+
+		if (vkCreateDescriptorPool(_device.GetDevice(), &poolInfo, nullptr, &_descriptorPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create descriptor pool!");
+		}
+
+		VkDescriptorSetAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.descriptorPool = _descriptorPool;
+		allocateInfo.descriptorSetCount = 1;
+		allocateInfo.pSetLayouts = &_descriptorSetLayout;
+
+		if (vkAllocateDescriptorSets(_device.GetDevice(), &allocateInfo, &_descriptorSet) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate descriptor set!");
+		}
+
+		// The buffers never change, the set is written once. Without an arena its binding stays empty, no pipeline reads it
+		const uint32_t writeCount = _meshArena != nullptr ? BINDING_COUNT + 1 : BINDING_COUNT;
+		std::array<VkDescriptorBufferInfo, BINDING_COUNT + 1> bufferInfos{};
+		std::array<VkWriteDescriptorSet, BINDING_COUNT + 1> writes{};
+		for (uint32_t binding = 0; binding < writeCount; ++binding)
+		{
+			bufferInfos[binding].buffer = binding == ARENA_VERTEX_BINDING ? _meshArena->GetVertexBuffer() : _buffers[binding].buffer;
+			bufferInfos[binding].offset = 0;
+			bufferInfos[binding].range = VK_WHOLE_SIZE;
+
+			writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[binding].dstSet = _descriptorSet;
+			writes[binding].dstBinding = binding;
+			writes[binding].descriptorCount = 1;
+			writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[binding].pBufferInfo = &bufferInfos[binding];
+		}
+		vkUpdateDescriptorSets(_device.GetDevice(), writeCount, writes.data(), 0, nullptr);
+	}
+
+	void GpuDrivenRenderSystem::CreatePyramidDescriptorSets()
+	{
+		VkDescriptorSetLayoutBinding binding{};
+		binding.binding = 0;
+		binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		binding.descriptorCount = 1;
+		binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = 1;
+		layoutInfo.pBindings = &binding;
+
+		if (vkCreateDescriptorSetLayout(_device.GetDevice(), &layoutInfo, nullptr, &_pyramidDescriptorSetLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create descriptor set layout!");
+		}
+
+		std::array<VkDescriptorSetLayout, RenderTarget::MAX_FRAMES_IN_FLIGHT> layouts;
+		layouts.fill(_pyramidDescriptorSetLayout);
+
+		VkDescriptorSetAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.descriptorPool = _descriptorPool;
+		allocateInfo.descriptorSetCount = RenderTarget::MAX_FRAMES_IN_FLIGHT;
+		allocateInfo.pSetLayouts = layouts.data();
+
+		if (vkAllocateDescriptorSets(_device.GetDevice(), &allocateInfo, _pyramidDescriptorSets.data()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate descriptor set!");
+		}
+	}
+
+	void GpuDrivenRenderSystem::CreatePipelineLayouts()
+	{
+		VkPushConstantRange computePushConstantRange{};
+		computePushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		computePushConstantRange.offset = 0;
+		computePushConstantRange.size = sizeof(CullPushConstantData);
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &_descriptorSetLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &computePushConstantRange;
+
+		if (vkCreatePipelineLayout(_device.GetDevice(), &pipelineLayoutInfo, nullptr, &_computePipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create pipeline layout!");
+		}
+
+		// Same set 0 and push constants, compatible with the set bound for the other compute passes
+		std::array<VkDescriptorSetLayout, 2> occlusionSetLayouts = { _descriptorSetLayout, _pyramidDescriptorSetLayout };
+		VkPipelineLayoutCreateInfo occlusionPipelineLayoutInfo = pipelineLayoutInfo;
+		occlusionPipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(occlusionSetLayouts.size());
+		occlusionPipelineLayoutInfo.pSetLayouts = occlusionSetLayouts.data();
+
+		if (vkCreatePipelineLayout(_device.GetDevice(), &occlusionPipelineLayoutInfo, nullptr, &_occlusionPipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create pipeline layout!");
+		}
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(GpuDrivenPushConstantData);
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		if (vkCreatePipelineLayout(_device.GetDevice(), &pipelineLayoutInfo, nullptr, &_pipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create pipeline layout!");
+		}
+	}
+
+	void GpuDrivenRenderSystem::CreatePipelines(VkRenderPass renderPass, bool useVertexPulling)
+	{
+		assert(_pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+
+		_cullPipeline = std::make_unique<ComputePipeline>(_device, "shaders/cull_instances.comp.spv", _computePipelineLayout);
+		_buildCommandsPipeline = std::make_unique<ComputePipeline>(_device, "shaders/build_draw_commands.comp.spv", _computePipelineLayout);
+		_cullOccludedPipeline = std::make_unique<ComputePipeline>(_device, "shaders/cull_occluded.comp.spv", _occlusionPipelineLayout);
+
+		// No instance binding, the vertex shader reads its transform through the visible object list
+		for (uint32_t format = 0; format < VERTEX_FORMAT_COUNT; ++format)
+		{
+			VertexFormat vertexFormat = static_cast<VertexFormat>(format);
+
+			PipelineConfigInfo pipelineConfig = {};
+			Pipeline::DefaultPipelineConfigInfo(pipelineConfig);
+			pipelineConfig.renderPass = renderPass;
+			pipelineConfig.pipelineLayout = _pipelineLayout;
+			pipelineConfig.bindingDescriptions = Model::GetBindingDescriptions(vertexFormat);
+			pipelineConfig.attributeDescriptions = Model::GetAttributeDescriptions(vertexFormat);
+			_pipelines[format] = std::make_unique<Pipeline>(_device, "shaders/simple_shader_gpu_driven.vert.spv", "shaders/simple_shader.frag.spv", pipelineConfig);
+		}
+
+		// No vertex input at all, the shader decodes the vertices of the arena in the format of their mesh
+		if (useVertexPulling)
+		{
+			PipelineConfigInfo pipelineConfig = {};
+			Pipeline::DefaultPipelineConfigInfo(pipelineConfig);
+			pipelineConfig.renderPass = renderPass;
+			pipelineConfig.pipelineLayout = _pipelineLayout;
+			_vertexPullingPipeline = std::make_unique<Pipeline>(_device, "shaders/simple_shader_vertex_pulling.vert.spv", "shaders/simple_shader.frag.spv", pipelineConfig);
+		}
+	}
+
+	void GpuDrivenRenderSystem::DestroyBuffer(Buffer& buffer)
+	{
+		if (buffer.buffer != VK_NULL_HANDLE)
+		{
+			_device.DestroyBuffer(buffer.buffer, buffer.allocation);
+			buffer.buffer = VK_NULL_HANDLE;
+			buffer.size = 0;
+		}
+	}
+
+	void GpuDrivenRenderSystem::SetEntities(const RenderView& entities, JobSystem* jobSystem)
+	{
+		const uint32_t count = static_cast<uint32_t>(entities.Size());
+		Resize(count);
+		if (count == 0)
+		{
+			return;
+		}
+
+		const Transform* transforms = entities.transforms;
+		_transformStore.Resize(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			_transformStore.Set(i, transforms[i]);
+		}
+
+		// The matrices are computed in SIMD batches straight into the objects
+		if (jobSystem != nullptr)
+		{
+			jobSystem->ParallelFor(count, OBJECTS_PER_JOB, [&](uint32_t begin, uint32_t end)
+				{
+					ComputeTransformMatrices(_transformStore, begin, end - begin, &_objects[begin].transform, sizeof(ObjectData));
+				});
+		}
+		else
+		{
+			ComputeTransformMatrices(_transformStore, 0, count, &_objects[0].transform, sizeof(ObjectData));
+		}
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			SetObject(i, entities.renderComponents[i].model);
+		}
+		_areAllObjectsDirty = true;
+	}
+
+	void GpuDrivenRenderSystem::UpdateEntities(const RenderView& entities, const std::vector<uint32_t>& changedEntities)
+	{
+		assert(entities.Size() == _objects.size() && "The entities were added or removed since SetEntities");
+
+		for (uint32_t entity : changedEntities)
+		{
+			_objects[entity].transform = entities.transforms[entity].mat4();
+			SetObject(entity, entities.renderComponents[entity].model);
+			MarkDirty(entity);
+		}
+	}
+
+	void GpuDrivenRenderSystem::Resize(uint32_t objectCount)
+	{
+		if (objectCount > _maxObjectCount)
+		{
+			throw std::runtime_error("Too many objects for the GPU driven render system!");
+		}
+
+		for (uint32_t i = objectCount; i < _objects.size(); ++i)
+		{
+			SetObject(i, nullptr);
+		}
+
+		_objects.resize(objectCount);
+		_isObjectDirty.resize(objectCount, 0);
+	}
+
+	void GpuDrivenRenderSystem::SetObject(uint32_t objectIndex, Model* model)
+	{
+		ObjectData& object = _objects[objectIndex];
+		Model* currentModel = object.meshIndex == INVALID_MESH ? nullptr : _meshes[object.meshIndex].model;
+		if (currentModel != model)
+		{
+			if (object.meshIndex != INVALID_MESH)
+			{
+				ReleaseMesh(object.meshIndex);
+			}
+			object.meshIndex = model == nullptr ? INVALID_MESH : AcquireMesh(model);
+		}
+
+		if (model != nullptr)
+		{
+			const BoundingSphere& sphere = model->GetBoundingSphere();
+			object.boundingSphere = glm::vec4(sphere.center, sphere.radius);
+		}
+	}
+
+	void GpuDrivenRenderSystem::MarkDirty(uint32_t objectIndex)
+	{
+		if (!_isObjectDirty[objectIndex])
+		{
+			_isObjectDirty[objectIndex] = 1;
+			_dirtyObjects.push_back(objectIndex);
+		}
+	}
+
+	uint32_t GpuDrivenRenderSystem::AcquireMesh(Model* model)
+	{
+		// Any change of the counts moves the ranges of the following meshes
+		_areMeshesDirty = true;
+
+		auto it = _meshLookup.find(model);
+		if (it != _meshLookup.end())
+		{
+			_meshes[it->second].objectCount++;
+			return it->second;
+		}
+
+		uint32_t meshIndex;
+		if (!_freeMeshes.empty())
+		{
+			meshIndex = _freeMeshes.back();
+			_freeMeshes.pop_back();
+		}
+		else
+		{
+			if (_meshes.size() >= MAX_MESH_COUNT)
+			{
+				throw std::runtime_error("Too many meshes for the GPU driven render system!");
+			}
+			meshIndex = static_cast<uint32_t>(_meshes.size());
+			_meshes.emplace_back();
+		}
+
+		_meshes[meshIndex] = { model, 1 };
+		_meshLookup.emplace(model, meshIndex);
+		return meshIndex;
+	}
+
+	void GpuDrivenRenderSystem::ReleaseMesh(uint32_t meshIndex)
+	{
+		_areMeshesDirty = true;
+
+		MeshRecord& mesh = _meshes[meshIndex];
+		assert(mesh.objectCount > 0 && "Released a mesh slot that has no object");
+		if (--mesh.objectCount == 0)
+		{
+			_meshLookup.erase(mesh.model);
+			mesh = {};
+			_freeMeshes.push_back(meshIndex);
+		}
+	}
+
+	void GpuDrivenRenderSystem::UpdateMeshes()
+	{
+		static_assert(sizeof(MeshData) == 64, "MeshData must match the std430 layout of the shaders");
+
+		// The visible object list is split between the meshes by their object counts, a mesh never overflows its range
+		_meshData.resize(_meshes.size());
+		_commandData.clear();
+
+		uint32_t firstInstance = 0;
+		for (uint32_t meshIndex = 0; meshIndex < _meshes.size(); ++meshIndex)
+		{
+			MeshRecord& mesh = _meshes[meshIndex];
+			mesh.firstInstance = firstInstance;
+			mesh.commandOffset = static_cast<uint32_t>(_commandData.size());
+
+			if (mesh.model != nullptr)
+			{
+				firstInstance += mesh.objectCount;
+
+				// Without indices the submesh ranges are ranges of vertices. In an arena they start where the model does
+				const uint32_t isIndexed = mesh.model->HasIndexBuffer() ? 1 : 0;
+				const uint32_t first = isIndexed ? mesh.model->GetFirstIndex() : mesh.model->GetVertexOffset();
+				const int32_t vertexOffset = isIndexed ? static_cast<int32_t>(mesh.model->GetVertexOffset()) : 0;
+				const std::vector<Model::Submesh>& submeshes = mesh.model->GetSubmeshes();
+				if (submeshes.empty())
+				{
+					uint32_t count = isIndexed ? mesh.model->GetIndexCount() : mesh.model->GetVertexCount();
+					_commandData.push_back({ count, first, vertexOffset, meshIndex, isIndexed });
+				}
+
+				for (const Model::Submesh& submesh : submeshes)
+				{
+					_commandData.push_back({ submesh.indexCount, first + submesh.firstIndex, vertexOffset, meshIndex, isIndexed });
+				}
+			}
+
+			mesh.commandCount = static_cast<uint32_t>(_commandData.size()) - mesh.commandOffset;
+			MeshData& meshData = _meshData[meshIndex];
+			meshData = { mesh.firstInstance, mesh.commandOffset, mesh.commandCount, mesh.objectCount };
+			if (mesh.model != nullptr)
+			{
+				const PositionQuantization& quantization = mesh.model->GetPositionQuantization();
+				meshData.positionScale = glm::vec4(quantization.scale, 0.0f);
+				meshData.positionBias = glm::vec4(quantization.bias, 0.0f);
+				meshData.vertexFormat = static_cast<uint32_t>(mesh.model->GetVertexFormat());
+			}
+		}
+
+		if (_commandData.size() > MAX_COMMAND_COUNT)
+		{
+			throw std::runtime_error("Too many draw commands for the GPU driven render system!");
+		}
+	}
+
+	void GpuDrivenRenderSystem::UploadChanges(VkCommandBuffer commandBuffer, FrameResources& frame)
+	{
+		const uint32_t objectCount = static_cast<uint32_t>(_objects.size());
+
+		// Consecutive dirty objects are copied as one region
+		_copyRegions.clear();
+		VkDeviceSize stagingSize = 0;
+		uint32_t uploadedObjectCount = 0;
+		if (_areAllObjectsDirty)
+		{
+			_copyRegions.push_back({ 0, 0, sizeof(ObjectData) * static_cast<VkDeviceSize>(objectCount) });
+			stagingSize = _copyRegions.back().size;
+			uploadedObjectCount = objectCount;
+		}
+		else
+		{
+			std::sort(_dirtyObjects.begin(), _dirtyObjects.end());
+			for (size_t i = 0; i < _dirtyObjects.size() && _dirtyObjects[i] < objectCount;)
+			{
+				size_t last = i + 1;
+				while (last < _dirtyObjects.size() && _dirtyObjects[last] == _dirtyObjects[last - 1] + 1 && _dirtyObjects[last] < objectCount)
+				{
+					++last;
+				}
+
+				VkDeviceSize size = sizeof(ObjectData) * static_cast<VkDeviceSize>(last - i);
+				_copyRegions.push_back({ stagingSize, sizeof(ObjectData) * static_cast<VkDeviceSize>(_dirtyObjects[i]), size });
+				stagingSize += size;
+				uploadedObjectCount += static_cast<uint32_t>(last - i);
+				i = last;
+			}
+		}
+
+		for (uint32_t objectIndex : _dirtyObjects)
+		{
+			if (objectIndex < objectCount)
+			{
+				_isObjectDirty[objectIndex] = 0;
+			}
+		}
+		_dirtyObjects.clear();
+		_areAllObjectsDirty = false;
+		_stats.uploadedObjectCount = uploadedObjectCount;
+
+		const bool uploadMeshes = _areMeshesDirty;
+		if (uploadMeshes)
+		{
+			UpdateMeshes();
+			_areMeshesDirty = false;
+		}
+
+		const VkDeviceSize meshOffset = stagingSize;
+		const VkDeviceSize meshSize = uploadMeshes ? sizeof(MeshData) * _meshData.size() : 0;
+		const VkDeviceSize commandOffset = meshOffset + meshSize;
+		const VkDeviceSize commandSize = uploadMeshes ? sizeof(CommandData) * _commandData.size() : 0;
+		if (commandOffset + commandSize == 0)
+		{
+			return;
+		}
+
+		// The staging buffer of this frame index is free, its fence was waited on in BeginFrame
+		ReserveStaging(frame.staging, commandOffset + commandSize);
+		uint8_t* staging = static_cast<uint8_t*>(frame.staging.allocation.mappedData);
+		for (const VkBufferCopy& region : _copyRegions)
+		{
+			std::memcpy(staging + region.srcOffset, &_objects[region.dstOffset / sizeof(ObjectData)], region.size);
+		}
+
+		if (!_copyRegions.empty())
+		{
+			vkCmdCopyBuffer(commandBuffer, frame.staging.buffer, _buffers[OBJECT_BINDING].buffer, static_cast<uint32_t>(_copyRegions.size()), _copyRegions.data());
+		}
+
+		if (meshSize > 0)
+		{
+			std::memcpy(staging + meshOffset, _meshData.data(), meshSize);
+			VkBufferCopy region{ meshOffset, 0, meshSize };
+			vkCmdCopyBuffer(commandBuffer, frame.staging.buffer, _buffers[MESH_BINDING].buffer, 1, &region);
+		}
+
+		if (commandSize > 0)
+		{
+			std::memcpy(staging + commandOffset, _commandData.data(), commandSize);
+			VkBufferCopy region{ commandOffset, 0, commandSize };
+			vkCmdCopyBuffer(commandBuffer, frame.staging.buffer, _buffers[COMMAND_DATA_BINDING].buffer, 1, &region);
+		}
+	}
+
+	void GpuDrivenRenderSystem::ReserveStaging(Buffer& staging, VkDeviceSize size)
+	{
+		if (size <= staging.size)
+		{
+			return;
+		}
+
+		VkDeviceSize capacity = std::max(size, staging.size * 2);
+		DestroyBuffer(staging);
+		_device.CreateBuffer(
+			capacity,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			staging.buffer,
+			staging.allocation);
+		staging.size = capacity;
+	}
+
+	void GpuDrivenRenderSystem::ReadVisibleCount(FrameResources& frame)
+	{
+		if (frame.readbackCount == 0)
+		{
+			return;
+		}
+
+		if (frame.hasOcclusionStats)
+		{
+			const OcclusionStats* occlusionStats = static_cast<const OcclusionStats*>(frame.readback.allocation.mappedData);
+			_stats.visibleCount = occlusionStats->frustumVisibleCount - occlusionStats->occludedCount;
+			_stats.occludedCount = occlusionStats->occludedCount;
+			_stats.lateVisibleCount = occlusionStats->lateVisibleCount;
+			return;
+		}
+
+		const uint32_t* visibleCounts = static_cast<const uint32_t*>(frame.readback.allocation.mappedData);
+		uint32_t visibleCount = 0;
+		for (uint32_t i = 0; i < frame.readbackCount; ++i)
+		{
+			visibleCount += visibleCounts[i];
+		}
+		_stats.visibleCount = visibleCount;
+		_stats.occludedCount = 0;
+		_stats.lateVisibleCount = 0;
+	}
+
+	void GpuDrivenRenderSystem::SetOcclusionCulling(bool isEnabled)
+	{
+		_isOcclusionCullingEnabled = isEnabled;
+	}
+
+	void GpuDrivenRenderSystem::Cull(FrameInfo& frameInfo, const glm::mat4& viewProjection)
+	{
+		VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+		FrameResources& frame = _frames[frameInfo.frameIndex];
+
+		// The last frame recorded with this index has completed, what it read back is valid
+		ReadVisibleCount(frame);
+
+		GpuProfileScope scope(frameInfo.gpuProfiler, commandBuffer, "GPU culling", false);
+
+		// The previous frames may still draw from the buffers rewritten here, their commands are in the scope of the barrier
+		RecordMemoryBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+		UploadChanges(commandBuffer, frame);
+
+		const uint32_t meshSlotCount = static_cast<uint32_t>(_meshes.size());
+		_viewProjection = viewProjection;
+		_culledObjectCount = static_cast<uint32_t>(_objects.size());
+		_culledCommandCount = static_cast<uint32_t>(_commandData.size());
+		_stats.objectCount = _culledObjectCount;
+		_stats.meshCount = static_cast<uint32_t>(_meshLookup.size());
+		_stats.commandCount = _culledCommandCount;
+		_stats.drawCallCount = 0;
+		_stats.bindCount = 0;
+		frame.readbackCount = _isOcclusionCullingEnabled ? 0 : meshSlotCount;
+		frame.hasOcclusionStats = false;
+		if (meshSlotCount == 0)
+		{
+			return;
+		}
+
+		vkCmdFillBuffer(commandBuffer, _buffers[VISIBLE_COUNT_BINDING].buffer, 0, sizeof(uint32_t) * meshSlotCount, 0);
+
+		// Nothing was visible before the first frame, the late phase draws everything it finds
+		if (_isOcclusionCullingEnabled && !_isVisibilityCleared)
+		{
+			vkCmdFillBuffer(commandBuffer, _buffers[VISIBILITY_BINDING].buffer, 0, VK_WHOLE_SIZE, 0);
+			_isVisibilityCleared = true;
+		}
+
+		RecordMemoryBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+		DispatchCulling(commandBuffer, _isOcclusionCullingEnabled ? EARLY_PHASE : FRUSTUM_PHASE);
+
+		// With occlusion culling the stats are read back after the late phase
+		if (_isOcclusionCullingEnabled)
+		{
+			return;
+		}
+
+		VkBufferCopy region{ 0, 0, sizeof(uint32_t) * meshSlotCount };
+		vkCmdCopyBuffer(commandBuffer, _buffers[VISIBLE_COUNT_BINDING].buffer, frame.readback.buffer, 1, &region);
+
+		RecordMemoryBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+	}
+
+	void GpuDrivenRenderSystem::CullOccluded(FrameInfo& frameInfo, const DepthPyramid& depthPyramid)
+	{
+		assert(_isOcclusionCullingEnabled && "CullOccluded needs occlusion culling, the first phase was recorded without it");
+
+		VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+		FrameResources& frame = _frames[frameInfo.frameIndex];
+		const uint32_t meshSlotCount = static_cast<uint32_t>(_meshes.size());
+		if (meshSlotCount == 0)
+		{
+			return;
+		}
+
+		GpuProfileScope scope(frameInfo.gpuProfiler, commandBuffer, "GPU occlusion culling", false);
+
+		// The set of this frame index is no longer in use, its fence was waited on in BeginFrame
+		VkDescriptorImageInfo pyramidInfo{};
+		pyramidInfo.sampler = depthPyramid.GetSampler();
+		pyramidInfo.imageView = depthPyramid.GetImageView();
+		pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = _pyramidDescriptorSets[frameInfo.frameIndex];
+		write.dstBinding = 0;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write.pImageInfo = &pyramidInfo;
+		vkUpdateDescriptorSets(_device.GetDevice(), 1, &write, 0, nullptr);
+
+		// The first phase draws still read the visible objects and commands rewritten here
+		RecordMemoryBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0,
+			VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+		VkExtent2D pyramidExtent = depthPyramid.GetExtent();
+		OcclusionData occlusionData{ _viewProjection, glm::vec2(pyramidExtent.width, pyramidExtent.height), depthPyramid.GetLevelCount(), 0 };
+		vkCmdUpdateBuffer(commandBuffer, _buffers[OCCLUSION_DATA_BINDING].buffer, 0, sizeof(OcclusionData), &occlusionData);
+		vkCmdFillBuffer(commandBuffer, _buffers[OCCLUSION_STATS_BINDING].buffer, 0, VK_WHOLE_SIZE, 0);
+		vkCmdFillBuffer(commandBuffer, _buffers[VISIBLE_COUNT_BINDING].buffer, 0, sizeof(uint32_t) * meshSlotCount, 0);
+
+		RecordMemoryBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _occlusionPipelineLayout, 1, 1, &_pyramidDescriptorSets[frameInfo.frameIndex], 0, nullptr);
+		DispatchCulling(commandBuffer, LATE_PHASE);
+
+		VkBufferCopy region{ 0, 0, sizeof(OcclusionStats) };
+		vkCmdCopyBuffer(commandBuffer, _buffers[OCCLUSION_STATS_BINDING].buffer, frame.readback.buffer, 1, &region);
+		frame.readbackCount = 1;
+		frame.hasOcclusionStats = true;
+
+		RecordMemoryBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+	}
+
+	void GpuDrivenRenderSystem::DispatchCulling(VkCommandBuffer commandBuffer, CullPhase phase)
+	{
+		CullPushConstantData push{};
+		std::array<glm::vec4, FrustumCuller::PLANE_COUNT> planes;
+		FrustumCuller::ExtractPlanes(_viewProjection, planes);
+		std::copy(planes.begin(), planes.end(), push.planes);
+		push.objectCount = _culledObjectCount;
+		push.commandCount = _culledCommandCount;
+		push.phase = phase;
+
+		// The occlusion layout only adds set 1, set 0 and the push constants stay valid for the other pipelines
+		VkPipelineLayout pipelineLayout = phase == LATE_PHASE ? _occlusionPipelineLayout : _computePipelineLayout;
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &_descriptorSet, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstantData), &push);
+
+		// First pass: every visible object takes the next slot in the range of its mesh
+		(phase == LATE_PHASE ? _cullOccludedPipeline : _cullPipeline)->Bind(commandBuffer);
+		vkCmdDispatch(commandBuffer, (push.objectCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+		RecordMemoryBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+		// Second pass: the counts become the instance counts of the commands and the draw count of each mesh
+		_buildCommandsPipeline->Bind(commandBuffer);
+		vkCmdDispatch(commandBuffer, (push.commandCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+		RecordMemoryBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT);
+	}
+
+	void GpuDrivenRenderSystem::Render(FrameInfo& frameInfo)
+	{
+		VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+		GpuProfileScope scope(frameInfo.gpuProfiler, commandBuffer, "GpuDrivenRenderSystem");
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 0, 1, &_descriptorSet, 0, nullptr);
+
+		// One indirect draw per mesh whatever its number of objects, the GPU decides how many of them are drawn. The meshes
+		// of the arena that follow each other are drawn together, from a single binding
+		Pipeline* boundPipeline = nullptr;
+		const void* boundBuffers = nullptr; // The arena, or the model that owns its buffers
+		uint32_t drawCallCount = 0;
+		uint32_t bindCount = 0;
+		uint32_t meshIndex = 0;
+		while (meshIndex < _meshes.size())
+		{
+			Model* model = _meshes[meshIndex].model;
+			if (model == nullptr || !model->IsResident())
+			{
+				++meshIndex;
+				continue;
+			}
+
+			// Free slots have no command, they do not split a range
+			uint32_t lastMesh = meshIndex + 1;
+			uint32_t modelCount = 1;
+			for (uint32_t next = lastMesh; next < _meshes.size(); ++next)
+			{
+				Model* nextModel = _meshes[next].model;
+				if (nextModel == nullptr)
+				{
+					continue;
+				}
+				if (!CanShareDraw(*nextModel, *model))
+				{
+					break;
+				}
+				lastMesh = next + 1;
+				modelCount++;
+			}
+
+			const bool isInArena = _meshArena != nullptr && model->GetMeshArena() == _meshArena;
+			Pipeline* pipeline = isInArena && _vertexPullingPipeline != nullptr ? _vertexPullingPipeline.get()
+				: _pipelines[static_cast<uint32_t>(model->GetVertexFormat())].get();
+			if (pipeline != boundPipeline)
+			{
+				pipeline->Bind(commandBuffer);
+				boundPipeline = pipeline;
+			}
+
+			const void* buffers = isInArena ? static_cast<const void*>(_meshArena) : model;
+			if (buffers != boundBuffers)
+			{
+				model->Bind(commandBuffer);
+				boundBuffers = buffers;
+				bindCount++;
+			}
+
+			drawCallCount += DrawMeshes(commandBuffer, meshIndex, lastMesh, modelCount);
+			meshIndex = lastMesh;
+		}
+
+		// Both phases with occlusion culling
+		_stats.drawCallCount += drawCallCount;
+		_stats.bindCount += bindCount;
+	}
+
+	bool GpuDrivenRenderSystem::CanShareDraw(Model& model, const Model& previousModel) const
+	{
+		// Pulled vertices are decoded by the shader, only the fixed function vertex fetch needs a pipeline per format
+		return _meshArena != nullptr
+			&& model.GetMeshArena() == _meshArena
+			&& previousModel.GetMeshArena() == _meshArena
+			&& model.HasIndexBuffer() == previousModel.HasIndexBuffer()
+			&& (_vertexPullingPipeline != nullptr || model.GetVertexFormat() == previousModel.GetVertexFormat())
+			&& model.IsResident();
+	}
+
+	uint32_t GpuDrivenRenderSystem::DrawMeshes(VkCommandBuffer commandBuffer, uint32_t firstMesh, uint32_t lastMesh, uint32_t modelCount)
+	{
+		// The commands of consecutive meshes are consecutive, one multi draw covers them all. The GPU no longer skips the
+		// culled meshes with a draw count, their commands draw 0 instances
+		if (modelCount > 1 && _device.GetEnabledFeatures().multiDrawIndirect)
+		{
+			const MeshRecord& lastRecord = _meshes[lastMesh - 1];
+			const uint32_t commandOffset = _meshes[firstMesh].commandOffset;
+			const uint32_t commandCount = lastRecord.commandOffset + lastRecord.commandCount - commandOffset;
+			const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+			VkBuffer drawCommands = _buffers[DRAW_COMMAND_BINDING].buffer;
+			VkDeviceSize offset = static_cast<VkDeviceSize>(commandOffset) * stride;
+			if (_meshes[firstMesh].model->HasIndexBuffer())
+			{
+				vkCmdDrawIndexedIndirect(commandBuffer, drawCommands, offset, commandCount, stride);
+			}
+			else
+			{
+				vkCmdDrawIndirect(commandBuffer, drawCommands, offset, commandCount, stride);
+			}
+			return 1;
+		}
+
+		uint32_t drawCallCount = 0;
+		for (uint32_t meshIndex = firstMesh; meshIndex < lastMesh; ++meshIndex)
+		{
+			if (_meshes[meshIndex].model != nullptr)
+			{
+				drawCallCount += DrawMesh(commandBuffer, meshIndex);
+			}
+		}
+		return drawCallCount;
+	}
+
+	uint32_t GpuDrivenRenderSystem::DrawMesh(VkCommandBuffer commandBuffer, uint32_t meshIndex)
+	{
+		const MeshRecord& mesh = _meshes[meshIndex];
+		const bool isIndexed = mesh.model->HasIndexBuffer();
+		const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+		VkBuffer drawCommands = _buffers[DRAW_COMMAND_BINDING].buffer;
+		VkDeviceSize offset = static_cast<VkDeviceSize>(mesh.commandOffset) * stride;
+
+		// The count written by the GPU is 0 when every object of the mesh was culled, nothing reaches the vertex stage
+		if (_device.IsDrawIndirectCountSupported())
+		{
+			VkBuffer drawCounts = _buffers[DRAW_COUNT_BINDING].buffer;
+			VkDeviceSize countOffset = sizeof(uint32_t) * static_cast<VkDeviceSize>(meshIndex);
+			if (isIndexed)
+			{
+				_device.GetCmdDrawIndexedIndirectCount()(commandBuffer, drawCommands, offset, drawCounts, countOffset, mesh.commandCount, stride);
+			}
+			else
+			{
+				_device.GetCmdDrawIndirectCount()(commandBuffer, drawCommands, offset, drawCounts, countOffset, mesh.commandCount, stride);
+			}
+			return 1;
+		}
+
+		// Without the extension every command is drawn, a culled mesh costs empty draws of 0 instances
+		const uint32_t drawsPerCall = _device.GetEnabledFeatures().multiDrawIndirect ? mesh.commandCount : 1;
+		uint32_t drawCallCount = 0;
+		for (uint32_t first = 0; first < mesh.commandCount; first += drawsPerCall)
+		{
+			VkDeviceSize callOffset = offset + static_cast<VkDeviceSize>(first) * stride;
+			if (isIndexed)
+			{
+				vkCmdDrawIndexedIndirect(commandBuffer, drawCommands, callOffset, drawsPerCall, stride);
+			}
+			else
+			{
+				vkCmdDrawIndirect(commandBuffer, drawCommands, callOffset, drawsPerCall, stride);
+			}
+			drawCallCount++;
+		}
+		return drawCallCount;
+	}
+} // namespace DaisyEngine
@@ -0,0 +1,294 @@
+#pragma once
+
+#include "Pipeline.hpp"
+#include "Device.hpp"
+#include "DepthPyramid.hpp"
+#include "FrameInfo.hpp"
+#include "Components.hpp"
+#include "MeshArena.hpp"
+#include "Model.hpp"
+#include "RenderTarget.hpp"
+#include "TransformStore.hpp"
+
+// Libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The GpuDrivenStats struct reports the work of a GpuDrivenRenderSystem. The visible count is read back from the GPU,
+	/// it is the one of the frame recorded MAX_FRAMES_IN_FLIGHT frames earlier.
+	/// </summary>
+	struct GpuDrivenStats
+	{
+		uint32_t objectCount = 0;
+		uint32_t meshCount = 0;
+		uint32_t commandCount = 0; // Indirect draw commands written by the GPU, one per submesh of each mesh
+		uint32_t drawCallCount = 0; // Indirect draw calls recorded by the CPU in the last frame
+		uint32_t bindCount = 0; // Vertex and index buffer bindings recorded in the last frame
+		uint32_t uploadedObjectCount = 0; // Objects copied to the GPU in the last frame
+		uint32_t visibleCount = 0;
+		uint32_t occludedCount = 0; // In the frustum but behind the depth of the first phase, 0 without occlusion culling
+		uint32_t lateVisibleCount = 0; // Visible but hidden the frame before, so only drawn by the second phase
+	};
+
+	/// <summary>
+	/// The GpuDrivenRenderSystem class draws entities without deciding any draw on the CPU. The transforms, bounding spheres
+	/// and mesh ranges live in storage buffers; each frame a compute pass culls every object against the frustum, compacts
+	/// the visible ones per mesh and writes the indirect draw commands, drawn with vkCmdDrawIndexedIndirectCount.
+	/// Only the objects that changed are uploaded, so for a static scene the CPU cost follows the number of meshes, not of
+	/// objects. A mesh with its own vertex and index buffers is bound and drawn on its own, while consecutive meshes of the
+	/// MeshArena given at creation share one binding and, with multiDrawIndirect, one indirect draw. With vertex pulling the
+	/// vertex shader fetches the vertices of every format from the arena, a single pipeline then draws all of its meshes.
+	/// The position quantization of each mesh is read by the vertex shader from the mesh buffer, no push constant is needed.
+	/// With occlusion culling, Cull and Render only draw the objects that were visible the frame before. Their depth is
+	/// reduced into a DepthPyramid, CullOccluded tests every object against it and the second Render draws the ones that
+	/// appeared; what is visible at the end of the frame is what the next frame draws first.
+	/// </summary>
+	class GpuDrivenRenderSystem
+	{
+	public:
+		// --- Constants ---
+		static constexpr uint32_t INVALID_MESH = UINT32_MAX;
+		static constexpr uint32_t DEFAULT_MAX_OBJECT_COUNT = 65536;
+		static constexpr uint32_t MAX_MESH_COUNT = 4096;
+		static constexpr uint32_t MAX_COMMAND_COUNT = 16384;
+		static constexpr uint32_t WORKGROUP_SIZE = 64; // local_size_x of both compute shaders
+		static constexpr uint32_t OBJECTS_PER_JOB = 4096; // Matrices computed per job when a job system is given
+
+		/// <summary>
+		/// The ObjectData struct is one element of the object storage buffer, in the std430 layout of the shaders.
+		/// </summary>
+		struct ObjectData
+		{
+			glm::mat4 transform{ 1.0f };
+			glm::vec4 boundingSphere{}; // Model space center and radius
+			uint32_t meshIndex = INVALID_MESH;
+			uint32_t padding[3]{};
+		};
+
+		// --- Constructors / Destructors ---
+		// The storage buffers are sized for maxObjectCount objects once and for all. Vertex pulling needs a mesh arena, the
+		// models outside of it are still drawn from their own vertex buffers
+		GpuDrivenRenderSystem(Device& device, VkRenderPass renderPass, uint32_t maxObjectCount = DEFAULT_MAX_OBJECT_COUNT,
+			MeshArena* meshArena = nullptr, bool useVertexPulling = false);
+		~GpuDrivenRenderSystem();
+
+		GpuDrivenRenderSystem(const GpuDrivenRenderSystem&) = delete;
+		GpuDrivenRenderSystem& operator=(const GpuDrivenRenderSystem&) = delete;
+
+		// Makes object i the entity at view index i for every entity of the view, all of them are uploaded with the next frame.
+		// Must be called from a worker of the job system when one is given
+		void SetEntities(const RenderView& entities, JobSystem* jobSystem = nullptr);
+
+		// Only the listed view indices changed since the entities were set, only they are uploaded with the next frame
+		void UpdateEntities(const RenderView& entities, const std::vector<uint32_t>& changedEntities);
+
+		// Records the uploads, the culling and the draw command generation. Outside of any render pass
+		void Cull(FrameInfo& frameInfo, const glm::mat4& viewProjection);
+
+		// Records the indirect draws of the commands written by the last Cull or CullOccluded, inside the render pass
+		void Render(FrameInfo& frameInfo);
+
+		// Makes Cull the first phase of the occlusion culling, CullOccluded must then be called every frame
+		void SetOcclusionCulling(bool isEnabled);
+		inline bool IsOcclusionCullingEnabled() const { return _isOcclusionCullingEnabled; }
+
+		// Second phase of the occlusion culling, between the two passes of the frame: tests the objects against the depth
+		// of the first pass, with the view projection given to Cull, and writes the commands of the newly visible ones
+		void CullOccluded(FrameInfo& frameInfo, const DepthPyramid& depthPyramid);
+
+		inline bool IsVertexPullingEnabled() const { return _vertexPullingPipeline != nullptr; }
+		inline const GpuDrivenStats& GetStats() const { return _stats; }
+
+	private:
+		enum Binding : uint32_t
+		{
+			OBJECT_BINDING,
+			MESH_BINDING,
+			COMMAND_DATA_BINDING,
+			VISIBLE_OBJECT_BINDING,
+			VISIBLE_COUNT_BINDING,
+			DRAW_COMMAND_BINDING,
+			DRAW_COUNT_BINDING,
+			VISIBILITY_BINDING,
+			OCCLUSION_DATA_BINDING,
+			OCCLUSION_STATS_BINDING,
+			BINDING_COUNT
+		};
+
+		// The vertex buffer of the mesh arena, after the buffers the system owns. Only read by the vertex pulling shader
+		static constexpr uint32_t ARENA_VERTEX_BINDING = BINDING_COUNT;
+
+		/// <summary>
+		/// The phase of cull_instances.comp.
+		/// </summary>
+		enum CullPhase : uint32_t
+		{
+			FRUSTUM_PHASE, // Without occlusion culling
+			EARLY_PHASE, // Visible in the frustum and the frame before
+			LATE_PHASE // Visible in the frustum and the depth pyramid, appended when hidden the frame before
+		};
+
+		/// <summary>
+		/// The OcclusionData struct is the element of the occlusion data buffer, updated before the late phase.
+		/// </summary>
+		struct OcclusionData
+		{
+			glm::mat4 viewProjection;
+			glm::vec2 pyramidSize;
+			uint32_t levelCount;
+			uint32_t padding;
+		};
+
+		/// <summary>
+		/// The OcclusionStats struct is what the late phase counts, read back like the visible counts.
+		/// </summary>
+		struct OcclusionStats
+		{
+			uint32_t frustumVisibleCount;
+			uint32_t occludedCount;
+			uint32_t lateVisibleCount;
+			uint32_t padding;
+		};
+
+		/// <summary>
+		/// The CPU side of a mesh slot. A slot is freed when its last object leaves it, a model at the same address later
+		/// gets a fresh slot rather than the ranges of the old one.
+		/// </summary>
+		struct MeshRecord
+		{
+			Model* model = nullptr;
+			uint32_t objectCount = 0;
+			uint32_t firstInstance = 0;
+			uint32_t commandOffset = 0;
+			uint32_t commandCount = 0;
+		};
+
+		/// <summary>
+		/// The MeshData struct is one element of the mesh storage buffer: the range of the mesh in the visible object list
+		/// and in the draw commands, then what the vertex shader needs to decode its vertices.
+		/// </summary>
+		struct MeshData
+		{
+			uint32_t firstInstance;
+			uint32_t commandOffset;
+			uint32_t commandCount;
+			uint32_t objectCount;
+			glm::vec4 positionScale;
+			glm::vec4 positionBias;
+			uint32_t vertexFormat;
+			uint32_t padding[3];
+		};
+
+		/// <summary>
+		/// The CommandData struct is what the draw command of one submesh keeps from frame to frame.
+		/// </summary>
+		struct CommandData
+		{
+			uint32_t count; // Indices, or vertices when the mesh has no index buffer
+			uint32_t first;
+			int32_t vertexOffset;
+			uint32_t meshIndex;
+			uint32_t isIndexed;
+		};
+
+		/// <summary>
+		/// A buffer and its allocation, with the size it was created with.
+		/// </summary>
+		struct Buffer
+		{
+			VkBuffer buffer = VK_NULL_HANDLE;
+			Allocation allocation{};
+			VkDeviceSize size = 0;
+		};
+
+		/// <summary>
+		/// The host visible buffers of one frame in flight: the changes it uploads and the visible counts it reads back.
+		/// </summary>
+		struct FrameResources
+		{
+			Buffer staging;
+			Buffer readback;
+			uint32_t readbackCount = 0; // Mesh slots copied into the readback buffer, 0 until the frame is recorded
+			bool hasOcclusionStats = false; // The readback buffer holds OcclusionStats instead of the visible counts
+		};
+
+		// --- Methods ---
+		void CreateBuffers(uint32_t maxObjectCount);
+		void CreateDescriptorSet();
+		void CreatePyramidDescriptorSets();
+		void CreatePipelineLayouts();
+		void CreatePipelines(VkRenderPass renderPass, bool useVertexPulling);
+		void DestroyBuffer(Buffer& buffer);
+
+		void Resize(uint32_t objectCount);
+		void SetObject(uint32_t objectIndex, Model* model);
+		void MarkDirty(uint32_t objectIndex);
+		uint32_t AcquireMesh(Model* model);
+		void ReleaseMesh(uint32_t meshIndex);
+		void UpdateMeshes();
+		void UploadChanges(VkCommandBuffer commandBuffer, FrameResources& frame);
+		void ReserveStaging(Buffer& staging, VkDeviceSize size);
+		void ReadVisibleCount(FrameResources& frame);
+		void DispatchCulling(VkCommandBuffer commandBuffer, CullPhase phase);
+		// Whether the model can be drawn with the meshes of the arena bound before it, by the same pipeline
+		bool CanShareDraw(Model& model, const Model& previousModel) const;
+		// Return the number of draw calls recorded. The meshes of the range share their binding
+		uint32_t DrawMeshes(VkCommandBuffer commandBuffer, uint32_t firstMesh, uint32_t lastMesh, uint32_t modelCount);
+		uint32_t DrawMesh(VkCommandBuffer commandBuffer, uint32_t meshIndex);
+
+		// --- Variables ---
+		Device& _device;
+		uint32_t _maxObjectCount;
+		MeshArena* _meshArena;
+
+		std::array<Buffer, BINDING_COUNT> _buffers; // Device local, indexed by Binding
+		std::array<FrameResources, RenderTarget::MAX_FRAMES_IN_FLIGHT> _frames;
+		VkDescriptorSetLayout _descriptorSetLayout = VK_NULL_HANDLE;
+		VkDescriptorPool _descriptorPool = VK_NULL_HANDLE;
+		VkDescriptorSet _descriptorSet = VK_NULL_HANDLE;
+		VkDescriptorSetLayout _pyramidDescriptorSetLayout = VK_NULL_HANDLE;
+		std::array<VkDescriptorSet, RenderTarget::MAX_FRAMES_IN_FLIGHT> _pyramidDescriptorSets{}; // Written each frame, the pyramid may be created again
+
+		VkPipelineLayout _computePipelineLayout = VK_NULL_HANDLE;
+		VkPipelineLayout _occlusionPipelineLayout = VK_NULL_HANDLE; // Compute layout with the pyramid as set 1
+		VkPipelineLayout _pipelineLayout = VK_NULL_HANDLE;
+		std::unique_ptr<ComputePipeline> _cullPipeline;
+		std::unique_ptr<ComputePipeline> _cullOccludedPipeline;
+		std::unique_ptr<ComputePipeline> _buildCommandsPipeline;
+		std::array<std::unique_ptr<Pipeline>, VERTEX_FORMAT_COUNT> _pipelines; // Indexed by VertexFormat
+		std::unique_ptr<Pipeline> _vertexPullingPipeline; // Every format of the arena, null without vertex pulling
+
+		std::vector<ObjectData> _objects;
+		std::vector<uint32_t> _dirtyObjects;
+		std::vector<uint8_t> _isObjectDirty;
+		bool _areAllObjectsDirty = false;
+		std::vector<VkBufferCopy> _copyRegions;
+		TransformStore _transformStore;
+
+		std::vector<MeshRecord> _meshes; // Indexed by mesh slot
+		std::vector<uint32_t> _freeMeshes;
+		std::unordered_map<Model*, uint32_t> _meshLookup;
+		std::vector<MeshData> _meshData;
+		std::vector<CommandData> _commandData;
+		bool _areMeshesDirty = false;
+
+		bool _isOcclusionCullingEnabled = false;
+		bool _isVisibilityCleared = false;
+		glm::mat4 _viewProjection{ 1.0f }; // Of the last Cull
+		uint32_t _culledObjectCount = 0; // Of the last Cull
+		uint32_t _culledCommandCount = 0;
+
+		GpuDrivenStats _stats;
+	};
+} // namespace DaisyEngine
@@ -0,0 +1,254 @@
+#include "GpuProfiler.hpp"
+
+// std
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+namespace DaisyEngine
+{
+	// Counters read back for every pipeline statistics query, in the order of their flag bits
+	static constexpr VkQueryPipelineStatisticFlags PIPELINE_STATISTICS_FLAGS =
+		VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT
+		| VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT
+		| VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+		| VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT
+		| VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT
+		| VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+	static constexpr uint32_t PIPELINE_STATISTICS_COUNT = 6;
+
+	GpuProfiler::GpuProfiler(Device& device)
+		: _device(device)
+	{
+		QueueFamilyIndices queueFamilies = _device.FindPhysicalQueueFamilies();
+
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(_device.GetPhysicalDevice(), &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(_device.GetPhysicalDevice(), &queueFamilyCount, queueFamilyProperties.data());
+
+		uint32_t validBits = queueFamilyProperties[queueFamilies.graphicsFamily].timestampValidBits;
+		if (validBits == 0)
+		{
+			std::cout << "GPU profiler: timestamps are not supported on the graphics queue" << std::endl;
+			return;
+		}
+
+		_timestampPeriod = _device._properties.limits.timestampPeriod;
+		_timestampMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+
+		// Queries active around secondary command buffers need inheritedQueries on top of the statistics themselves
+		const VkPhysicalDeviceFeatures& features = _device.GetEnabledFeatures();
+		if (features.pipelineStatisticsQuery && features.inheritedQueries)
+		{
+			_pipelineStatisticsFlags = PIPELINE_STATISTICS_FLAGS;
+		}
+
+		CreateQueryPools();
+	}
+
+	GpuProfiler::~GpuProfiler()
+	{
+		for (FrameQueries& frame : _frames)
+		{
+			vkDestroyQueryPool(_device.GetDevice(), frame.timestampPool, nullptr);
+			vkDestroyQueryPool(_device.GetDevice(), frame.statisticsPool, nullptr);
+		}
+	}
+
+	void GpuProfiler::BeginFrame(VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		assert(_currentFrame == nullptr && "Cannot begin a GPU profiler frame while one is in progress");
+
+		if (!IsSupported())
+		{
+			return;
+		}
+
+		FrameQueries& frame = _frames[frameIndex];
+		if (frame.isPending)
+		{
+			ResolveFrame(frame);
+		}
+
+		vkCmdResetQueryPool(commandBuffer, frame.timestampPool, 0, MAX_SCOPES * 2);
+		if (frame.statisticsPool != VK_NULL_HANDLE)
+		{
+			vkCmdResetQueryPool(commandBuffer, frame.statisticsPool, 0, MAX_SCOPES);
+		}
+
+		frame.scopes.clear();
+		frame.statisticsCount = 0;
+		frame.frameNumber = _frameNumber++;
+
+		_currentFrame = &frame;
+		_openScopeCount = 0;
+		_activeStatisticsScope = INVALID_SCOPE;
+
+		// The whole frame only gets timestamps, a statistics query here would prevent any nested one
+		_frameScope = BeginScope(commandBuffer, "Frame", false);
+	}
+
+	void GpuProfiler::EndFrame(VkCommandBuffer commandBuffer)
+	{
+		if (_currentFrame == nullptr)
+		{
+			return;
+		}
+
+		EndScope(commandBuffer, _frameScope);
+		assert(_openScopeCount == 0 && "Every GPU profiler scope must be closed before the end of the frame");
+
+		_currentFrame->isPending = true;
+		_currentFrame = nullptr;
+	}
+
+	uint32_t GpuProfiler::BeginScope(VkCommandBuffer commandBuffer, const char* name, bool pipelineStatistics)
+	{
+		if (_currentFrame == nullptr
+			|| _currentFrame->scopes.size() >= MAX_SCOPES)
+		{
+			return INVALID_SCOPE;
+		}
+
+		uint32_t scope = static_cast<uint32_t>(_currentFrame->scopes.size());
+		FrameQueries::Scope scopeInfo{ name, _openScopeCount, INVALID_SCOPE };
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, _currentFrame->timestampPool, scope * 2);
+
+		if (pipelineStatistics
+			&& HasPipelineStatistics()
+			&& _activeStatisticsScope == INVALID_SCOPE)
+		{
+			scopeInfo.statisticsQuery = _currentFrame->statisticsCount++;
+			vkCmdBeginQuery(commandBuffer, _currentFrame->statisticsPool, scopeInfo.statisticsQuery, 0);
+			_activeStatisticsScope = scope;
+		}
+
+		_currentFrame->scopes.push_back(scopeInfo);
+		_openScopeCount++;
+		return scope;
+	}
+
+	void GpuProfiler::EndScope(VkCommandBuffer commandBuffer, uint32_t scope)
+	{
+		if (_currentFrame == nullptr
+			|| scope == INVALID_SCOPE)
+		{
+			return;
+		}
+
+		const FrameQueries::Scope& scopeInfo = _currentFrame->scopes[scope];
+		if (scopeInfo.statisticsQuery != INVALID_SCOPE)
+		{
+			vkCmdEndQuery(commandBuffer, _currentFrame->statisticsPool, scopeInfo.statisticsQuery);
+			_activeStatisticsScope = INVALID_SCOPE;
+		}
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _currentFrame->timestampPool, scope * 2 + 1);
+		_openScopeCount--;
+	}
+
+	void GpuProfiler::CreateQueryPools()
+	{
+		VkQueryPoolCreateInfo timestampInfo{};
+		timestampInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		timestampInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		timestampInfo.queryCount = MAX_SCOPES * 2;
+
+		VkQueryPoolCreateInfo statisticsInfo{};
+		statisticsInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		statisticsInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		statisticsInfo.queryCount = MAX_SCOPES;
+		statisticsInfo.pipelineStatistics = _pipelineStatisticsFlags;
+
+		for (FrameQueries& frame : _frames)
+		{
+			if (vkCreateQueryPool(_device.GetDevice(), &timestampInfo, nullptr, &frame.timestampPool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create timestamp query pool!");
+			}
+
+			if (HasPipelineStatistics()
+				&& vkCreateQueryPool(_device.GetDevice(), &statisticsInfo, nullptr, &frame.statisticsPool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create pipeline statistics query pool!");
+			}
+
+			frame.scopes.reserve(MAX_SCOPES);
+		}
+	}
+
+	void GpuProfiler::ResolveFrame(FrameQueries& frame)
+	{
+		frame.isPending = false;
+
+		const uint32_t scopeCount = static_cast<uint32_t>(frame.scopes.size());
+		if (scopeCount == 0)
+		{
+			return;
+		}
+
+		// The renderer waited on this frame's fence before reusing the slot: no VK_QUERY_RESULT_WAIT_BIT, nothing blocks.
+		// VK_NOT_READY only happens if the frame never reached the GPU, its results are dropped.
+		_timestamps.resize(scopeCount * 2);
+		VkResult result = vkGetQueryPoolResults(_device.GetDevice(), frame.timestampPool, 0, scopeCount * 2,
+			_timestamps.size() * sizeof(uint64_t), _timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+		if (result != VK_SUCCESS)
+		{
+			return;
+		}
+
+		if (frame.statisticsCount > 0)
+		{
+			_statistics.resize(frame.statisticsCount * PIPELINE_STATISTICS_COUNT);
+			result = vkGetQueryPoolResults(_device.GetDevice(), frame.statisticsPool, 0, frame.statisticsCount,
+				_statistics.size() * sizeof(uint64_t), _statistics.data(), PIPELINE_STATISTICS_COUNT * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+			if (result != VK_SUCCESS)
+			{
+				return;
+			}
+		}
+
+		const double millisecondsPerTick = static_cast<double>(_timestampPeriod) * 1e-6;
+
+		_lastFrameStats.frameNumber = frame.frameNumber;
+		_lastFrameStats.scopes.resize(scopeCount);
+		for (uint32_t i = 0; i < scopeCount; ++i)
+		{
+			const FrameQueries::Scope& scope = frame.scopes[i];
+			GpuScopeStats& stats = _lastFrameStats.scopes[i];
+
+			uint64_t begin = _timestamps[i * 2] & _timestampMask;
+			uint64_t end = _timestamps[i * 2 + 1] & _timestampMask;
+
+			stats.name = scope.name;
+			stats.depth = scope.depth;
+			stats.milliseconds = static_cast<double>((end - begin) & _timestampMask) * millisecondsPerTick;
+
+			stats.hasPipelineStatistics = scope.statisticsQuery != INVALID_SCOPE;
+			if (stats.hasPipelineStatistics)
+			{
+				const uint64_t* counters = &_statistics[scope.statisticsQuery * PIPELINE_STATISTICS_COUNT];
+				stats.inputAssemblyVertices = counters[0];
+				stats.inputAssemblyPrimitives = counters[1];
+				stats.vertexShaderInvocations = counters[2];
+				stats.clippingInvocations = counters[3];
+				stats.clippingPrimitives = counters[4];
+				stats.fragmentShaderInvocations = counters[5];
+			}
+			else
+			{
+				stats.inputAssemblyVertices = 0;
+				stats.inputAssemblyPrimitives = 0;
+				stats.vertexShaderInvocations = 0;
+				stats.clippingInvocations = 0;
+				stats.clippingPrimitives = 0;
+				stats.fragmentShaderInvocations = 0;
+			}
+		}
+
+		// Scope 0 is the frame scope opened in BeginFrame
+		_lastFrameStats.frameMilliseconds = _lastFrameStats.scopes[0].milliseconds;
+	}
+} // namespace DaisyEngine
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "Device.hpp"
+#include "RenderTarget.hpp"
+
+// std
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The GpuScopeStats struct holds the GPU time of one named scope and, for the scopes that could open one,
+	/// the counters of its pipeline statistics query.
+	/// </summary>
+	struct GpuScopeStats
+	{
+		std::string name;
+		uint32_t depth = 0;
+		double milliseconds = 0.0;
+
+		bool hasPipelineStatistics = false;
+		uint64_t inputAssemblyVertices = 0;
+		uint64_t inputAssemblyPrimitives = 0;
+		uint64_t vertexShaderInvocations = 0;
+		uint64_t clippingInvocations = 0;
+		uint64_t clippingPrimitives = 0;
+		uint64_t fragmentShaderInvocations = 0;
+	};
+
+	/// <summary>
+	/// The GpuFrameStats struct is the resolved result of one frame, scopes are listed in the order they were opened.
+	/// </summary>
+	struct GpuFrameStats
+	{
+		uint64_t frameNumber = 0;
+		double frameMilliseconds = 0.0;
+		std::vector<GpuScopeStats> scopes;
+	};
+
+	/// <summary>
+	/// The GpuProfiler class measures command ranges with timestamp and pipeline statistics queries.
+	/// Every frame in flight owns its query pools: they are read back when the frame slot comes around again,
+	/// once the renderer has waited on its fence, so reading the results never stalls the GPU.
+	/// </summary>
+	class GpuProfiler
+	{
+	public:
+		// --- Constants ---
+		static constexpr uint32_t MAX_SCOPES = 64;
+		static constexpr uint32_t INVALID_SCOPE = UINT32_MAX;
+
+		// --- Constructor/ Destructor ---
+		GpuProfiler(Device& device);
+		~GpuProfiler();
+
+		GpuProfiler(const GpuProfiler&) = delete;
+		GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+		// --- Methods ---
+		// Resolves the last frame recorded in this slot and resets its queries, called outside of any render pass
+		void BeginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+		void EndFrame(VkCommandBuffer commandBuffer);
+
+		// Scopes are closed in reverse order of opening, names must outlive the frame (string literals).
+		// A pipeline statistics query is only opened when none is already active, nested scopes only get timestamps.
+		// Returns INVALID_SCOPE outside of a frame or once MAX_SCOPES is reached.
+		uint32_t BeginScope(VkCommandBuffer commandBuffer, const char* name, bool pipelineStatistics = true);
+		void EndScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+		// Secondary command buffers executed while a pipeline statistics query is active must inherit these flags
+		inline VkQueryPipelineStatisticFlags GetInheritedPipelineStatistics() const { return _pipelineStatisticsFlags; }
+
+		inline bool IsSupported() const { return _timestampPeriod > 0.0f; }
+		inline bool HasPipelineStatistics() const { return _pipelineStatisticsFlags != 0; }
+
+		// Latest resolved frame, it lags MAX_FRAMES_IN_FLIGHT frames behind the one being recorded
+		inline const GpuFrameStats& GetLastFrameStats() const { return _lastFrameStats; }
+
+	private:
+		/// <summary>
+		/// Query pools and scope bookkeeping of one frame in flight.
+		/// </summary>
+		struct FrameQueries
+		{
+			VkQueryPool timestampPool = VK_NULL_HANDLE;
+			VkQueryPool statisticsPool = VK_NULL_HANDLE;
+
+			struct Scope
+			{
+				const char* name;
+				uint32_t depth;
+				uint32_t statisticsQuery; // INVALID_SCOPE when the scope has no pipeline statistics
+			};
+			std::vector<Scope> scopes;
+			uint32_t statisticsCount = 0;
+			uint64_t frameNumber = 0;
+			bool isPending = false;
+		};
+
+		// --- Methods ---
+		void CreateQueryPools();
+		void ResolveFrame(FrameQueries& frame);
+
+		// --- Variables ---
+		Device& _device;
+		float _timestampPeriod = 0.0f; // Nanoseconds per tick, 0 when timestamps are not supported
+		uint64_t _timestampMask = 0;
+		VkQueryPipelineStatisticFlags _pipelineStatisticsFlags = 0;
+
+		std::array<FrameQueries, RenderTarget::MAX_FRAMES_IN_FLIGHT> _frames;
+		FrameQueries* _currentFrame = nullptr;
+		uint32_t _openScopeCount = 0;
+		uint32_t _activeStatisticsScope = INVALID_SCOPE;
+		uint32_t _frameScope = INVALID_SCOPE;
+		uint64_t _frameNumber = 0;
+
+		GpuFrameStats _lastFrameStats;
+		std::vector<uint64_t> _timestamps;
+		std::vector<uint64_t> _statistics;
+	};
+
+	/// <summary>
+	/// The GpuProfileScope struct opens a GpuProfiler scope for its lifetime, the profiler may be null.
+	/// </summary>
+	struct GpuProfileScope
+	{
+		GpuProfileScope(GpuProfiler* profiler, VkCommandBuffer commandBuffer, const char* name, bool pipelineStatistics = true)
+			: profiler(profiler), commandBuffer(commandBuffer)
+		{
+			if (profiler != nullptr)
+			{
+				scope = profiler->BeginScope(commandBuffer, name, pipelineStatistics);
+			}
+		}
+
+		~GpuProfileScope()
+		{
+			if (profiler != nullptr)
+			{
+				profiler->EndScope(commandBuffer, scope);
+			}
+		}
+
+		GpuProfileScope(const GpuProfileScope&) = delete;
+		GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+		GpuProfiler* profiler;
+		VkCommandBuffer commandBuffer;
+		uint32_t scope = GpuProfiler::INVALID_SCOPE;
+	};
+} // namespace DaisyEngine
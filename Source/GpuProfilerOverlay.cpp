@@ -0,0 +1,226 @@
+#include "GpuProfilerOverlay.hpp"
+
+// std
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+// ImGUI
+#include <imgui.h>
+#include <imgui_impl_vulkan.h>
+#include <imgui_impl_glfw.h>
+
+namespace DaisyEngine
+{
+	static void check_vk_result(VkResult err)
+	{
+		if (err == 0)
+		{
+			return;
+		}
+
+		fprintf(stderr, "[Vulkan] Error : VkResult = %d\n", err);
+
+		if (err < 0)
+		{
+			abort();
+		}
+	}
+
+	GpuProfilerOverlay::GpuProfilerOverlay(Window& window, Device& device, VkRenderPass renderPass, uint32_t imageCount)
+		: _device(device)
+	{
+		CreateDescriptorPool();
+		CreateCommandBuffers();
+
+		IMGUI_CHECKVERSION();
+		ImGui::CreateContext();
+		ImGui::GetIO().IniFilename = nullptr;
+		ImGui::StyleColorsDark();
+
+		ImGui_ImplGlfw_InitForVulkan(window.GetGLFWWindow(), true);
+
+		QueueFamilyIndices queueFamilies = _device.FindPhysicalQueueFamilies();
+
+		// The font texture is uploaded on the first NewFrame (ImGui 1.90+ backend)
+		ImGui_ImplVulkan_InitInfo initInfo{};
+		initInfo.Instance = _device.GetInstance();
+		initInfo.PhysicalDevice = _device.GetPhysicalDevice();
+		initInfo.Device = _device.GetDevice();
+		initInfo.QueueFamily = queueFamilies.graphicsFamily;
+		initInfo.Queue = _device.GetGraphicsQueue();
+		initInfo.PipelineCache = _device.GetPipelineCache();
+		initInfo.DescriptorPool = _descriptorPool;
+		initInfo.RenderPass = renderPass;
+		initInfo.Subpass = 0;
+		initInfo.MinImageCount = RenderTarget::MAX_FRAMES_IN_FLIGHT;
+		initInfo.ImageCount = imageCount;
+		initInfo.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
+		initInfo.CheckVkResultFn = check_vk_result;
+
+		if (!ImGui_ImplVulkan_Init(&initInfo))
+		{
+			throw std::runtime_error("Failed to initialize the ImGui Vulkan backend!");
+		}
+	}
+
+	GpuProfilerOverlay::~GpuProfilerOverlay()
+	{
+		ImGui_ImplVulkan_Shutdown();
+		ImGui_ImplGlfw_Shutdown();
+		ImGui::DestroyContext();
+
+		for (VkCommandPool commandPool : _commandPools)
+		{
+			vkDestroyCommandPool(_device.GetDevice(), commandPool, nullptr);
+		}
+
+		vkDestroyDescriptorPool(_device.GetDevice(), _descriptorPool, nullptr);
+	}
+
+	void GpuProfilerOverlay::Render(FrameInfo& frameInfo, const GpuProfiler& profiler, VkSubpassContents contents)
+	{
+		ImGui_ImplVulkan_NewFrame();
+		ImGui_ImplGlfw_NewFrame();
+		ImGui::NewFrame();
+
+		BuildWindow(profiler);
+
+		ImGui::Render();
+		ImDrawData* drawData = ImGui::GetDrawData();
+
+		if (contents == VK_SUBPASS_CONTENTS_INLINE)
+		{
+			ImGui_ImplVulkan_RenderDrawData(drawData, frameInfo.commandBuffer);
+			return;
+		}
+
+		// The fence of this frame was waited on in BeginFrame, the pool can be reset as a whole
+		vkResetCommandPool(_device.GetDevice(), _commandPools[frameInfo.frameIndex], 0);
+		VkCommandBuffer commandBuffer = _commandBuffers[frameInfo.frameIndex];
+
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = frameInfo.renderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = frameInfo.framebuffer;
+		inheritanceInfo.pipelineStatistics = profiler.GetInheritedPipelineStatistics();
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to begin recording overlay command buffer!");
+		}
+
+		ImGui_ImplVulkan_RenderDrawData(drawData, commandBuffer);
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to record overlay command buffer!");
+		}
+
+		vkCmdExecuteCommands(frameInfo.commandBuffer, 1, &commandBuffer);
+	}
+
+	void GpuProfilerOverlay::CreateDescriptorPool()
+	{
+		// Only the font texture is bound through this pool
+		VkDescriptorPoolSize poolSize{};
+		poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSize.descriptorCount = 1;
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+		poolInfo.maxSets = 1;
+		poolInfo.poolSizeCount = 1;
+		poolInfo.pPoolSizes = &poolSize;
+
+		if (vkCreateDescriptorPool(_device.GetDevice(), &poolInfo, nullptr, &_descriptorPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create overlay descriptor pool!");
+		}
+	}
+
+	void GpuProfilerOverlay::CreateCommandBuffers()
+	{
+		QueueFamilyIndices queueFamilies = _device.FindPhysicalQueueFamilies();
+
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = queueFamilies.graphicsFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		for (int frameIndex = 0; frameIndex < RenderTarget::MAX_FRAMES_IN_FLIGHT; ++frameIndex)
+		{
+			if (vkCreateCommandPool(_device.GetDevice(), &poolInfo, nullptr, &_commandPools[frameIndex]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create overlay command pool!");
+			}
+
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandPool = _commandPools[frameIndex];
+			allocInfo.commandBufferCount = 1;
+
+			if (vkAllocateCommandBuffers(_device.GetDevice(), &allocInfo, &_commandBuffers[frameIndex]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to allocate overlay command buffer!");
+			}
+		}
+	}
+
+	void GpuProfilerOverlay::BuildWindow(const GpuProfiler& profiler)
+	{
+		ImGui::SetNextWindowPos(ImVec2(10.0f, 10.0f), ImGuiCond_FirstUseEver);
+		ImGui::Begin("GPU profiler", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+
+		if (!profiler.IsSupported())
+		{
+			ImGui::TextUnformatted("Timestamps are not supported by this device");
+			ImGui::End();
+			return;
+		}
+
+		const GpuFrameStats& stats = profiler.GetLastFrameStats();
+		ImGui::Text("Frame %llu: %.3f ms", static_cast<unsigned long long>(stats.frameNumber), stats.frameMilliseconds);
+
+		if (ImGui::BeginTable("Scopes", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+		{
+			ImGui::TableSetupColumn("Scope");
+			ImGui::TableSetupColumn("GPU ms");
+			ImGui::TableSetupColumn("Primitives");
+			ImGui::TableSetupColumn("VS invocations");
+			ImGui::TableSetupColumn("FS invocations");
+			ImGui::TableHeadersRow();
+
+			for (const GpuScopeStats& scope : stats.scopes)
+			{
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Text("%*s%s", static_cast<int>(scope.depth * 2), "", scope.name.c_str());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", scope.milliseconds);
+
+				if (scope.hasPipelineStatistics)
+				{
+					ImGui::TableNextColumn();
+					ImGui::Text("%llu", static_cast<unsigned long long>(scope.inputAssemblyPrimitives));
+					ImGui::TableNextColumn();
+					ImGui::Text("%llu", static_cast<unsigned long long>(scope.vertexShaderInvocations));
+					ImGui::TableNextColumn();
+					ImGui::Text("%llu", static_cast<unsigned long long>(scope.fragmentShaderInvocations));
+				}
+			}
+
+			ImGui::EndTable();
+		}
+
+		ImGui::End();
+	}
+} // namespace DaisyEngine
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Window.hpp"
+#include "Device.hpp"
+#include "FrameInfo.hpp"
+#include "GpuProfiler.hpp"
+#include "RenderTarget.hpp"
+
+// std
+#include <array>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The GpuProfilerOverlay class draws the last resolved GpuProfiler frame with ImGui on top of the scene.
+	/// When the render pass only executes secondary command buffers, the overlay is recorded in its own secondary.
+	/// </summary>
+	class GpuProfilerOverlay
+	{
+	public:
+		// --- Constructor/ Destructor ---
+		GpuProfilerOverlay(Window& window, Device& device, VkRenderPass renderPass, uint32_t imageCount);
+		~GpuProfilerOverlay();
+
+		GpuProfilerOverlay(const GpuProfilerOverlay&) = delete;
+		GpuProfilerOverlay& operator=(const GpuProfilerOverlay&) = delete;
+
+		// --- Methods ---
+		// Records the overlay inside the current render pass, contents must match the ones the pass was begun with
+		void Render(FrameInfo& frameInfo, const GpuProfiler& profiler, VkSubpassContents contents);
+
+	private:
+		// --- Methods ---
+		void CreateDescriptorPool();
+		void CreateCommandBuffers();
+		void BuildWindow(const GpuProfiler& profiler);
+
+		// --- Variables ---
+		Device& _device;
+		VkDescriptorPool _descriptorPool = VK_NULL_HANDLE;
+
+		std::array<VkCommandPool, RenderTarget::MAX_FRAMES_IN_FLIGHT> _commandPools{};
+		std::array<VkCommandBuffer, RenderTarget::MAX_FRAMES_IN_FLIGHT> _commandBuffers{};
+	};
+} // namespace DaisyEngine
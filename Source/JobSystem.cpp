@@ -0,0 +1,428 @@
+#include "JobSystem.hpp"
+#include "CpuProfiler.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <string>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// A submitted job, allocated from the ring of the worker that submitted it and reused once it ran.
+	/// </summary>
+	struct Job
+	{
+		JobSystem::JobFunction function;
+		JobCounter* counter = nullptr;
+		std::atomic<bool> isPending{ false };
+	};
+
+	// The job system the calling thread works for, and its index in it
+	static thread_local const JobSystem* t_jobSystem = nullptr;
+	static thread_local uint32_t t_workerIndex = JobSystem::INVALID_WORKER;
+
+	// Before sleeping, an idle worker retries this many times in case more work is about to be queued
+	static constexpr int IDLE_SPIN_COUNT = 64;
+
+	bool JobSystem::WorkStealingQueue::Push(Job* job)
+	{
+		int64_t bottom = _bottom.load(std::memory_order_relaxed);
+		int64_t top = _top.load(std::memory_order_acquire);
+		if (bottom - top >= static_cast<int64_t>(MAX_PENDING_JOBS))
+		{
+			return false;
+		}
+
+		_jobs[bottom & (MAX_PENDING_JOBS - 1)].store(job, std::memory_order_relaxed);
+		_bottom.store(bottom + 1, std::memory_order_release);
+		return true;
+	}
+
+	Job* JobSystem::WorkStealingQueue::Pop()
+	{
+		// Claim the bottom job first, a thief can only take it by winning the race on top
+		int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+		_bottom.store(bottom, std::memory_order_seq_cst);
+		int64_t top = _top.load(std::memory_order_seq_cst);
+
+		if (top > bottom)
+		{
+			_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Job* job = _jobs[bottom & (MAX_PENDING_JOBS - 1)].load(std::memory_order_relaxed);
+		if (top == bottom)
+		{
+			// Last job, the owner and the thieves race for it
+			if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				job = nullptr;
+			}
+			_bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+
+		return job;
+	}
+
+	Job* JobSystem::WorkStealingQueue::Steal()
+	{
+		int64_t top = _top.load(std::memory_order_seq_cst);
+		int64_t bottom = _bottom.load(std::memory_order_seq_cst);
+		if (top >= bottom)
+		{
+			return nullptr;
+		}
+
+		Job* job = _jobs[top & (MAX_PENDING_JOBS - 1)].load(std::memory_order_relaxed);
+		if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			return nullptr;
+		}
+
+		return job;
+	}
+
+	JobSystem::JobSystem(uint32_t workerCount)
+	{
+		if (workerCount == 0)
+		{
+			workerCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		_workers.reserve(workerCount);
+		for (uint32_t workerIndex = 0; workerIndex < workerCount; ++workerIndex)
+		{
+			_workers.push_back(std::make_unique<Worker>());
+			_workers.back()->jobs.reset(new Job[MAX_PENDING_JOBS]);
+		}
+
+		// Job systems created on the same thread nest, the previous one gets the thread back once this one is destroyed
+		_previousJobSystem = t_jobSystem;
+		_previousWorkerIndex = t_workerIndex;
+		t_jobSystem = this;
+		t_workerIndex = 0;
+
+		_threads.reserve(workerCount - 1);
+		for (uint32_t workerIndex = 1; workerIndex < workerCount; ++workerIndex)
+		{
+			_threads.emplace_back(&JobSystem::WorkerLoop, this, workerIndex);
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_sleepMutex);
+			_isStopping.store(true);
+		}
+		_wakeCondition.notify_all();
+
+		for (std::thread& thread : _threads)
+		{
+			thread.join();
+		}
+
+		if (t_jobSystem == this)
+		{
+			t_jobSystem = _previousJobSystem;
+			t_workerIndex = _previousWorkerIndex;
+		}
+	}
+
+	uint32_t JobSystem::GetCurrentWorkerIndex() const
+	{
+		return t_jobSystem == this ? t_workerIndex : INVALID_WORKER;
+	}
+
+	uint64_t JobSystem::GetExecutedJobCount() const
+	{
+		uint64_t count = 0;
+		for (const std::unique_ptr<Worker>& worker : _workers)
+		{
+			count += worker->executedCount.load(std::memory_order_relaxed);
+		}
+		return count;
+	}
+
+	uint64_t JobSystem::GetStolenJobCount() const
+	{
+		uint64_t count = 0;
+		for (const std::unique_ptr<Worker>& worker : _workers)
+		{
+			count += worker->stolenCount.load(std::memory_order_relaxed);
+		}
+		return count;
+	}
+
+	void JobSystem::Submit(JobFunction function, JobCounter* counter, JobCounter* dependency)
+	{
+		uint32_t workerIndex = GetCurrentWorkerIndex();
+		assert(workerIndex != INVALID_WORKER && "Jobs can only be submitted from a worker of this job system");
+
+		Worker& worker = *_workers[workerIndex];
+		Job* job = &worker.jobs[worker.nextJob & (MAX_PENDING_JOBS - 1)];
+		if (job->isPending.load(std::memory_order_acquire))
+		{
+			// Every job of the ring is still in flight, run this one now instead of waiting for a free one
+			if (dependency != nullptr)
+			{
+				RunUntilDone(*dependency);
+			}
+
+			if (counter != nullptr)
+			{
+				counter->_value.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			Job inlineJob;
+			inlineJob.function = std::move(function);
+			inlineJob.counter = counter;
+			inlineJob.isPending.store(true, std::memory_order_relaxed);
+			Execute(&inlineJob);
+			return;
+		}
+
+		if (counter != nullptr)
+		{
+			counter->_value.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		worker.nextJob++;
+		job->function = std::move(function);
+		job->counter = counter;
+		job->isPending.store(true, std::memory_order_relaxed);
+
+		if (dependency != nullptr)
+		{
+			std::lock_guard<std::mutex> lock(dependency->_mutex);
+			if (!dependency->IsDone())
+			{
+				dependency->_dependentJobs.push_back(job);
+				return;
+			}
+		}
+
+		Enqueue(workerIndex, job);
+	}
+
+	void JobSystem::Wait(JobCounter& counter)
+	{
+		RunUntilDone(counter);
+
+		// The last job reaches zero while holding the lock, the counter may only be destroyed once it released it
+		std::exception_ptr exception;
+		{
+			std::lock_guard<std::mutex> lock(counter._mutex);
+			exception = counter._exception;
+			counter._exception = nullptr;
+		}
+
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}
+	}
+
+	void JobSystem::RunUntilDone(JobCounter& counter)
+	{
+		DAISY_PROFILE_ZONE("Wait for jobs");
+
+		uint32_t workerIndex = GetCurrentWorkerIndex();
+		while (!counter.IsDone())
+		{
+			// Help instead of blocking, the jobs being waited on may still be queued
+			Job* job = workerIndex != INVALID_WORKER ? FindJob(workerIndex) : nullptr;
+			if (job != nullptr)
+			{
+				Execute(job);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void JobSystem::ParallelFor(uint32_t count, uint32_t grainSize, const RangeFunction& function)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		grainSize = std::max(grainSize, 1u);
+		if (count <= grainSize || _workers.size() == 1)
+		{
+			function(0, count);
+			return;
+		}
+
+		JobCounter counter;
+		for (uint32_t begin = grainSize; begin < count; begin += grainSize)
+		{
+			uint32_t end = std::min(begin + grainSize, count);
+			Submit([&function, begin, end]() { function(begin, end); }, &counter);
+		}
+
+		// The first range runs here, the others are likely stolen by then. The jobs reference function, they must finish before any exception leaves
+		std::exception_ptr exception;
+		try
+		{
+			function(0, grainSize);
+		}
+		catch (...)
+		{
+			exception = std::current_exception();
+		}
+
+		Wait(counter);
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}
+	}
+
+	void JobSystem::WorkerLoop(uint32_t workerIndex)
+	{
+		t_jobSystem = this;
+		t_workerIndex = workerIndex;
+		DAISY_PROFILE_THREAD("Job worker " + std::to_string(workerIndex));
+
+		int idleCount = 0;
+		while (!_isStopping.load(std::memory_order_relaxed))
+		{
+			if (Job* job = FindJob(workerIndex))
+			{
+				Execute(job);
+				idleCount = 0;
+				continue;
+			}
+
+			if (++idleCount < IDLE_SPIN_COUNT)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			// The queued count is incremented before WakeWorker reads the sleeping count, so no wake up is lost
+			std::unique_lock<std::mutex> lock(_sleepMutex);
+			_sleepingWorkerCount.fetch_add(1);
+			_wakeCondition.wait(lock, [this]() { return _queuedJobCount.load() > 0 || _isStopping.load(); });
+			_sleepingWorkerCount.fetch_sub(1);
+			idleCount = 0;
+		}
+	}
+
+	Job* JobSystem::FindJob(uint32_t workerIndex)
+	{
+		Worker& worker = *_workers[workerIndex];
+		if (Job* job = worker.queue.Pop())
+		{
+			_queuedJobCount.fetch_sub(1);
+			return job;
+		}
+
+		// Steal from the next workers in turn, so the thieves do not all start with the same victim
+		uint32_t workerCount = GetWorkerCount();
+		for (uint32_t offset = 1; offset < workerCount; ++offset)
+		{
+			if (Job* job = _workers[(workerIndex + offset) % workerCount]->queue.Steal())
+			{
+				_queuedJobCount.fetch_sub(1);
+				worker.stolenCount.fetch_add(1, std::memory_order_relaxed);
+				return job;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void JobSystem::Enqueue(uint32_t workerIndex, Job* job)
+	{
+		if (!_workers[workerIndex]->queue.Push(job))
+		{
+			// The deque is full of jobs released by dependencies, run it now
+			Execute(job);
+			return;
+		}
+
+		_queuedJobCount.fetch_add(1);
+		WakeWorker();
+	}
+
+	void JobSystem::Execute(Job* job)
+	{
+		try
+		{
+			job->function();
+		}
+		catch (...)
+		{
+			if (job->counter == nullptr)
+			{
+				std::terminate();
+			}
+
+			std::lock_guard<std::mutex> lock(job->counter->_mutex);
+			if (!job->counter->_exception)
+			{
+				job->counter->_exception = std::current_exception();
+			}
+		}
+
+		// The job can be reused by its worker as soon as it is no longer pending, read the counter first
+		JobCounter* counter = job->counter;
+		job->function = nullptr;
+		job->isPending.store(false, std::memory_order_release);
+
+		uint32_t workerIndex = GetCurrentWorkerIndex();
+		_workers[workerIndex]->executedCount.fetch_add(1, std::memory_order_relaxed);
+
+		if (counter != nullptr)
+		{
+			Finish(*counter);
+		}
+	}
+
+	void JobSystem::Finish(JobCounter& counter)
+	{
+		// Not the last job, nothing to release
+		uint32_t value = counter._value.load(std::memory_order_relaxed);
+		while (value > 1)
+		{
+			if (counter._value.compare_exchange_weak(value, value - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+			{
+				return;
+			}
+		}
+
+		// Reaching zero under the lock orders it with the dependency check of Submit
+		std::vector<Job*> dependentJobs;
+		{
+			std::lock_guard<std::mutex> lock(counter._mutex);
+			if (counter._value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				dependentJobs.swap(counter._dependentJobs);
+			}
+		}
+
+		uint32_t workerIndex = GetCurrentWorkerIndex();
+		for (Job* job : dependentJobs)
+		{
+			Enqueue(workerIndex, job);
+		}
+	}
+
+	void JobSystem::WakeWorker()
+	{
+		if (_sleepingWorkerCount.load() == 0)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		_wakeCondition.notify_one();
+	}
+} // namespace DaisyEngine
@@ -0,0 +1,142 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DaisyEngine
+{
+	class JobSystem;
+	struct Job;
+
+	/// <summary>
+	/// The JobCounter class counts the unfinished jobs submitted with it. Waiting on it, or submitting a job that depends on it,
+	/// completes once every one of those jobs is done. A counter can be reused, or destroyed, once a Wait on it returned.
+	/// The first exception thrown by one of its jobs is kept in the counter and rethrown by the next Wait on it.
+	/// </summary>
+	class JobCounter
+	{
+	public:
+		// --- Constructor ---
+		JobCounter() = default;
+
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		// --- Methods ---
+		inline bool IsDone() const { return _value.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class JobSystem;
+
+		// --- Variables ---
+		std::atomic<uint32_t> _value{ 0 };
+		std::mutex _mutex; // Guards the dependent jobs and the exception
+		std::vector<Job*> _dependentJobs; // Submitted with this counter as dependency, queued once it reaches zero
+		std::exception_ptr _exception;
+	};
+
+	/// <summary>
+	/// The JobSystem class runs jobs on a fixed set of worker threads. Every worker owns a work stealing deque: it pushes and pops
+	/// its own jobs at the bottom without locking, idle workers steal the oldest jobs from the top of the others.
+	/// The thread creating the JobSystem is worker 0, it has no thread of its own and runs jobs while it waits on a counter.
+	/// Jobs can only be submitted from the workers, including worker 0. A job submitted without a counter has no Wait to report
+	/// an exception to, one escaping it terminates the program like one escaping a std::thread.
+	/// </summary>
+	class JobSystem
+	{
+	public:
+		using JobFunction = std::function<void()>;
+		// Processes the indices [begin, end)
+		using RangeFunction = std::function<void(uint32_t begin, uint32_t end)>;
+
+		// --- Constants ---
+		static constexpr uint32_t MAX_PENDING_JOBS = 4096; // Per worker, a worker with more jobs in flight runs the next ones inline. Power of two
+		static constexpr uint32_t INVALID_WORKER = UINT32_MAX;
+
+		// --- Constructor/ Destructor ---
+		// A worker count of 0 uses one worker per hardware thread, the calling thread counts as worker 0
+		explicit JobSystem(uint32_t workerCount = 0);
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		// --- Methods ---
+		// Queues a job on the calling worker. The job is counted by counter, and only starts once dependency is done, even
+		// if one of the jobs of the dependency threw: the exception stays in the dependency for its own Wait
+		void Submit(JobFunction function, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+
+		// Runs queued jobs until the counter reaches zero, then rethrows the first exception one of its jobs threw since the last Wait on it
+		void Wait(JobCounter& counter);
+
+		// Splits [0, count) in ranges of grainSize indices, runs them on every worker and returns once they are all done
+		void ParallelFor(uint32_t count, uint32_t grainSize, const RangeFunction& function);
+
+		inline uint32_t GetWorkerCount() const { return static_cast<uint32_t>(_workers.size()); }
+		uint64_t GetExecutedJobCount() const;
+		uint64_t GetStolenJobCount() const;
+
+		// The worker index of the calling thread in this job system, INVALID_WORKER for other threads
+		uint32_t GetCurrentWorkerIndex() const;
+
+	private:
+		/// <summary>
+		/// Chase-Lev deque of job pointers with a fixed capacity. Push and Pop are only called by the owning worker, Steal by any thread.
+		/// </summary>
+		class WorkStealingQueue
+		{
+		public:
+			bool Push(Job* job);
+			Job* Pop();
+			Job* Steal();
+
+		private:
+			std::atomic<int64_t> _top{ 0 };
+			std::atomic<int64_t> _bottom{ 0 };
+			std::unique_ptr<std::atomic<Job*>[]> _jobs{ new std::atomic<Job*>[MAX_PENDING_JOBS] };
+		};
+
+		/// <summary>
+		/// Everything owned by one worker, on its own cache lines so workers do not invalidate each other's.
+		/// </summary>
+		struct alignas(64) Worker
+		{
+			WorkStealingQueue queue;
+			std::unique_ptr<Job[]> jobs; // Ring of MAX_PENDING_JOBS jobs allocated by this worker
+			uint32_t nextJob = 0;
+			std::atomic<uint64_t> executedCount{ 0 };
+			std::atomic<uint64_t> stolenCount{ 0 };
+		};
+
+		// --- Methods ---
+		void WorkerLoop(uint32_t workerIndex);
+		// Wait without the rethrow
+		void RunUntilDone(JobCounter& counter);
+		Job* FindJob(uint32_t workerIndex);
+		void Enqueue(uint32_t workerIndex, Job* job);
+		void Execute(Job* job);
+		void Finish(JobCounter& counter);
+		void WakeWorker();
+
+		// --- Variables ---
+		std::vector<std::unique_ptr<Worker>> _workers;
+		std::vector<std::thread> _threads;
+		const JobSystem* _previousJobSystem = nullptr;
+		uint32_t _previousWorkerIndex = INVALID_WORKER;
+
+		// Sleeping workers are woken when jobs are queued, _queuedJobCount is the condition they wait on
+		std::atomic<int64_t> _queuedJobCount{ 0 };
+		std::atomic<uint32_t> _sleepingWorkerCount{ 0 };
+		std::mutex _sleepMutex;
+		std::condition_variable _wakeCondition;
+		std::atomic<bool> _isStopping{ false };
+	};
+} // namespace DaisyEngine
@@ -0,0 +1,120 @@
+#include "LodSelector.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace DaisyEngine
+{
+	// Below this clip space w the sphere is at or behind the eye, it is drawn at full detail
+	static constexpr float MIN_CLIP_W = 1e-6f;
+
+	LodStats& LodStats::operator+=(const LodStats& other)
+	{
+		objectCount += other.objectCount;
+		triangleCount += other.triangleCount;
+		fullDetailTriangleCount += other.fullDetailTriangleCount;
+		for (size_t lod = 0; lod < objectsPerLod.size(); ++lod)
+		{
+			objectsPerLod[lod] += other.objectsPerLod[lod];
+		}
+		return *this;
+	}
+
+	void LodSelector::Select(const glm::mat4& viewProjection, VkExtent2D extent, const RenderView& entities, const std::vector<uint32_t>& objects,
+		JobSystem* jobSystem)
+	{
+		_lods.resize(entities.Size(), 0);
+		_stats = {};
+
+		// A length of one unit along y at w = 1 covers the norm of the y row of the matrix in clip space, half the
+		// height in pixels per clip unit. The same scale is used along x, the error of a level has no direction
+		glm::vec3 yRow{ viewProjection[0][1], viewProjection[1][1], viewProjection[2][1] };
+		const float pixelsPerClipUnit = glm::length(yRow) * 0.5f * static_cast<float>(extent.height);
+
+		if (jobSystem == nullptr)
+		{
+			SelectRange(viewProjection, pixelsPerClipUnit, entities, objects.data(), objects.size(), _stats);
+			return;
+		}
+
+		// Every range only writes the levels of its own objects and its own stats, summed once they are all done
+		_jobStats.assign((objects.size() + OBJECTS_PER_JOB - 1) / OBJECTS_PER_JOB, LodStats{});
+		jobSystem->ParallelFor(static_cast<uint32_t>(objects.size()), OBJECTS_PER_JOB, [&](uint32_t begin, uint32_t end)
+			{
+				SelectRange(viewProjection, pixelsPerClipUnit, entities, &objects[begin], end - begin, _jobStats[begin / OBJECTS_PER_JOB]);
+			});
+
+		for (const LodStats& jobStats : _jobStats)
+		{
+			_stats += jobStats;
+		}
+	}
+
+	void LodSelector::SelectRange(const glm::mat4& viewProjection, float pixelsPerClipUnit, const RenderView& entities,
+		const uint32_t* objects, size_t count, LodStats& stats)
+	{
+		Transform* transforms = entities.transforms;
+		const RenderComponent* renderComponents = entities.renderComponents;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint32_t object = objects[i];
+			Model* model = renderComponents[object].model;
+
+			// A streamed mesh that is not resident may come back as another model, it starts again from full detail
+			if (model == nullptr || !model->IsResident())
+			{
+				_lods[object] = 0;
+				continue;
+			}
+
+			uint32_t lod = 0;
+			if (model->GetLodCount() > 1)
+			{
+				Transform& transform = transforms[object];
+				const BoundingSphere& sphere = model->GetBoundingSphere();
+				glm::vec4 center = viewProjection * (transform.mat4() * glm::vec4(sphere.center, 1.0f));
+
+				if (center.w > MIN_CLIP_W)
+				{
+					// Rotation keeps lengths, only the largest scale axis can grow the error
+					const glm::vec3& scale = transform.scale;
+					float maxScale = std::max({ std::fabs(scale.x), std::fabs(scale.y), std::fabs(scale.z) });
+					float pixelsPerUnit = pixelsPerClipUnit * maxScale / center.w;
+
+					uint32_t currentLod = std::min<uint32_t>(_lods[object], model->GetLodCount() - 1);
+					lod = SelectLod(*model, pixelsPerUnit, currentLod, _pixelError, _hysteresis);
+				}
+			}
+
+			_lods[object] = static_cast<uint8_t>(lod);
+			stats.objectCount++;
+			stats.triangleCount += model->GetTriangleCount(lod);
+			stats.fullDetailTriangleCount += model->GetTriangleCount();
+			stats.objectsPerLod[lod]++;
+		}
+	}
+
+	uint32_t LodSelector::SelectLod(const Model& model, float pixelsPerUnit, uint32_t currentLod, float pixelError, float hysteresis)
+	{
+		assert(currentLod < model.GetLodCount() && "LOD out of range");
+
+		// Finer while the current level is visibly wrong
+		uint32_t lod = currentLod;
+		while (lod > 0 && model.GetLod(lod).error * pixelsPerUnit > pixelError)
+		{
+			lod--;
+		}
+
+		// Coarser only while the next level is clearly under the threshold, so a level picked at the threshold is kept
+		const float coarserPixelError = pixelError * (1.0f - hysteresis);
+		while (lod + 1 < model.GetLodCount() && model.GetLod(lod + 1).error * pixelsPerUnit <= coarserPixelError)
+		{
+			lod++;
+		}
+
+		return lod;
+	}
+} // namespace DaisyEngine
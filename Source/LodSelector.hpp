@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Components.hpp"
+#include "JobSystem.hpp"
+#include "Model.hpp"
+
+// Libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+// std
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The LodStats struct reports the result of the last LodSelector::Select call.
+	/// </summary>
+	struct LodStats
+	{
+		uint32_t objectCount = 0; // Objects with a resident model
+		uint64_t triangleCount = 0; // Triangles of the selected levels
+		uint64_t fullDetailTriangleCount = 0; // Triangles the same objects would submit without LODs
+		std::array<uint32_t, Model::MAX_LOD_COUNT> objectsPerLod{};
+
+		LodStats& operator+=(const LodStats& other);
+	};
+
+	/// <summary>
+	/// The LodSelector class picks the level of detail each object is drawn with. The error of a level, in model units, is
+	/// projected to pixels at the distance of the object's bounding sphere and the coarsest level under the pixel threshold is
+	/// kept. To keep an object from switching back and forth at the threshold, a level only gives way to a coarser one once that
+	/// one is below the threshold by the hysteresis margin. The levels are kept by view index from one frame to the next.
+	/// </summary>
+	class LodSelector
+	{
+	public:
+		// --- Constants ---
+		static constexpr float DEFAULT_PIXEL_ERROR = 1.0f;
+		static constexpr float DEFAULT_HYSTERESIS = 0.25f; // Fraction of the threshold a coarser level must be below
+		static constexpr uint32_t OBJECTS_PER_JOB = 4096;
+
+		// --- Methods ---
+		// Selects the level of each listed object, typically the output of a FrustumCuller. The others keep their level
+		// Must be called from a worker of the job system when one is given
+		void Select(const glm::mat4& viewProjection, VkExtent2D extent, const RenderView& entities, const std::vector<uint32_t>& objects,
+			JobSystem* jobSystem = nullptr);
+
+		// The level selected for a view index, 0 for objects never selected
+		inline uint32_t GetLod(uint32_t object) const { return object < _lods.size() ? _lods[object] : 0; }
+		inline const LodStats& GetStats() const { return _stats; }
+
+		inline void SetPixelError(float pixelError) { _pixelError = pixelError; }
+		inline float GetPixelError() const { return _pixelError; }
+		inline void SetHysteresis(float hysteresis) { _hysteresis = hysteresis; }
+		inline float GetHysteresis() const { return _hysteresis; }
+
+		// The level of a model projected at pixelsPerUnit pixels per model unit, starting from the current one
+		static uint32_t SelectLod(const Model& model, float pixelsPerUnit, uint32_t currentLod, float pixelError, float hysteresis);
+
+	private:
+		// --- Methods ---
+		void SelectRange(const glm::mat4& viewProjection, float pixelsPerClipUnit, const RenderView& entities,
+			const uint32_t* objects, size_t count, LodStats& stats);
+
+		// --- Variables ---
+		float _pixelError = DEFAULT_PIXEL_ERROR;
+		float _hysteresis = DEFAULT_HYSTERESIS;
+
+		std::vector<uint8_t> _lods; // By view index
+		std::vector<LodStats> _jobStats; // Of each job range, summed into _stats
+		LodStats _stats;
+	};
+} // namespace DaisyEngine
@@ -0,0 +1,148 @@
+#include "MappedFile.hpp"
+
+// std
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace DaisyEngine
+{
+	MappedFile::MappedFile(const std::string& filepath)
+		: _path(filepath)
+	{
+#ifdef _WIN32
+		HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			throw std::runtime_error("Failed to open file: " + filepath);
+		}
+		_fileHandle = file;
+
+		LARGE_INTEGER size{};
+		if (!GetFileSizeEx(file, &size))
+		{
+			Close();
+			throw std::runtime_error("Failed to get the size of file: " + filepath);
+		}
+		_size = static_cast<size_t>(size.QuadPart);
+
+		// An empty file cannot be mapped, it simply has no data
+		if (_size == 0)
+		{
+			return;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+		{
+			Close();
+			throw std::runtime_error("Failed to map file: " + filepath);
+		}
+		_mappingHandle = mapping;
+
+		_data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if (_data == nullptr)
+		{
+			Close();
+			throw std::runtime_error("Failed to map file: " + filepath);
+		}
+#else
+		int file = open(filepath.c_str(), O_RDONLY);
+		if (file < 0)
+		{
+			throw std::runtime_error("Failed to open file: " + filepath);
+		}
+
+		struct stat status{};
+		if (fstat(file, &status) != 0)
+		{
+			close(file);
+			throw std::runtime_error("Failed to get the size of file: " + filepath);
+		}
+		_size = static_cast<size_t>(status.st_size);
+
+		if (_size > 0)
+		{
+			void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (data == MAP_FAILED)
+			{
+				close(file);
+				throw std::runtime_error("Failed to map file: " + filepath);
+			}
+
+			// The file is read front to back, let the kernel read ahead aggressively
+			madvise(data, _size, MADV_SEQUENTIAL);
+			_data = static_cast<const uint8_t*>(data);
+		}
+
+		// The mapping keeps its own reference to the file
+		close(file);
+#endif
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+		: _path(std::move(other._path)), _data(std::exchange(other._data, nullptr)), _size(std::exchange(other._size, 0))
+#ifdef _WIN32
+		, _fileHandle(std::exchange(other._fileHandle, nullptr)), _mappingHandle(std::exchange(other._mappingHandle, nullptr))
+#endif
+	{
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Close();
+			_path = std::move(other._path);
+			_data = std::exchange(other._data, nullptr);
+			_size = std::exchange(other._size, 0);
+#ifdef _WIN32
+			_fileHandle = std::exchange(other._fileHandle, nullptr);
+			_mappingHandle = std::exchange(other._mappingHandle, nullptr);
+#endif
+		}
+		return *this;
+	}
+
+	void MappedFile::Close()
+	{
+#ifdef _WIN32
+		if (_data != nullptr)
+		{
+			UnmapViewOfFile(_data);
+		}
+		if (_mappingHandle != nullptr)
+		{
+			CloseHandle(_mappingHandle);
+		}
+		if (_fileHandle != nullptr)
+		{
+			CloseHandle(_fileHandle);
+		}
+		_fileHandle = nullptr;
+		_mappingHandle = nullptr;
+#else
+		if (_data != nullptr)
+		{
+			munmap(const_cast<uint8_t*>(_data), _size);
+		}
+#endif
+		_data = nullptr;
+		_size = 0;
+	}
+} // namespace DaisyEngine
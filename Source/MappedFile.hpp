@@ -0,0 +1,47 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The MappedFile class maps a whole file read only into the address space. The pages are read by the OS on first access,
+	/// so the data can be copied straight from the file cache to its destination without going through a heap buffer.
+	/// </summary>
+	class MappedFile
+	{
+	public:
+		// --- Constructor/ Destructor ---
+		explicit MappedFile(const std::string& filepath);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		// --- Methods ---
+		// Page aligned, null for an empty file
+		inline const uint8_t* Data() const { return _data; }
+		inline size_t Size() const { return _size; }
+		inline const std::string& GetPath() const { return _path; }
+
+	private:
+		// --- Methods ---
+		void Close();
+
+		// --- Variables ---
+		std::string _path;
+		const uint8_t* _data = nullptr;
+		size_t _size = 0;
+
+#ifdef _WIN32
+		void* _fileHandle = nullptr;
+		void* _mappingHandle = nullptr;
+#endif
+	};
+} // namespace DaisyEngine
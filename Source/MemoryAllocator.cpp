@@ -0,0 +1,532 @@
+#include "MemoryAllocator.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace DaisyEngine
+{
+	static inline VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	static inline uint32_t LowestBit(uint64_t mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, mask);
+		return static_cast<uint32_t>(index);
+#else
+		return static_cast<uint32_t>(__builtin_ctzll(mask));
+#endif
+	}
+
+	static inline uint32_t HighestBit(uint64_t mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse64(&index, mask);
+		return static_cast<uint32_t>(index);
+#else
+		return 63u - static_cast<uint32_t>(__builtin_clzll(mask));
+#endif
+	}
+
+	MemoryAllocator::MemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device)
+		: _device(device)
+	{
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &_memoryProperties);
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		_bufferImageGranularity = properties.limits.bufferImageGranularity;
+		_maxMemoryAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+		// One pool per memory type and resource kind
+		_pools.resize(_memoryProperties.memoryTypeCount * 2);
+		for (uint32_t i = 0; i < _memoryProperties.memoryTypeCount; ++i)
+		{
+			for (uint32_t kind = 0; kind < 2; ++kind)
+			{
+				Pool& pool = _pools[i * 2 + kind];
+				pool.memoryTypeIndex = i;
+				pool.kind = static_cast<ResourceKind>(kind);
+				pool.blockSize = ComputeBlockSize(i);
+			}
+		}
+
+		_dedicatedBytes.resize(_memoryProperties.memoryTypeCount, 0);
+		_dedicatedCount.resize(_memoryProperties.memoryTypeCount, 0);
+	}
+
+	MemoryAllocator::~MemoryAllocator()
+	{
+		for (Pool& pool : _pools)
+		{
+			for (std::unique_ptr<Block>& block : pool.blocks)
+			{
+				if (block->allocationCount > 0)
+				{
+					std::cerr << "MemoryAllocator: " << block->allocationCount << " allocation(s) still alive in memory type "
+						<< pool.memoryTypeIndex << std::endl;
+				}
+				DestroyBlock(*block);
+			}
+			pool.blocks.clear();
+		}
+	}
+
+	Allocation MemoryAllocator::Allocate(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, ResourceKind kind)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		const VkDeviceSize size = requirements.size;
+		const VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+		const uint32_t poolIndex = GetPoolIndex(memoryTypeIndex, kind);
+		Pool& pool = _pools[poolIndex];
+
+		Allocation allocation{};
+		allocation.memoryTypeIndex = memoryTypeIndex;
+		allocation.poolIndex = poolIndex;
+		allocation.size = size;
+
+		// Big resources get their own memory, they would waste most of a block anyway
+		if (size > pool.blockSize / 2)
+		{
+			allocation.memory = AllocateDeviceMemory(size, memoryTypeIndex, &allocation.mappedData);
+			if (allocation.memory == VK_NULL_HANDLE)
+			{
+				throw std::runtime_error("Failed to allocate dedicated device memory!");
+			}
+
+			_dedicatedBytes[memoryTypeIndex] += size;
+			_dedicatedCount[memoryTypeIndex]++;
+			return allocation;
+		}
+
+		Block* target = nullptr;
+		uint32_t rangeIndex = INVALID_INDEX;
+		for (std::unique_ptr<Block>& block : pool.blocks)
+		{
+			if (AllocateFromBlock(*block, size, alignment, rangeIndex))
+			{
+				target = block.get();
+				break;
+			}
+		}
+
+		if (target == nullptr)
+		{
+			target = CreateBlock(pool);
+			if (!AllocateFromBlock(*target, size, alignment, rangeIndex))
+			{
+				throw std::runtime_error("Failed to sub-allocate from a new memory block!");
+			}
+		}
+
+		const Range& range = target->ranges[rangeIndex];
+		target->allocationCount++;
+		target->usedBytes += range.size;
+
+		allocation.memory = target->memory;
+		allocation.offset = range.offset;
+		allocation.rangeIndex = rangeIndex;
+		allocation.block = target;
+		if (target->mappedData != nullptr)
+		{
+			allocation.mappedData = static_cast<char*>(target->mappedData) + range.offset;
+		}
+
+		return allocation;
+	}
+
+	void MemoryAllocator::Free(Allocation& allocation)
+	{
+		if (!allocation.IsValid())
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if (allocation.IsDedicated())
+		{
+			FreeDeviceMemory(allocation.memory);
+			_dedicatedBytes[allocation.memoryTypeIndex] -= allocation.size;
+			_dedicatedCount[allocation.memoryTypeIndex]--;
+			allocation = Allocation{};
+			return;
+		}
+
+		Block& block = *static_cast<Block*>(allocation.block);
+		assert(!block.ranges[allocation.rangeIndex].isFree && "Allocation freed twice");
+
+		block.usedBytes -= block.ranges[allocation.rangeIndex].size;
+		block.allocationCount--;
+		FreeRange(block, allocation.rangeIndex);
+
+		// Keep a single empty block per pool around to avoid allocation thrashing
+		if (block.allocationCount == 0)
+		{
+			Pool& pool = _pools[allocation.poolIndex];
+			size_t emptyBlocks = std::count_if(pool.blocks.begin(), pool.blocks.end(),
+				[](const std::unique_ptr<Block>& b) { return b->allocationCount == 0; });
+
+			if (emptyBlocks > 1)
+			{
+				auto it = std::find_if(pool.blocks.begin(), pool.blocks.end(),
+					[&block](const std::unique_ptr<Block>& b) { return b.get() == &block; });
+				DestroyBlock(block);
+				pool.blocks.erase(it);
+			}
+		}
+
+		allocation = Allocation{};
+	}
+
+	MemoryStats MemoryAllocator::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		MemoryStats stats{};
+		stats.deviceMemoryCount = _deviceMemoryCount;
+		stats.maxDeviceMemoryCount = _maxMemoryAllocationCount;
+		stats.heaps.resize(_memoryProperties.memoryHeapCount);
+
+		for (uint32_t i = 0; i < _memoryProperties.memoryHeapCount; ++i)
+		{
+			stats.heaps[i].heapSize = _memoryProperties.memoryHeaps[i].size;
+			stats.heaps[i].flags = _memoryProperties.memoryHeaps[i].flags;
+		}
+
+		for (const Pool& pool : _pools)
+		{
+			HeapStats& heap = stats.heaps[_memoryProperties.memoryTypes[pool.memoryTypeIndex].heapIndex];
+			for (const std::unique_ptr<Block>& block : pool.blocks)
+			{
+				heap.blockCount++;
+				heap.allocationCount += block->allocationCount;
+				heap.reservedBytes += block->size;
+				heap.usedBytes += block->usedBytes;
+
+				uint64_t mask = block->freeListMask;
+				while (mask != 0)
+				{
+					uint32_t sizeClass = LowestBit(mask);
+					for (uint32_t r = block->freeListHeads[sizeClass]; r != INVALID_INDEX; r = block->ranges[r].nextFree)
+					{
+						heap.freeBytes += block->ranges[r].size;
+						heap.largestFreeRange = std::max(heap.largestFreeRange, block->ranges[r].size);
+						heap.freeRangeCount++;
+					}
+					mask &= mask - 1;
+				}
+			}
+		}
+
+		for (uint32_t i = 0; i < _memoryProperties.memoryTypeCount; ++i)
+		{
+			HeapStats& heap = stats.heaps[_memoryProperties.memoryTypes[i].heapIndex];
+			heap.dedicatedAllocationCount += _dedicatedCount[i];
+			heap.allocationCount += _dedicatedCount[i];
+			heap.reservedBytes += _dedicatedBytes[i];
+			heap.usedBytes += _dedicatedBytes[i];
+		}
+
+		for (HeapStats& heap : stats.heaps)
+		{
+			if (heap.freeBytes > 0)
+			{
+				heap.fragmentation = 1.0f - static_cast<float>(heap.largestFreeRange) / static_cast<float>(heap.freeBytes);
+			}
+		}
+
+		return stats;
+	}
+
+	uint32_t MemoryAllocator::GetPoolIndex(uint32_t memoryTypeIndex, ResourceKind kind) const
+	{
+		// Without granularity constraints buffers and images can share the same blocks
+		if (_bufferImageGranularity <= 1)
+		{
+			kind = ResourceKind::Linear;
+		}
+
+		return memoryTypeIndex * 2 + static_cast<uint32_t>(kind);
+	}
+
+	VkDeviceSize MemoryAllocator::ComputeBlockSize(uint32_t memoryTypeIndex) const
+	{
+		const uint32_t heapIndex = _memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+		const VkDeviceSize heapSize = _memoryProperties.memoryHeaps[heapIndex].size;
+
+		if (heapSize <= SMALL_HEAP_MAX_SIZE)
+		{
+			return AlignUp(heapSize / 8, 1024);
+		}
+
+		return LARGE_HEAP_BLOCK_SIZE;
+	}
+
+	MemoryAllocator::Block* MemoryAllocator::CreateBlock(Pool& pool)
+	{
+		std::unique_ptr<Block> block = std::make_unique<Block>();
+		block->size = pool.blockSize;
+		block->memory = AllocateDeviceMemory(pool.blockSize, pool.memoryTypeIndex, &block->mappedData);
+		if (block->memory == VK_NULL_HANDLE)
+		{
+			throw std::runtime_error("Failed to allocate device memory block!");
+		}
+
+		std::fill(std::begin(block->freeListHeads), std::end(block->freeListHeads), INVALID_INDEX);
+
+		// The whole block starts as one free range
+		uint32_t rangeIndex = NewRange(*block);
+		block->ranges[rangeIndex].offset = 0;
+		block->ranges[rangeIndex].size = pool.blockSize;
+		InsertFree(*block, rangeIndex);
+
+		pool.blocks.push_back(std::move(block));
+		return pool.blocks.back().get();
+	}
+
+	void MemoryAllocator::DestroyBlock(Block& block)
+	{
+		FreeDeviceMemory(block.memory);
+		block.memory = VK_NULL_HANDLE;
+		block.mappedData = nullptr;
+	}
+
+	bool MemoryAllocator::AllocateFromBlock(Block& block, VkDeviceSize size, VkDeviceSize alignment, uint32_t& outRangeIndex)
+	{
+		// Only look at size classes that may hold a range big enough
+		uint64_t mask = block.freeListMask & (~0ull << SizeClass(size));
+
+		uint32_t found = INVALID_INDEX;
+		VkDeviceSize padding = 0;
+		while (mask != 0 && found == INVALID_INDEX)
+		{
+			uint32_t sizeClass = LowestBit(mask);
+			for (uint32_t r = block.freeListHeads[sizeClass]; r != INVALID_INDEX; r = block.ranges[r].nextFree)
+			{
+				const Range& range = block.ranges[r];
+				VkDeviceSize alignedOffset = AlignUp(range.offset, alignment);
+				if (alignedOffset + size <= range.offset + range.size)
+				{
+					found = r;
+					padding = alignedOffset - range.offset;
+					break;
+				}
+			}
+			mask &= mask - 1;
+		}
+
+		if (found == INVALID_INDEX)
+		{
+			return false;
+		}
+
+		RemoveFree(block, found);
+		block.ranges[found].isFree = false;
+
+		// Give the alignment padding its own free range
+		if (padding > 0)
+		{
+			uint32_t front = NewRange(block);
+			Range& frontRange = block.ranges[front];
+			Range& used = block.ranges[found];
+
+			frontRange.offset = used.offset;
+			frontRange.size = padding;
+			frontRange.prev = used.prev;
+			frontRange.next = found;
+			if (used.prev != INVALID_INDEX)
+			{
+				block.ranges[used.prev].next = front;
+			}
+
+			used.prev = front;
+			used.offset += padding;
+			used.size -= padding;
+			InsertFree(block, front);
+		}
+
+		// And the remainder after the allocation
+		if (block.ranges[found].size > size)
+		{
+			uint32_t tail = NewRange(block);
+			Range& tailRange = block.ranges[tail];
+			Range& used = block.ranges[found];
+
+			tailRange.offset = used.offset + size;
+			tailRange.size = used.size - size;
+			tailRange.prev = found;
+			tailRange.next = used.next;
+			if (used.next != INVALID_INDEX)
+			{
+				block.ranges[used.next].prev = tail;
+			}
+
+			used.next = tail;
+			used.size = size;
+			InsertFree(block, tail);
+		}
+
+		outRangeIndex = found;
+		return true;
+	}
+
+	void MemoryAllocator::FreeRange(Block& block, uint32_t rangeIndex)
+	{
+		block.ranges[rangeIndex].isFree = true;
+
+		// Merge with the next range
+		uint32_t next = block.ranges[rangeIndex].next;
+		if (next != INVALID_INDEX && block.ranges[next].isFree)
+		{
+			RemoveFree(block, next);
+			block.ranges[rangeIndex].size += block.ranges[next].size;
+			block.ranges[rangeIndex].next = block.ranges[next].next;
+			if (block.ranges[next].next != INVALID_INDEX)
+			{
+				block.ranges[block.ranges[next].next].prev = rangeIndex;
+			}
+			ReleaseRange(block, next);
+		}
+
+		// Merge with the previous range
+		uint32_t prev = block.ranges[rangeIndex].prev;
+		if (prev != INVALID_INDEX && block.ranges[prev].isFree)
+		{
+			RemoveFree(block, prev);
+			block.ranges[prev].size += block.ranges[rangeIndex].size;
+			block.ranges[prev].next = block.ranges[rangeIndex].next;
+			if (block.ranges[rangeIndex].next != INVALID_INDEX)
+			{
+				block.ranges[block.ranges[rangeIndex].next].prev = prev;
+			}
+			ReleaseRange(block, rangeIndex);
+			rangeIndex = prev;
+		}
+
+		InsertFree(block, rangeIndex);
+	}
+
+	uint32_t MemoryAllocator::NewRange(Block& block)
+	{
+		if (!block.unusedRangeSlots.empty())
+		{
+			uint32_t index = block.unusedRangeSlots.back();
+			block.unusedRangeSlots.pop_back();
+			block.ranges[index] = Range{};
+			return index;
+		}
+
+		block.ranges.emplace_back();
+		return static_cast<uint32_t>(block.ranges.size() - 1);
+	}
+
+	void MemoryAllocator::ReleaseRange(Block& block, uint32_t rangeIndex)
+	{
+		block.ranges[rangeIndex] = Range{};
+		block.unusedRangeSlots.push_back(rangeIndex);
+	}
+
+	void MemoryAllocator::InsertFree(Block& block, uint32_t rangeIndex)
+	{
+		Range& range = block.ranges[rangeIndex];
+		const uint32_t sizeClass = SizeClass(range.size);
+
+		range.isFree = true;
+		range.prevFree = INVALID_INDEX;
+		range.nextFree = block.freeListHeads[sizeClass];
+		if (range.nextFree != INVALID_INDEX)
+		{
+			block.ranges[range.nextFree].prevFree = rangeIndex;
+		}
+
+		block.freeListHeads[sizeClass] = rangeIndex;
+		block.freeListMask |= 1ull << sizeClass;
+	}
+
+	void MemoryAllocator::RemoveFree(Block& block, uint32_t rangeIndex)
+	{
+		Range& range = block.ranges[rangeIndex];
+		const uint32_t sizeClass = SizeClass(range.size);
+
+		if (range.prevFree != INVALID_INDEX)
+		{
+			block.ranges[range.prevFree].nextFree = range.nextFree;
+		}
+		else
+		{
+			block.freeListHeads[sizeClass] = range.nextFree;
+		}
+
+		if (range.nextFree != INVALID_INDEX)
+		{
+			block.ranges[range.nextFree].prevFree = range.prevFree;
+		}
+
+		if (block.freeListHeads[sizeClass] == INVALID_INDEX)
+		{
+			block.freeListMask &= ~(1ull << sizeClass);
+		}
+
+		range.prevFree = INVALID_INDEX;
+		range.nextFree = INVALID_INDEX;
+	}
+
+	VkDeviceMemory MemoryAllocator::AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void** mappedData)
+	{
+		if (_deviceMemoryCount >= _maxMemoryAllocationCount)
+		{
+			throw std::runtime_error("Reached maxMemoryAllocationCount!");
+		}
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		if (vkAllocateMemory(_device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+		{
+			return VK_NULL_HANDLE;
+		}
+
+		// Host visible memory is mapped once for its whole lifetime, as a VkDeviceMemory cannot be mapped twice
+		*mappedData = nullptr;
+		if (_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		{
+			if (vkMapMemory(_device, memory, 0, VK_WHOLE_SIZE, 0, mappedData) != VK_SUCCESS)
+			{
+				vkFreeMemory(_device, memory, nullptr);
+				throw std::runtime_error("Failed to map device memory!");
+			}
+		}
+
+		_deviceMemoryCount++;
+		return memory;
+	}
+
+	void MemoryAllocator::FreeDeviceMemory(VkDeviceMemory memory)
+	{
+		// vkFreeMemory implicitly unmaps the memory
+		vkFreeMemory(_device, memory, nullptr);
+		_deviceMemoryCount--;
+	}
+
+	uint32_t MemoryAllocator::SizeClass(VkDeviceSize size)
+	{
+		assert(size > 0 && "Cannot compute the size class of an empty range");
+		return HighestBit(size);
+	}
+} // namespace DaisyEngine
@@ -0,0 +1,168 @@
+#pragma once
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The Allocation struct describes a range of device memory handed out by the MemoryAllocator.
+	/// Resources must be bound at (memory, offset). mappedData is only set for host visible memory and already points at offset.
+	/// </summary>
+	struct Allocation
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		void* mappedData = nullptr;
+
+		// Bookkeeping used by the allocator to free the range in O(1)
+		uint32_t memoryTypeIndex = UINT32_MAX;
+		uint32_t poolIndex = UINT32_MAX;
+		uint32_t rangeIndex = UINT32_MAX;
+		void* block = nullptr; // Owning block, null for dedicated allocations
+
+		inline bool IsValid() const { return memory != VK_NULL_HANDLE; }
+		inline bool IsDedicated() const { return block == nullptr; }
+	};
+
+	/// <summary>
+	/// The HeapStats struct reports the usage of one memory heap. fragmentation is 0 when all the free space
+	/// is one contiguous range and tends to 1 when the free space is split in many small ranges.
+	/// </summary>
+	struct HeapStats
+	{
+		VkDeviceSize heapSize = 0;
+		VkMemoryHeapFlags flags = 0;
+		uint32_t blockCount = 0;
+		uint32_t allocationCount = 0;
+		uint32_t dedicatedAllocationCount = 0;
+		VkDeviceSize reservedBytes = 0;
+		VkDeviceSize usedBytes = 0;
+		VkDeviceSize freeBytes = 0;
+		VkDeviceSize largestFreeRange = 0;
+		uint32_t freeRangeCount = 0;
+		float fragmentation = 0.0f;
+	};
+
+	/// <summary>
+	/// The MemoryStats struct aggregates the HeapStats of every memory heap of the physical device.
+	/// </summary>
+	struct MemoryStats
+	{
+		std::vector<HeapStats> heaps;
+		uint32_t deviceMemoryCount = 0;
+		uint32_t maxDeviceMemoryCount = 0;
+	};
+
+	/// <summary>
+	/// The MemoryAllocator class sub-allocates resources from large VkDeviceMemory blocks instead of calling vkAllocateMemory per resource.
+	/// Blocks are grouped by memory type, and linear (buffers) and optimal (images) resources live in different blocks so that
+	/// bufferImageGranularity never has to be checked between neighbours. Free ranges are kept in segregated lists by power of two,
+	/// and freeing merges with the physical neighbours in constant time.
+	/// </summary>
+	class MemoryAllocator
+	{
+	public:
+		enum class ResourceKind : uint32_t
+		{
+			Linear = 0, // Buffers and linear images
+			Optimal = 1, // Optimal tiling images
+		};
+
+		// --- Constants ---
+		static constexpr VkDeviceSize LARGE_HEAP_BLOCK_SIZE = 64ull * 1024 * 1024;
+		static constexpr VkDeviceSize SMALL_HEAP_MAX_SIZE = 1024ull * 1024 * 1024;
+
+		// --- Constructor/ Destructor ---
+		MemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device);
+		~MemoryAllocator();
+
+		MemoryAllocator(const MemoryAllocator&) = delete;
+		MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+		// --- Methods ---
+		Allocation Allocate(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, ResourceKind kind);
+		void Free(Allocation& allocation);
+
+		MemoryStats GetStats();
+
+	private:
+		static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+		static constexpr uint32_t SIZE_CLASS_COUNT = 64;
+
+		/// <summary>
+		/// A contiguous range of a block, either used or free. Ranges form a doubly linked list in address order,
+		/// and free ranges are additionally linked in the free list of their size class.
+		/// </summary>
+		struct Range
+		{
+			VkDeviceSize offset = 0;
+			VkDeviceSize size = 0;
+			uint32_t prev = INVALID_INDEX;
+			uint32_t next = INVALID_INDEX;
+			uint32_t prevFree = INVALID_INDEX;
+			uint32_t nextFree = INVALID_INDEX;
+			bool isFree = false;
+		};
+
+		struct Block
+		{
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			VkDeviceSize size = 0;
+			void* mappedData = nullptr;
+
+			std::vector<Range> ranges;
+			std::vector<uint32_t> unusedRangeSlots;
+			uint32_t freeListHeads[SIZE_CLASS_COUNT];
+			uint64_t freeListMask = 0;
+			uint32_t allocationCount = 0;
+			VkDeviceSize usedBytes = 0;
+		};
+
+		struct Pool
+		{
+			uint32_t memoryTypeIndex = 0;
+			ResourceKind kind = ResourceKind::Linear;
+			VkDeviceSize blockSize = 0;
+			std::vector<std::unique_ptr<Block>> blocks;
+		};
+
+		// --- Methods ---
+		uint32_t GetPoolIndex(uint32_t memoryTypeIndex, ResourceKind kind) const;
+		VkDeviceSize ComputeBlockSize(uint32_t memoryTypeIndex) const;
+
+		Block* CreateBlock(Pool& pool);
+		void DestroyBlock(Block& block);
+		bool AllocateFromBlock(Block& block, VkDeviceSize size, VkDeviceSize alignment, uint32_t& outRangeIndex);
+		void FreeRange(Block& block, uint32_t rangeIndex);
+
+		uint32_t NewRange(Block& block);
+		void ReleaseRange(Block& block, uint32_t rangeIndex);
+		void InsertFree(Block& block, uint32_t rangeIndex);
+		void RemoveFree(Block& block, uint32_t rangeIndex);
+
+		VkDeviceMemory AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void** mappedData);
+		void FreeDeviceMemory(VkDeviceMemory memory);
+
+		static uint32_t SizeClass(VkDeviceSize size);
+
+		// --- Variables ---
+		VkDevice _device;
+		VkPhysicalDeviceMemoryProperties _memoryProperties;
+		VkDeviceSize _bufferImageGranularity;
+		uint32_t _maxMemoryAllocationCount;
+		uint32_t _deviceMemoryCount = 0;
+
+		std::vector<Pool> _pools;
+		std::vector<VkDeviceSize> _dedicatedBytes; // per memory type
+		std::vector<uint32_t> _dedicatedCount; // per memory type
+		std::mutex _mutex;
+	};
+} // namespace DaisyEngine
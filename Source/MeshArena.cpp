@@ -0,0 +1,191 @@
+#include "MeshArena.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <stdexcept>
+
+namespace DaisyEngine
+{
+	MeshArena::MeshArena(Device& device, VkDeviceSize vertexCapacity, VkDeviceSize indexCapacity)
+		: _device(device), _vertexCapacity(vertexCapacity), _indexCapacity(indexCapacity)
+	{
+		assert(vertexCapacity > 0 && indexCapacity > 0 && "A mesh arena needs room for vertices and indices");
+
+		_device.CreateBuffer(
+			vertexCapacity,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			_vertexBuffer,
+			_vertexBufferAllocation);
+
+		_device.CreateBuffer(
+			indexCapacity,
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			_indexBuffer,
+			_indexBufferAllocation);
+
+		_freeVertices.ranges.emplace(0, vertexCapacity);
+		_freeIndices.ranges.emplace(0, indexCapacity);
+	}
+
+	MeshArena::~MeshArena()
+	{
+		assert(_meshCount == 0 && "The mesh arena is destroyed before the models in it");
+
+		_device.DestroyBuffer(_vertexBuffer, _vertexBufferAllocation);
+		_device.DestroyBuffer(_indexBuffer, _indexBufferAllocation);
+	}
+
+	MeshArena::Range MeshArena::AllocateVertices(uint32_t vertexCount, uint32_t vertexStride)
+	{
+		assert(vertexStride > 0 && "Vertex stride must not be 0");
+
+		Range range{ 0, static_cast<VkDeviceSize>(vertexCount) * vertexStride };
+		if (range.size == 0)
+		{
+			return range;
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (!_freeVertices.Allocate(range.size, vertexStride, range.offset))
+		{
+			throw std::runtime_error("Failed to allocate vertices, the mesh arena is full!");
+		}
+
+		_meshCount++;
+		return range;
+	}
+
+	MeshArena::Range MeshArena::AllocateIndices(uint32_t indexCount)
+	{
+		Range range{ 0, static_cast<VkDeviceSize>(indexCount) * sizeof(uint32_t) };
+		if (range.size == 0)
+		{
+			return range;
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (!_freeIndices.Allocate(range.size, sizeof(uint32_t), range.offset))
+		{
+			throw std::runtime_error("Failed to allocate indices, the mesh arena is full!");
+		}
+
+		return range;
+	}
+
+	void MeshArena::FreeVertices(const Range& range)
+	{
+		if (range.size == 0)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		_freeVertices.Free(range.offset, range.size);
+		_meshCount--;
+	}
+
+	void MeshArena::FreeIndices(const Range& range)
+	{
+		if (range.size == 0)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		_freeIndices.Free(range.offset, range.size);
+	}
+
+	void MeshArena::Bind(VkCommandBuffer commandBuffer)
+	{
+		VkBuffer buffers[] = { _vertexBuffer };
+		VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+		vkCmdBindIndexBuffer(commandBuffer, _indexBuffer, 0, INDEX_TYPE);
+	}
+
+	MeshArenaStats MeshArena::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		MeshArenaStats stats{};
+		stats.meshCount = _meshCount;
+		stats.vertexCapacity = _vertexCapacity;
+		stats.vertexBytes = _freeVertices.usedBytes;
+		stats.indexCapacity = _indexCapacity;
+		stats.indexBytes = _freeIndices.usedBytes;
+		stats.largestFreeVertexRange = _freeVertices.GetLargestRange();
+		return stats;
+	}
+
+	bool MeshArena::FreeList::Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset)
+	{
+		// The strides are not powers of two, the padding before the aligned offset stays free
+		for (auto it = ranges.begin(); it != ranges.end(); ++it)
+		{
+			const VkDeviceSize rangeOffset = it->first;
+			const VkDeviceSize rangeEnd = it->first + it->second;
+			const VkDeviceSize offset = (rangeOffset + alignment - 1) / alignment * alignment;
+			if (offset + size > rangeEnd)
+			{
+				continue;
+			}
+
+			ranges.erase(it);
+			if (offset > rangeOffset)
+			{
+				ranges.emplace(rangeOffset, offset - rangeOffset);
+			}
+			if (offset + size < rangeEnd)
+			{
+				ranges.emplace(offset + size, rangeEnd - offset - size);
+			}
+
+			usedBytes += size;
+			outOffset = offset;
+			return true;
+		}
+
+		return false;
+	}
+
+	void MeshArena::FreeList::Free(VkDeviceSize offset, VkDeviceSize size)
+	{
+		auto next = ranges.lower_bound(offset);
+		assert((next == ranges.end() || next->first >= offset + size) && "Freed a range that overlaps a free one");
+		usedBytes -= size;
+
+		// Merged with the free ranges that end where it starts and start where it ends
+		if (next != ranges.begin())
+		{
+			auto previous = std::prev(next);
+			if (previous->first + previous->second == offset)
+			{
+				offset = previous->first;
+				size += previous->second;
+				ranges.erase(previous);
+			}
+		}
+
+		if (next != ranges.end() && next->first == offset + size)
+		{
+			size += next->second;
+			ranges.erase(next);
+		}
+
+		ranges.emplace(offset, size);
+	}
+
+	VkDeviceSize MeshArena::FreeList::GetLargestRange() const
+	{
+		VkDeviceSize largest = 0;
+		for (const auto& range : ranges)
+		{
+			largest = std::max(largest, range.second);
+		}
+		return largest;
+	}
+} // namespace DaisyEngine
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Device.hpp"
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The MeshArenaStats struct reports how full the buffers of a MeshArena are.
+	/// </summary>
+	struct MeshArenaStats
+	{
+		uint32_t meshCount = 0;
+		VkDeviceSize vertexCapacity = 0;
+		VkDeviceSize vertexBytes = 0;
+		VkDeviceSize indexCapacity = 0;
+		VkDeviceSize indexBytes = 0;
+		VkDeviceSize largestFreeVertexRange = 0; // The largest mesh that still fits, fragmentation makes it smaller than the free bytes
+	};
+
+	/// <summary>
+	/// The MeshArena class holds the geometry of many models in one device local vertex buffer and one index buffer, so meshes
+	/// drawn one after the other share a single binding. A mesh is a range of each buffer, drawn with its first index and its
+	/// vertex offset. The indices are always 32 bit, and a vertex range starts on a multiple of its stride, so vertices of
+	/// different formats can share the buffer and the vertex offset of a mesh is its first vertex in its own format.
+	/// The vertex buffer is also a storage buffer, shaders can fetch the vertices themselves from gl_VertexIndex.
+	/// Ranges are found first fit and merged back with their free neighbours; the arena must outlive the models in it.
+	/// </summary>
+	class MeshArena
+	{
+	public:
+		// --- Constants ---
+		static constexpr VkDeviceSize DEFAULT_VERTEX_CAPACITY = 64ull * 1024 * 1024;
+		static constexpr VkDeviceSize DEFAULT_INDEX_CAPACITY = 32ull * 1024 * 1024;
+		static constexpr VkIndexType INDEX_TYPE = VK_INDEX_TYPE_UINT32;
+
+		/// <summary>
+		/// A range of one of the buffers, in bytes. Empty ranges are never freed.
+		/// </summary>
+		struct Range
+		{
+			VkDeviceSize offset = 0;
+			VkDeviceSize size = 0;
+		};
+
+		// --- Constructor/ Destructor ---
+		MeshArena(Device& device, VkDeviceSize vertexCapacity = DEFAULT_VERTEX_CAPACITY, VkDeviceSize indexCapacity = DEFAULT_INDEX_CAPACITY);
+		~MeshArena();
+
+		MeshArena(const MeshArena&) = delete;
+		MeshArena& operator=(const MeshArena&) = delete;
+
+		// --- Methods ---
+		// Throw when the arena has no free range large enough, safe to call from several threads
+		Range AllocateVertices(uint32_t vertexCount, uint32_t vertexStride);
+		Range AllocateIndices(uint32_t indexCount);
+		// The GPU must be done with the range, like with a buffer that is destroyed
+		void FreeVertices(const Range& range);
+		void FreeIndices(const Range& range);
+
+		// Binds both buffers at offset 0, every mesh of the arena can then be drawn
+		void Bind(VkCommandBuffer commandBuffer);
+
+		MeshArenaStats GetStats();
+		inline VkBuffer GetVertexBuffer() const { return _vertexBuffer; }
+		inline VkBuffer GetIndexBuffer() const { return _indexBuffer; }
+
+	private:
+		/// <summary>
+		/// The free ranges of one buffer, by offset.
+		/// </summary>
+		struct FreeList
+		{
+			std::map<VkDeviceSize, VkDeviceSize> ranges;
+			VkDeviceSize usedBytes = 0;
+
+			bool Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset);
+			void Free(VkDeviceSize offset, VkDeviceSize size);
+			VkDeviceSize GetLargestRange() const;
+		};
+
+		// --- Variables ---
+		Device& _device;
+		VkDeviceSize _vertexCapacity;
+		VkDeviceSize _indexCapacity;
+
+		VkBuffer _vertexBuffer = VK_NULL_HANDLE;
+		Allocation _vertexBufferAllocation{};
+		VkBuffer _indexBuffer = VK_NULL_HANDLE;
+		Allocation _indexBufferAllocation{};
+
+		FreeList _freeVertices;
+		FreeList _freeIndices;
+		uint32_t _meshCount = 0; // Vertex ranges handed out
+		std::mutex _mutex;
+	};
+} // namespace DaisyEngine
@@ -0,0 +1,261 @@
+#include "MeshFile.hpp"
+
+// std
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace DaisyEngine
+{
+	static uint64_t AlignSection(uint64_t offset)
+	{
+		return (offset + MeshFile::SECTION_ALIGNMENT - 1) & ~(MeshFile::SECTION_ALIGNMENT - 1);
+	}
+
+	MeshFile::MeshFile(const std::string& filepath)
+		: _file(filepath)
+	{
+		if (_file.Size() < sizeof(MeshFileHeader))
+		{
+			throw std::runtime_error("Invalid mesh file, too small for a header: " + filepath);
+		}
+
+		// The mapping is page aligned and every section offset is a multiple of SECTION_ALIGNMENT, the data is read in place
+		_header = reinterpret_cast<const MeshFileHeader*>(_file.Data());
+		if (_header->magic != MAGIC)
+		{
+			throw std::runtime_error("Invalid mesh file, bad magic: " + filepath);
+		}
+		if (_header->version < MIN_VERSION || _header->version > VERSION)
+		{
+			throw std::runtime_error("Unsupported mesh file version " + std::to_string(_header->version) + ": " + filepath);
+		}
+		if (_header->indexCount > 0 && _header->indexSize != sizeof(uint16_t) && _header->indexSize != sizeof(uint32_t))
+		{
+			throw std::runtime_error("Invalid mesh file, bad index size: " + filepath);
+		}
+
+		uint64_t tableSize = static_cast<uint64_t>(_header->sectionCount) * sizeof(MeshFileSection);
+		if (tableSize > _file.Size() - sizeof(MeshFileHeader))
+		{
+			throw std::runtime_error("Invalid mesh file, truncated section table: " + filepath);
+		}
+		_sections = reinterpret_cast<const MeshFileSection*>(_file.Data() + sizeof(MeshFileHeader));
+
+		for (uint32_t i = 0; i < _header->sectionCount; ++i)
+		{
+			const MeshFileSection& section = _sections[i];
+			if (section.offset % SECTION_ALIGNMENT != 0 || section.offset > _file.Size() || section.size > _file.Size() - section.offset)
+			{
+				throw std::runtime_error("Invalid mesh file, section " + std::to_string(i) + " is out of bounds or misaligned: " + filepath);
+			}
+		}
+
+		// The stride is checked against the format, a mesh file is never uploaded with a layout no pipeline reads
+		if (_header->vertexFormat == VERTEX_FORMAT_POSITION_COLOR && _header->vertexStride == sizeof(Model::Vertex))
+		{
+			_vertexFormat = VertexFormat::PositionColor;
+		}
+		else if (_header->vertexFormat == VERTEX_FORMAT_QUANTIZED && _header->vertexStride == sizeof(QuantizedVertex) && _header->version >= 3)
+		{
+			_vertexFormat = VertexFormat::Quantized;
+			const MeshFileQuantization* quantization = static_cast<const MeshFileQuantization*>(
+				GetSectionData(SECTION_QUANTIZATION, sizeof(MeshFileQuantization), true));
+			_positionQuantization.scale = { quantization->scale[0], quantization->scale[1], quantization->scale[2] };
+			_positionQuantization.bias = { quantization->bias[0], quantization->bias[1], quantization->bias[2] };
+		}
+		else
+		{
+			throw std::runtime_error("Invalid mesh file, unsupported vertex format " + std::to_string(_header->vertexFormat)
+				+ " with a stride of " + std::to_string(_header->vertexStride) + ": " + filepath);
+		}
+
+		_vertices = GetSectionData(SECTION_VERTICES, static_cast<uint64_t>(_header->vertexCount) * _header->vertexStride, true);
+		_indices = GetSectionData(SECTION_INDICES, static_cast<uint64_t>(_header->indexCount) * _header->indexSize, _header->indexCount > 0);
+		_bounds = static_cast<const MeshFileBounds*>(GetSectionData(SECTION_BOUNDS, sizeof(MeshFileBounds), true));
+		_submeshes = static_cast<const Model::Submesh*>(GetSectionData(SECTION_SUBMESHES,
+			static_cast<uint64_t>(_header->submeshCount) * sizeof(Model::Submesh), _header->submeshCount > 0));
+
+		// The count was reserved and written as 0 by version 1
+		if (_header->lodCount >= Model::MAX_LOD_COUNT || (_header->lodCount > 0 && _header->indexCount == 0))
+		{
+			throw std::runtime_error("Invalid mesh file, bad LOD count: " + filepath);
+		}
+		_lods = static_cast<const Model::Lod*>(GetSectionData(SECTION_LODS,
+			static_cast<uint64_t>(_header->lodCount) * sizeof(Model::Lod), _header->lodCount > 0));
+
+		// A handful of ranges, checked so a bad file cannot make a draw read past the index buffer
+		uint64_t drawnCount = _header->indexCount > 0 ? _header->indexCount : _header->vertexCount;
+		for (uint32_t i = 0; i < _header->submeshCount; ++i)
+		{
+			if (static_cast<uint64_t>(_submeshes[i].firstIndex) + _submeshes[i].indexCount > drawnCount)
+			{
+				throw std::runtime_error("Invalid mesh file, submesh " + std::to_string(i) + " is out of range: " + filepath);
+			}
+		}
+
+		for (uint32_t i = 0; i < _header->lodCount; ++i)
+		{
+			if (static_cast<uint64_t>(_lods[i].firstIndex) + _lods[i].indexCount > _header->indexCount)
+			{
+				throw std::runtime_error("Invalid mesh file, LOD " + std::to_string(i + 1) + " is out of range: " + filepath);
+			}
+		}
+	}
+
+	const MeshFileSection* MeshFile::FindSection(uint32_t type) const
+	{
+		for (uint32_t i = 0; i < _header->sectionCount; ++i)
+		{
+			if (_sections[i].type == type)
+			{
+				return &_sections[i];
+			}
+		}
+
+		return nullptr;
+	}
+
+	const void* MeshFile::GetSectionData(uint32_t type, uint64_t expectedSize, bool isRequired) const
+	{
+		const MeshFileSection* section = FindSection(type);
+		if (section == nullptr)
+		{
+			if (isRequired)
+			{
+				throw std::runtime_error("Invalid mesh file, missing section " + std::to_string(type) + ": " + _file.GetPath());
+			}
+			return nullptr;
+		}
+
+		if (section->size != expectedSize)
+		{
+			throw std::runtime_error("Invalid mesh file, section " + std::to_string(type) + " does not match the header: " + _file.GetPath());
+		}
+
+		return _file.Data() + section->offset;
+	}
+
+	void MeshFile::Write(const std::string& filepath, const Model::Builder& builder, VertexFormat vertexFormat)
+	{
+		const uint32_t vertexCount = static_cast<uint32_t>(builder.vertices.size());
+		const uint32_t indexCount = static_cast<uint32_t>(builder.indices.size());
+		if (vertexCount < 3)
+		{
+			throw std::runtime_error("Failed to write mesh file, it needs at least one triangle: " + filepath);
+		}
+
+		// Narrowed here rather than at load time, the loader copies the section as is
+		std::vector<uint16_t> shortIndices;
+		const void* indexData = builder.indices.data();
+		uint32_t indexSize = sizeof(uint32_t);
+		if (vertexCount <= Model::MAX_UINT16_VERTEX_COUNT)
+		{
+			shortIndices.assign(builder.indices.begin(), builder.indices.end());
+			indexData = shortIndices.data();
+			indexSize = sizeof(uint16_t);
+		}
+
+		BoundingBox boundingBox{};
+		BoundingSphere boundingSphere{};
+		Model::ComputeBounds(builder.vertices, boundingBox, boundingSphere);
+
+		MeshFileBounds bounds{};
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			bounds.boxMin[axis] = boundingBox.min[axis];
+			bounds.boxMax[axis] = boundingBox.max[axis];
+			bounds.sphereCenter[axis] = boundingSphere.center[axis];
+		}
+		bounds.sphereRadius = boundingSphere.radius;
+
+		// Quantized in the box of the float positions, the bounds above stay exact
+		std::vector<QuantizedVertex> quantizedVertices;
+		MeshFileQuantization quantization{};
+		const void* vertexData = builder.vertices.data();
+		uint32_t vertexStride = sizeof(Model::Vertex);
+		if (vertexFormat == VertexFormat::Quantized)
+		{
+			PositionQuantization positionQuantization = Model::QuantizeVertices(builder, quantizedVertices);
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				quantization.scale[axis] = positionQuantization.scale[axis];
+				quantization.bias[axis] = positionQuantization.bias[axis];
+			}
+			vertexData = quantizedVertices.data();
+			vertexStride = sizeof(QuantizedVertex);
+		}
+
+		struct SectionSource
+		{
+			uint32_t type;
+			const void* data;
+			uint64_t size;
+		};
+
+		std::vector<SectionSource> sources = {
+			{ SECTION_VERTICES, vertexData, static_cast<uint64_t>(vertexCount) * vertexStride },
+			{ SECTION_BOUNDS, &bounds, sizeof(MeshFileBounds) },
+		};
+		if (vertexFormat == VertexFormat::Quantized)
+		{
+			sources.push_back({ SECTION_QUANTIZATION, &quantization, sizeof(MeshFileQuantization) });
+		}
+		if (indexCount > 0)
+		{
+			sources.push_back({ SECTION_INDICES, indexData, static_cast<uint64_t>(indexCount) * indexSize });
+		}
+		if (!builder.submeshes.empty())
+		{
+			sources.push_back({ SECTION_SUBMESHES, builder.submeshes.data(), builder.submeshes.size() * sizeof(Model::Submesh) });
+		}
+		if (!builder.lods.empty())
+		{
+			sources.push_back({ SECTION_LODS, builder.lods.data(), builder.lods.size() * sizeof(Model::Lod) });
+		}
+
+		MeshFileHeader header{};
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.sectionCount = static_cast<uint32_t>(sources.size());
+		header.vertexFormat = vertexFormat == VertexFormat::Quantized ? VERTEX_FORMAT_QUANTIZED : VERTEX_FORMAT_POSITION_COLOR;
+		header.vertexStride = vertexStride;
+		header.vertexCount = vertexCount;
+		header.indexSize = indexSize;
+		header.indexCount = indexCount;
+		header.submeshCount = static_cast<uint32_t>(builder.submeshes.size());
+		header.lodCount = static_cast<uint32_t>(builder.lods.size());
+
+		std::vector<MeshFileSection> sections(sources.size());
+		uint64_t offset = sizeof(MeshFileHeader) + sizeof(MeshFileSection) * sections.size();
+		for (size_t i = 0; i < sources.size(); ++i)
+		{
+			offset = AlignSection(offset);
+			sections[i] = { sources[i].type, 0, offset, sources[i].size };
+			offset += sources[i].size;
+		}
+
+		std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			throw std::runtime_error("Failed to open mesh file for writing: " + filepath);
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(sections.data()), sizeof(MeshFileSection) * sections.size());
+
+		const char padding[SECTION_ALIGNMENT] = {};
+		for (size_t i = 0; i < sources.size(); ++i)
+		{
+			uint64_t position = static_cast<uint64_t>(file.tellp());
+			file.write(padding, static_cast<std::streamsize>(sections[i].offset - position));
+			file.write(static_cast<const char*>(sources[i].data), static_cast<std::streamsize>(sources[i].size));
+		}
+
+		if (!file)
+		{
+			throw std::runtime_error("Failed to write mesh file: " + filepath);
+		}
+	}
+} // namespace DaisyEngine
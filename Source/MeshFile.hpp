@@ -0,0 +1,143 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include "Model.hpp"
+
+// std
+#include <cstdint>
+#include <string>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The MeshFileHeader struct starts every mesh file, it is followed by the section table. All integers are little endian.
+	/// </summary>
+	struct MeshFileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t sectionCount;
+		uint32_t vertexFormat;
+		uint32_t vertexStride;
+		uint32_t vertexCount;
+		uint32_t indexSize; // 2 or 4 bytes, picked at conversion with the same rule as Model
+		uint32_t indexCount;
+		uint32_t submeshCount;
+		uint32_t lodCount; // Since version 2, the levels after the mesh itself
+		uint32_t reserved[6];
+	};
+
+	/// <summary>
+	/// The MeshFileSection struct locates one section in the file. Sections of an unknown type are skipped by the loader.
+	/// </summary>
+	struct MeshFileSection
+	{
+		uint32_t type;
+		uint32_t reserved;
+		uint64_t offset; // From the start of the file, a multiple of SECTION_ALIGNMENT
+		uint64_t size;
+	};
+
+	/// <summary>
+	/// The MeshFileBounds struct is the content of the bounds section, computed at conversion so loading never reads the vertices.
+	/// </summary>
+	struct MeshFileBounds
+	{
+		float boxMin[3];
+		float boxMax[3];
+		float sphereCenter[3];
+		float sphereRadius;
+	};
+
+	/// <summary>
+	/// The MeshFileQuantization struct is the content of the quantization section, the PositionQuantization of quantized vertices.
+	/// </summary>
+	struct MeshFileQuantization
+	{
+		float scale[3];
+		float bias[3];
+	};
+
+	static_assert(sizeof(MeshFileHeader) == 64, "The mesh file header layout is part of the format");
+	static_assert(sizeof(MeshFileSection) == 24, "The mesh file section layout is part of the format");
+	static_assert(sizeof(MeshFileBounds) == 40, "The mesh file bounds layout is part of the format");
+	static_assert(sizeof(MeshFileQuantization) == 24, "The mesh file quantization layout is part of the format");
+	static_assert(sizeof(QuantizedVertex) == 12, "The quantized vertices are stored as they are in memory");
+	static_assert(sizeof(Model::Submesh) == 8, "The submeshes are stored as they are in memory");
+	static_assert(sizeof(Model::Lod) == 12, "The LODs are stored as they are in memory");
+
+	/// <summary>
+	/// The MeshFile class maps a binary mesh file and exposes its sections in place. The vertices and indices are stored in the
+	/// layout the GPU reads, so a Model is created by copying them straight from the mapping into the staging ring: there is
+	/// nothing to parse and no intermediate copy. Opening a file checks its header and section table, not the data itself.
+	/// </summary>
+	class MeshFile
+	{
+	public:
+		// --- Constants ---
+		static constexpr uint32_t MAGIC = 0x48534D44; // "DMSH"
+		static constexpr uint32_t VERSION = 3; // Adds quantized vertices, version 1 and 2 files are still read
+		static constexpr uint32_t MIN_VERSION = 1;
+		static constexpr uint64_t SECTION_ALIGNMENT = 16;
+
+		static constexpr uint32_t SECTION_VERTICES = 1;
+		static constexpr uint32_t SECTION_INDICES = 2;
+		static constexpr uint32_t SECTION_BOUNDS = 3;
+		static constexpr uint32_t SECTION_SUBMESHES = 4;
+		static constexpr uint32_t SECTION_LODS = 5;
+		static constexpr uint32_t SECTION_QUANTIZATION = 6; // Since version 3, with quantized vertices only
+
+		// Model::Vertex, float3 position then float3 color
+		static constexpr uint32_t VERTEX_FORMAT_POSITION_COLOR = 1;
+		// QuantizedVertex, snorm16x4 position in the box of the quantization section then unorm8x4 color
+		static constexpr uint32_t VERTEX_FORMAT_QUANTIZED = 2;
+
+		// --- Constructor ---
+		explicit MeshFile(const std::string& filepath);
+
+		// --- Methods ---
+		// Welds nothing and reorders nothing, the builder is written as is in the given vertex format
+		static void Write(const std::string& filepath, const Model::Builder& builder, VertexFormat vertexFormat = VertexFormat::PositionColor);
+
+		inline const MeshFileHeader& GetHeader() const { return *_header; }
+		inline size_t GetFileSize() const { return _file.Size(); }
+
+		inline const void* GetVertices() const { return _vertices; }
+		inline uint32_t GetVertexCount() const { return _header->vertexCount; }
+		inline VertexFormat GetVertexFormat() const { return _vertexFormat; }
+		// Identity unless the vertices are quantized
+		inline const PositionQuantization& GetPositionQuantization() const { return _positionQuantization; }
+
+		// Null without indices, the vertices are then a plain triangle list
+		inline const void* GetIndices() const { return _indices; }
+		inline uint32_t GetIndexCount() const { return _header->indexCount; }
+		inline uint32_t GetIndexSize() const { return _header->indexSize; }
+
+		inline const MeshFileBounds& GetBounds() const { return *_bounds; }
+		inline const Model::Submesh* GetSubmeshes() const { return _submeshes; }
+		inline uint32_t GetSubmeshCount() const { return _header->submeshCount; }
+
+		// The index section holds the mesh then every LOD, the indices before the first LOD are the mesh itself
+		inline const Model::Lod* GetLods() const { return _lods; }
+		inline uint32_t GetLodCount() const { return _header->lodCount; }
+
+	private:
+		// --- Methods ---
+		const MeshFileSection* FindSection(uint32_t type) const;
+		const void* GetSectionData(uint32_t type, uint64_t expectedSize, bool isRequired) const;
+
+		// --- Variables ---
+		MappedFile _file;
+		const MeshFileHeader* _header = nullptr;
+		const MeshFileSection* _sections = nullptr;
+
+		const void* _vertices = nullptr;
+		const void* _indices = nullptr;
+		const MeshFileBounds* _bounds = nullptr;
+		const Model::Submesh* _submeshes = nullptr;
+		const Model::Lod* _lods = nullptr;
+
+		VertexFormat _vertexFormat = VertexFormat::PositionColor;
+		PositionQuantization _positionQuantization;
+	};
+} // namespace DaisyEngine
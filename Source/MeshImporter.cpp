@@ -0,0 +1,842 @@
+#include "MeshImporter.hpp"
+#include "MappedFile.hpp"
+
+// std
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace DaisyEngine
+{
+	namespace
+	{
+		const glm::vec3 DEFAULT_VERTEX_COLOR{ 0.8f, 0.8f, 0.8f };
+
+		// --- Text parsing ---
+
+		bool IsSpace(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+
+		const char* SkipSpaces(const char* p, const char* end)
+		{
+			while (p < end && IsSpace(*p))
+			{
+				++p;
+			}
+			return p;
+		}
+
+		const char* SkipToken(const char* p, const char* end)
+		{
+			while (p < end && !IsSpace(*p) && *p != '\n')
+			{
+				++p;
+			}
+			return p;
+		}
+
+		bool StartsWithKeyword(const char* p, const char* end, const char* keyword)
+		{
+			size_t length = strlen(keyword);
+			return static_cast<size_t>(end - p) > length && memcmp(p, keyword, length) == 0 && IsSpace(p[length]);
+		}
+
+		// from_chars is bounded by end, the mapped file is not null terminated
+		const char* ParseFloat(const char* p, const char* end, float& value)
+		{
+			p = SkipSpaces(p, end);
+			if (p < end && *p == '+')
+			{
+				++p;
+			}
+
+			std::from_chars_result result = std::from_chars(p, end, value);
+			return result.ec == std::errc() ? result.ptr : nullptr;
+		}
+
+		// --- OBJ ---
+
+		void CloseSubmesh(Model::Builder& builder, uint32_t& firstIndex)
+		{
+			uint32_t indexCount = static_cast<uint32_t>(builder.indices.size()) - firstIndex;
+			if (indexCount > 0)
+			{
+				builder.submeshes.push_back({ firstIndex, indexCount });
+				firstIndex = static_cast<uint32_t>(builder.indices.size());
+			}
+		}
+
+		// --- JSON, only what glTF needs ---
+
+		struct JsonValue
+		{
+			enum class Type { Null, Bool, Number, String, Array, Object };
+
+			Type type = Type::Null;
+			bool boolean = false;
+			double number = 0.0;
+			std::string string;
+			std::vector<JsonValue> array;
+			std::vector<std::pair<std::string, JsonValue>> object;
+
+			const JsonValue* Find(const char* key) const
+			{
+				for (const auto& [name, value] : object)
+				{
+					if (name == key)
+					{
+						return &value;
+					}
+				}
+				return nullptr;
+			}
+
+			double GetNumber(const char* key, double defaultValue) const
+			{
+				const JsonValue* value = Find(key);
+				return value != nullptr && value->type == Type::Number ? value->number : defaultValue;
+			}
+
+			const std::vector<JsonValue>& GetArray(const char* key) const
+			{
+				static const std::vector<JsonValue> empty;
+				const JsonValue* value = Find(key);
+				return value != nullptr && value->type == Type::Array ? value->array : empty;
+			}
+		};
+
+		class JsonParser
+		{
+		public:
+			JsonParser(const char* begin, const char* end, const std::string& filepath)
+				: _p(begin), _end(end), _filepath(filepath)
+			{
+			}
+
+			JsonValue Parse()
+			{
+				JsonValue value = ParseValue(0);
+				SkipWhitespace();
+				if (_p != _end)
+				{
+					Fail("trailing characters");
+				}
+				return value;
+			}
+
+		private:
+			static constexpr int MAX_DEPTH = 64;
+
+			[[noreturn]] void Fail(const char* reason) const
+			{
+				throw std::runtime_error(std::string("Failed to parse glTF JSON, ") + reason + ": " + _filepath);
+			}
+
+			void SkipWhitespace()
+			{
+				while (_p < _end && (*_p == ' ' || *_p == '\t' || *_p == '\r' || *_p == '\n'))
+				{
+					++_p;
+				}
+			}
+
+			void Expect(char c)
+			{
+				SkipWhitespace();
+				if (_p == _end || *_p != c)
+				{
+					Fail("unexpected character");
+				}
+				++_p;
+			}
+
+			bool Consume(const char* literal)
+			{
+				size_t length = strlen(literal);
+				if (static_cast<size_t>(_end - _p) >= length && memcmp(_p, literal, length) == 0)
+				{
+					_p += length;
+					return true;
+				}
+				return false;
+			}
+
+			bool ConsumeSeparator()
+			{
+				SkipWhitespace();
+				if (_p < _end && *_p == ',')
+				{
+					++_p;
+					return true;
+				}
+				return false;
+			}
+
+			JsonValue ParseValue(int depth)
+			{
+				if (depth > MAX_DEPTH)
+				{
+					Fail("nested too deep");
+				}
+
+				SkipWhitespace();
+				if (_p == _end)
+				{
+					Fail("unexpected end");
+				}
+
+				JsonValue value;
+				if (*_p == '{')
+				{
+					++_p;
+					value.type = JsonValue::Type::Object;
+					SkipWhitespace();
+					if (_p < _end && *_p == '}')
+					{
+						++_p;
+						return value;
+					}
+					while (true)
+					{
+						SkipWhitespace();
+						std::string key = ParseString();
+						Expect(':');
+						value.object.emplace_back(std::move(key), ParseValue(depth + 1));
+						if (!ConsumeSeparator())
+						{
+							break;
+						}
+					}
+					Expect('}');
+				}
+				else if (*_p == '[')
+				{
+					++_p;
+					value.type = JsonValue::Type::Array;
+					SkipWhitespace();
+					if (_p < _end && *_p == ']')
+					{
+						++_p;
+						return value;
+					}
+					while (true)
+					{
+						value.array.push_back(ParseValue(depth + 1));
+						if (!ConsumeSeparator())
+						{
+							break;
+						}
+					}
+					Expect(']');
+				}
+				else if (*_p == '"')
+				{
+					value.type = JsonValue::Type::String;
+					value.string = ParseString();
+				}
+				else if (Consume("true"))
+				{
+					value.type = JsonValue::Type::Bool;
+					value.boolean = true;
+				}
+				else if (Consume("false"))
+				{
+					value.type = JsonValue::Type::Bool;
+				}
+				else if (Consume("null"))
+				{
+					value.type = JsonValue::Type::Null;
+				}
+				else
+				{
+					value.type = JsonValue::Type::Number;
+					std::from_chars_result result = std::from_chars(_p, _end, value.number);
+					if (result.ec != std::errc())
+					{
+						Fail("invalid value");
+					}
+					_p = result.ptr;
+				}
+
+				return value;
+			}
+
+			std::string ParseString()
+			{
+				if (_p == _end || *_p != '"')
+				{
+					Fail("expected a string");
+				}
+				++_p;
+
+				std::string string;
+				while (_p < _end && *_p != '"')
+				{
+					char c = *_p++;
+					if (c != '\\')
+					{
+						string.push_back(c);
+						continue;
+					}
+
+					if (_p == _end)
+					{
+						Fail("unterminated string");
+					}
+
+					char escaped = *_p++;
+					switch (escaped)
+					{
+					case 'b': string.push_back('\b'); break;
+					case 'f': string.push_back('\f'); break;
+					case 'n': string.push_back('\n'); break;
+					case 'r': string.push_back('\r'); break;
+					case 't': string.push_back('\t'); break;
+					case 'u':
+					{
+						// Encoded as UTF-8, surrogate pairs are not recombined (glTF keys and URIs are ASCII)
+						unsigned int codePoint = 0;
+						if (_end - _p < 4 || std::from_chars(_p, _p + 4, codePoint, 16).ptr != _p + 4)
+						{
+							Fail("invalid unicode escape");
+						}
+						_p += 4;
+
+						if (codePoint < 0x80)
+						{
+							string.push_back(static_cast<char>(codePoint));
+						}
+						else if (codePoint < 0x800)
+						{
+							string.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+							string.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+						}
+						else
+						{
+							string.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+							string.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+							string.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+						}
+						break;
+					}
+					default: string.push_back(escaped); break;
+					}
+				}
+
+				if (_p == _end)
+				{
+					Fail("unterminated string");
+				}
+				++_p;
+				return string;
+			}
+
+			const char* _p;
+			const char* _end;
+			const std::string& _filepath;
+		};
+
+		// --- glTF ---
+
+		constexpr uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+		constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+		constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+		constexpr uint32_t COMPONENT_BYTE = 5120;
+		constexpr uint32_t COMPONENT_UNSIGNED_BYTE = 5121;
+		constexpr uint32_t COMPONENT_SHORT = 5122;
+		constexpr uint32_t COMPONENT_UNSIGNED_SHORT = 5123;
+		constexpr uint32_t COMPONENT_UNSIGNED_INT = 5125;
+		constexpr uint32_t COMPONENT_FLOAT = 5126;
+		constexpr uint32_t MODE_TRIANGLES = 4;
+
+		uint32_t GetComponentSize(uint32_t componentType)
+		{
+			switch (componentType)
+			{
+			case COMPONENT_BYTE:
+			case COMPONENT_UNSIGNED_BYTE: return 1;
+			case COMPONENT_SHORT:
+			case COMPONENT_UNSIGNED_SHORT: return 2;
+			case COMPONENT_UNSIGNED_INT:
+			case COMPONENT_FLOAT: return 4;
+			default: return 0;
+			}
+		}
+
+		uint32_t GetComponentCount(const std::string& type)
+		{
+			if (type == "SCALAR") return 1;
+			if (type == "VEC2") return 2;
+			if (type == "VEC3") return 3;
+			if (type == "VEC4") return 4;
+			return 0;
+		}
+
+		int Base64Value(char c)
+		{
+			if (c >= 'A' && c <= 'Z') return c - 'A';
+			if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+			if (c >= '0' && c <= '9') return c - '0' + 52;
+			if (c == '+') return 62;
+			if (c == '/') return 63;
+			return -1;
+		}
+
+		std::vector<uint8_t> DecodeBase64(const char* p, const char* end)
+		{
+			std::vector<uint8_t> bytes;
+			bytes.reserve((end - p) / 4 * 3);
+
+			uint32_t bits = 0;
+			int bitCount = 0;
+			for (; p < end && *p != '='; ++p)
+			{
+				int value = Base64Value(*p);
+				if (value < 0)
+				{
+					throw std::runtime_error("Failed to decode a base64 glTF buffer");
+				}
+
+				bits = (bits << 6) | static_cast<uint32_t>(value);
+				bitCount += 6;
+				if (bitCount >= 8)
+				{
+					bitCount -= 8;
+					bytes.push_back(static_cast<uint8_t>(bits >> bitCount));
+				}
+			}
+
+			return bytes;
+		}
+
+		/// <summary>
+		/// A typed, bounds checked window on the buffer data of one accessor.
+		/// </summary>
+		struct AccessorView
+		{
+			const uint8_t* data = nullptr;
+			uint32_t count = 0;
+			uint32_t stride = 0;
+			uint32_t componentType = 0;
+			uint32_t componentCount = 0;
+			bool isNormalized = false;
+
+			float ReadFloat(uint32_t element, uint32_t component) const
+			{
+				const uint8_t* p = data + static_cast<size_t>(element) * stride + component * GetComponentSize(componentType);
+				switch (componentType)
+				{
+				case COMPONENT_FLOAT: { float value; memcpy(&value, p, sizeof(value)); return value; }
+				case COMPONENT_UNSIGNED_BYTE: return isNormalized ? *p / 255.0f : *p;
+				case COMPONENT_BYTE: { int8_t value = static_cast<int8_t>(*p); return isNormalized ? std::max(value / 127.0f, -1.0f) : value; }
+				case COMPONENT_UNSIGNED_SHORT: { uint16_t value; memcpy(&value, p, sizeof(value)); return isNormalized ? value / 65535.0f : value; }
+				case COMPONENT_SHORT: { int16_t value; memcpy(&value, p, sizeof(value)); return isNormalized ? std::max(value / 32767.0f, -1.0f) : value; }
+				default: { uint32_t value; memcpy(&value, p, sizeof(value)); return static_cast<float>(value); }
+				}
+			}
+
+			uint32_t ReadIndex(uint32_t element) const
+			{
+				const uint8_t* p = data + static_cast<size_t>(element) * stride;
+				switch (componentType)
+				{
+				case COMPONENT_UNSIGNED_BYTE: return *p;
+				case COMPONENT_UNSIGNED_SHORT: { uint16_t value; memcpy(&value, p, sizeof(value)); return value; }
+				default: { uint32_t value; memcpy(&value, p, sizeof(value)); return value; }
+				}
+			}
+		};
+
+		class GltfDocument
+		{
+		public:
+			explicit GltfDocument(const std::string& filepath)
+				: _filepath(filepath), _file(filepath)
+			{
+				const char* text = reinterpret_cast<const char*>(_file.Data());
+				size_t textSize = _file.Size();
+
+				uint32_t magic = 0;
+				if (_file.Size() >= sizeof(magic))
+				{
+					memcpy(&magic, _file.Data(), sizeof(magic));
+				}
+
+				// Binary container: a 12 byte header, the JSON chunk, then an optional BIN chunk used by the buffer without uri
+				if (magic == GLB_MAGIC)
+				{
+					size_t offset = 12;
+					bool hasJson = false;
+					while (offset + 8 <= _file.Size())
+					{
+						uint32_t chunk[2];
+						memcpy(chunk, _file.Data() + offset, sizeof(chunk));
+						offset += 8;
+						if (chunk[0] > _file.Size() - offset)
+						{
+							Fail("truncated chunk");
+						}
+
+						if (chunk[1] == GLB_CHUNK_JSON && !hasJson)
+						{
+							text = reinterpret_cast<const char*>(_file.Data() + offset);
+							textSize = chunk[0];
+							hasJson = true;
+						}
+						else if (chunk[1] == GLB_CHUNK_BIN && _binaryChunk.first == nullptr)
+						{
+							_binaryChunk = { _file.Data() + offset, chunk[0] };
+						}
+						offset += (chunk[0] + 3) & ~3u;
+					}
+
+					if (!hasJson)
+					{
+						Fail("no JSON chunk");
+					}
+				}
+
+				_json = JsonParser(text, text + textSize, filepath).Parse();
+				LoadBuffers();
+			}
+
+			const JsonValue& GetJson() const { return _json; }
+
+			AccessorView GetAccessor(double index) const
+			{
+				const JsonValue& accessor = GetElement("accessors", index);
+				if (accessor.Find("sparse") != nullptr || accessor.Find("bufferView") == nullptr)
+				{
+					Fail("sparse accessors and accessors without buffer view are not supported");
+				}
+
+				AccessorView view{};
+				view.count = static_cast<uint32_t>(accessor.GetNumber("count", 0));
+				view.componentType = static_cast<uint32_t>(accessor.GetNumber("componentType", 0));
+				const JsonValue* type = accessor.Find("type");
+				view.componentCount = type != nullptr ? GetComponentCount(type->string) : 0;
+				const JsonValue* normalized = accessor.Find("normalized");
+				view.isNormalized = normalized != nullptr && normalized->boolean;
+
+				uint32_t componentSize = GetComponentSize(view.componentType);
+				if (componentSize == 0 || view.componentCount == 0)
+				{
+					Fail("unknown accessor type");
+				}
+
+				const JsonValue& bufferView = GetElement("bufferViews", accessor.GetNumber("bufferView", 0));
+				const std::pair<const uint8_t*, size_t>& buffer = GetBuffer(bufferView.GetNumber("buffer", 0));
+
+				uint64_t viewOffset = static_cast<uint64_t>(bufferView.GetNumber("byteOffset", 0));
+				uint64_t viewLength = static_cast<uint64_t>(bufferView.GetNumber("byteLength", 0));
+				uint64_t accessorOffset = static_cast<uint64_t>(accessor.GetNumber("byteOffset", 0));
+				uint32_t elementSize = componentSize * view.componentCount;
+				view.stride = static_cast<uint32_t>(bufferView.GetNumber("byteStride", elementSize));
+
+				if (viewOffset + viewLength > buffer.second
+					|| (view.count > 0 && accessorOffset + static_cast<uint64_t>(view.count - 1) * view.stride + elementSize > viewLength))
+				{
+					Fail("accessor out of its buffer");
+				}
+
+				view.data = buffer.first + viewOffset + accessorOffset;
+				return view;
+			}
+
+		private:
+			[[noreturn]] void Fail(const char* reason) const
+			{
+				throw std::runtime_error(std::string("Failed to import glTF, ") + reason + ": " + _filepath);
+			}
+
+			const JsonValue& GetElement(const char* arrayName, double index) const
+			{
+				const std::vector<JsonValue>& elements = _json.GetArray(arrayName);
+				if (index < 0 || index >= static_cast<double>(elements.size()))
+				{
+					Fail("index out of range");
+				}
+				return elements[static_cast<size_t>(index)];
+			}
+
+			const std::pair<const uint8_t*, size_t>& GetBuffer(double index) const
+			{
+				if (index < 0 || index >= static_cast<double>(_buffers.size()))
+				{
+					Fail("buffer index out of range");
+				}
+				return _buffers[static_cast<size_t>(index)];
+			}
+
+			void LoadBuffers()
+			{
+				const std::vector<JsonValue>& buffers = _json.GetArray("buffers");
+				for (size_t i = 0; i < buffers.size(); ++i)
+				{
+					const JsonValue* uri = buffers[i].Find("uri");
+					if (uri == nullptr)
+					{
+						if (i != 0 || _binaryChunk.first == nullptr)
+						{
+							Fail("buffer without uri outside of a .glb");
+						}
+						_buffers.push_back(_binaryChunk);
+						continue;
+					}
+
+					const std::string& path = uri->string;
+					if (path.compare(0, 5, "data:") == 0)
+					{
+						size_t comma = path.find(";base64,");
+						if (comma == std::string::npos)
+						{
+							Fail("only base64 data uris are supported");
+						}
+
+						_decodedBuffers.push_back(DecodeBase64(path.data() + comma + 8, path.data() + path.size()));
+						_buffers.emplace_back(_decodedBuffers.back().data(), _decodedBuffers.back().size());
+						continue;
+					}
+
+					// Relative to the glTF file, mapped like the file itself
+					size_t slash = _filepath.find_last_of("/\\");
+					std::string directory = slash == std::string::npos ? std::string() : _filepath.substr(0, slash + 1);
+					_externalFiles.push_back(std::make_unique<MappedFile>(directory + path));
+					_buffers.emplace_back(_externalFiles.back()->Data(), _externalFiles.back()->Size());
+				}
+			}
+
+			std::string _filepath;
+			MappedFile _file;
+			JsonValue _json;
+			std::pair<const uint8_t*, size_t> _binaryChunk{ nullptr, 0 };
+
+			// Each buffer as a span, owned by the file mapping, a decoded data uri or an external file
+			std::vector<std::pair<const uint8_t*, size_t>> _buffers;
+			std::vector<std::vector<uint8_t>> _decodedBuffers;
+			std::vector<std::unique_ptr<MappedFile>> _externalFiles;
+		};
+	}
+
+	Model::Builder ImportObj(const std::string& filepath)
+	{
+		MappedFile file{ filepath };
+		const char* p = reinterpret_cast<const char*>(file.Data());
+		const char* end = p + file.Size();
+
+		Model::Builder builder{};
+		uint32_t firstIndex = 0;
+		std::vector<uint32_t> polygon;
+		size_t lineNumber = 0;
+
+		auto fail = [&](const char* reason)
+			{
+				throw std::runtime_error("Failed to import OBJ, " + std::string(reason) + " at line " + std::to_string(lineNumber) + ": " + filepath);
+			};
+
+		while (p < end)
+		{
+			lineNumber++;
+			const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+			if (lineEnd == nullptr)
+			{
+				lineEnd = end;
+			}
+
+			p = SkipSpaces(p, lineEnd);
+			if (StartsWithKeyword(p, lineEnd, "v"))
+			{
+				// Every position is a vertex: without normals or texture coordinates, face corners sharing a position share a vertex
+				Model::Vertex vertex{ {}, DEFAULT_VERTEX_COLOR };
+				const char* cursor = p + 1;
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					cursor = ParseFloat(cursor, lineEnd, vertex.position[axis]);
+					if (cursor == nullptr)
+					{
+						fail("invalid position");
+					}
+				}
+
+				glm::vec3 color;
+				const char* colorCursor = cursor;
+				bool hasColor = true;
+				for (int channel = 0; channel < 3 && hasColor; ++channel)
+				{
+					colorCursor = ParseFloat(colorCursor, lineEnd, color[channel]);
+					hasColor = colorCursor != nullptr;
+				}
+				if (hasColor)
+				{
+					vertex.color = color;
+				}
+
+				builder.vertices.push_back(vertex);
+			}
+			else if (StartsWithKeyword(p, lineEnd, "f"))
+			{
+				polygon.clear();
+				const char* cursor = SkipSpaces(p + 1, lineEnd);
+				while (cursor < lineEnd)
+				{
+					// Only the position of "v", "v/vt", "v//vn" or "v/vt/vn"
+					long index = 0;
+					std::from_chars_result result = std::from_chars(cursor, lineEnd, index);
+					if (result.ec != std::errc() || index == 0)
+					{
+						fail("invalid face index");
+					}
+
+					long resolved = index > 0 ? index - 1 : static_cast<long>(builder.vertices.size()) + index;
+					if (resolved < 0 || resolved >= static_cast<long>(builder.vertices.size()))
+					{
+						fail("face index out of range");
+					}
+
+					polygon.push_back(static_cast<uint32_t>(resolved));
+					cursor = SkipSpaces(SkipToken(result.ptr, lineEnd), lineEnd);
+				}
+
+				if (polygon.size() < 3)
+				{
+					fail("face with less than 3 vertices");
+				}
+
+				for (size_t i = 2; i < polygon.size(); ++i)
+				{
+					builder.indices.push_back(polygon[0]);
+					builder.indices.push_back(polygon[i - 1]);
+					builder.indices.push_back(polygon[i]);
+				}
+			}
+			else if (StartsWithKeyword(p, lineEnd, "o") || StartsWithKeyword(p, lineEnd, "g") || StartsWithKeyword(p, lineEnd, "usemtl"))
+			{
+				CloseSubmesh(builder, firstIndex);
+			}
+
+			p = lineEnd + 1;
+		}
+
+		CloseSubmesh(builder, firstIndex);
+		if (builder.submeshes.size() == 1)
+		{
+			builder.submeshes.clear();
+		}
+
+		return builder;
+	}
+
+	Model::Builder ImportGltf(const std::string& filepath)
+	{
+		GltfDocument document{ filepath };
+		Model::Builder builder{};
+
+		for (const JsonValue& mesh : document.GetJson().GetArray("meshes"))
+		{
+			for (const JsonValue& primitive : mesh.GetArray("primitives"))
+			{
+				// Points, lines and strips are skipped, the pipelines draw triangle lists
+				const JsonValue* attributes = primitive.Find("attributes");
+				const JsonValue* positionAccessor = attributes != nullptr ? attributes->Find("POSITION") : nullptr;
+				if (primitive.GetNumber("mode", MODE_TRIANGLES) != MODE_TRIANGLES || positionAccessor == nullptr)
+				{
+					continue;
+				}
+
+				AccessorView positions = document.GetAccessor(positionAccessor->number);
+				if (positions.componentCount != 3)
+				{
+					throw std::runtime_error("Failed to import glTF, POSITION is not a VEC3: " + filepath);
+				}
+
+				const JsonValue* colorAccessor = attributes->Find("COLOR_0");
+				AccessorView colors{};
+				if (colorAccessor != nullptr)
+				{
+					colors = document.GetAccessor(colorAccessor->number);
+					if (colors.count != positions.count || colors.componentCount < 3)
+					{
+						throw std::runtime_error("Failed to import glTF, COLOR_0 does not match POSITION: " + filepath);
+					}
+				}
+
+				const uint32_t baseVertex = static_cast<uint32_t>(builder.vertices.size());
+				for (uint32_t i = 0; i < positions.count; ++i)
+				{
+					Model::Vertex vertex{ {}, DEFAULT_VERTEX_COLOR };
+					for (uint32_t axis = 0; axis < 3; ++axis)
+					{
+						vertex.position[axis] = positions.ReadFloat(i, axis);
+						if (colors.data != nullptr)
+						{
+							vertex.color[axis] = colors.ReadFloat(i, axis);
+						}
+					}
+					builder.vertices.push_back(vertex);
+				}
+
+				const uint32_t firstIndex = static_cast<uint32_t>(builder.indices.size());
+				if (const JsonValue* indexAccessor = primitive.Find("indices"))
+				{
+					AccessorView indices = document.GetAccessor(indexAccessor->number);
+					if (indices.componentCount != 1 || indices.componentType == COMPONENT_FLOAT)
+					{
+						throw std::runtime_error("Failed to import glTF, indices must be unsigned integer scalars: " + filepath);
+					}
+
+					for (uint32_t i = 0; i < indices.count; ++i)
+					{
+						uint32_t index = indices.ReadIndex(i);
+						if (index >= positions.count)
+						{
+							throw std::runtime_error("Failed to import glTF, index out of range: " + filepath);
+						}
+						builder.indices.push_back(baseVertex + index);
+					}
+				}
+				else
+				{
+					for (uint32_t i = 0; i < positions.count; ++i)
+					{
+						builder.indices.push_back(baseVertex + i);
+					}
+				}
+
+				builder.submeshes.push_back({ firstIndex, static_cast<uint32_t>(builder.indices.size()) - firstIndex });
+			}
+		}
+
+		if (builder.submeshes.size() == 1)
+		{
+			builder.submeshes.clear();
+		}
+
+		return builder;
+	}
+
+	Model::Builder ImportMesh(const std::string& filepath)
+	{
+		size_t dot = filepath.find_last_of('.');
+		std::string extension = dot == std::string::npos ? std::string() : filepath.substr(dot + 1);
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+		if (extension == "obj")
+		{
+			return ImportObj(filepath);
+		}
+		if (extension == "gltf" || extension == "glb")
+		{
+			return ImportGltf(filepath);
+		}
+
+		throw std::runtime_error("Failed to import mesh, unknown file extension: " + filepath);
+	}
+} // namespace DaisyEngine
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Model.hpp"
+
+// std
+#include <string>
+
+namespace DaisyEngine
+{
+	// The importers only keep what Model::Vertex holds, vertices the source file gives no color to are light grey
+
+	// Wavefront OBJ: positions, with the common "v x y z r g b" vertex color extension, and polygonal faces triangulated as fans.
+	// Texture coordinates and normals are ignored, every object, group or material change starts a new submesh
+	Model::Builder ImportObj(const std::string& filepath);
+
+	// glTF 2.0, either .gltf (buffers embedded as base64 or in external files) or .glb. Every triangle primitive of every mesh
+	// becomes a submesh, with its POSITION and COLOR_0 attributes. Node transforms are not applied, the meshes stay in their own space
+	Model::Builder ImportGltf(const std::string& filepath);
+
+	// Picks the importer from the file extension
+	Model::Builder ImportMesh(const std::string& filepath);
+} // namespace DaisyEngine
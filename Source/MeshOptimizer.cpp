@@ -0,0 +1,572 @@
+#include "MeshOptimizer.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace DaisyEngine
+{
+	// Scoring of "Linear-Speed Vertex Cache Optimisation", Tom Forsyth
+	static constexpr uint32_t SCORING_CACHE_SIZE = 32;
+	static constexpr float CACHE_DECAY_POWER = 1.5f;
+	static constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+	static constexpr float VALENCE_BOOST_SCALE = 2.0f;
+	static constexpr float VALENCE_BOOST_POWER = 0.5f;
+	static constexpr uint32_t NO_TRIANGLE = UINT32_MAX;
+
+	static float ScoreVertex(int32_t cachePosition, uint32_t remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+		{
+			return -1.0f;
+		}
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			// The vertices of the last triangle score the same whatever their order, the triangle sharing them is taken next anyway
+			if (cachePosition < 3)
+			{
+				score = LAST_TRIANGLE_SCORE;
+			}
+			else
+			{
+				float scaled = 1.0f - static_cast<float>(cachePosition - 3) / (SCORING_CACHE_SIZE - 3);
+				score = std::pow(scaled, CACHE_DECAY_POWER);
+			}
+		}
+
+		// Vertices with few triangles left are finished first, rather than left behind to be transformed again later
+		return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+	}
+
+	/// <summary>
+	/// The triangles using each vertex, in one array with an offset per vertex. The first counts[vertex] entries of a vertex
+	/// are the triangles not emitted yet.
+	/// </summary>
+	struct TriangleAdjacency
+	{
+		std::vector<uint32_t> counts;
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> triangles;
+
+		TriangleAdjacency(const uint32_t* indices, size_t indexCount, uint32_t vertexCount)
+			: counts(vertexCount, 0), offsets(vertexCount, 0), triangles(indexCount)
+		{
+			for (size_t i = 0; i < indexCount; ++i)
+			{
+				assert(indices[i] < vertexCount && "Index out of the vertex range");
+				counts[indices[i]]++;
+			}
+
+			uint32_t offset = 0;
+			for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+			{
+				offsets[vertex] = offset;
+				offset += counts[vertex];
+			}
+
+			std::vector<uint32_t> filled(vertexCount, 0);
+			for (size_t i = 0; i < indexCount; ++i)
+			{
+				uint32_t vertex = indices[i];
+				triangles[offsets[vertex] + filled[vertex]++] = static_cast<uint32_t>(i / 3);
+			}
+		}
+
+		// A degenerate triangle is listed twice by the vertex it repeats, every entry goes
+		void Remove(uint32_t vertex, uint32_t triangle)
+		{
+			uint32_t* first = &triangles[offsets[vertex]];
+			for (uint32_t i = 0; i < counts[vertex];)
+			{
+				if (first[i] == triangle)
+				{
+					std::swap(first[i], first[counts[vertex] - 1]);
+					counts[vertex]--;
+				}
+				else
+				{
+					++i;
+				}
+			}
+		}
+	};
+
+	/// <summary>
+	/// A FIFO cache simulated with a timestamp per entry: an entry is cached while fewer than size misses followed its own.
+	/// </summary>
+	struct FifoCache
+	{
+		std::vector<uint32_t> timestamps;
+		uint32_t size;
+		uint32_t time;
+
+		FifoCache(size_t entryCount, uint32_t cacheSize)
+			: timestamps(entryCount, 0), size(cacheSize), time(cacheSize + 1)
+		{
+		}
+
+		// Returns true on a miss, the entry is then cached
+		bool Access(size_t entry)
+		{
+			if (time - timestamps[entry] <= size)
+			{
+				return false;
+			}
+
+			timestamps[entry] = time++;
+			return true;
+		}
+
+		void Clear()
+		{
+			time += size + 1;
+		}
+	};
+
+	VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+	{
+		VertexCacheStats stats{};
+		if (indexCount < 3 || vertexCount == 0)
+		{
+			return stats;
+		}
+
+		FifoCache cache{ vertexCount, cacheSize };
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			stats.transformedCount += cache.Access(indices[i]) ? 1 : 0;
+		}
+
+		stats.acmr = static_cast<float>(stats.transformedCount) / static_cast<float>(indexCount / 3);
+		stats.atvr = static_cast<float>(stats.transformedCount) / static_cast<float>(vertexCount);
+		return stats;
+	}
+
+	VertexFetchStats AnalyzeVertexFetch(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t vertexStride)
+	{
+		VertexFetchStats stats{};
+		if (indexCount == 0 || vertexCount == 0)
+		{
+			return stats;
+		}
+
+		// Only the vertices the post transform cache misses are fetched, a vertex may straddle two lines
+		const size_t bufferSize = static_cast<size_t>(vertexCount) * vertexStride;
+		FifoCache vertexCache{ vertexCount, VERTEX_CACHE_SIZE };
+		FifoCache lineCache{ (bufferSize + VERTEX_FETCH_LINE_SIZE - 1) / VERTEX_FETCH_LINE_SIZE, VERTEX_FETCH_LINE_COUNT };
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			if (!vertexCache.Access(indices[i]))
+			{
+				continue;
+			}
+
+			size_t firstByte = static_cast<size_t>(indices[i]) * vertexStride;
+			for (size_t line = firstByte / VERTEX_FETCH_LINE_SIZE; line <= (firstByte + vertexStride - 1) / VERTEX_FETCH_LINE_SIZE; ++line)
+			{
+				stats.fetchedBytes += lineCache.Access(line) ? VERTEX_FETCH_LINE_SIZE : 0;
+			}
+		}
+
+		stats.overfetch = static_cast<float>(stats.fetchedBytes) / static_cast<float>(bufferSize);
+		return stats;
+	}
+
+	OverdrawStats AnalyzeOverdraw(const uint32_t* indices, size_t indexCount, const std::vector<Model::Vertex>& vertices)
+	{
+		OverdrawStats stats{};
+		if (indexCount < 3 || vertices.empty())
+		{
+			return stats;
+		}
+
+		glm::vec3 min = vertices[0].position;
+		glm::vec3 max = vertices[0].position;
+		for (const Model::Vertex& vertex : vertices)
+		{
+			min = glm::min(min, vertex.position);
+			max = glm::max(max, vertex.position);
+		}
+
+		float extent = std::max({ max.x - min.x, max.y - min.y, max.z - min.z });
+		if (extent <= 0.0f)
+		{
+			return stats;
+		}
+
+		// Both directions of each axis, the mesh scaled uniformly to fill the grid; no face is culled, as the pipeline does
+		const float scale = static_cast<float>(OVERDRAW_GRID_SIZE) / extent;
+		std::vector<float> depths(OVERDRAW_GRID_SIZE * OVERDRAW_GRID_SIZE);
+		for (int view = 0; view < 6; ++view)
+		{
+			const int depthAxis = view / 2;
+			const int xAxis = (depthAxis + 1) % 3;
+			const int yAxis = (depthAxis + 2) % 3;
+			const float depthSign = view % 2 == 0 ? 1.0f : -1.0f;
+			std::fill(depths.begin(), depths.end(), std::numeric_limits<float>::infinity());
+
+			for (size_t i = 0; i + 2 < indexCount; i += 3)
+			{
+				glm::vec3 corners[3];
+				for (int k = 0; k < 3; ++k)
+				{
+					const glm::vec3& position = vertices[indices[i + k]].position;
+					corners[k] = { (position[xAxis] - min[xAxis]) * scale, (position[yAxis] - min[yAxis]) * scale, position[depthAxis] * depthSign };
+				}
+
+				float area = (corners[1].x - corners[0].x) * (corners[2].y - corners[0].y) - (corners[2].x - corners[0].x) * (corners[1].y - corners[0].y);
+				if (area == 0.0f)
+				{
+					continue;
+				}
+
+				int minX = std::max(0, static_cast<int>(std::floor(std::min({ corners[0].x, corners[1].x, corners[2].x }))));
+				int maxX = std::min(static_cast<int>(OVERDRAW_GRID_SIZE) - 1, static_cast<int>(std::ceil(std::max({ corners[0].x, corners[1].x, corners[2].x }))));
+				int minY = std::max(0, static_cast<int>(std::floor(std::min({ corners[0].y, corners[1].y, corners[2].y }))));
+				int maxY = std::min(static_cast<int>(OVERDRAW_GRID_SIZE) - 1, static_cast<int>(std::ceil(std::max({ corners[0].y, corners[1].y, corners[2].y }))));
+
+				for (int y = minY; y <= maxY; ++y)
+				{
+					for (int x = minX; x <= maxX; ++x)
+					{
+						// Barycentrics at the pixel center, divided by the signed area so either winding is inside when all are positive
+						float px = x + 0.5f;
+						float py = y + 0.5f;
+						float w0 = ((corners[1].x - px) * (corners[2].y - py) - (corners[2].x - px) * (corners[1].y - py)) / area;
+						float w1 = ((corners[2].x - px) * (corners[0].y - py) - (corners[0].x - px) * (corners[2].y - py)) / area;
+						float w2 = 1.0f - w0 - w1;
+						if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+						{
+							continue;
+						}
+
+						float depth = w0 * corners[0].z + w1 * corners[1].z + w2 * corners[2].z;
+						float& stored = depths[y * OVERDRAW_GRID_SIZE + x];
+						if (depth < stored)
+						{
+							stats.coveredPixels += stored == std::numeric_limits<float>::infinity() ? 1 : 0;
+							stats.shadedPixels++;
+							stored = depth;
+						}
+					}
+				}
+			}
+		}
+
+		stats.overdraw = stats.coveredPixels == 0 ? 0.0f : static_cast<float>(stats.shadedPixels) / static_cast<float>(stats.coveredPixels);
+		return stats;
+	}
+
+	void OptimizeVertexCache(uint32_t* indices, size_t indexCount, uint32_t vertexCount)
+	{
+		assert(indexCount % 3 == 0 && "The indices must be a triangle list");
+		const uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		TriangleAdjacency adjacency{ indices, indexCount, vertexCount };
+		const std::vector<uint32_t> source(indices, indices + indexCount);
+
+		std::vector<int32_t> cachePositions(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+		{
+			vertexScores[vertex] = ScoreVertex(-1, adjacency.counts[vertex]);
+		}
+
+		std::vector<float> triangleScores(triangleCount);
+		uint32_t bestTriangle = 0;
+		for (uint32_t triangle = 0; triangle < triangleCount; ++triangle)
+		{
+			const uint32_t* corners = &source[triangle * 3];
+			triangleScores[triangle] = vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+			if (triangleScores[triangle] > triangleScores[bestTriangle])
+			{
+				bestTriangle = triangle;
+			}
+		}
+
+		std::vector<uint8_t> emitted(triangleCount, 0);
+		std::array<uint32_t, SCORING_CACHE_SIZE + 3> cache{};
+		std::array<uint32_t, SCORING_CACHE_SIZE + 3> newCache{};
+		uint32_t cacheCount = 0;
+		uint32_t cursor = 0;
+
+		for (uint32_t output = 0; output < triangleCount; ++output)
+		{
+			// Nothing in the cache has triangles left, carry on from the first one not emitted
+			if (bestTriangle == NO_TRIANGLE)
+			{
+				while (emitted[cursor] != 0)
+				{
+					cursor++;
+				}
+				bestTriangle = cursor;
+			}
+
+			const uint32_t* corners = &source[bestTriangle * 3];
+			std::copy(corners, corners + 3, indices + output * 3);
+			emitted[bestTriangle] = 1;
+
+			// The vertices of the triangle move to the front of the cache, a degenerate triangle only once per vertex
+			uint32_t newCount = 0;
+			for (int k = 0; k < 3; ++k)
+			{
+				uint32_t vertex = corners[k];
+				if ((k > 0 && vertex == corners[0]) || (k > 1 && vertex == corners[1]))
+				{
+					continue;
+				}
+				adjacency.Remove(vertex, bestTriangle);
+				newCache[newCount++] = vertex;
+			}
+
+			for (uint32_t i = 0; i < cacheCount; ++i)
+			{
+				uint32_t vertex = cache[i];
+				if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+				{
+					newCache[newCount++] = vertex;
+				}
+			}
+
+			// Rescore the vertices whose position or triangle count changed, evicted ones included, and their triangles
+			for (uint32_t i = 0; i < newCount; ++i)
+			{
+				uint32_t vertex = newCache[i];
+				int32_t position = i < SCORING_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+				cachePositions[vertex] = position;
+
+				float score = ScoreVertex(position, adjacency.counts[vertex]);
+				float delta = score - vertexScores[vertex];
+				vertexScores[vertex] = score;
+
+				const uint32_t* triangles = &adjacency.triangles[adjacency.offsets[vertex]];
+				for (uint32_t j = 0; j < adjacency.counts[vertex]; ++j)
+				{
+					triangleScores[triangles[j]] += delta;
+				}
+			}
+
+			cacheCount = std::min(newCount, SCORING_CACHE_SIZE);
+			std::swap(cache, newCache);
+
+			// The next triangle is the best one touching the cache
+			bestTriangle = NO_TRIANGLE;
+			float bestScore = -1.0f;
+			for (uint32_t i = 0; i < cacheCount; ++i)
+			{
+				uint32_t vertex = cache[i];
+				const uint32_t* triangles = &adjacency.triangles[adjacency.offsets[vertex]];
+				for (uint32_t j = 0; j < adjacency.counts[vertex]; ++j)
+				{
+					if (triangleScores[triangles[j]] > bestScore)
+					{
+						bestScore = triangleScores[triangles[j]];
+						bestTriangle = triangles[j];
+					}
+				}
+			}
+		}
+	}
+
+	void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const std::vector<Model::Vertex>& vertices, float threshold)
+	{
+		assert(indexCount % 3 == 0 && "The indices must be a triangle list");
+		const size_t triangleCount = indexCount / 3;
+		if (triangleCount < 2)
+		{
+			return;
+		}
+
+		// Hard boundaries, where the cache order starts afresh: no vertex of the triangle is still in the cache
+		std::vector<size_t> hardStarts;
+		FifoCache cache{ vertices.size(), VERTEX_CACHE_SIZE };
+		for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+		{
+			uint32_t misses = 0;
+			for (size_t k = 0; k < 3; ++k)
+			{
+				misses += cache.Access(indices[triangle * 3 + k]) ? 1 : 0;
+			}
+			if (misses == 3 || triangle == 0)
+			{
+				hardStarts.push_back(triangle);
+			}
+		}
+		hardStarts.push_back(triangleCount);
+
+		// Soft boundaries, inside each hard cluster: cut as soon as the part since the last cut, from a cold cache, has an ACMR
+		// within threshold of the whole cluster, so the cuts cost at most that much
+		std::vector<size_t> clusterStarts;
+		for (size_t h = 0; h + 1 < hardStarts.size(); ++h)
+		{
+			const size_t start = hardStarts[h];
+			const size_t end = hardStarts[h + 1];
+
+			cache.Clear();
+			uint32_t clusterMisses = 0;
+			for (size_t i = start * 3; i < end * 3; ++i)
+			{
+				clusterMisses += cache.Access(indices[i]) ? 1 : 0;
+			}
+			const float targetAcmr = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+
+			cache.Clear();
+			clusterStarts.push_back(start);
+			size_t softStart = start;
+			uint32_t misses = 0;
+			for (size_t triangle = start; triangle < end; ++triangle)
+			{
+				for (size_t k = 0; k < 3; ++k)
+				{
+					misses += cache.Access(indices[triangle * 3 + k]) ? 1 : 0;
+				}
+
+				if (triangle + 1 < end && static_cast<float>(misses) <= targetAcmr * static_cast<float>(triangle + 1 - softStart))
+				{
+					softStart = triangle + 1;
+					clusterStarts.push_back(softStart);
+					misses = 0;
+					cache.Clear();
+				}
+			}
+		}
+		clusterStarts.push_back(triangleCount);
+		const size_t clusterCount = clusterStarts.size() - 1;
+
+		// Area weighted centroid and normal of each cluster, and of the mesh
+		std::vector<glm::vec3> centroids(clusterCount, glm::vec3{ 0.0f });
+		std::vector<glm::vec3> normals(clusterCount, glm::vec3{ 0.0f });
+		std::vector<float> areas(clusterCount, 0.0f);
+		glm::vec3 meshCentroid{ 0.0f };
+		float meshArea = 0.0f;
+		for (size_t cluster = 0; cluster < clusterCount; ++cluster)
+		{
+			for (size_t triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; ++triangle)
+			{
+				const glm::vec3& a = vertices[indices[triangle * 3]].position;
+				const glm::vec3& b = vertices[indices[triangle * 3 + 1]].position;
+				const glm::vec3& c = vertices[indices[triangle * 3 + 2]].position;
+
+				glm::vec3 normal = glm::cross(b - a, c - a);
+				float area = glm::length(normal);
+				centroids[cluster] += (a + b + c) * (area / 3.0f);
+				normals[cluster] += normal;
+				areas[cluster] += area;
+			}
+
+			meshCentroid += centroids[cluster];
+			meshArea += areas[cluster];
+			if (areas[cluster] > 0.0f)
+			{
+				centroids[cluster] /= areas[cluster];
+			}
+		}
+		if (meshArea > 0.0f)
+		{
+			meshCentroid /= meshArea;
+		}
+
+		// Clusters far out along their own normal are the most likely to be in front of the others, from any view
+		std::vector<float> sortKeys(clusterCount, 0.0f);
+		for (size_t cluster = 0; cluster < clusterCount; ++cluster)
+		{
+			float normalLength = glm::length(normals[cluster]);
+			if (normalLength > 0.0f)
+			{
+				sortKeys[cluster] = glm::dot(centroids[cluster] - meshCentroid, normals[cluster] / normalLength);
+			}
+		}
+
+		std::vector<size_t> order(clusterCount);
+		std::iota(order.begin(), order.end(), size_t{ 0 });
+		std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+		const std::vector<uint32_t> source(indices, indices + indexCount);
+		uint32_t* output = indices;
+		for (size_t cluster : order)
+		{
+			output = std::copy(source.begin() + clusterStarts[cluster] * 3, source.begin() + clusterStarts[cluster + 1] * 3, output);
+		}
+	}
+
+	void OptimizeVertexFetch(Model::Builder& builder)
+	{
+		if (builder.indices.empty())
+		{
+			return;
+		}
+
+		std::vector<uint32_t> remap(builder.vertices.size(), UINT32_MAX);
+		uint32_t vertexCount = 0;
+		for (uint32_t& index : builder.indices)
+		{
+			if (remap[index] == UINT32_MAX)
+			{
+				remap[index] = vertexCount++;
+			}
+			index = remap[index];
+		}
+
+		std::vector<Model::Vertex> vertices(vertexCount);
+		for (size_t vertex = 0; vertex < remap.size(); ++vertex)
+		{
+			uint32_t target = remap[vertex];
+			if (target != UINT32_MAX)
+			{
+				vertices[target] = builder.vertices[vertex];
+			}
+		}
+
+		builder.vertices.swap(vertices);
+	}
+
+	static void Analyze(const Model::Builder& builder, VertexCacheStats& cache, VertexFetchStats& fetch, OverdrawStats& overdraw)
+	{
+		const uint32_t vertexCount = static_cast<uint32_t>(builder.vertices.size());
+		cache = AnalyzeVertexCache(builder.indices.data(), builder.indices.size(), vertexCount);
+		fetch = AnalyzeVertexFetch(builder.indices.data(), builder.indices.size(), vertexCount, sizeof(Model::Vertex));
+		overdraw = AnalyzeOverdraw(builder.indices.data(), builder.indices.size(), builder.vertices);
+	}
+
+	MeshOptimizationStats OptimizeMesh(Model::Builder& builder, float overdrawThreshold)
+	{
+		assert(builder.lods.empty() && "The LODs are built after the mesh is optimized");
+
+		if (builder.indices.empty())
+		{
+			builder.WeldVertices();
+		}
+
+		MeshOptimizationStats stats{};
+		Analyze(builder, stats.cacheBefore, stats.fetchBefore, stats.overdrawBefore);
+
+		// A triangle never leaves its submesh, the ranges are optimized independently
+		std::vector<Model::Submesh> parts = builder.submeshes;
+		if (parts.empty())
+		{
+			parts.push_back({ 0, static_cast<uint32_t>(builder.indices.size()) });
+		}
+
+		const uint32_t vertexCount = static_cast<uint32_t>(builder.vertices.size());
+		for (const Model::Submesh& part : parts)
+		{
+			uint32_t* indices = builder.indices.data() + part.firstIndex;
+			OptimizeVertexCache(indices, part.indexCount, vertexCount);
+			OptimizeOverdraw(indices, part.indexCount, builder.vertices, overdrawThreshold);
+		}
+
+		OptimizeVertexFetch(builder);
+		Analyze(builder, stats.cacheAfter, stats.fetchAfter, stats.overdrawAfter);
+		return stats;
+	}
+} // namespace DaisyEngine
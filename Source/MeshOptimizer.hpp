@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Model.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace DaisyEngine
+{
+	// --- Constants ---
+	static constexpr uint32_t VERTEX_CACHE_SIZE = 16; // Post transform cache simulated by the analysis, a FIFO as on most GPUs
+	static constexpr uint32_t VERTEX_FETCH_LINE_SIZE = 64; // Bytes per cache line of the simulated vertex fetch
+	static constexpr uint32_t VERTEX_FETCH_LINE_COUNT = 64; // 4 KB, small enough to show the locality of one draw
+	static constexpr uint32_t OVERDRAW_GRID_SIZE = 256; // Pixels per side of the views the overdraw is rasterized in
+	static constexpr float DEFAULT_OVERDRAW_THRESHOLD = 1.05f; // ACMR the overdraw pass may trade, as a factor of the cache order
+
+	/// <summary>
+	/// The VertexCacheStats struct is the post transform cache behavior of an index buffer. ACMR is the transformed vertices
+	/// per triangle, 0.5 at best on a regular grid and 3 at worst. ATVR is the transformed vertices per vertex, 1 at best.
+	/// </summary>
+	struct VertexCacheStats
+	{
+		uint32_t transformedCount = 0;
+		float acmr = 0.0f;
+		float atvr = 0.0f;
+	};
+
+	/// <summary>
+	/// The VertexFetchStats struct is what the vertex fetch reads from the vertex buffer in cache lines. An overfetch of 1
+	/// reads every byte of the buffer once.
+	/// </summary>
+	struct VertexFetchStats
+	{
+		uint64_t fetchedBytes = 0;
+		float overfetch = 0.0f;
+	};
+
+	/// <summary>
+	/// The OverdrawStats struct counts the pixels shaded with a depth test against the pixels covered, over orthographic
+	/// views along the six axes. An overdraw of 1 shades every covered pixel once.
+	/// </summary>
+	struct OverdrawStats
+	{
+		uint64_t coveredPixels = 0;
+		uint64_t shadedPixels = 0;
+		float overdraw = 0.0f;
+	};
+
+	/// <summary>
+	/// The MeshOptimizationStats struct compares a mesh before and after OptimizeMesh.
+	/// </summary>
+	struct MeshOptimizationStats
+	{
+		VertexCacheStats cacheBefore;
+		VertexCacheStats cacheAfter;
+		VertexFetchStats fetchBefore;
+		VertexFetchStats fetchAfter;
+		OverdrawStats overdrawBefore;
+		OverdrawStats overdrawAfter;
+	};
+
+	VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+	VertexFetchStats AnalyzeVertexFetch(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t vertexStride);
+	OverdrawStats AnalyzeOverdraw(const uint32_t* indices, size_t indexCount, const std::vector<Model::Vertex>& vertices);
+
+	// Reorders the triangles for the post transform cache, with the linear time scoring of Tom Forsyth
+	void OptimizeVertexCache(uint32_t* indices, size_t indexCount, uint32_t vertexCount);
+
+	// Reorders clusters of triangles, outward facing ones of the outer layers first, so that whatever the view they tend to be
+	// drawn before what they hide. The clusters are cut where the cache order restarts or where cutting keeps the ACMR within
+	// threshold of it, so the indices should come from OptimizeVertexCache
+	void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const std::vector<Model::Vertex>& vertices, float threshold = DEFAULT_OVERDRAW_THRESHOLD);
+
+	// Renumbers the vertices in the order the indices first use them, so the fetch walks the buffer forward. Vertices no index
+	// uses are dropped
+	void OptimizeVertexFetch(Model::Builder& builder);
+
+	// Runs the three passes, each submesh on its own range so the ranges stay valid. Unindexed builders are welded first
+	MeshOptimizationStats OptimizeMesh(Model::Builder& builder, float overdrawThreshold = DEFAULT_OVERDRAW_THRESHOLD);
+} // namespace DaisyEngine
@@ -0,0 +1,163 @@
+#include "MeshRegistry.hpp"
+#include "MeshFile.hpp"
+
+// std
+#include <cassert>
+
+namespace DaisyEngine
+{
+	static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+	static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+	static uint64_t HashBytes(const void* data, size_t size, uint64_t hash)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= FNV_PRIME;
+		}
+		return hash;
+	}
+
+	// Model narrows the indices of the meshes 16 bits can address
+	static uint32_t GetIndexSize(const Model::Builder& builder)
+	{
+		return builder.vertices.size() <= Model::MAX_UINT16_VERTEX_COUNT ? sizeof(uint16_t) : sizeof(uint32_t);
+	}
+
+	MeshRegistry::MeshRegistry(Device& device, VertexFormat vertexFormat, MeshArena* meshArena)
+		: _device(device), _vertexFormat(vertexFormat), _meshArena(meshArena)
+	{
+	}
+
+	uint64_t MeshRegistry::HashGeometry(const Model::Builder& builder, VertexFormat vertexFormat)
+	{
+		uint64_t hash = FNV_OFFSET_BASIS;
+		if (vertexFormat == VertexFormat::Quantized)
+		{
+			std::vector<QuantizedVertex> vertices;
+			PositionQuantization quantization = Model::QuantizeVertices(builder, vertices);
+			hash = HashBytes(vertices.data(), vertices.size() * sizeof(QuantizedVertex), hash);
+			hash = HashBytes(&quantization, sizeof(quantization), hash);
+		}
+		else
+		{
+			hash = HashBytes(builder.vertices.data(), builder.vertices.size() * sizeof(Model::Vertex), hash);
+		}
+
+		if (GetIndexSize(builder) == sizeof(uint16_t))
+		{
+			for (uint32_t index : builder.indices)
+			{
+				uint16_t shortIndex = static_cast<uint16_t>(index);
+				hash = HashBytes(&shortIndex, sizeof(shortIndex), hash);
+			}
+		}
+		else
+		{
+			hash = HashBytes(builder.indices.data(), builder.indices.size() * sizeof(uint32_t), hash);
+		}
+
+		hash = HashBytes(builder.submeshes.data(), builder.submeshes.size() * sizeof(Model::Submesh), hash);
+		return HashBytes(builder.lods.data(), builder.lods.size() * sizeof(Model::Lod), hash);
+	}
+
+	uint64_t MeshRegistry::HashGeometry(const MeshFile& meshFile)
+	{
+		uint64_t hash = HashBytes(meshFile.GetVertices(), static_cast<size_t>(meshFile.GetVertexCount()) * meshFile.GetHeader().vertexStride, FNV_OFFSET_BASIS);
+		if (meshFile.GetVertexFormat() == VertexFormat::Quantized)
+		{
+			hash = HashBytes(&meshFile.GetPositionQuantization(), sizeof(PositionQuantization), hash);
+		}
+		hash = HashBytes(meshFile.GetIndices(), static_cast<size_t>(meshFile.GetIndexCount()) * meshFile.GetIndexSize(), hash);
+		hash = HashBytes(meshFile.GetSubmeshes(), meshFile.GetSubmeshCount() * sizeof(Model::Submesh), hash);
+		return HashBytes(meshFile.GetLods(), meshFile.GetLodCount() * sizeof(Model::Lod), hash);
+	}
+
+	Model* MeshRegistry::GetOrCreate(const Model::Builder& builder)
+	{
+		GeometryKey key = GetKey(builder);
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		RegisteredMesh* mesh = Find(key);
+		return mesh != nullptr ? mesh->model.get() : Create(key, builder).model.get();
+	}
+
+	Model* MeshRegistry::Load(const std::string& filepath)
+	{
+		MeshFile meshFile{ filepath };
+		GeometryKey key{ HashGeometry(meshFile), meshFile.GetVertexCount(), meshFile.GetIndexCount() };
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (RegisteredMesh* mesh = Find(key))
+		{
+			return mesh->model.get();
+		}
+
+		// The vertices keep the stride they were written with, the arena widens the indices to 32 bit
+		VkDeviceSize size = static_cast<VkDeviceSize>(meshFile.GetVertexCount()) * meshFile.GetHeader().vertexStride
+			+ static_cast<VkDeviceSize>(meshFile.GetIndexCount()) * (_meshArena != nullptr ? sizeof(uint32_t) : meshFile.GetIndexSize());
+		return Add(key, std::make_unique<Model>(_device, meshFile, _meshArena), size).model.get();
+	}
+
+	Model* MeshRegistry::GetPrimitive(Primitive primitive)
+	{
+		assert(primitive < Primitive::Count && "Unknown primitive");
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		RegisteredMesh*& cached = _primitives[static_cast<uint32_t>(primitive)];
+		if (cached != nullptr)
+		{
+			_stats.hitCount++;
+			_stats.savedBytes += cached->size;
+			return cached->model.get();
+		}
+
+		// A mesh with the same geometry may already be registered, the primitive then shares it
+		Model::Builder builder = CreatePrimitive(primitive);
+		GeometryKey key = GetKey(builder);
+		cached = Find(key);
+		if (cached == nullptr)
+		{
+			cached = &Create(key, builder);
+		}
+		return cached->model.get();
+	}
+
+	MeshRegistry::GeometryKey MeshRegistry::GetKey(const Model::Builder& builder) const
+	{
+		return { HashGeometry(builder, _vertexFormat), static_cast<uint32_t>(builder.vertices.size()), static_cast<uint32_t>(builder.indices.size()) };
+	}
+
+	MeshRegistry::RegisteredMesh* MeshRegistry::Find(const GeometryKey& key)
+	{
+		auto it = _meshes.find(key);
+		if (it == _meshes.end())
+		{
+			_stats.missCount++;
+			return nullptr;
+		}
+
+		_stats.hitCount++;
+		_stats.savedBytes += it->second.size;
+		return &it->second;
+	}
+
+	MeshRegistry::RegisteredMesh& MeshRegistry::Create(const GeometryKey& key, const Model::Builder& builder)
+	{
+		VkDeviceSize size = builder.vertices.size() * static_cast<VkDeviceSize>(Model::GetVertexStride(_vertexFormat))
+			+ builder.indices.size() * static_cast<VkDeviceSize>(_meshArena != nullptr ? sizeof(uint32_t) : GetIndexSize(builder));
+		return Add(key, std::make_unique<Model>(_device, builder, _vertexFormat, _meshArena), size);
+	}
+
+	MeshRegistry::RegisteredMesh& MeshRegistry::Add(const GeometryKey& key, std::unique_ptr<Model> model, VkDeviceSize size)
+	{
+		RegisteredMesh& mesh = _meshes[key];
+		mesh.model = std::move(model);
+		mesh.size = size;
+		_stats.meshCount++;
+		_stats.residentBytes += size;
+		return mesh;
+	}
+} // namespace DaisyEngine
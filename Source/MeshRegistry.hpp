@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Model.hpp"
+#include "Primitives.hpp"
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+// std
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace DaisyEngine
+{
+	class MeshFile;
+
+	/// <summary>
+	/// The MeshRegistryStats struct counts the requests made to a MeshRegistry and the buffer memory sharing saved.
+	/// </summary>
+	struct MeshRegistryStats
+	{
+		uint64_t hitCount = 0;
+		uint64_t missCount = 0;
+		uint32_t meshCount = 0;
+		VkDeviceSize residentBytes = 0; // Vertex and index buffers of the unique meshes
+		VkDeviceSize savedBytes = 0; // What the hits would have uploaded again
+
+		inline double GetHitRate() const { return hitCount + missCount == 0 ? 0.0 : static_cast<double>(hitCount) / (hitCount + missCount); }
+	};
+
+	/// <summary>
+	/// The MeshRegistry class shares the models of identical meshes. A mesh is keyed by a hash of the bytes its buffers hold
+	/// once uploaded: the vertices, the indices at their uploaded width and the submeshes, so a builder and the mesh file
+	/// converted from it land on the same model. The models are owned by the registry and live as long as it does.
+	/// Builders and primitives are uploaded in the vertex format of the registry, mesh files in the format they were written in.
+	/// With a MeshArena every model is created in it, so all the meshes of the registry share one binding.
+	/// </summary>
+	class MeshRegistry
+	{
+	public:
+		// --- Constructor/ Destructor ---
+		MeshRegistry(Device& device, VertexFormat vertexFormat = VertexFormat::PositionColor, MeshArena* meshArena = nullptr);
+
+		MeshRegistry(const MeshRegistry&) = delete;
+		MeshRegistry& operator=(const MeshRegistry&) = delete;
+
+		// --- Methods ---
+		// The model holding this geometry, created on the first request
+		Model* GetOrCreate(const Model::Builder& builder);
+		// Hashes the sections in place, the file is only uploaded when its geometry is not registered yet
+		Model* Load(const std::string& filepath);
+		// Generated and uploaded on the first request, then served from the cache
+		Model* GetPrimitive(Primitive primitive);
+
+		inline const MeshRegistryStats& GetStats() const { return _stats; }
+		inline VertexFormat GetVertexFormat() const { return _vertexFormat; }
+		inline MeshArena* GetMeshArena() const { return _meshArena; }
+
+		// FNV-1a of the uploaded bytes of a mesh, quantized vertices are hashed with their position quantization
+		static uint64_t HashGeometry(const Model::Builder& builder, VertexFormat vertexFormat = VertexFormat::PositionColor);
+		static uint64_t HashGeometry(const MeshFile& meshFile);
+
+	private:
+		/// <summary>
+		/// The hash alone identifies the geometry, the counts only make a collision between different meshes less likely.
+		/// </summary>
+		struct GeometryKey
+		{
+			uint64_t hash;
+			uint32_t vertexCount;
+			uint32_t indexCount;
+
+			bool operator==(const GeometryKey& other) const
+			{
+				return hash == other.hash && vertexCount == other.vertexCount && indexCount == other.indexCount;
+			}
+		};
+
+		struct GeometryKeyHasher
+		{
+			size_t operator()(const GeometryKey& key) const { return static_cast<size_t>(key.hash); }
+		};
+
+		struct RegisteredMesh
+		{
+			std::unique_ptr<Model> model;
+			VkDeviceSize size = 0;
+		};
+
+		// --- Methods ---
+		GeometryKey GetKey(const Model::Builder& builder) const;
+
+		// Called with the mutex held, Find counts the hit or the miss
+		RegisteredMesh* Find(const GeometryKey& key);
+		RegisteredMesh& Create(const GeometryKey& key, const Model::Builder& builder);
+		RegisteredMesh& Add(const GeometryKey& key, std::unique_ptr<Model> model, VkDeviceSize size);
+
+		// --- Variables ---
+		Device& _device;
+		VertexFormat _vertexFormat;
+		MeshArena* _meshArena;
+
+		std::unordered_map<GeometryKey, RegisteredMesh, GeometryKeyHasher> _meshes;
+		std::array<RegisteredMesh*, PRIMITIVE_COUNT> _primitives{};
+		MeshRegistryStats _stats;
+		std::mutex _mutex;
+	};
+} // namespace DaisyEngine
@@ -0,0 +1,414 @@
+#include "MeshSimplifier.hpp"
+#include "MeshOptimizer.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// A sum of squared distances to planes, the symmetric matrix of Garland and Heckbert: for a point p it is
+	/// p.A.p + 2 b.p + c. Kept in double, the planes of a large mesh add up to values a float cannot tell apart.
+	/// </summary>
+	struct Quadric
+	{
+		double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+		double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+		double c = 0.0;
+
+		// The plane of the points p with dot(normal, p) + distance = 0, normal of unit length
+		void AddPlane(const glm::dvec3& normal, double distance)
+		{
+			a00 += normal.x * normal.x;
+			a01 += normal.x * normal.y;
+			a02 += normal.x * normal.z;
+			a11 += normal.y * normal.y;
+			a12 += normal.y * normal.z;
+			a22 += normal.z * normal.z;
+			b0 += normal.x * distance;
+			b1 += normal.y * distance;
+			b2 += normal.z * distance;
+			c += distance * distance;
+		}
+
+		void Add(const Quadric& other)
+		{
+			a00 += other.a00;
+			a01 += other.a01;
+			a02 += other.a02;
+			a11 += other.a11;
+			a12 += other.a12;
+			a22 += other.a22;
+			b0 += other.b0;
+			b1 += other.b1;
+			b2 += other.b2;
+			c += other.c;
+		}
+
+		double Evaluate(const glm::vec3& point) const
+		{
+			const double x = point.x;
+			const double y = point.y;
+			const double z = point.z;
+			double value = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+				+ 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+
+			// Rounding can take a sum of squares slightly below 0
+			return std::max(value, 0.0);
+		}
+	};
+
+	/// <summary>
+	/// An edge collapse: from is merged into to, the triangles using both disappear.
+	/// </summary>
+	struct Collapse
+	{
+		double cost;
+		uint32_t from;
+		uint32_t to;
+	};
+
+	// Hashes the bit patterns of a position, adding 0.0f first so that -0.0f and 0.0f share a hash
+	struct PositionHasher
+	{
+		size_t operator()(const glm::vec3& position) const
+		{
+			size_t hash = 0;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				float value = position[axis] + 0.0f;
+				uint32_t bits;
+				memcpy(&bits, &value, sizeof(bits));
+				hash ^= std::hash<uint32_t>{}(bits) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+			}
+			return hash;
+		}
+	};
+
+	static uint64_t GetEdgeKey(uint32_t a, uint32_t b)
+	{
+		return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+	}
+
+	// Every undirected edge of the triangles, sorted, once per triangle using it
+	static void GatherEdges(const std::vector<uint32_t>& indices, std::vector<uint64_t>& edges)
+	{
+		edges.clear();
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			edges.push_back(GetEdgeKey(indices[i], indices[i + 1]));
+			edges.push_back(GetEdgeKey(indices[i + 1], indices[i + 2]));
+			edges.push_back(GetEdgeKey(indices[i + 2], indices[i]));
+		}
+		std::sort(edges.begin(), edges.end());
+	}
+
+	// An edge used by one triangle is on the outline, by more than two the surface is not a manifold there
+	static void LockBorders(const std::vector<uint32_t>& indices, std::vector<bool>& isLocked)
+	{
+		std::vector<uint64_t> edges;
+		GatherEdges(indices, edges);
+
+		for (size_t first = 0; first < edges.size();)
+		{
+			size_t last = first + 1;
+			while (last < edges.size() && edges[last] == edges[first])
+			{
+				last++;
+			}
+
+			if (last - first != 2)
+			{
+				isLocked[static_cast<uint32_t>(edges[first] >> 32)] = true;
+				isLocked[static_cast<uint32_t>(edges[first])] = true;
+			}
+			first = last;
+		}
+	}
+
+	// Vertices sharing a position differ by their other attributes, moving one of them would open a crack along the seam
+	static void LockSeams(const std::vector<uint32_t>& indices, const std::vector<Model::Vertex>& vertices, std::vector<bool>& isLocked)
+	{
+		std::unordered_map<glm::vec3, uint32_t, PositionHasher> firstVertices;
+		firstVertices.reserve(vertices.size());
+
+		for (uint32_t index : indices)
+		{
+			auto [it, inserted] = firstVertices.try_emplace(vertices[index].position, index);
+			if (!inserted && it->second != index)
+			{
+				isLocked[it->second] = true;
+				isLocked[index] = true;
+			}
+		}
+	}
+
+	// The triangles around each vertex, triangleOffsets[v] to triangleOffsets[v + 1] in vertexTriangles
+	static void BuildAdjacency(const std::vector<uint32_t>& indices, uint32_t vertexCount, std::vector<uint32_t>& triangleOffsets, std::vector<uint32_t>& vertexTriangles)
+	{
+		triangleOffsets.assign(vertexCount + 1, 0);
+		for (uint32_t index : indices)
+		{
+			triangleOffsets[index + 1]++;
+		}
+		for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+		{
+			triangleOffsets[vertex + 1] += triangleOffsets[vertex];
+		}
+
+		std::vector<uint32_t> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+		vertexTriangles.resize(indices.size());
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			vertexTriangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+	}
+
+	// Refuses a collapse that would turn a remaining triangle around or squash it to a line
+	static bool IsCollapseValid(const Collapse& collapse, const std::vector<uint32_t>& indices, const std::vector<Model::Vertex>& vertices,
+		const std::vector<uint32_t>& triangleOffsets, const std::vector<uint32_t>& vertexTriangles)
+	{
+		for (uint32_t i = triangleOffsets[collapse.from]; i < triangleOffsets[collapse.from + 1]; ++i)
+		{
+			const uint32_t* triangle = &indices[vertexTriangles[i] * 3];
+			if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+			{
+				continue;
+			}
+
+			glm::vec3 corners[3];
+			glm::vec3 movedCorners[3];
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				corners[corner] = vertices[triangle[corner]].position;
+				movedCorners[corner] = triangle[corner] == collapse.from ? vertices[collapse.to].position : corners[corner];
+			}
+
+			glm::vec3 normal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+			glm::vec3 movedNormal = glm::cross(movedCorners[1] - movedCorners[0], movedCorners[2] - movedCorners[0]);
+			float normalLengthSquared = glm::dot(normal, normal);
+			float movedLengthSquared = glm::dot(movedNormal, movedNormal);
+			if (glm::dot(normal, movedNormal) <= 0.0f || movedLengthSquared <= 1e-12f * normalLengthSquared)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	SimplificationStats SimplifyMesh(const uint32_t* indices, size_t indexCount, const std::vector<Model::Vertex>& vertices,
+		float targetError, std::vector<uint32_t>& outIndices, size_t targetIndexCount)
+	{
+		assert(indexCount % 3 == 0 && "Only triangle lists can be simplified");
+
+		const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+		std::vector<uint32_t> current(indices, indices + indexCount);
+
+		SimplificationStats stats{};
+		stats.triangleCountBefore = static_cast<uint32_t>(indexCount / 3);
+
+		std::vector<bool> isLocked(vertexCount, false);
+		LockBorders(current, isLocked);
+		LockSeams(current, vertices, isLocked);
+
+		// Every vertex starts with the planes of its triangles, a collapse adds the planes of the vertex that goes away
+		std::vector<Quadric> quadrics(vertexCount);
+		for (size_t i = 0; i < current.size(); i += 3)
+		{
+			glm::dvec3 a = vertices[current[i]].position;
+			glm::dvec3 b = vertices[current[i + 1]].position;
+			glm::dvec3 c = vertices[current[i + 2]].position;
+			glm::dvec3 normal = glm::cross(b - a, c - a);
+			double length = glm::length(normal);
+			if (length <= 0.0)
+			{
+				continue;
+			}
+
+			normal /= length;
+			for (size_t corner = i; corner < i + 3; ++corner)
+			{
+				quadrics[current[corner]].AddPlane(normal, -glm::dot(normal, a));
+			}
+		}
+
+		const double maxCost = static_cast<double>(targetError) * targetError;
+		double largestCost = 0.0;
+
+		std::vector<uint64_t> edges;
+		std::vector<Collapse> collapses;
+		std::vector<uint32_t> triangleOffsets;
+		std::vector<uint32_t> vertexTriangles;
+		std::vector<uint32_t> remap(vertexCount);
+		std::vector<bool> isTouched(vertexCount);
+
+		// Each pass collapses the cheapest edges whose neighborhoods do not overlap, then rewrites the indices
+		while (current.size() > targetIndexCount)
+		{
+			BuildAdjacency(current, vertexCount, triangleOffsets, vertexTriangles);
+			GatherEdges(current, edges);
+			edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+			collapses.clear();
+			for (uint64_t edge : edges)
+			{
+				uint32_t a = static_cast<uint32_t>(edge >> 32);
+				uint32_t b = static_cast<uint32_t>(edge);
+				Quadric quadric = quadrics[a];
+				quadric.Add(quadrics[b]);
+
+				// Onto whichever end keeps the planes of both the closest, a locked vertex can only be kept
+				Collapse collapse{ maxCost + 1.0, 0, 0 };
+				if (!isLocked[a])
+				{
+					collapse = { quadric.Evaluate(vertices[b].position), a, b };
+				}
+				if (!isLocked[b])
+				{
+					double cost = quadric.Evaluate(vertices[a].position);
+					if (cost < collapse.cost)
+					{
+						collapse = { cost, b, a };
+					}
+				}
+
+				if (collapse.cost <= maxCost)
+				{
+					collapses.push_back(collapse);
+				}
+			}
+
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+			for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+			{
+				remap[vertex] = vertex;
+			}
+			std::fill(isTouched.begin(), isTouched.end(), false);
+
+			uint32_t passCollapseCount = 0;
+			size_t remainingIndexCount = current.size();
+			for (const Collapse& collapse : collapses)
+			{
+				if (isTouched[collapse.from] || isTouched[collapse.to] || remainingIndexCount <= targetIndexCount)
+				{
+					continue;
+				}
+
+				if (!IsCollapseValid(collapse, current, vertices, triangleOffsets, vertexTriangles))
+				{
+					continue;
+				}
+
+				// The triangles around the vertex change shape, later tests of this pass must not rely on them
+				for (uint32_t i = triangleOffsets[collapse.from]; i < triangleOffsets[collapse.from + 1]; ++i)
+				{
+					const uint32_t* triangle = &current[vertexTriangles[i] * 3];
+					isTouched[triangle[0]] = true;
+					isTouched[triangle[1]] = true;
+					isTouched[triangle[2]] = true;
+					if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+					{
+						remainingIndexCount -= 3;
+					}
+				}
+
+				remap[collapse.from] = collapse.to;
+				quadrics[collapse.to].Add(quadrics[collapse.from]);
+				largestCost = std::max(largestCost, collapse.cost);
+				passCollapseCount++;
+			}
+
+			if (passCollapseCount == 0)
+			{
+				break;
+			}
+			stats.collapseCount += passCollapseCount;
+
+			// Triangles that lost a corner to the collapse of their edge are dropped
+			size_t writeIndex = 0;
+			for (size_t i = 0; i < current.size(); i += 3)
+			{
+				uint32_t a = remap[current[i]];
+				uint32_t b = remap[current[i + 1]];
+				uint32_t c = remap[current[i + 2]];
+				if (a != b && b != c && c != a)
+				{
+					current[writeIndex++] = a;
+					current[writeIndex++] = b;
+					current[writeIndex++] = c;
+				}
+			}
+			current.resize(writeIndex);
+		}
+
+		stats.triangleCountAfter = static_cast<uint32_t>(current.size() / 3);
+		stats.error = static_cast<float>(std::sqrt(largestCost));
+		outIndices.swap(current);
+		return stats;
+	}
+
+	std::vector<SimplificationStats> BuildLods(Model::Builder& builder, const float* targetErrors, size_t targetErrorCount)
+	{
+		assert(builder.lods.empty() && "The LODs of the builder are already built");
+
+		std::vector<SimplificationStats> levels;
+		if (builder.indices.empty())
+		{
+			return levels;
+		}
+
+		BoundingBox boundingBox{};
+		BoundingSphere boundingSphere{};
+		Model::ComputeBounds(builder.vertices, boundingBox, boundingSphere);
+
+		// A triangle never leaves its submesh, the ranges are simplified independently and laid out one after the other
+		std::vector<Model::Submesh> parts = builder.submeshes;
+		if (parts.empty())
+		{
+			parts.push_back({ 0, static_cast<uint32_t>(builder.indices.size()) });
+		}
+
+		const uint32_t vertexCount = static_cast<uint32_t>(builder.vertices.size());
+		std::vector<uint32_t> levelIndices;
+		std::vector<uint32_t> partIndices;
+		size_t previousIndexCount = builder.indices.size();
+
+		for (size_t i = 0; i < targetErrorCount && builder.lods.size() + 1 < Model::MAX_LOD_COUNT; ++i)
+		{
+			SimplificationStats level{};
+			levelIndices.clear();
+			for (const Model::Submesh& part : parts)
+			{
+				SimplificationStats partStats = SimplifyMesh(builder.indices.data() + part.firstIndex, part.indexCount, builder.vertices,
+					targetErrors[i] * boundingSphere.radius, partIndices);
+				levelIndices.insert(levelIndices.end(), partIndices.begin(), partIndices.end());
+
+				level.triangleCountBefore += partStats.triangleCountBefore;
+				level.triangleCountAfter += partStats.triangleCountAfter;
+				level.collapseCount += partStats.collapseCount;
+				level.error = std::max(level.error, partStats.error);
+			}
+
+			// A level that saves too little is not worth its indices, a larger error may still do
+			if (levelIndices.empty() || levelIndices.size() > previousIndexCount * MIN_LOD_REDUCTION)
+			{
+				continue;
+			}
+
+			OptimizeVertexCache(levelIndices.data(), levelIndices.size(), vertexCount);
+			builder.lods.push_back({ static_cast<uint32_t>(builder.indices.size()), static_cast<uint32_t>(levelIndices.size()), level.error });
+			builder.indices.insert(builder.indices.end(), levelIndices.begin(), levelIndices.end());
+
+			previousIndexCount = levelIndices.size();
+			levels.push_back(level);
+		}
+
+		return levels;
+	}
+} // namespace DaisyEngine
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Model.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace DaisyEngine
+{
+	// --- Constants ---
+	// Target errors of the LOD chain built by default, as fractions of the bounding sphere radius of the mesh
+	static constexpr float DEFAULT_LOD_ERRORS[] = { 0.005f, 0.015f, 0.04f, 0.1f };
+	static constexpr float MIN_LOD_REDUCTION = 0.8f; // A level keeping more of the triangles of the previous one is skipped
+
+	/// <summary>
+	/// The SimplificationStats struct reports what SimplifyMesh removed.
+	/// </summary>
+	struct SimplificationStats
+	{
+		uint32_t triangleCountBefore = 0;
+		uint32_t triangleCountAfter = 0;
+		uint32_t collapseCount = 0;
+		float error = 0.0f; // Largest distance the surface may have moved, in model units
+	};
+
+	// Simplifies a triangle list by quadric error edge collapse (Garland and Heckbert): each vertex accumulates the planes
+	// of its triangles, and the edges are collapsed, cheapest first, onto the one of their two vertices that keeps the
+	// sum of squared distances to those planes the lowest, until the next collapse would move the surface by more than
+	// targetError or the index count reaches targetIndexCount. Vertices are never moved nor created, the result indexes the
+	// same vertices. Vertices on an open border or on a seam (a position shared by vertices with other attributes) stay in
+	// place so the outline and the attribute borders keep their shape, and a collapse flipping a triangle is refused
+	SimplificationStats SimplifyMesh(const uint32_t* indices, size_t indexCount, const std::vector<Model::Vertex>& vertices,
+		float targetError, std::vector<uint32_t>& outIndices, size_t targetIndexCount = 0);
+
+	// Appends a simplified copy of the mesh to the indices for each target error, as a fraction of its bounding sphere radius,
+	// and lists them as the LODs of the builder, finest first. Each level is simplified from the mesh itself, every submesh
+	// on its own, then reordered for the vertex cache. A level saving too little over the previous one is skipped, so the chain
+	// may be shorter than the targets. Must be called last, welding and optimization expect a builder without LODs
+	std::vector<SimplificationStats> BuildLods(Model::Builder& builder, const float* targetErrors, size_t targetErrorCount);
+} // namespace DaisyEngine
@@ -0,0 +1,301 @@
+#include "MeshStreamer.hpp"
+#include "MeshFile.hpp"
+#include "CpuProfiler.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace DaisyEngine
+{
+	MeshStreamer::MeshStreamer(Device& device, VkDeviceSize budget, uint32_t ioThreadCount)
+		: _device(device), _budget(budget)
+	{
+		assert(ioThreadCount > 0 && "The mesh streamer needs at least one I/O thread");
+
+		for (uint32_t i = 0; i < ioThreadCount; ++i)
+		{
+			_ioThreads.emplace_back(&MeshStreamer::IoThreadLoop, this);
+		}
+	}
+
+	MeshStreamer::~MeshStreamer()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_isStopping = true;
+		}
+		_loadCondition.notify_all();
+
+		for (std::thread& thread : _ioThreads)
+		{
+			thread.join();
+		}
+	}
+
+	MeshHandle MeshStreamer::Register(const std::string& filepath)
+	{
+		auto it = _handles.find(filepath);
+		if (it != _handles.end())
+		{
+			return it->second;
+		}
+
+		// Only the header and the bounds section are read, the pages of the geometry are never touched
+		MeshFile meshFile{ filepath };
+		const MeshFileHeader& header = meshFile.GetHeader();
+		const MeshFileBounds& bounds = meshFile.GetBounds();
+
+		StreamedMesh mesh{};
+		mesh.filepath = filepath;
+		mesh.size = static_cast<VkDeviceSize>(header.vertexCount) * header.vertexStride + static_cast<VkDeviceSize>(header.indexCount) * header.indexSize;
+		mesh.boundingSphere.center = { bounds.sphereCenter[0], bounds.sphereCenter[1], bounds.sphereCenter[2] };
+		mesh.boundingSphere.radius = bounds.sphereRadius;
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		MeshHandle handle{ static_cast<uint32_t>(_meshes.size()) };
+		_meshes.push_back(std::move(mesh));
+		_handles.emplace(filepath, handle);
+		return handle;
+	}
+
+	void MeshStreamer::Resolve(RenderView& entities)
+	{
+		DAISY_PROFILE_ZONE("Resolve streamed meshes");
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (size_t i = 0; i < entities.Size(); ++i)
+		{
+			RenderComponent& renderComponent = entities.renderComponents[i];
+			if (!renderComponent.mesh.IsValid())
+			{
+				continue;
+			}
+
+			StreamedMesh& mesh = _meshes[renderComponent.mesh.index];
+			renderComponent.model = mesh.state == MeshState::Resident ? mesh.model.get() : nullptr;
+		}
+	}
+
+	void MeshStreamer::Update(const RenderView& entities, const std::vector<uint32_t>& visibleEntities, const glm::vec3& cameraPosition)
+	{
+		DAISY_PROFILE_ZONE("Update mesh streaming");
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_loadException)
+		{
+			std::exception_ptr exception = _loadException;
+			_loadException = nullptr;
+			std::rethrow_exception(exception);
+		}
+
+		++_frame;
+
+		// The last frame that could draw them has completed by now
+		_retiredModels.erase(std::remove_if(_retiredModels.begin(), _retiredModels.end(),
+			[this](const RetiredModel& retired) { return _frame - retired.frame > RETIRED_FRAME_COUNT; }), _retiredModels.end());
+
+		for (uint32_t entity : visibleEntities)
+		{
+			const MeshHandle& handle = entities.renderComponents[entity].mesh;
+			if (handle.IsValid())
+			{
+				_meshes[handle.index].visibleFrame = _frame;
+			}
+		}
+
+		// The bounding sphere radius over its distance approximates the size on screen, it reaches 1 once the camera is inside.
+		// Rotation is ignored, it only moves the sphere of a mesh that is not centered on its origin
+		for (size_t i = 0; i < entities.Size(); ++i)
+		{
+			const MeshHandle& handle = entities.renderComponents[i].mesh;
+			if (!handle.IsValid())
+			{
+				continue;
+			}
+
+			StreamedMesh& mesh = _meshes[handle.index];
+			const Transform& transform = entities.transforms[i];
+			glm::vec3 center = transform.translation + mesh.boundingSphere.center * transform.scale;
+			float radius = mesh.boundingSphere.radius * std::max({ std::fabs(transform.scale.x), std::fabs(transform.scale.y), std::fabs(transform.scale.z) });
+			float distance = glm::length(center - cameraPosition);
+			float priority = radius / std::max(distance, radius);
+
+			mesh.priority = mesh.requestFrame == _frame ? std::max(mesh.priority, priority) : priority;
+			mesh.requestFrame = _frame;
+		}
+
+		// Requests no entity made this frame are dropped, the others are reordered by their new priority
+		_queue.clear();
+		for (uint32_t i = 0; i < static_cast<uint32_t>(_meshes.size()); ++i)
+		{
+			StreamedMesh& mesh = _meshes[i];
+			if (mesh.state == MeshState::Unloaded || mesh.state == MeshState::Queued)
+			{
+				mesh.state = mesh.requestFrame == _frame ? MeshState::Queued : MeshState::Unloaded;
+				if (mesh.state == MeshState::Queued)
+				{
+					_queue.push_back(i);
+				}
+			}
+		}
+
+		std::sort(_queue.begin(), _queue.end(), [this](uint32_t a, uint32_t b) { return _meshes[a].priority < _meshes[b].priority; });
+
+		// Without a request this only trims a budget that was lowered
+		if (_queue.empty())
+		{
+			MakeRoom(0, std::numeric_limits<float>::infinity());
+		}
+		else
+		{
+			const StreamedMesh& mostUrgent = _meshes[_queue.back()];
+			MakeRoom(mostUrgent.size, mostUrgent.priority);
+		}
+
+		_stats = {};
+		for (const StreamedMesh& mesh : _meshes)
+		{
+			_stats.residentCount += mesh.state == MeshState::Resident ? 1 : 0;
+		}
+		_stats.meshCount = static_cast<uint32_t>(_meshes.size());
+		_stats.loadingCount = _loadingCount;
+		_stats.queuedCount = static_cast<uint32_t>(_queue.size());
+		_stats.residentBytes = _residentBytes;
+		_stats.budgetBytes = _budget;
+		_stats.loadCount = _loadCount;
+		_stats.evictionCount = _evictionCount;
+
+		_loadCondition.notify_all();
+	}
+
+	void MeshStreamer::WaitIdle()
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_idleCondition.wait(lock, [this]() { return _loadException != nullptr || (_loadingCount == 0 && !CanStartLoad()); });
+	}
+
+	void MeshStreamer::SetBudget(VkDeviceSize budget)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_budget = budget;
+		}
+		_loadCondition.notify_all();
+	}
+
+	bool MeshStreamer::IsResident(MeshHandle mesh)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		StreamedMesh& streamedMesh = _meshes[mesh.index];
+		return streamedMesh.state == MeshState::Resident && streamedMesh.model->IsResident();
+	}
+
+	const BoundingSphere& MeshStreamer::GetBoundingSphere(MeshHandle mesh) const
+	{
+		return _meshes[mesh.index].boundingSphere;
+	}
+
+	bool MeshStreamer::CanStartLoad() const
+	{
+		if (_queue.empty())
+		{
+			return false;
+		}
+
+		// A mesh larger than the whole budget still loads once nothing else is resident
+		VkDeviceSize size = _meshes[_queue.back()].size;
+		return _residentBytes + size <= _budget || _residentBytes == 0;
+	}
+
+	void MeshStreamer::Evict(StreamedMesh& mesh)
+	{
+		_residentBytes -= mesh.size;
+		_retiredModels.push_back({ std::move(mesh.model), _frame });
+		mesh.state = MeshState::Unloaded;
+		_evictionCount++;
+	}
+
+	void MeshStreamer::MakeRoom(VkDeviceSize size, float priority)
+	{
+		// Never a mesh seen this frame, nor one wanted more than the mesh the room is made for
+		while (_residentBytes + size > _budget)
+		{
+			StreamedMesh* leastRecentlyVisible = nullptr;
+			for (StreamedMesh& mesh : _meshes)
+			{
+				bool isEvictable = mesh.state == MeshState::Resident && mesh.visibleFrame != _frame
+					&& (mesh.requestFrame != _frame || mesh.priority < priority);
+				if (isEvictable && (leastRecentlyVisible == nullptr || mesh.visibleFrame < leastRecentlyVisible->visibleFrame))
+				{
+					leastRecentlyVisible = &mesh;
+				}
+			}
+
+			if (leastRecentlyVisible == nullptr)
+			{
+				return;
+			}
+
+			Evict(*leastRecentlyVisible);
+		}
+	}
+
+	void MeshStreamer::IoThreadLoop()
+	{
+		DAISY_PROFILE_THREAD("Mesh I/O thread");
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		while (true)
+		{
+			_loadCondition.wait(lock, [this]() { return _isStopping || CanStartLoad(); });
+			if (_isStopping)
+			{
+				return;
+			}
+
+			// The memory is accounted for from the start, the budget holds while the loads are in flight
+			uint32_t index = _queue.back();
+			_queue.pop_back();
+			_meshes[index].state = MeshState::Loading;
+			_residentBytes += _meshes[index].size;
+			_loadingCount++;
+			std::string filepath = _meshes[index].filepath;
+			lock.unlock();
+
+			// Mapped and copied into the staging ring, the batch is submitted with the next flush of the upload service
+			std::unique_ptr<Model> model;
+			std::exception_ptr exception;
+			try
+			{
+				DAISY_PROFILE_ZONE("Load mesh");
+				model = Model::LoadFromFile(_device, filepath);
+			}
+			catch (...)
+			{
+				exception = std::current_exception();
+			}
+
+			lock.lock();
+			_loadingCount--;
+
+			StreamedMesh& mesh = _meshes[index];
+			if (model != nullptr)
+			{
+				mesh.model = std::move(model);
+				mesh.state = MeshState::Resident;
+				_loadCount++;
+			}
+			else
+			{
+				mesh.state = MeshState::Unloaded;
+				_residentBytes -= mesh.size;
+				_loadException = exception;
+			}
+
+			_idleCondition.notify_all();
+		}
+	}
+} // namespace DaisyEngine
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "Model.hpp"
+#include "Components.hpp"
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+// Libs
+#include <glm/glm.hpp>
+
+// std
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The StreamingStats struct reports the state of the MeshStreamer after its last Update.
+	/// </summary>
+	struct StreamingStats
+	{
+		uint32_t meshCount = 0;
+		uint32_t residentCount = 0;
+		uint32_t loadingCount = 0;
+		uint32_t queuedCount = 0;
+		VkDeviceSize residentBytes = 0; // Vertex and index buffers of the resident meshes, loads in progress included
+		VkDeviceSize budgetBytes = 0;
+		uint64_t loadCount = 0; // Since the streamer was created
+		uint64_t evictionCount = 0;
+	};
+
+	/// <summary>
+	/// The MeshStreamer class loads mesh files in the background, in the order the camera needs them, and keeps the meshes
+	/// it made resident under a memory budget. A mesh is registered once and referenced by its handle; it is requested when an
+	/// entity using it is updated, read by an I/O thread straight into the upload ring, and evicted, least recently visible
+	/// first, when a more urgent mesh needs its memory. Entities are never evicted from under a frame that sees them.
+	/// Every method but the I/O work itself runs on the render thread.
+	/// </summary>
+	class MeshStreamer
+	{
+	public:
+		// --- Constants ---
+		static constexpr VkDeviceSize DEFAULT_BUDGET = 256ull * 1024 * 1024;
+		static constexpr uint32_t DEFAULT_IO_THREAD_COUNT = 2;
+		static constexpr uint64_t RETIRED_FRAME_COUNT = 3; // Updates an evicted model is kept for, the frames in flight may still draw it
+
+		// --- Constructor/ Destructor ---
+		MeshStreamer(Device& device, VkDeviceSize budget = DEFAULT_BUDGET, uint32_t ioThreadCount = DEFAULT_IO_THREAD_COUNT);
+		~MeshStreamer();
+
+		MeshStreamer(const MeshStreamer&) = delete;
+		MeshStreamer& operator=(const MeshStreamer&) = delete;
+
+		// --- Methods ---
+		// Maps a mesh file written by the MeshConverter for its size and bounds, the geometry is only read once requested.
+		// Registering the same path again returns the same handle
+		MeshHandle Register(const std::string& filepath);
+
+		// Points the render component of every streamed entity at its model, or at nothing while the mesh is not resident
+		void Resolve(RenderView& entities);
+
+		// Called once per frame, after recording. The visible entities keep their meshes, every other streamed entity requests
+		// its mesh with a priority growing with its size on screen, seen from the camera position. Rethrows a failed load
+		void Update(const RenderView& entities, const std::vector<uint32_t>& visibleEntities, const glm::vec3& cameraPosition);
+
+		// Blocks until no queued mesh can start loading and no load is in progress
+		void WaitIdle();
+
+		void SetBudget(VkDeviceSize budget);
+		bool IsResident(MeshHandle mesh);
+		const BoundingSphere& GetBoundingSphere(MeshHandle mesh) const;
+		inline const StreamingStats& GetStats() const { return _stats; }
+
+	private:
+		enum class MeshState
+		{
+			Unloaded,
+			Queued,
+			Loading,
+			Resident,
+		};
+
+		/// <summary>
+		/// A registered mesh, its state and model are guarded by the streamer mutex.
+		/// </summary>
+		struct StreamedMesh
+		{
+			std::string filepath;
+			VkDeviceSize size = 0; // Vertex and index buffer bytes once resident
+			BoundingSphere boundingSphere{};
+
+			MeshState state = MeshState::Unloaded;
+			std::unique_ptr<Model> model;
+
+			float priority = 0.0f; // Of the last update that requested it
+			uint64_t requestFrame = 0;
+			uint64_t visibleFrame = 0;
+		};
+
+		/// <summary>
+		/// An evicted model, destroyed once the frames that may draw it are done.
+		/// </summary>
+		struct RetiredModel
+		{
+			std::unique_ptr<Model> model;
+			uint64_t frame;
+		};
+
+		// --- Methods ---
+		void IoThreadLoop();
+		bool CanStartLoad() const;
+		void Evict(StreamedMesh& mesh);
+		void MakeRoom(VkDeviceSize size, float priority);
+
+		// --- Variables ---
+		Device& _device;
+		VkDeviceSize _budget;
+
+		std::vector<StreamedMesh> _meshes;
+		std::unordered_map<std::string, MeshHandle> _handles;
+
+		// Mesh indices waiting for an I/O thread, the most urgent last
+		std::vector<uint32_t> _queue;
+		VkDeviceSize _residentBytes = 0;
+		std::vector<RetiredModel> _retiredModels;
+		uint64_t _frame = 0;
+		uint64_t _evictionCount = 0;
+		StreamingStats _stats;
+
+		std::mutex _mutex;
+		std::condition_variable _loadCondition; // Wakes the I/O threads
+		std::condition_variable _idleCondition; // Wakes WaitIdle
+		uint32_t _loadingCount = 0;
+		uint64_t _loadCount = 0;
+		bool _isStopping = false;
+		std::exception_ptr _loadException;
+		std::vector<std::thread> _ioThreads;
+	};
+} // namespace DaisyEngine
@@ -1,75 +1,375 @@
 #include "Model.hpp"
+#include "MeshFile.hpp"
 
 // std
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstring>
+#include <stdexcept>
+#include <unordered_map>
 
 namespace DaisyEngine
 {
-	Model::Model(Device& device, const std::vector<Vertex>& vertices) 
-		: _device{ device }
+	// Hashes the bit patterns of a vertex, adding 0.0f first so that -0.0f and 0.0f (equal values) share a hash
+	struct VertexHasher
 	{
-		CreateVertexBuffers(vertices);
+		size_t operator()(const Model::Vertex& vertex) const
+		{
+			const float values[] = {
+				vertex.position.x + 0.0f, vertex.position.y + 0.0f, vertex.position.z + 0.0f,
+				vertex.color.x + 0.0f, vertex.color.y + 0.0f, vertex.color.z + 0.0f };
+
+			size_t hash = 0;
+			for (float value : values)
+			{
+				uint32_t bits;
+				memcpy(&bits, &value, sizeof(bits));
+				hash ^= std::hash<uint32_t>{}(bits) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+			}
+			return hash;
+		}
+	};
+
+	void Model::Builder::WeldVertices()
+	{
+		std::unordered_map<Vertex, uint32_t, VertexHasher> uniqueVertices;
+		uniqueVertices.reserve(vertices.size());
+
+		std::vector<Vertex> weldedVertices;
+		weldedVertices.reserve(vertices.size());
+
+		const size_t indexCount = indices.empty() ? vertices.size() : indices.size();
+		std::vector<uint32_t> weldedIndices;
+		weldedIndices.reserve(indexCount);
+
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			const Vertex& vertex = vertices[indices.empty() ? i : indices[i]];
+
+			auto [it, inserted] = uniqueVertices.try_emplace(vertex, static_cast<uint32_t>(weldedVertices.size()));
+			if (inserted)
+			{
+				weldedVertices.push_back(vertex);
+			}
+
+			weldedIndices.push_back(it->second);
+		}
+
+		vertices.swap(weldedVertices);
+		indices.swap(weldedIndices);
+	}
+
+	size_t Model::Builder::GetMeshIndexCount() const
+	{
+		return lods.empty() ? indices.size() : lods.front().firstIndex;
+	}
+
+	Model::Model(Device& device, const Builder& builder, VertexFormat vertexFormat, MeshArena* meshArena)
+		: _device{ device }, _meshArena{ meshArena }, _vertexFormat{ vertexFormat }
+	{
+		const uint32_t vertexCount = static_cast<uint32_t>(builder.vertices.size());
+		if (vertexFormat == VertexFormat::Quantized)
+		{
+			std::vector<QuantizedVertex> quantizedVertices;
+			_positionQuantization = QuantizeVertices(builder, quantizedVertices);
+			CreateVertexBuffers(quantizedVertices.data(), vertexCount, sizeof(QuantizedVertex));
+		}
+		else
+		{
+			CreateVertexBuffers(builder.vertices.data(), vertexCount, sizeof(Vertex));
+		}
+
+		// 16 bit indices halve the index bandwidth whenever every vertex can be addressed with them
+		const uint32_t indexCount = static_cast<uint32_t>(builder.indices.size());
+		if (_vertexCount <= MAX_UINT16_VERTEX_COUNT && _meshArena == nullptr)
+		{
+			std::vector<uint16_t> shortIndices(builder.indices.begin(), builder.indices.end());
+			CreateIndexBuffers(shortIndices.data(), indexCount, VK_INDEX_TYPE_UINT16);
+		}
+		else
+		{
+			CreateIndexBuffers(builder.indices.data(), indexCount, VK_INDEX_TYPE_UINT32);
+		}
+
+		ComputeBounds(builder.vertices, _boundingBox, _boundingSphere);
+		_submeshes = builder.submeshes;
+		SetLods(builder.lods.data(), static_cast<uint32_t>(builder.lods.size()));
+	}
+
+	Model::Model(Device& device, const MeshFile& meshFile, MeshArena* meshArena)
+		: _device{ device }, _meshArena{ meshArena }, _vertexFormat{ meshFile.GetVertexFormat() },
+		_positionQuantization{ meshFile.GetPositionQuantization() }
+	{
+		// The format and stride were checked when the file was opened
+		CreateVertexBuffers(meshFile.GetVertices(), meshFile.GetVertexCount(), meshFile.GetHeader().vertexStride);
+		CreateIndexBuffers(meshFile.GetIndices(), meshFile.GetIndexCount(),
+			meshFile.GetIndexSize() == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32);
+
+		const MeshFileBounds& bounds = meshFile.GetBounds();
+		_boundingBox.min = { bounds.boxMin[0], bounds.boxMin[1], bounds.boxMin[2] };
+		_boundingBox.max = { bounds.boxMax[0], bounds.boxMax[1], bounds.boxMax[2] };
+		_boundingSphere.center = { bounds.sphereCenter[0], bounds.sphereCenter[1], bounds.sphereCenter[2] };
+		_boundingSphere.radius = bounds.sphereRadius;
+
+		_submeshes.assign(meshFile.GetSubmeshes(), meshFile.GetSubmeshes() + meshFile.GetSubmeshCount());
+		SetLods(meshFile.GetLods(), meshFile.GetLodCount());
+	}
+
+	std::unique_ptr<Model> Model::LoadFromFile(Device& device, const std::string& filepath, MeshArena* meshArena)
+	{
+		// The upload copies out of the mapping before returning, the file can be unmapped right after
+		MeshFile meshFile{ filepath };
+		return std::make_unique<Model>(device, meshFile, meshArena);
 	}
 
 	Model::~Model()
 	{
-		vkDestroyBuffer(_device.GetDevice(), _vertexBuffer, nullptr);
-		vkFreeMemory(_device.GetDevice(), _vertexBufferMemory, nullptr);
+		// The buffer may still be the destination of an in flight copy
+		if (!_isResident)
+		{
+			_device.GetUploadService().Wait(_uploadTicket);
+		}
+
+		if (_meshArena != nullptr)
+		{
+			_meshArena->FreeVertices(_vertexRange);
+			_meshArena->FreeIndices(_indexRange);
+			return;
+		}
+
+		_device.DestroyBuffer(_vertexBuffer, _vertexBufferAllocation);
+
+		if (_hasIndexBuffer)
+		{
+			_device.DestroyBuffer(_indexBuffer, _indexBufferAllocation);
+		}
 	}
 
-	void Model::CreateVertexBuffers(const std::vector<Vertex>& vertices)
+	void Model::CreateVertexBuffers(const void* vertices, uint32_t vertexCount, uint32_t vertexStride)
 	{
-		_vertexCount = static_cast<uint32_t>(vertices.size());
+		_vertexCount = vertexCount;
 		assert(_vertexCount >= 3 && "Vertex count must be at least 3");
-		VkDeviceSize bufferSize = sizeof(vertices[0]) * _vertexCount;
+		VkDeviceSize bufferSize = static_cast<VkDeviceSize>(vertexStride) * _vertexCount;
+
+		if (_meshArena != nullptr)
+		{
+			_vertexRange = _meshArena->AllocateVertices(_vertexCount, vertexStride);
+			_vertexOffset = static_cast<uint32_t>(_vertexRange.offset / vertexStride);
+			_uploadTicket = _device.GetUploadService().Upload(_meshArena->GetVertexBuffer(), _vertexRange.offset, vertices, bufferSize);
+			return;
+		}
 
 		_device.CreateBuffer(
 			bufferSize, 
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
 			_vertexBuffer, 
-			_vertexBufferMemory);
+			_vertexBufferAllocation);
+
+		// The copy is batched with the other pending uploads, it is submitted on the next flush
+		_uploadTicket = _device.GetUploadService().Upload(_vertexBuffer, 0, vertices, bufferSize);
+	}
+
+	void Model::CreateIndexBuffers(const void* indices, uint32_t indexCount, VkIndexType indexType)
+	{
+		_indexCount = indexCount;
+		_hasIndexBuffer = _indexCount > 0;
+
+		if (!_hasIndexBuffer)
+		{
+			return;
+		}
+
+		if (_meshArena != nullptr)
+		{
+			AllocateIndices(indices, indexCount, indexType);
+			return;
+		}
 
-		void* data;
-		vkMapMemory(_device.GetDevice(), _vertexBufferMemory, 0, bufferSize, 0, &data);
-		memcpy(data, vertices.data(), static_cast<size_t>(bufferSize));
-		vkUnmapMemory(_device.GetDevice(), _vertexBufferMemory);
+		_indexType = indexType;
+		VkDeviceSize bufferSize = (indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t)) * static_cast<VkDeviceSize>(_indexCount);
+
+		_device.CreateBuffer(
+			bufferSize,
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			_indexBuffer,
+			_indexBufferAllocation);
+
+		// Tickets grow with each batch, the model is resident once the latest one completes
+		_uploadTicket = std::max(_uploadTicket, _device.GetUploadService().Upload(_indexBuffer, 0, indices, bufferSize));
+	}
+
+	void Model::AllocateIndices(const void* indices, uint32_t indexCount, VkIndexType indexType)
+	{
+		std::vector<uint32_t> wideIndices;
+		if (indexType == VK_INDEX_TYPE_UINT16)
+		{
+			const uint16_t* shortIndices = static_cast<const uint16_t*>(indices);
+			wideIndices.assign(shortIndices, shortIndices + indexCount);
+			indices = wideIndices.data();
+		}
+
+		_indexType = MeshArena::INDEX_TYPE;
+		_indexRange = _meshArena->AllocateIndices(indexCount);
+		_firstIndex = static_cast<uint32_t>(_indexRange.offset / sizeof(uint32_t));
+
+		// The upload copies into the staging ring before returning, the widened indices can go
+		_uploadTicket = std::max(_uploadTicket, _device.GetUploadService().Upload(_meshArena->GetIndexBuffer(), _indexRange.offset, indices, _indexRange.size));
+	}
+
+	void Model::SetLods(const Lod* lods, uint32_t lodCount)
+	{
+		assert(lodCount < MAX_LOD_COUNT && "Too many LODs");
+		assert((lodCount == 0 || _hasIndexBuffer) && "Only models with indices have LODs");
+
+		if (lodCount > 0)
+		{
+			_indexCount = lods[0].firstIndex;
+		}
+
+		_lods.assign(1, Lod{ 0, _hasIndexBuffer ? _indexCount : _vertexCount, 0.0f });
+		_lods.insert(_lods.end(), lods, lods + lodCount);
+	}
+
+	void Model::ComputeBounds(const std::vector<Vertex>& vertices, BoundingBox& boundingBox, BoundingSphere& boundingSphere)
+	{
+		if (vertices.empty())
+		{
+			boundingBox = {};
+			boundingSphere = {};
+			return;
+		}
+
+		boundingBox.min = vertices[0].position;
+		boundingBox.max = vertices[0].position;
+		for (const Vertex& vertex : vertices)
+		{
+			boundingBox.min = glm::min(boundingBox.min, vertex.position);
+			boundingBox.max = glm::max(boundingBox.max, vertex.position);
+		}
+
+		// Centered on the box, not minimal but a single pass and tight for most meshes
+		boundingSphere.center = (boundingBox.min + boundingBox.max) * 0.5f;
+		float radiusSquared = 0.0f;
+		for (const Vertex& vertex : vertices)
+		{
+			glm::vec3 offset = vertex.position - boundingSphere.center;
+			radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+		}
+		boundingSphere.radius = std::sqrt(radiusSquared);
+	}
+
+	PositionQuantization Model::QuantizeVertices(const Builder& builder, std::vector<QuantizedVertex>& vertices)
+	{
+		BoundingBox boundingBox;
+		BoundingSphere boundingSphere;
+		ComputeBounds(builder.vertices, boundingBox, boundingSphere);
+		PositionQuantization quantization = PositionQuantization::FromBounds(boundingBox.min, boundingBox.max);
+
+		vertices.resize(builder.vertices.size());
+		for (size_t i = 0; i < vertices.size(); ++i)
+		{
+			vertices[i] = QuantizeVertex({ builder.vertices[i].position, builder.vertices[i].color }, quantization);
+		}
+		return quantization;
+	}
+
+	bool Model::IsResident()
+	{
+		if (!_isResident)
+		{
+			_isResident = _device.GetUploadService().IsComplete(_uploadTicket);
+		}
+
+		return _isResident;
 	}
 
 	void Model::Bind(VkCommandBuffer commandBuffer)
 	{
+		if (_meshArena != nullptr)
+		{
+			_meshArena->Bind(commandBuffer);
+			return;
+		}
+
 		VkBuffer buffers[] = { _vertexBuffer };
 		VkDeviceSize offsets[] = { 0 };
 		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+
+		if (_hasIndexBuffer)
+		{
+			vkCmdBindIndexBuffer(commandBuffer, _indexBuffer, 0, _indexType);
+		}
+	}
+
+	void Model::Draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance, uint32_t lod)
+	{
+		assert(lod < _lods.size() && "LOD out of range");
+		if (_hasIndexBuffer)
+		{
+			const Lod& level = _lods[lod];
+			vkCmdDrawIndexed(commandBuffer, level.indexCount, instanceCount, _firstIndex + level.firstIndex, static_cast<int32_t>(_vertexOffset), firstInstance);
+		}
+		else
+		{
+			vkCmdDraw(commandBuffer, _vertexCount, instanceCount, _vertexOffset, firstInstance);
+		}
+	}
+
+	void Model::Bind(DrawCommandBuffer& commandBuffer)
+	{
+		if (_meshArena != nullptr)
+		{
+			commandBuffer.BindVertexBuffer(0, _meshArena->GetVertexBuffer());
+			commandBuffer.BindIndexBuffer(_meshArena->GetIndexBuffer(), 0, MeshArena::INDEX_TYPE);
+			return;
+		}
+
+		commandBuffer.BindVertexBuffer(0, _vertexBuffer);
+		if (_hasIndexBuffer)
+		{
+			commandBuffer.BindIndexBuffer(_indexBuffer, 0, _indexType);
+		}
 	}
 
-	void Model::Draw(VkCommandBuffer commandBuffer)
+	void Model::Draw(DrawCommandBuffer& commandBuffer, uint32_t instanceCount, uint32_t firstInstance, uint32_t lod)
 	{
-		vkCmdDraw(commandBuffer, _vertexCount, 1, 0, 0);
+		assert(lod < _lods.size() && "LOD out of range");
+		if (_hasIndexBuffer)
+		{
+			const Lod& level = _lods[lod];
+			commandBuffer.DrawIndexed(level.indexCount, instanceCount, _firstIndex + level.firstIndex, static_cast<int32_t>(_vertexOffset), firstInstance);
+		}
+		else
+		{
+			commandBuffer.Draw(_vertexCount, instanceCount, _vertexOffset, firstInstance);
+		}
 	}
 
 	std::vector<VkVertexInputBindingDescription> Model::Vertex::GetBindingDescriptions()
 	{
-		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
-		bindingDescriptions[0].binding = 0;
-		bindingDescriptions[0].stride = sizeof(Vertex);
-		bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-		return bindingDescriptions;
+		return POSITION_COLOR_VERTEX_LAYOUT.GetBindingDescriptions();
 	}
 
 	std::vector<VkVertexInputAttributeDescription> Model::Vertex::GetAttributeDescriptions()
 	{
-		std::vector<VkVertexInputAttributeDescription> attributeDescriptions(2);
-		attributeDescriptions[0].binding = 0;
-		attributeDescriptions[0].location = 0;
-		attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-		attributeDescriptions[0].offset = offsetof(Vertex, position);
-
-		attributeDescriptions[1].binding = 0;
-		attributeDescriptions[1].location = 1;
-		attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-		attributeDescriptions[1].offset = offsetof(Vertex, color);
-		return attributeDescriptions;
+		return POSITION_COLOR_VERTEX_LAYOUT.GetAttributeDescriptions();
+	}
+
+	uint32_t Model::GetVertexStride(VertexFormat vertexFormat)
+	{
+		return vertexFormat == VertexFormat::Quantized ? QUANTIZED_VERTEX_LAYOUT.GetStride() : POSITION_COLOR_VERTEX_LAYOUT.GetStride();
+	}
+
+	std::vector<VkVertexInputBindingDescription> Model::GetBindingDescriptions(VertexFormat vertexFormat)
+	{
+		return vertexFormat == VertexFormat::Quantized ? QUANTIZED_VERTEX_LAYOUT.GetBindingDescriptions() : POSITION_COLOR_VERTEX_LAYOUT.GetBindingDescriptions();
+	}
+
+	std::vector<VkVertexInputAttributeDescription> Model::GetAttributeDescriptions(VertexFormat vertexFormat)
+	{
+		return vertexFormat == VertexFormat::Quantized ? QUANTIZED_VERTEX_LAYOUT.GetAttributeDescriptions() : POSITION_COLOR_VERTEX_LAYOUT.GetAttributeDescriptions();
 	}
 } // namespace DaisyEngine
\ No newline at end of file
@@ -2,6 +2,10 @@
 
 // Includes
 #include "Device.hpp"
+#include "DrawCommandBuffer.hpp"
+#include "MeshArena.hpp"
+#include "UploadService.hpp"
+#include "VertexFormat.hpp"
 
 // Libs
 #define GLM_FORCE_RADIANS
@@ -9,10 +13,33 @@
 #include <glm/glm.hpp>
 
 // Std
+#include <atomic>
+#include <memory>
+#include <string>
 #include <vector>
 
 namespace DaisyEngine
 {
+	class MeshFile;
+
+	/// <summary>
+	/// The BoundingBox struct is an axis aligned box in model space.
+	/// </summary>
+	struct BoundingBox
+	{
+		glm::vec3 min{};
+		glm::vec3 max{};
+	};
+
+	/// <summary>
+	/// The BoundingSphere struct encloses every vertex of a model, in model space.
+	/// </summary>
+	struct BoundingSphere
+	{
+		glm::vec3 center{};
+		float radius = 0.0f;
+	};
+
 	class Model
 	{
 	public:
@@ -23,26 +50,145 @@ namespace DaisyEngine
 
 			static std::vector<VkVertexInputBindingDescription> GetBindingDescriptions();
 			static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions();
+
+			bool operator==(const Vertex& other) const
+			{
+				return position == other.position && color == other.color;
+			}
 		};
 
+		/// <summary>
+		/// The Submesh struct is a range of the index buffer, or of the vertices without indices, typically one per material.
+		/// </summary>
+		struct Submesh
+		{
+			uint32_t firstIndex = 0;
+			uint32_t indexCount = 0;
+		};
+
+		/// <summary>
+		/// The Lod struct is a level of detail of the mesh, a range of the index buffer drawing the same vertices with fewer
+		/// triangles. Level 0 is the mesh itself with an error of 0, the coarser levels are built offline by BuildLods.
+		/// </summary>
+		struct Lod
+		{
+			uint32_t firstIndex = 0;
+			uint32_t indexCount = 0;
+			float error = 0.0f; // Largest distance the surface may have moved, in model units
+		};
+
+		/// <summary>
+		/// The Builder struct holds the geometry a Model is created from. Without indices the vertices are drawn as a plain triangle list.
+		/// </summary>
+		struct Builder
+		{
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			std::vector<Submesh> submeshes{}; // Empty when the whole mesh is a single part
+			std::vector<Lod> lods{}; // Coarser levels, ranges of indices after the ones of the mesh, finest first
+
+			// Merges identical vertices and rewrites the indices to reference the unique ones
+			void WeldVertices();
+
+			// The indices of the mesh itself, the ones of the LODs follow them
+			size_t GetMeshIndexCount() const;
+		};
+
+		// --- Constants --- //
+		static constexpr uint32_t MAX_UINT16_VERTEX_COUNT = 65535;
+		static constexpr uint32_t MAX_LOD_COUNT = 8; // Including the mesh itself
+
 		// --- Constructor & Destructor --- //
-		Model(Device& device, const std::vector<Vertex>& vertices);
+		// With a mesh arena the geometry is a range of its buffers instead of buffers of its own, indices are then 32 bit
+		Model(Device& device, const Builder& builder, VertexFormat vertexFormat = VertexFormat::PositionColor, MeshArena* meshArena = nullptr);
+		// The sections of the file are copied from its mapping into the staging ring, nothing is parsed
+		Model(Device& device, const MeshFile& meshFile, MeshArena* meshArena = nullptr);
 		~Model();
 
+		static std::unique_ptr<Model> LoadFromFile(Device& device, const std::string& filepath, MeshArena* meshArena = nullptr);
+
+		// The box of the vertex positions and a sphere centered on it, an empty box and a sphere of radius 0 at the origin without vertices
+		static void ComputeBounds(const std::vector<Vertex>& vertices, BoundingBox& boundingBox, BoundingSphere& boundingSphere);
+
+		// Encodes the vertices of the builder in the box of its positions
+		static PositionQuantization QuantizeVertices(const Builder& builder, std::vector<QuantizedVertex>& vertices);
+
+		static uint32_t GetVertexStride(VertexFormat vertexFormat);
+		static std::vector<VkVertexInputBindingDescription> GetBindingDescriptions(VertexFormat vertexFormat);
+		static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions(VertexFormat vertexFormat);
+
 		Model(const Model&) = delete;
 		Model& operator=(const Model&) = delete;
 
 		void Bind(VkCommandBuffer commandBuffer);
-		void Draw(VkCommandBuffer commandBuffer);
+		void Draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0, uint32_t lod = 0);
+		// The same through a DrawCommandBuffer, a model sharing the buffers of the previous one binds nothing
+		void Bind(DrawCommandBuffer& commandBuffer);
+		void Draw(DrawCommandBuffer& commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0, uint32_t lod = 0);
+
+		inline const BoundingBox& GetBoundingBox() const { return _boundingBox; }
+		inline const BoundingSphere& GetBoundingSphere() const { return _boundingSphere; }
+		inline const std::vector<Submesh>& GetSubmeshes() const { return _submeshes; }
+		inline bool HasIndexBuffer() const { return _hasIndexBuffer; }
+		inline uint32_t GetIndexCount() const { return _indexCount; }
+		inline uint32_t GetVertexCount() const { return _vertexCount; }
+		// At least one level, the mesh itself. Models without indices have no other
+		inline uint32_t GetLodCount() const { return static_cast<uint32_t>(_lods.size()); }
+		inline const Lod& GetLod(uint32_t lod) const { return _lods[lod]; }
+		inline uint32_t GetTriangleCount(uint32_t lod = 0) const { return _lods[lod].indexCount / 3; }
+		// Null when the model owns its buffers
+		inline MeshArena* GetMeshArena() const { return _meshArena; }
+		// Where the geometry starts in the bound buffers, 0 for a model with its own buffers. The vertex offset is added to
+		// every index, or is the first vertex without indices
+		inline uint32_t GetFirstIndex() const { return _firstIndex; }
+		inline uint32_t GetVertexOffset() const { return _vertexOffset; }
+		inline VertexFormat GetVertexFormat() const { return _vertexFormat; }
+		// Identity unless the format is quantized, the shader applies it to the vertex positions
+		inline const PositionQuantization& GetPositionQuantization() const { return _positionQuantization; }
+
+		// The geometry can only be drawn once its upload has completed, safe to call from several recording threads
+		bool IsResident();
 
 	private:
 		// --- Methods --- //
-		void CreateVertexBuffers(const std::vector<Vertex>& vertices);
+		void CreateVertexBuffers(const void* vertices, uint32_t vertexCount, uint32_t vertexStride);
+		void CreateIndexBuffers(const void* indices, uint32_t indexCount, VkIndexType indexType);
+		// The arena only holds 32 bit indices, 16 bit ones are widened first
+		void AllocateIndices(const void* indices, uint32_t indexCount, VkIndexType indexType);
+		// Once the index buffer is created, the indices before the first LOD are the mesh itself
+		void SetLods(const Lod* lods, uint32_t lodCount);
 
 		// --- Variables --- //
 		Device& _device;
-		VkBuffer _vertexBuffer;
-		VkDeviceMemory _vertexBufferMemory;
+		MeshArena* _meshArena = nullptr;
+		MeshArena::Range _vertexRange;
+		MeshArena::Range _indexRange;
+		uint32_t _firstIndex = 0;
+		uint32_t _vertexOffset = 0;
+
+		VkBuffer _vertexBuffer = VK_NULL_HANDLE;
+		Allocation _vertexBufferAllocation;
 		uint32_t _vertexCount;
+		VertexFormat _vertexFormat = VertexFormat::PositionColor;
+		PositionQuantization _positionQuantization;
+
+		bool _hasIndexBuffer = false;
+		VkBuffer _indexBuffer = VK_NULL_HANDLE;
+		Allocation _indexBufferAllocation;
+		uint32_t _indexCount = 0;
+		VkIndexType _indexType = VK_INDEX_TYPE_UINT32;
+
+		BoundingBox _boundingBox;
+		BoundingSphere _boundingSphere;
+		std::vector<Submesh> _submeshes;
+		std::vector<Lod> _lods;
+
+		UploadService::Ticket _uploadTicket = 0;
+		std::atomic<bool> _isResident = false;
 	};
-}
\ No newline at end of file
+
+	static constexpr auto POSITION_COLOR_VERTEX_LAYOUT = MakeVertexLayout<Model::Vertex>(
+		VertexElement{ VertexAttribute::Position, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Model::Vertex, position) },
+		VertexElement{ VertexAttribute::Color, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Model::Vertex, color) });
+	static_assert(POSITION_COLOR_VERTEX_LAYOUT.IsValid(), "Model::Vertex members do not match their formats");
+}
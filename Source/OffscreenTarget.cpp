@@ -0,0 +1,276 @@
+#include "OffscreenTarget.hpp"
+#include "CpuProfiler.hpp"
+
+// std
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace DaisyEngine
+{
+	OffscreenTarget::OffscreenTarget(Device& device, VkExtent2D extent)
+		: _device(device), _extent(extent)
+	{
+		_depthFormat = _device.FindSupportedFormat(
+			{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+
+		_renderPass = CreateRenderPass(false);
+		_loadRenderPass = CreateRenderPass(true);
+		CreateFrames();
+	}
+
+	OffscreenTarget::~OffscreenTarget()
+	{
+		for (Frame& frame : _frames)
+		{
+			vkDestroyFence(_device.GetDevice(), frame.fence, nullptr);
+			vkDestroyFramebuffer(_device.GetDevice(), frame.framebuffer, nullptr);
+			vkDestroyImageView(_device.GetDevice(), frame.depthView, nullptr);
+			_device.DestroyImage(frame.depthImage, frame.depthAllocation);
+			vkDestroyImageView(_device.GetDevice(), frame.colorView, nullptr);
+			_device.DestroyImage(frame.colorImage, frame.colorAllocation);
+		}
+
+		vkDestroyRenderPass(_device.GetDevice(), _renderPass, nullptr);
+		vkDestroyRenderPass(_device.GetDevice(), _loadRenderPass, nullptr);
+	}
+
+	VkResult OffscreenTarget::AcquireNextImage(uint32_t* imageIndex)
+	{
+		DAISY_PROFILE_FUNCTION();
+
+		// There is no presentation engine handing images back, frame N always renders into image N
+		vkWaitForFences(_device.GetDevice(), 1, &_frames[_currentFrame].fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+		*imageIndex = _currentFrame;
+		return VK_SUCCESS;
+	}
+
+	VkResult OffscreenTarget::SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex)
+	{
+		DAISY_PROFILE_FUNCTION();
+
+		Frame& frame = _frames[*imageIndex];
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = buffers;
+
+		vkResetFences(_device.GetDevice(), 1, &frame.fence);
+		VkResult result = vkQueueSubmit(_device.GetGraphicsQueue(), 1, &submitInfo, frame.fence);
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to submit offscreen command buffer!");
+		}
+
+		_currentFrame = (_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+		return result;
+	}
+
+	void OffscreenTarget::ReadPixels(uint32_t imageIndex, std::vector<uint8_t>& pixels)
+	{
+		Frame& frame = _frames[imageIndex];
+		vkWaitForFences(_device.GetDevice(), 1, &frame.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+		VkDeviceSize size = static_cast<VkDeviceSize>(_extent.width) * _extent.height * 4;
+
+		VkBuffer readbackBuffer;
+		Allocation readbackAllocation;
+		_device.CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			readbackBuffer, readbackAllocation);
+
+		// The render pass leaves the color image in TRANSFER_SRC_OPTIMAL, it can be copied as is
+		VkCommandBuffer commandBuffer = _device.BeginSingleTimeCommands();
+
+		VkBufferImageCopy region{};
+		region.bufferOffset = 0;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { _extent.width, _extent.height, 1 };
+
+		vkCmdCopyImageToBuffer(commandBuffer, frame.colorImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer, 1, &region);
+
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = readbackBuffer;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+		_device.EndSingleTimeCommands(commandBuffer);
+
+		pixels.resize(static_cast<size_t>(size));
+		memcpy(pixels.data(), readbackAllocation.mappedData, static_cast<size_t>(size));
+
+		_device.DestroyBuffer(readbackBuffer, readbackAllocation);
+	}
+
+	VkRenderPass OffscreenTarget::CreateRenderPass(bool loadContents)
+	{
+		// The depth is stored, a depth pyramid may be built from it between two passes of the frame
+		VkAttachmentDescription depthAttachment{};
+		depthAttachment.format = _depthFormat;
+		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		depthAttachment.loadOp = loadContents ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.initialLayout = loadContents ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference depthAttachmentRef{};
+		depthAttachmentRef.attachment = 1;
+		depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		// Same layout as the swap chain render pass, except the image ends ready to be copied instead of presented
+		VkAttachmentDescription colorAttachment = {};
+		colorAttachment.format = COLOR_FORMAT;
+		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		colorAttachment.loadOp = loadContents ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		colorAttachment.initialLayout = loadContents ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+		VkAttachmentReference colorAttachmentRef = {};
+		colorAttachmentRef.attachment = 0;
+		colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		VkSubpassDescription subpass = {};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &colorAttachmentRef;
+		subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+		std::array<VkSubpassDependency, 2> dependencies = {};
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass = 0;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+		dependencies[0].srcAccessMask = 0;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		if (loadContents)
+		{
+			// What the previous pass of the frame wrote is loaded
+			dependencies[0].srcStageMask |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			dependencies[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			dependencies[0].dstAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+		}
+
+		// Makes the color writes visible to the readback copy
+		dependencies[1].srcSubpass = 0;
+		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
+		VkRenderPassCreateInfo renderPassInfo = {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		renderPassInfo.pAttachments = attachments.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+		renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+		renderPassInfo.pDependencies = dependencies.data();
+
+		VkRenderPass renderPass;
+		if (vkCreateRenderPass(_device.GetDevice(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create offscreen render pass!");
+		}
+
+		return renderPass;
+	}
+
+	void OffscreenTarget::CreateFrames()
+	{
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		for (Frame& frame : _frames)
+		{
+			frame.colorView = CreateAttachment(COLOR_FORMAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+				VK_IMAGE_ASPECT_COLOR_BIT, frame.colorImage, frame.colorAllocation);
+			frame.depthView = CreateAttachment(_depthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+				VK_IMAGE_ASPECT_DEPTH_BIT, frame.depthImage, frame.depthAllocation);
+
+			std::array<VkImageView, 2> attachments = { frame.colorView, frame.depthView };
+
+			VkFramebufferCreateInfo framebufferInfo = {};
+			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			framebufferInfo.renderPass = _renderPass;
+			framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+			framebufferInfo.pAttachments = attachments.data();
+			framebufferInfo.width = _extent.width;
+			framebufferInfo.height = _extent.height;
+			framebufferInfo.layers = 1;
+
+			if (vkCreateFramebuffer(_device.GetDevice(), &framebufferInfo, nullptr, &frame.framebuffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create offscreen framebuffer!");
+			}
+
+			if (vkCreateFence(_device.GetDevice(), &fenceInfo, nullptr, &frame.fence) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create offscreen frame fence!");
+			}
+		}
+	}
+
+	VkImageView OffscreenTarget::CreateAttachment(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect, VkImage& image, Allocation& allocation)
+	{
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent.width = _extent.width;
+		imageInfo.extent.height = _extent.height;
+		imageInfo.extent.depth = 1;
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = format;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = usage;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.flags = 0;
+
+		_device.CreateImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, allocation);
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.subresourceRange.aspectMask = aspect;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		VkImageView imageView;
+		if (vkCreateImageView(_device.GetDevice(), &viewInfo, nullptr, &imageView) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create offscreen image view!");
+		}
+
+		return imageView;
+	}
+} // namespace DaisyEngine
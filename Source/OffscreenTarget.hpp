@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Device.hpp"
+#include "RenderTarget.hpp"
+
+// std
+#include <array>
+#include <vector>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The OffscreenTarget class renders into a ring of color and depth images instead of a swap chain, one per frame in flight.
+	/// Nothing is presented: it only needs a graphics queue, so it runs on headless machines and software drivers.
+	/// </summary>
+	class OffscreenTarget : public RenderTarget
+	{
+	public:
+		// --- Constants ---
+		static constexpr VkFormat COLOR_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+		// --- Constructor/ Destructor ---
+		OffscreenTarget(Device& device, VkExtent2D extent);
+		~OffscreenTarget();
+
+		OffscreenTarget(const OffscreenTarget&) = delete;
+		OffscreenTarget& operator=(const OffscreenTarget&) = delete;
+
+		// --- Methods ---
+		VkFramebuffer GetFrameBuffer(int index) override { return _frames[index].framebuffer; }
+		VkRenderPass GetRenderPass() override { return _renderPass; }
+		VkRenderPass GetLoadRenderPass() override { return _loadRenderPass; }
+		VkImage GetDepthImage(int index) override { return _frames[index].depthImage; }
+		VkImageView GetDepthImageView(int index) override { return _frames[index].depthView; }
+		VkFormat GetDepthFormat() override { return _depthFormat; }
+		size_t GetImageCount() override { return _frames.size(); }
+		VkExtent2D GetSwapChainExtent() override { return _extent; }
+
+		VkResult AcquireNextImage(uint32_t* imageIndex) override;
+		VkResult SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex) override;
+
+		// Waits for the image to be rendered and copies it to pixels, tightly packed RGBA8 rows
+		void ReadPixels(uint32_t imageIndex, std::vector<uint8_t>& pixels);
+
+	private:
+		/// <summary>
+		/// The attachments and fence of one frame in flight.
+		/// </summary>
+		struct Frame
+		{
+			VkImage colorImage = VK_NULL_HANDLE;
+			Allocation colorAllocation{};
+			VkImageView colorView = VK_NULL_HANDLE;
+			VkImage depthImage = VK_NULL_HANDLE;
+			Allocation depthAllocation{};
+			VkImageView depthView = VK_NULL_HANDLE;
+			VkFramebuffer framebuffer = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE;
+		};
+
+		// --- Methods ---
+		// The load render pass keeps what the frame drew so far, both are compatible with the same framebuffers
+		VkRenderPass CreateRenderPass(bool loadContents);
+		void CreateFrames();
+		VkImageView CreateAttachment(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect, VkImage& image, Allocation& allocation);
+
+		// --- Variables ---
+		Device& _device;
+		VkExtent2D _extent;
+		VkFormat _depthFormat;
+		VkRenderPass _renderPass = VK_NULL_HANDLE;
+		VkRenderPass _loadRenderPass = VK_NULL_HANDLE;
+
+		std::array<Frame, MAX_FRAMES_IN_FLIGHT> _frames;
+		uint32_t _currentFrame = 0;
+	};
+} // namespace DaisyEngine
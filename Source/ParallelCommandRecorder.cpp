@@ -0,0 +1,112 @@
+#include "ParallelCommandRecorder.hpp"
+#include "CpuProfiler.hpp"
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace DaisyEngine
+{
+	ParallelCommandRecorder::ParallelCommandRecorder(Device& device, JobSystem& jobSystem)
+		: _device(device), _jobSystem(jobSystem), _taskSlotCount(jobSystem.GetWorkerCount())
+	{
+		CreateCommandPools();
+	}
+
+	ParallelCommandRecorder::~ParallelCommandRecorder()
+	{
+		// Destroying a pool frees its command buffers
+		for (std::vector<VkCommandPool>& framePools : _commandPools)
+		{
+			for (VkCommandPool commandPool : framePools)
+			{
+				vkDestroyCommandPool(_device.GetDevice(), commandPool, nullptr);
+			}
+		}
+	}
+
+	void ParallelCommandRecorder::Record(VkCommandBuffer primaryCommandBuffer, int frameIndex, const VkCommandBufferInheritanceInfo& inheritanceInfo, uint32_t taskCount, const RecordFunction& recordFunction)
+	{
+		DAISY_PROFILE_FUNCTION();
+		assert(taskCount <= _taskSlotCount && "Cannot record more tasks than there are task slots");
+
+		if (taskCount == 0)
+		{
+			return;
+		}
+
+		// One task per job, the calling thread records the first one and helps with the others
+		_jobSystem.ParallelFor(taskCount, 1, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t taskIndex = begin; taskIndex < end; ++taskIndex)
+				{
+					RecordTask(frameIndex, inheritanceInfo, taskIndex, recordFunction);
+				}
+			});
+
+		vkCmdExecuteCommands(primaryCommandBuffer, taskCount, _commandBuffers[frameIndex].data());
+	}
+
+	void ParallelCommandRecorder::CreateCommandPools()
+	{
+		QueueFamilyIndices queueFamilyIndices = _device.FindPhysicalQueueFamilies();
+
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		for (int frameIndex = 0; frameIndex < RenderTarget::MAX_FRAMES_IN_FLIGHT; ++frameIndex)
+		{
+			_commandPools[frameIndex].resize(_taskSlotCount);
+			_commandBuffers[frameIndex].resize(_taskSlotCount);
+
+			for (uint32_t taskIndex = 0; taskIndex < _taskSlotCount; ++taskIndex)
+			{
+				if (vkCreateCommandPool(_device.GetDevice(), &poolInfo, nullptr, &_commandPools[frameIndex][taskIndex]) != VK_SUCCESS)
+				{
+					throw std::runtime_error("Failed to create worker command pool!");
+				}
+
+				VkCommandBufferAllocateInfo allocInfo{};
+				allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+				allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+				allocInfo.commandPool = _commandPools[frameIndex][taskIndex];
+				allocInfo.commandBufferCount = 1;
+
+				if (vkAllocateCommandBuffers(_device.GetDevice(), &allocInfo, &_commandBuffers[frameIndex][taskIndex]) != VK_SUCCESS)
+				{
+					throw std::runtime_error("Failed to allocate secondary command buffer!");
+				}
+			}
+		}
+	}
+
+	void ParallelCommandRecorder::RecordTask(int frameIndex, const VkCommandBufferInheritanceInfo& inheritanceInfo, uint32_t taskIndex, const RecordFunction& recordFunction)
+	{
+		DAISY_PROFILE_ZONE("Record secondary command buffer");
+
+		// The fence of this frame was waited on in BeginFrame, nothing recorded from this pool is still in use
+		vkResetCommandPool(_device.GetDevice(), _commandPools[frameIndex][taskIndex], 0);
+
+		VkCommandBuffer commandBuffer = _commandBuffers[frameIndex][taskIndex];
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to begin recording secondary command buffer!");
+		}
+
+		// Exceptions are rethrown on the calling thread by the job system, once every task is done
+		recordFunction(taskIndex, commandBuffer);
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to record secondary command buffer!");
+		}
+	}
+} // namespace DaisyEngine
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Device.hpp"
+#include "RenderTarget.hpp"
+#include "JobSystem.hpp"
+
+// std
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The ParallelCommandRecorder class records secondary command buffers as jobs of the JobSystem.
+	/// A command pool can only be used by one thread at a time, so every task slot owns one pool per frame in flight
+	/// and resets it as a whole at the start of the frame instead of freeing command buffers one by one.
+	/// A task runs on a single worker, whichever it is, so its pool is never used by two threads at once.
+	/// </summary>
+	class ParallelCommandRecorder
+	{
+	public:
+		// Records the commands of one task, called on the worker thread running the task
+		using RecordFunction = std::function<void(uint32_t taskIndex, VkCommandBuffer commandBuffer)>;
+
+		// --- Constructor/ Destructor ---
+		// One task slot per worker of the job system
+		ParallelCommandRecorder(Device& device, JobSystem& jobSystem);
+		~ParallelCommandRecorder();
+
+		ParallelCommandRecorder(const ParallelCommandRecorder&) = delete;
+		ParallelCommandRecorder& operator=(const ParallelCommandRecorder&) = delete;
+
+		// --- Methods ---
+		// Records taskCount secondary command buffers in parallel, then executes them in task order in the primary command buffer.
+		// Must be called from a worker of the job system, usually worker 0
+		void Record(VkCommandBuffer primaryCommandBuffer, int frameIndex, const VkCommandBufferInheritanceInfo& inheritanceInfo, uint32_t taskCount, const RecordFunction& recordFunction);
+
+		inline uint32_t GetWorkerCount() const { return _taskSlotCount; }
+
+	private:
+		// --- Methods ---
+		void CreateCommandPools();
+		void RecordTask(int frameIndex, const VkCommandBufferInheritanceInfo& inheritanceInfo, uint32_t taskIndex, const RecordFunction& recordFunction);
+
+		// --- Variables ---
+		Device& _device;
+		JobSystem& _jobSystem;
+		uint32_t _taskSlotCount;
+
+		// Indexed by [frameIndex][taskIndex]
+		std::array<std::vector<VkCommandPool>, RenderTarget::MAX_FRAMES_IN_FLIGHT> _commandPools;
+		std::array<std::vector<VkCommandBuffer>, RenderTarget::MAX_FRAMES_IN_FLIGHT> _commandBuffers;
+	};
+} // namespace DaisyEngine
@@ -3,12 +3,25 @@
 #include "Model.hpp"
 
 #include <cassert>
+#include <chrono>
 #include <iostream>
-#include <fstream>
 #include <stdexcept>
 
 namespace DaisyEngine
 {
+	static void CreateShaderModule(Device& device, const MappedFile& code, VkShaderModule* shaderModule)
+	{
+		VkShaderModuleCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		createInfo.codeSize = code.Size();
+		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.Data());
+
+		if (vkCreateShaderModule(device.GetDevice(), &createInfo, nullptr, shaderModule) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create shader module");
+		}
+	}
+
 	Pipeline::Pipeline(Device& device, const std::string& vertexFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo)
 		: _device(device)
 	{
@@ -22,31 +35,6 @@ namespace DaisyEngine
 		vkDestroyPipeline(_device.GetDevice(), _graphicsPipeline, nullptr);
 	}
 
-	/// <summary>
-	/// Read a file and return a vector of characters
-	/// </summary>
-	/// <param name="filepath"></param>
-	/// <returns></returns>
-	std::vector<char> Pipeline::ReadFile(const std::string& filepath)
-	{
-		// Open the file at the end of the file (ate) and in binary mode
-		std::ifstream file(filepath, std::ios::ate | std::ios::binary);
-
-		if (!file.is_open())
-		{
-			throw std::runtime_error("Failed to open file: " + filepath);
-		}
-
-		// Get the size of the file (as we're at the end of the file, the position is the size)
-		size_t fileSize = static_cast<size_t>(file.tellg());
-		std::vector<char> buffer(fileSize);
-
-		file.seekg(0);
-		file.read(buffer.data(), fileSize);
-		file.close();
-		return buffer;
-	}
-
 	/// <summary>
 	/// Create a graphic pipeline
 	/// </summary>
@@ -59,8 +47,9 @@ namespace DaisyEngine
 		assert(configInfo.renderPass != VK_NULL_HANDLE 
 			&& "Cannot create graphics pipeline: no renderPass provided in configInfo");
 
-		auto vertexCode = ReadFile(vertexFilepath);
-		auto fragCode = ReadFile(fragFilepath);
+		// SPIR-V is read in place from the mapping, the driver copies it while creating the module
+		MappedFile vertexCode{ vertexFilepath };
+		MappedFile fragCode{ fragFilepath };
 
 		CreateShaderModule(vertexCode, &_vertexShaderModule);
 		CreateShaderModule(fragCode, &_fragShaderModule);
@@ -81,8 +70,8 @@ namespace DaisyEngine
 		shaderStages[1].pNext = nullptr;
 		shaderStages[1].pSpecializationInfo = nullptr;
 
-		std::vector<VkVertexInputBindingDescription> bindingDescriptions = Model::Vertex::GetBindingDescriptions();
-		std::vector<VkVertexInputAttributeDescription> attributeDescriptions = Model::Vertex::GetAttributeDescriptions();
+		const std::vector<VkVertexInputBindingDescription>& bindingDescriptions = configInfo.bindingDescriptions;
+		const std::vector<VkVertexInputAttributeDescription>& attributeDescriptions = configInfo.attributeDescriptions;
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
@@ -110,24 +99,21 @@ namespace DaisyEngine
 		pipelineInfo.basePipelineIndex = -1;
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-		if (vkCreateGraphicsPipelines(_device.GetDevice(), VK_NULL_HANDLE, 1,
+		auto start = std::chrono::high_resolution_clock::now();
+
+		if (vkCreateGraphicsPipelines(_device.GetDevice(), _device.GetPipelineCache(), 1,
 			&pipelineInfo, nullptr, &_graphicsPipeline) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to create graphics pipeline");
 		}
+
+		auto end = std::chrono::high_resolution_clock::now();
+		_device.RecordPipelineCreation(std::chrono::duration<double, std::milli>(end - start).count());
 	}
 
-	void Pipeline::CreateShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule)
+	void Pipeline::CreateShaderModule(const MappedFile& code, VkShaderModule* shaderModule)
 	{
-		VkShaderModuleCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = code.size();
-		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
-
-		if (vkCreateShaderModule(_device.GetDevice(), &createInfo, nullptr, shaderModule) != VK_SUCCESS)
-		{
-			throw std::runtime_error("Failed to create shader module");
-		}
+		DaisyEngine::CreateShaderModule(_device, code, shaderModule);
 	}
 
 	void Pipeline::Bind(VkCommandBuffer commandBuffer)
@@ -206,5 +192,48 @@ namespace DaisyEngine
 		configInfo.dynamicStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
 		configInfo.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
 		configInfo.dynamicStateInfo.flags = 0;
+
+		configInfo.bindingDescriptions = Model::Vertex::GetBindingDescriptions();
+		configInfo.attributeDescriptions = Model::Vertex::GetAttributeDescriptions();
+	}
+
+	ComputePipeline::ComputePipeline(Device& device, const std::string& computeFilepath, VkPipelineLayout pipelineLayout)
+		: _device(device)
+	{
+		assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline: no pipelineLayout provided");
+
+		MappedFile computeCode{ computeFilepath };
+		CreateShaderModule(_device, computeCode, &_computeShaderModule);
+
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineInfo.stage.module = _computeShaderModule;
+		pipelineInfo.stage.pName = "main";
+		pipelineInfo.layout = pipelineLayout;
+		pipelineInfo.basePipelineIndex = -1;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		if (vkCreateComputePipelines(_device.GetDevice(), _device.GetPipelineCache(), 1, &pipelineInfo, nullptr, &_computePipeline) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create compute pipeline");
+		}
+
+		auto end = std::chrono::high_resolution_clock::now();
+		_device.RecordPipelineCreation(std::chrono::duration<double, std::milli>(end - start).count());
+	}
+
+	ComputePipeline::~ComputePipeline()
+	{
+		vkDestroyShaderModule(_device.GetDevice(), _computeShaderModule, nullptr);
+		vkDestroyPipeline(_device.GetDevice(), _computePipeline, nullptr);
+	}
+
+	void ComputePipeline::Bind(VkCommandBuffer commandBuffer)
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _computePipeline);
 	}
 } // namespace DaisyEngine
\ No newline at end of file
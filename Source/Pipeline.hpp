@@ -4,6 +4,7 @@
 #include <vector>
 #include <vulkan/vulkan_core.h>
 #include "Device.hpp"
+#include "MappedFile.hpp"
 
 namespace DaisyEngine
 {
@@ -14,6 +15,8 @@ namespace DaisyEngine
 		PipelineConfigInfo(const PipelineConfigInfo&) = delete;
 		PipelineConfigInfo& operator=(const PipelineConfigInfo&) = delete;
 
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
 		VkPipelineViewportStateCreateInfo viewportInfo;
 		VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo;
 		VkPipelineRasterizationStateCreateInfo rasterizationInfo;
@@ -42,14 +45,13 @@ namespace DaisyEngine
 		Pipeline& operator=(const Pipeline&) = delete;
 
 		void Bind(VkCommandBuffer commandBuffer);
+		inline VkPipeline GetPipeline() const { return _graphicsPipeline; }
 		static void DefaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
 
 	private:
 		// --- Methods ---
-		static std::vector<char> ReadFile(const std::string& filepath);
-
 		void CreateGraphicPipeline(const std::string& vertexFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo);
-		void CreateShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
+		void CreateShaderModule(const MappedFile& code, VkShaderModule* shaderModule);
 
 		// --- Variables ---
 		Device& _device;
@@ -57,4 +59,25 @@ namespace DaisyEngine
 		VkShaderModule _vertexShaderModule;
 		VkShaderModule _fragShaderModule;
 	};
+
+	/// <summary>
+	/// The ComputePipeline class holds a compute shader and its pipeline, created through the pipeline cache like the graphics ones.
+	/// </summary>
+	class ComputePipeline
+	{
+	public:
+		ComputePipeline(Device& device, const std::string& computeFilepath, VkPipelineLayout pipelineLayout);
+		~ComputePipeline();
+
+		ComputePipeline(const ComputePipeline&) = delete;
+		ComputePipeline& operator=(const ComputePipeline&) = delete;
+
+		void Bind(VkCommandBuffer commandBuffer);
+
+	private:
+		// --- Variables ---
+		Device& _device;
+		VkPipeline _computePipeline;
+		VkShaderModule _computeShaderModule;
+	};
 }
\ No newline at end of file
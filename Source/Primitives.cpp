@@ -0,0 +1,236 @@
+#include "Primitives.hpp"
+
+// Libs
+#include <glm/gtc/constants.hpp>
+
+// std
+#include <cassert>
+#include <cmath>
+
+namespace DaisyEngine
+{
+	static Model::Builder CreateCube()
+	{
+		Model::Builder builder{};
+		builder.vertices = {
+
+			// left face (white)
+			{{-.5f, -.5f, -.5f}, {.9f, .9f, .9f}},
+			{{-.5f, .5f, .5f}, {.9f, .9f, .9f}},
+			{{-.5f, -.5f, .5f}, {.9f, .9f, .9f}},
+			{{-.5f, -.5f, -.5f}, {.9f, .9f, .9f}},
+			{{-.5f, .5f, -.5f}, {.9f, .9f, .9f}},
+			{{-.5f, .5f, .5f}, {.9f, .9f, .9f}},
+
+			// right face (yellow)
+			{{.5f, -.5f, -.5f}, {.8f, .8f, .1f}},
+			{{.5f, .5f, .5f}, {.8f, .8f, .1f}},
+			{{.5f, -.5f, .5f}, {.8f, .8f, .1f}},
+			{{.5f, -.5f, -.5f}, {.8f, .8f, .1f}},
+			{{.5f, .5f, -.5f}, {.8f, .8f, .1f}},
+			{{.5f, .5f, .5f}, {.8f, .8f, .1f}},
+
+			// top face (orange, remember y axis points down)
+			{{-.5f, -.5f, -.5f}, {.9f, .6f, .1f}},
+			{{.5f, -.5f, .5f}, {.9f, .6f, .1f}},
+			{{-.5f, -.5f, .5f}, {.9f, .6f, .1f}},
+			{{-.5f, -.5f, -.5f}, {.9f, .6f, .1f}},
+			{{.5f, -.5f, -.5f}, {.9f, .6f, .1f}},
+			{{.5f, -.5f, .5f}, {.9f, .6f, .1f}},
+
+			// bottom face (red)
+			{{-.5f, .5f, -.5f}, {.8f, .1f, .1f}},
+			{{.5f, .5f, .5f}, {.8f, .1f, .1f}},
+			{{-.5f, .5f, .5f}, {.8f, .1f, .1f}},
+			{{-.5f, .5f, -.5f}, {.8f, .1f, .1f}},
+			{{.5f, .5f, -.5f}, {.8f, .1f, .1f}},
+			{{.5f, .5f, .5f}, {.8f, .1f, .1f}},
+
+			// nose face (blue)
+			{{-.5f, -.5f, 0.5f}, {.1f, .1f, .8f}},
+			{{.5f, .5f, 0.5f}, {.1f, .1f, .8f}},
+			{{-.5f, .5f, 0.5f}, {.1f, .1f, .8f}},
+			{{-.5f, -.5f, 0.5f}, {.1f, .1f, .8f}},
+			{{.5f, -.5f, 0.5f}, {.1f, .1f, .8f}},
+			{{.5f, .5f, 0.5f}, {.1f, .1f, .8f}},
+
+			// tail face (green)
+			{{-.5f, -.5f, -0.5f}, {.1f, .8f, .1f}},
+			{{.5f, .5f, -0.5f}, {.1f, .8f, .1f}},
+			{{-.5f, .5f, -0.5f}, {.1f, .8f, .1f}},
+			{{-.5f, -.5f, -0.5f}, {.1f, .8f, .1f}},
+			{{.5f, -.5f, -0.5f}, {.1f, .8f, .1f}},
+			{{.5f, .5f, -0.5f}, {.1f, .8f, .1f}},
+
+		};
+
+		// Each face shares two corners between its triangles: 36 vertices become 24 unique ones
+		builder.WeldVertices();
+		return builder;
+	}
+
+	static glm::vec3 NormalColor(const glm::vec3& normal)
+	{
+		return normal * 0.5f + glm::vec3{ 0.5f };
+	}
+
+	// Triangles between two rows of segments + 1 vertices, the last vertex of a row repeats its first
+	static void AddQuadStrip(std::vector<uint32_t>& indices, uint32_t firstRow, uint32_t secondRow, uint32_t segmentCount = PRIMITIVE_SEGMENTS)
+	{
+		for (uint32_t segment = 0; segment < segmentCount; ++segment)
+		{
+			uint32_t a = firstRow + segment;
+			uint32_t b = secondRow + segment;
+			indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+		}
+	}
+
+	static void RemoveDegenerateTriangles(Model::Builder& builder)
+	{
+		size_t kept = 0;
+		for (size_t i = 0; i + 2 < builder.indices.size(); i += 3)
+		{
+			uint32_t a = builder.indices[i];
+			uint32_t b = builder.indices[i + 1];
+			uint32_t c = builder.indices[i + 2];
+			if (a != b && b != c && a != c)
+			{
+				builder.indices[kept++] = a;
+				builder.indices[kept++] = b;
+				builder.indices[kept++] = c;
+			}
+		}
+		builder.indices.resize(kept);
+	}
+
+	static Model::Builder CreateCylinder()
+	{
+		Model::Builder builder{};
+
+		// Side, two rows around the axis
+		for (uint32_t row = 0; row < 2; ++row)
+		{
+			for (uint32_t segment = 0; segment <= PRIMITIVE_SEGMENTS; ++segment)
+			{
+				float azimuth = glm::two_pi<float>() * static_cast<float>(segment % PRIMITIVE_SEGMENTS) / PRIMITIVE_SEGMENTS;
+				glm::vec3 normal{ std::cos(azimuth), 0.f, std::sin(azimuth) };
+				builder.vertices.push_back({ normal * 0.5f + glm::vec3{ 0.f, row == 0 ? -.5f : .5f, 0.f }, NormalColor(normal) });
+			}
+		}
+		AddQuadStrip(builder.indices, 0, PRIMITIVE_SEGMENTS + 1);
+
+		// Caps, fans around their center, colored like the top and bottom faces of the cube
+		for (uint32_t cap = 0; cap < 2; ++cap)
+		{
+			float y = cap == 0 ? -.5f : .5f;
+			glm::vec3 color = cap == 0 ? glm::vec3{ .9f, .6f, .1f } : glm::vec3{ .8f, .1f, .1f };
+
+			uint32_t center = static_cast<uint32_t>(builder.vertices.size());
+			builder.vertices.push_back({ { 0.f, y, 0.f }, color });
+			for (uint32_t segment = 0; segment < PRIMITIVE_SEGMENTS; ++segment)
+			{
+				float azimuth = glm::two_pi<float>() * static_cast<float>(segment) / PRIMITIVE_SEGMENTS;
+				builder.vertices.push_back({ { 0.5f * std::cos(azimuth), y, 0.5f * std::sin(azimuth) }, color });
+			}
+
+			for (uint32_t segment = 0; segment < PRIMITIVE_SEGMENTS; ++segment)
+			{
+				uint32_t a = center + 1 + segment;
+				uint32_t b = center + 1 + (segment + 1) % PRIMITIVE_SEGMENTS;
+				builder.indices.insert(builder.indices.end(), { center, cap == 0 ? b : a, cap == 0 ? a : b });
+			}
+		}
+
+		builder.WeldVertices();
+		return builder;
+	}
+
+	Model::Builder CreatePlane(uint32_t quadsPerSide)
+	{
+		assert(quadsPerSide >= 1 && "Too few quads for a plane");
+
+		const glm::vec3 color{ .6f, .6f, .6f };
+
+		Model::Builder builder{};
+		for (uint32_t z = 0; z <= quadsPerSide; ++z)
+		{
+			for (uint32_t x = 0; x <= quadsPerSide; ++x)
+			{
+				float u = static_cast<float>(x) / quadsPerSide;
+				float v = static_cast<float>(z) / quadsPerSide;
+				builder.vertices.push_back({ { u - .5f, 0.f, v - .5f }, color });
+			}
+		}
+
+		// The next row first, so the triangles face up
+		for (uint32_t z = 0; z < quadsPerSide; ++z)
+		{
+			AddQuadStrip(builder.indices, (z + 1) * (quadsPerSide + 1), z * (quadsPerSide + 1), quadsPerSide);
+		}
+		return builder;
+	}
+
+	Model::Builder CreateSphere(uint32_t segments, uint32_t rings)
+	{
+		assert(segments >= 3 && rings >= 2 && "Too few segments or rings for a sphere");
+
+		Model::Builder builder{};
+		for (uint32_t ring = 0; ring <= rings; ++ring)
+		{
+			float polar = glm::pi<float>() * static_cast<float>(ring) / rings;
+			for (uint32_t segment = 0; segment <= segments; ++segment)
+			{
+				float azimuth = glm::two_pi<float>() * static_cast<float>(segment % segments) / segments;
+				glm::vec3 normal{ std::sin(polar) * std::cos(azimuth), -std::cos(polar), std::sin(polar) * std::sin(azimuth) };
+
+				// The pole rows collapse to a single point, exactly, so welding merges them
+				if (ring == 0 || ring == rings)
+				{
+					normal = { 0.f, ring == 0 ? -1.f : 1.f, 0.f };
+				}
+
+				builder.vertices.push_back({ normal * 0.5f, NormalColor(normal) });
+			}
+		}
+
+		for (uint32_t ring = 0; ring < rings; ++ring)
+		{
+			AddQuadStrip(builder.indices, ring * (segments + 1), (ring + 1) * (segments + 1), segments);
+		}
+
+		// The seam and the poles share their positions and colors; the degenerate pole triangles go with the duplicates
+		builder.WeldVertices();
+		RemoveDegenerateTriangles(builder);
+		return builder;
+	}
+
+	Model::Builder CreatePrimitive(Primitive primitive)
+	{
+		switch (primitive)
+		{
+		case Primitive::Cube:
+			return CreateCube();
+		case Primitive::Sphere:
+			return CreateSphere(PRIMITIVE_SEGMENTS, PRIMITIVE_RINGS);
+		case Primitive::Plane:
+			return CreatePlane(1);
+		case Primitive::Cylinder:
+			return CreateCylinder();
+		default:
+			assert(false && "Unknown primitive");
+			return {};
+		}
+	}
+
+	const char* GetPrimitiveName(Primitive primitive)
+	{
+		switch (primitive)
+		{
+		case Primitive::Cube: return "cube";
+		case Primitive::Sphere: return "sphere";
+		case Primitive::Plane: return "plane";
+		case Primitive::Cylinder: return "cylinder";
+		default: return "unknown";
+		}
+	}
+} // namespace DaisyEngine
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Model.hpp"
+
+// std
+#include <cstdint>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The Primitive enum lists the built in shapes. Each fits the 1x1x1 cube centered on the origin and is welded, with its
+	/// colors baked in the vertices.
+	/// </summary>
+	enum class Primitive : uint32_t
+	{
+		Cube, // One color per face
+		Sphere, // Colored by its normal
+		Plane, // Horizontal, facing up (-y, the y axis points down)
+		Cylinder, // Along the y axis, the side colored by its normal, the caps flat
+		Count,
+	};
+
+	// --- Constants ---
+	static constexpr uint32_t PRIMITIVE_COUNT = static_cast<uint32_t>(Primitive::Count);
+	static constexpr uint32_t PRIMITIVE_SEGMENTS = 32; // Around the sphere and cylinder axis
+	static constexpr uint32_t PRIMITIVE_RINGS = 16; // From pole to pole of the sphere
+
+	// Builds the geometry of a primitive, a new builder each call
+	Model::Builder CreatePrimitive(Primitive primitive);
+	// The plane primitive split in quadsPerSide * quadsPerSide quads, the vertices in rows along x
+	Model::Builder CreatePlane(uint32_t quadsPerSide);
+	// The sphere primitive with another tessellation, segments around the axis and rings from pole to pole
+	Model::Builder CreateSphere(uint32_t segments, uint32_t rings);
+
+	const char* GetPrimitiveName(Primitive primitive);
+} // namespace DaisyEngine
@@ -0,0 +1,39 @@
+#pragma once
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The RenderTarget class is what the Renderer draws into: a ring of framebuffers sharing one render pass.
+	/// SwapChain presents them to a window surface, OffscreenTarget keeps them in memory for headless runs.
+	/// The depth images are stored at the end of the pass and can be sampled, a second compatible render pass loads the
+	/// color and depth instead of clearing them, to draw again into a frame once its depth has been read.
+	/// </summary>
+	class RenderTarget
+	{
+	public:
+		// --- Constants ---
+		static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+
+		virtual ~RenderTarget() = default;
+
+		// --- Methods ---
+		virtual VkFramebuffer GetFrameBuffer(int index) = 0;
+		virtual VkRenderPass GetRenderPass() = 0;
+		virtual VkRenderPass GetLoadRenderPass() = 0;
+		virtual VkImage GetDepthImage(int index) = 0;
+		virtual VkImageView GetDepthImageView(int index) = 0;
+		virtual VkFormat GetDepthFormat() = 0;
+		virtual size_t GetImageCount() = 0;
+		virtual VkExtent2D GetSwapChainExtent() = 0;
+
+		// Waits until the frame slot is free and returns the index of the image to render into
+		virtual VkResult AcquireNextImage(uint32_t* imageIndex) = 0;
+		virtual VkResult SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex) = 0;
+	};
+} // namespace DaisyEngine
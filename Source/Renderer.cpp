@@ -1,4 +1,6 @@
 #include "Renderer.hpp"
+#include "UploadService.hpp"
+#include "CpuProfiler.hpp"
 
 #include <stdexcept>
 #include <array>
@@ -7,11 +9,23 @@
 
 namespace DaisyEngine
 {
-	Renderer::Renderer(Window& window, Device& device)
-		: _window(window), _device(device)
+	Renderer::Renderer(Window& window, Device& device, JobSystem& jobSystem)
+		: _window(&window), _device(device)
 	{
 		RecreateSwapChain();
 		CreateCommandBuffers();
+		_commandRecorder = std::make_unique<ParallelCommandRecorder>(_device, jobSystem);
+		_gpuProfiler = std::make_unique<GpuProfiler>(_device);
+	}
+
+	Renderer::Renderer(Device& device, JobSystem& jobSystem, VkExtent2D extent)
+		: _device(device)
+	{
+		_offscreenTarget = std::make_unique<OffscreenTarget>(_device, extent);
+		_renderTarget = _offscreenTarget.get();
+		CreateCommandBuffers();
+		_commandRecorder = std::make_unique<ParallelCommandRecorder>(_device, jobSystem);
+		_gpuProfiler = std::make_unique<GpuProfiler>(_device);
 	}
 
 	Renderer::~Renderer()
@@ -25,11 +39,18 @@ namespace DaisyEngine
 		return _commandBuffers[_currentFrameIndex];
 	}
 
+	VkFramebuffer Renderer::GetCurrentFramebuffer() const
+	{
+		assert(_isFrameStarted && "Cannot get frame buffer when frame is not in progress.");
+		return _renderTarget->GetFrameBuffer(_currentImageIndex);
+	}
+
 	VkCommandBuffer Renderer::BeginFrame()
 	{
+		DAISY_PROFILE_FUNCTION();
 		assert(!_isFrameStarted && "Cannot call BeginFrame while frame is already in progress.");
 
-		VkResult result = _swapChain->AcquireNextImage(&_currentImageIndex);
+		VkResult result = _renderTarget->AcquireNextImage(&_currentImageIndex);
 		if (result == VK_ERROR_OUT_OF_DATE_KHR)
 		{
 			RecreateSwapChain();
@@ -44,6 +65,9 @@ namespace DaisyEngine
 
 		_isFrameStarted = true;
 
+		// Submit the uploads requested since the last frame, they complete while this frame is recorded
+		_device.GetUploadService().Flush();
+
 		VkCommandBuffer commandBuffer = GetCurrentCommandBuffer();
 
 		VkCommandBufferBeginInfo beginInfo{};
@@ -54,27 +78,34 @@ namespace DaisyEngine
 			throw std::runtime_error("Failed to begin recording command buffer!");
 		}
 
+		// The fence of this frame was waited on in AcquireNextImage, its previous queries can be read without stalling
+		_gpuProfiler->BeginFrame(commandBuffer, _currentFrameIndex);
+
 		return commandBuffer;
 	}
 
 	void Renderer::EndFrame()
 	{
+		DAISY_PROFILE_FUNCTION();
 		assert(_isFrameStarted && "Cannot call EndFrame while frame is not in progress.");
 
 		VkCommandBuffer commandBuffer = GetCurrentCommandBuffer();
+		_gpuProfiler->EndFrame(commandBuffer);
 
 		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to record command buffer!");
 		}
 
-		VkResult result = _swapChain->SubmitCommandBuffers(&commandBuffer, &_currentImageIndex);
+		VkResult result = _renderTarget->SubmitCommandBuffers(&commandBuffer, &_currentImageIndex);
+		_lastSubmittedImageIndex = _currentImageIndex;
 
-		if (result == VK_ERROR_OUT_OF_DATE_KHR
-			|| result == VK_SUBOPTIMAL_KHR
-			|| _window.WasWindowResized())
+		if (!IsHeadless()
+			&& (result == VK_ERROR_OUT_OF_DATE_KHR
+				|| result == VK_SUBOPTIMAL_KHR
+				|| _window->WasWindowResized()))
 		{
-			_window.ResetWindowResizedFlag();
+			_window->ResetWindowResizedFlag();
 			RecreateSwapChain();
 		}
 		else if (result != VK_SUCCESS)
@@ -83,22 +114,33 @@ namespace DaisyEngine
 		}
 
 		_isFrameStarted = false;
-		_currentFrameIndex = (_currentFrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+		_currentFrameIndex = (_currentFrameIndex + 1) % RenderTarget::MAX_FRAMES_IN_FLIGHT;
 	}
 
-	void Renderer::BeginSwapChainRenderPass(VkCommandBuffer commandBuffer)
+	void Renderer::BeginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents)
+	{
+		BeginRenderPass(commandBuffer, _renderTarget->GetRenderPass(), contents, "Main pass");
+	}
+
+	void Renderer::ResumeSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents)
+	{
+		// The load render pass ignores its clear values, they are given anyway
+		BeginRenderPass(commandBuffer, _renderTarget->GetLoadRenderPass(), contents, "Late pass");
+	}
+
+	void Renderer::BeginRenderPass(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkSubpassContents contents, const char* scopeName)
 	{
 		assert(_isFrameStarted && "Cannot begin render pass when frame is not in progress.");
-		assert(commandBuffer == GetCurrentCommandBuffer(), "Can only begin render pass for command buffer that was acquired this frame.");
+		assert(commandBuffer == GetCurrentCommandBuffer() && "Can only begin render pass for command buffer that was acquired this frame.");
 
 		// Begin Render Pass
 		VkRenderPassBeginInfo renderPassInfo{};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = _swapChain->GetRenderPass();
-		renderPassInfo.framebuffer = _swapChain->GetFrameBuffer(_currentImageIndex);
+		renderPassInfo.renderPass = renderPass;
+		renderPassInfo.framebuffer = _renderTarget->GetFrameBuffer(_currentImageIndex);
 
 		renderPassInfo.renderArea.offset = { 0, 0 };
-		renderPassInfo.renderArea.extent = _swapChain->GetSwapChainExtent();
+		renderPassInfo.renderArea.extent = _renderTarget->GetSwapChainExtent();
 
 		std::array<VkClearValue, 2> clearValues{};
 		clearValues[0].color = { 0.01f, 0.01f, 0.1f, 1.0f };
@@ -106,16 +148,23 @@ namespace DaisyEngine
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassInfo.pClearValues = clearValues.data();
 
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		// Queries cannot be started inside a subpass that only executes secondary command buffers, the scope wraps the whole pass
+		_mainPassScope = _gpuProfiler->BeginScope(commandBuffer, scopeName);
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+
+		if (contents != VK_SUBPASS_CONTENTS_INLINE)
+		{
+			return;
+		}
 
 		VkViewport viewport{};
 		viewport.x = 0.0f;
 		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(_swapChain->GetSwapChainExtent().width);
-		viewport.height = static_cast<float>(_swapChain->GetSwapChainExtent().height);
+		viewport.width = static_cast<float>(_renderTarget->GetSwapChainExtent().width);
+		viewport.height = static_cast<float>(_renderTarget->GetSwapChainExtent().height);
 		viewport.minDepth = 0.0f;
 		viewport.maxDepth = 1.0f;
-		VkRect2D scissor{ {0, 0}, _swapChain->GetSwapChainExtent() };
+		VkRect2D scissor{ {0, 0}, _renderTarget->GetSwapChainExtent() };
 		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 	}
@@ -123,9 +172,26 @@ namespace DaisyEngine
 	void Renderer::EndSwapChainRenderPass(VkCommandBuffer commandBuffer)
 	{
 		assert(_isFrameStarted && "Cannot begin render pass when frame is not in progress.");
-		assert(commandBuffer == GetCurrentCommandBuffer(), "Can only begin render pass for command buffer that was acquired this frame.");
+		assert(commandBuffer == GetCurrentCommandBuffer() && "Can only begin render pass for command buffer that was acquired this frame.");
 
 		vkCmdEndRenderPass(commandBuffer);
+		_gpuProfiler->EndScope(commandBuffer, _mainPassScope);
+		_mainPassScope = GpuProfiler::INVALID_SCOPE;
+	}
+
+	DepthPyramid& Renderer::BuildDepthPyramid(VkCommandBuffer commandBuffer)
+	{
+		assert(_isFrameStarted && "Cannot build the depth pyramid when frame is not in progress.");
+		assert(commandBuffer == GetCurrentCommandBuffer() && "Can only build the depth pyramid in the command buffer that was acquired this frame.");
+
+		if (_depthPyramid == nullptr)
+		{
+			_depthPyramid = std::make_unique<DepthPyramid>(_device, *_renderTarget);
+		}
+
+		GpuProfileScope scope(_gpuProfiler.get(), commandBuffer, "Depth pyramid", false);
+		_depthPyramid->Build(commandBuffer, _currentImageIndex);
+		return *_depthPyramid;
 	}
 
 	int Renderer::GetFrameIndex() const
@@ -134,17 +200,30 @@ namespace DaisyEngine
 		return _currentFrameIndex;
 	}
 
+	void Renderer::ReadbackLastFrame(std::vector<uint8_t>& pixels)
+	{
+		if (_offscreenTarget == nullptr)
+		{
+			throw std::runtime_error("Frame readback is only supported by headless renderers!");
+		}
+
+		_offscreenTarget->ReadPixels(_lastSubmittedImageIndex, pixels);
+	}
+
 	void Renderer::RecreateSwapChain()
 	{
-		VkExtent2D extent = _window.GetExtent();
+		VkExtent2D extent = _window->GetExtent();
 		while (extent.width == 0 || extent.height == 0)
 		{
-			extent = _window.GetExtent();
+			extent = _window->GetExtent();
 			glfwWaitEvents();
 		}
 
 		vkDeviceWaitIdle(_device.GetDevice());
 
+		// Built from the depth images of the old swap chain
+		_depthPyramid = nullptr;
+
 		if (_swapChain == nullptr)
 		{
 			_swapChain = std::make_unique<SwapChain>(_device, extent);
@@ -160,19 +239,20 @@ namespace DaisyEngine
 			}
 		}
 
+		_renderTarget = _swapChain.get();
+
 		// TODO
 	}
 
 	void Renderer::CreateCommandBuffers()
 	{
-		size_t imageCount = _swapChain->GetImageCount();
-		_commandBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+		_commandBuffers.resize(RenderTarget::MAX_FRAMES_IN_FLIGHT);
 
 		VkCommandBufferAllocateInfo allocateInfo{};
 		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 		allocateInfo.commandPool = _device.GetCommandPool();
-		allocateInfo.commandBufferCount = static_cast<uint32_t>(imageCount);
+		allocateInfo.commandBufferCount = static_cast<uint32_t>(_commandBuffers.size());
 
 		if (vkAllocateCommandBuffers(_device.GetDevice(), &allocateInfo, _commandBuffers.data()) != VK_SUCCESS)
 		{
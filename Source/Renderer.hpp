@@ -3,6 +3,10 @@
 #include "Window.hpp"
 #include "Device.hpp"
 #include "SwapChain.hpp"
+#include "OffscreenTarget.hpp"
+#include "ParallelCommandRecorder.hpp"
+#include "GpuProfiler.hpp"
+#include "DepthPyramid.hpp"
 
 // std
 #include <memory>
@@ -14,37 +18,64 @@ namespace DaisyEngine
 	{
 	public:
 		// --- Constructors / Destructors ---
-		Renderer(Window& window, Device& device);
+		// The job system records the secondary command buffers of the parallel render mode
+		Renderer(Window& window, Device& device, JobSystem& jobSystem);
+		// Headless renderer, draws into offscreen images of the given extent that are never presented
+		Renderer(Device& device, JobSystem& jobSystem, VkExtent2D extent);
 		~Renderer();
 
 		Renderer(const Renderer&) = delete;
 		Renderer& operator=(const Renderer&) = delete;
 
 		inline bool IsFrameInProgress() const { return _isFrameStarted; }
-		VkRenderPass GetSwapChainRenderPass() const { return _swapChain->GetRenderPass(); }
+		inline bool IsHeadless() const { return _window == nullptr; }
+		VkRenderPass GetSwapChainRenderPass() const { return _renderTarget->GetRenderPass(); }
 		VkCommandBuffer GetCurrentCommandBuffer() const;
+		VkFramebuffer GetCurrentFramebuffer() const;
+		VkExtent2D GetSwapChainExtent() const { return _renderTarget->GetSwapChainExtent(); }
+		size_t GetImageCount() const { return _renderTarget->GetImageCount(); }
+		inline ParallelCommandRecorder& GetCommandRecorder() { return *_commandRecorder; }
+		inline GpuProfiler& GetGpuProfiler() { return *_gpuProfiler; }
 
 		// --- Methods ---
 		VkCommandBuffer BeginFrame();
 		void EndFrame();
-		void BeginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+		// The pass is measured as the "Main pass" GPU profiler scope.
+		// With VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS the pass may only execute secondary command buffers, which set their own viewport and scissor
+		void BeginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 		void EndSwapChainRenderPass(VkCommandBuffer commandBuffer);
+		// Begins the pass again on the images of the frame, keeping what the previous pass drew. Measured as the "Late pass"
+		void ResumeSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+		// Between two passes of the frame: reduces the depth drawn so far. The pyramid is created on first use and again
+		// with the swap chain, a reference is only valid for the frame
+		DepthPyramid& BuildDepthPyramid(VkCommandBuffer commandBuffer);
 
 		int GetFrameIndex() const;
 
+		// Headless only: waits for the last submitted frame and copies its color image as tightly packed RGBA8 rows
+		void ReadbackLastFrame(std::vector<uint8_t>& pixels);
+
 	private:
 		void CreateCommandBuffers();
 		void FreeCommandBuffers();
 		void RecreateSwapChain();
+		void BeginRenderPass(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkSubpassContents contents, const char* scopeName);
 
 		// --- Variables ---
 		uint32_t _currentImageIndex{ 0 };
+		uint32_t _lastSubmittedImageIndex{ 0 };
 		int _currentFrameIndex{ 0 };
 		bool _isFrameStarted{ false };
 
-		Window& _window;
+		Window* _window = nullptr; // Null when headless
 		Device& _device;
 		std::unique_ptr<SwapChain> _swapChain;
+		std::unique_ptr<OffscreenTarget> _offscreenTarget;
+		RenderTarget* _renderTarget = nullptr; // Whichever of the two above is in use
+		std::unique_ptr<DepthPyramid> _depthPyramid; // Of the current render target, null until first built
 		std::vector<VkCommandBuffer> _commandBuffers;
+		std::unique_ptr<ParallelCommandRecorder> _commandRecorder;
+		std::unique_ptr<GpuProfiler> _gpuProfiler;
+		uint32_t _mainPassScope{ GpuProfiler::INVALID_SCOPE };
 	};
 } // namespace DaisyEngine
\ No newline at end of file
@@ -1,4 +1,10 @@
 #include "SimpleRenderSystem.hpp"
+#include "Model.hpp"
+#include "ParallelCommandRecorder.hpp"
+#include "GpuProfiler.hpp"
+#include "JobSystem.hpp"
+#include "LodSelector.hpp"
+#include "TransformBatch.hpp"
 
 // Libs
 #define GLM_FORCE_RADIANS
@@ -6,8 +12,12 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
 #include <stdexcept>
 #include <array>
+#include <cassert>
+#include <cstddef>
+#include <numeric>
 
 namespace DaisyEngine
 {
@@ -15,24 +25,50 @@ namespace DaisyEngine
 	{
 		glm::mat4 transform{ 1.0f };
 		alignas(16) glm::vec3 color;
+		alignas(16) glm::vec4 positionScale{ 1.0f }; // PositionQuantization of the model, identity for float positions
+		glm::vec4 positionBias{ 0.0f };
 	};
 
-	SimpleRenderSystem::SimpleRenderSystem(Device& device, VkRenderPass renderPass)
-		: _device(device)
+	// The transform and color change with every object, the quantization after them only with the model
+	static constexpr uint32_t QUANTIZATION_OFFSET = offsetof(SimplePushConstantData, positionScale);
+	static constexpr VkShaderStageFlags PUSH_CONSTANT_STAGES = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	static uint32_t GetLod(const FrameInfo& frameInfo, uint32_t object)
+	{
+		return frameInfo.lodSelector != nullptr ? frameInfo.lodSelector->GetLod(object) : 0;
+	}
+
+	static void SetPositionQuantization(SimplePushConstantData& push, const Model& model)
+	{
+		const PositionQuantization& quantization = model.GetPositionQuantization();
+		push.positionScale = glm::vec4(quantization.scale, 0.0f);
+		push.positionBias = glm::vec4(quantization.bias, 0.0f);
+	}
+
+	SimpleRenderSystem::SimpleRenderSystem(Device& device, VkRenderPass renderPass, RenderMode renderMode)
+		: _device(device), _renderMode(renderMode)
 	{
 		CreatePipelineLayout();
-		CreatePipeline(renderPass);
+		CreatePipelines(renderPass);
 	}
 
 	SimpleRenderSystem::~SimpleRenderSystem()
 	{
+		for (InstanceBuffer& instanceBuffer : _instanceBuffers)
+		{
+			if (instanceBuffer.buffer != VK_NULL_HANDLE)
+			{
+				_device.DestroyBuffer(instanceBuffer.buffer, instanceBuffer.allocation);
+			}
+		}
+
 		vkDestroyPipelineLayout(_device.GetDevice(), _pipelineLayout, nullptr);
 	}
 
 	void SimpleRenderSystem::CreatePipelineLayout()
 	{
 		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		pushConstantRange.stageFlags = PUSH_CONSTANT_STAGES;
 		pushConstantRange.offset = 0;
 		pushConstantRange.size = sizeof(SimplePushConstantData);
 
@@ -40,7 +76,7 @@ namespace DaisyEngine
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutInfo.setLayoutCount = 0;
 		pipelineLayoutInfo.pSetLayouts = nullptr;
-		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
 		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 
 		if (vkCreatePipelineLayout(_device.GetDevice(), &pipelineLayoutInfo, nullptr, &_pipelineLayout) != VK_SUCCESS)
@@ -49,42 +85,360 @@ namespace DaisyEngine
 		}
 	}
 
-	void SimpleRenderSystem::CreatePipeline(VkRenderPass renderPass)
+	void SimpleRenderSystem::CreatePipelines(VkRenderPass renderPass)
 	{
 		assert(_pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-		PipelineConfigInfo pipelineConfig = {};
-		Pipeline::DefaultPipelineConfigInfo(pipelineConfig);
-		pipelineConfig.renderPass = renderPass;
-		pipelineConfig.pipelineLayout = _pipelineLayout;
-		_pipeline = std::make_unique<Pipeline>(_device, "shaders/simple_shader.vert.spv", "shaders/simple_shader.frag.spv", pipelineConfig);
+		std::vector<VkVertexInputBindingDescription> instanceBindings = InstanceData::GetBindingDescriptions();
+		std::vector<VkVertexInputAttributeDescription> instanceAttributes = InstanceData::GetAttributeDescriptions();
+
+		// The shaders are shared by every vertex format, the vertex fetch converts the attributes to floats
+		for (uint32_t format = 0; format < VERTEX_FORMAT_COUNT; ++format)
+		{
+			VertexFormat vertexFormat = static_cast<VertexFormat>(format);
+
+			PipelineConfigInfo pipelineConfig = {};
+			Pipeline::DefaultPipelineConfigInfo(pipelineConfig);
+			pipelineConfig.renderPass = renderPass;
+			pipelineConfig.pipelineLayout = _pipelineLayout;
+			pipelineConfig.bindingDescriptions = Model::GetBindingDescriptions(vertexFormat);
+			pipelineConfig.attributeDescriptions = Model::GetAttributeDescriptions(vertexFormat);
+			_pipelines[format] = std::make_unique<Pipeline>(_device, "shaders/simple_shader.vert.spv", "shaders/simple_shader.frag.spv", pipelineConfig);
+
+			// Same shader compiled with INSTANCED, the instance data comes from a second vertex binding
+			PipelineConfigInfo instancedConfig = {};
+			Pipeline::DefaultPipelineConfigInfo(instancedConfig);
+			instancedConfig.renderPass = renderPass;
+			instancedConfig.pipelineLayout = _pipelineLayout;
+			instancedConfig.bindingDescriptions = pipelineConfig.bindingDescriptions;
+			instancedConfig.attributeDescriptions = pipelineConfig.attributeDescriptions;
+			instancedConfig.bindingDescriptions.insert(instancedConfig.bindingDescriptions.end(), instanceBindings.begin(), instanceBindings.end());
+			instancedConfig.attributeDescriptions.insert(instancedConfig.attributeDescriptions.end(), instanceAttributes.begin(), instanceAttributes.end());
+			_instancedPipelines[format] = std::make_unique<Pipeline>(_device, "shaders/simple_shader_instanced.vert.spv", "shaders/simple_shader.frag.spv", instancedConfig);
+		}
 	}
 
-	void SimpleRenderSystem::RenderGameObjects(VkCommandBuffer commandBuffer, std::vector<GameObject>& gameObjects)
+	void SimpleRenderSystem::RenderEntities(FrameInfo& frameInfo, const RenderView& entities)
 	{
-		_pipeline->Bind(commandBuffer);
+		if (_allEntities.size() != entities.Size())
+		{
+			_allEntities.resize(entities.Size());
+			std::iota(_allEntities.begin(), _allEntities.end(), 0u);
+		}
+
+		RenderEntities(frameInfo, entities, _allEntities);
+	}
+
+	void SimpleRenderSystem::RenderEntities(FrameInfo& frameInfo, const RenderView& entities, const std::vector<uint32_t>& visibleEntities)
+	{
+		_stats = {};
 
-		int i = 0;
-		for (GameObject& object : gameObjects)
+		// Only the primary command buffer of an inline subpass can write timestamps, the parallel path is measured by the pass scope
+		switch (_renderMode)
+		{
+		case RenderMode::Instanced:
+		{
+			GpuProfileScope scope(frameInfo.gpuProfiler, frameInfo.commandBuffer, "SimpleRenderSystem");
+			RenderInstanced(frameInfo, entities, visibleEntities);
+			break;
+		}
+		case RenderMode::Parallel:
+			RenderParallel(frameInfo, entities, visibleEntities);
+			break;
+		default:
 		{
-			i += 1;
-			object.transform.rotation.y = glm::mod<float>(object.transform.rotation.y + 0.01f, glm::two_pi<float>());
-			object.transform.rotation.x = glm::mod<float>(object.transform.rotation.x + 0.005f, glm::two_pi<float>());
+			GpuProfileScope scope(frameInfo.gpuProfiler, frameInfo.commandBuffer, "SimpleRenderSystem");
+			RenderPerObject(frameInfo, entities, visibleEntities);
+			break;
+		}
+		}
+	}
+
+	VkSubpassContents SimpleRenderSystem::GetSubpassContents() const
+	{
+		return _renderMode == RenderMode::Parallel ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+	}
+
+	void SimpleRenderSystem::RenderPerObject(FrameInfo& frameInfo, const RenderView& entities, const std::vector<uint32_t>& objects)
+	{
+		SubmitObjects(frameInfo, entities, objects);
+
+		DrawCommandBuffer commandBuffer{ frameInfo.commandBuffer };
+		RecordPackets(commandBuffer, entities, 0, _drawQueue.Size());
+		_stats = commandBuffer.GetStats();
+	}
+
+	void SimpleRenderSystem::RenderParallel(FrameInfo& frameInfo, const RenderView& entities, const std::vector<uint32_t>& objects)
+	{
+		assert(frameInfo.commandRecorder != nullptr && "Cannot record in parallel without a command recorder");
+		ParallelCommandRecorder& commandRecorder = *frameInfo.commandRecorder;
+
+		SubmitObjects(frameInfo, entities, objects);
+		const size_t packetCount = _drawQueue.Size();
+
+		// Small tasks cost more in thread wake ups and secondary command buffer overhead than they save. Each task starts
+		// with nothing bound, the state is only bound again at the first packet of a task
+		size_t taskCount = (packetCount + MIN_OBJECTS_PER_TASK - 1) / MIN_OBJECTS_PER_TASK;
+		taskCount = std::min<size_t>(taskCount, commandRecorder.GetWorkerCount());
+		if (taskCount == 0)
+		{
+			return;
+		}
+
+		size_t packetsPerTask = (packetCount + taskCount - 1) / taskCount;
+		_taskStats.assign(taskCount, DrawStateStats{});
+
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = frameInfo.renderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = frameInfo.framebuffer;
+
+		// The pass scope of the GPU profiler keeps a pipeline statistics query active while the secondaries execute
+		if (frameInfo.gpuProfiler != nullptr)
+		{
+			inheritanceInfo.pipelineStatistics = frameInfo.gpuProfiler->GetInheritedPipelineStatistics();
+		}
+
+		// Dynamic state is not inherited from the primary command buffer
+		VkViewport viewport{};
+		viewport.width = static_cast<float>(frameInfo.extent.width);
+		viewport.height = static_cast<float>(frameInfo.extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		VkRect2D scissor{ {0, 0}, frameInfo.extent };
+
+		commandRecorder.Record(frameInfo.commandBuffer, frameInfo.frameIndex, inheritanceInfo, static_cast<uint32_t>(taskCount),
+			[&](uint32_t taskIndex, VkCommandBuffer commandBuffer)
+			{
+				vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+				vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+				DrawCommandBuffer drawCommandBuffer{ commandBuffer };
+				size_t first = taskIndex * packetsPerTask;
+				size_t last = std::min(first + packetsPerTask, packetCount);
+				RecordPackets(drawCommandBuffer, entities, first, last);
+				_taskStats[taskIndex] = drawCommandBuffer.GetStats();
+			});
+
+		for (const DrawStateStats& taskStats : _taskStats)
+		{
+			_stats += taskStats;
+		}
+	}
+
+	void SimpleRenderSystem::SubmitObjects(FrameInfo& frameInfo, const RenderView& entities, const std::vector<uint32_t>& objects)
+	{
+		const Transform* transforms = entities.transforms;
+		const RenderComponent* renderComponents = entities.renderComponents;
+
+		_drawQueue.Clear();
+		_drawQueue.Reserve(objects.size());
+		_meshIds.clear();
+
+		for (uint32_t object : objects)
+		{
+			Model* model = renderComponents[object].model;
+			if (model == nullptr || !model->IsResident())
+			{
+				continue;
+			}
+
+			auto [it, inserted] = _meshIds.try_emplace(model, static_cast<uint32_t>(_meshIds.size()));
+			assert(it->second < (1u << DrawQueue::MESH_BITS) / Model::MAX_LOD_COUNT && "Too many models for the mesh field of the sort key");
+
+			// The pipeline is the one of the vertex format. There are no materials yet, and no camera: the depth is the clip
+			// space depth of the object's origin, so the draws of a mesh go front to back. Each level of a model is a mesh
+			// of its own, the levels share the buffers of the model so they still follow each other without binds
+			uint32_t pipeline = static_cast<uint32_t>(model->GetVertexFormat());
+			uint32_t mesh = it->second * Model::MAX_LOD_COUNT + std::min(GetLod(frameInfo, object), model->GetLodCount() - 1);
+			uint32_t depthBucket = DrawQueue::GetDepthBucket(transforms[object].translation.z);
+			_drawQueue.Submit(DrawQueue::MakeSortKey(pipeline, 0, mesh, depthBucket), object);
+		}
+
+		_drawQueue.Sort(frameInfo.jobSystem);
+	}
+
+	void SimpleRenderSystem::RecordPackets(DrawCommandBuffer& commandBuffer, const RenderView& entities, size_t first, size_t last)
+	{
+		const std::vector<DrawPacket>& packets = _drawQueue.GetPackets();
+		Transform* transforms = entities.transforms;
+		const RenderComponent* renderComponents = entities.renderComponents;
+
+		for (size_t i = first; i < last; ++i)
+		{
+			const DrawPacket& packet = packets[i];
+			const RenderComponent& renderComponent = renderComponents[packet.object];
+			Model& model = *renderComponent.model;
+
+			commandBuffer.BindPipeline(_pipelines[DrawQueue::GetPipeline(packet.sortKey)]->GetPipeline());
 
 			SimplePushConstantData push{};
-			push.color = object.color;
-			push.transform = object.transform.mat4();
+			push.color = renderComponent.color;
+			push.transform = transforms[packet.object].mat4();
+			SetPositionQuantization(push, model);
+
+			commandBuffer.PushConstants(_pipelineLayout, PUSH_CONSTANT_STAGES, 0, QUANTIZATION_OFFSET, &push);
+			commandBuffer.PushConstants(
+				_pipelineLayout,
+				PUSH_CONSTANT_STAGES,
+				QUANTIZATION_OFFSET,
+				sizeof(SimplePushConstantData) - QUANTIZATION_OFFSET,
+				reinterpret_cast<const uint8_t*>(&push) + QUANTIZATION_OFFSET);
+
+			model.Bind(commandBuffer);
+			model.Draw(commandBuffer, 1, 0, DrawQueue::GetMesh(packet.sortKey) % Model::MAX_LOD_COUNT);
+		}
+	}
+
+	void SimpleRenderSystem::RenderInstanced(FrameInfo& frameInfo, const RenderView& entities, const std::vector<uint32_t>& objects)
+	{
+		const Transform* transforms = entities.transforms;
+		const RenderComponent* renderComponents = entities.renderComponents;
+
+		// First pass: count the instances of each model and level
+		_batchLookup.clear();
+		_batches.clear();
+		_objectBatches.resize(objects.size());
+
+		uint32_t instanceCount = 0;
+		for (size_t i = 0; i < objects.size(); ++i)
+		{
+			Model* model = renderComponents[objects[i]].model;
+			if (model == nullptr || !model->IsResident())
+			{
+				_objectBatches[i] = UINT32_MAX;
+				continue;
+			}
+
+			uint32_t lod = std::min(GetLod(frameInfo, objects[i]), model->GetLodCount() - 1);
+			auto [it, inserted] = _batchLookup.try_emplace(BatchKey{ model, lod }, static_cast<uint32_t>(_batches.size()));
+			if (inserted)
+			{
+				_batches.push_back({ model, lod, 0, 0 });
+			}
+
+			_batches[it->second].instanceCount++;
+			_objectBatches[i] = it->second;
+			instanceCount++;
+		}
+
+		if (instanceCount == 0)
+		{
+			return;
+		}
+
+		uint32_t firstInstance = 0;
+		for (InstanceBatch& batch : _batches)
+		{
+			batch.firstInstance = firstInstance;
+			firstInstance += batch.instanceCount;
+			batch.instanceCount = 0;
+		}
+
+		// Second pass: gather each object next to the other instances of its model and level
+		InstanceBuffer& instanceBuffer = _instanceBuffers[frameInfo.frameIndex];
+		ReserveInstances(instanceBuffer, instanceCount);
+		InstanceData* instances = static_cast<InstanceData*>(instanceBuffer.allocation.mappedData);
+		_transformStore.Resize(instanceCount);
+
+		for (size_t i = 0; i < objects.size(); ++i)
+		{
+			if (_objectBatches[i] == UINT32_MAX)
+			{
+				continue;
+			}
+
+			InstanceBatch& batch = _batches[_objectBatches[i]];
+			uint32_t instanceIndex = batch.firstInstance + batch.instanceCount++;
+			_transformStore.Set(instanceIndex, transforms[objects[i]]);
+		}
 
-			vkCmdPushConstants(
-				commandBuffer,
+		// The matrices are computed in SIMD batches and written straight into the mapped instance buffer
+		if (frameInfo.jobSystem != nullptr)
+		{
+			frameInfo.jobSystem->ParallelFor(instanceCount, INSTANCES_PER_JOB, [&](uint32_t begin, uint32_t end)
+				{
+					ComputeTransformMatrices(_transformStore, begin, end - begin, &instances[begin].transform, sizeof(InstanceData));
+				});
+		}
+		else
+		{
+			ComputeTransformMatrices(_transformStore, 0, instanceCount, &instances[0].transform, sizeof(InstanceData));
+		}
+
+		DrawCommandBuffer commandBuffer{ frameInfo.commandBuffer };
+		commandBuffer.BindVertexBuffer(INSTANCE_BINDING, instanceBuffer.buffer);
+
+		// The instanced shader only reads the position quantization out of the push constants
+		for (const InstanceBatch& batch : _batches)
+		{
+			commandBuffer.BindPipeline(_instancedPipelines[static_cast<uint32_t>(batch.model->GetVertexFormat())]->GetPipeline());
+
+			SimplePushConstantData push{};
+			SetPositionQuantization(push, *batch.model);
+			commandBuffer.PushConstants(
 				_pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(SimplePushConstantData),
-				&push);
+				PUSH_CONSTANT_STAGES,
+				QUANTIZATION_OFFSET,
+				sizeof(SimplePushConstantData) - QUANTIZATION_OFFSET,
+				reinterpret_cast<const uint8_t*>(&push) + QUANTIZATION_OFFSET);
+
+			batch.model->Bind(commandBuffer);
+			batch.model->Draw(commandBuffer, batch.instanceCount, batch.firstInstance, batch.lod);
+		}
+
+		_stats = commandBuffer.GetStats();
+	}
+
+	void SimpleRenderSystem::ReserveInstances(InstanceBuffer& instanceBuffer, uint32_t instanceCount)
+	{
+		if (instanceCount <= instanceBuffer.capacity)
+		{
+			return;
+		}
+
+		// The previous buffer of this frame index is no longer in use, its fence was waited on in BeginFrame
+		if (instanceBuffer.buffer != VK_NULL_HANDLE)
+		{
+			_device.DestroyBuffer(instanceBuffer.buffer, instanceBuffer.allocation);
+		}
+
+		uint32_t capacity = std::max(instanceBuffer.capacity, MIN_INSTANCE_CAPACITY);
+		while (capacity < instanceCount)
+		{
+			capacity *= 2;
+		}
 
-			object.model->Bind(commandBuffer);
-			object.model->Draw(commandBuffer);
+		_device.CreateBuffer(
+			sizeof(InstanceData) * capacity,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			instanceBuffer.buffer,
+			instanceBuffer.allocation);
+		instanceBuffer.capacity = capacity;
+	}
+
+	std::vector<VkVertexInputBindingDescription> SimpleRenderSystem::InstanceData::GetBindingDescriptions()
+	{
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+		bindingDescriptions[0].binding = INSTANCE_BINDING;
+		bindingDescriptions[0].stride = sizeof(InstanceData);
+		bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+		return bindingDescriptions;
+	}
+
+	std::vector<VkVertexInputAttributeDescription> SimpleRenderSystem::InstanceData::GetAttributeDescriptions()
+	{
+		// A mat4 attribute takes one location per column
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions(4);
+		for (uint32_t column = 0; column < 4; ++column)
+		{
+			attributeDescriptions[column].binding = INSTANCE_BINDING;
+			attributeDescriptions[column].location = 2 + column;
+			attributeDescriptions[column].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+			attributeDescriptions[column].offset = offsetof(InstanceData, transform) + sizeof(glm::vec4) * column;
 		}
+		return attributeDescriptions;
 	}
-} // namespace DaisyEngine
\ No newline at end of file
+} // namespace DaisyEngine
@@ -2,10 +2,18 @@
 
 #include "Pipeline.hpp"
 #include "Device.hpp"
-#include "GameObject.hpp"
+#include "FrameInfo.hpp"
+#include "Components.hpp"
+#include "DrawCommandBuffer.hpp"
+#include "DrawQueue.hpp"
+#include "RenderTarget.hpp"
+#include "TransformStore.hpp"
+#include "VertexFormat.hpp"
 
 // std
+#include <array>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace DaisyEngine
@@ -13,24 +21,118 @@ namespace DaisyEngine
 	class SimpleRenderSystem
 	{
 	public:
+		enum class RenderMode
+		{
+			PerObject, // One push constant and one draw per object, sorted by pipeline, mesh and depth
+			Instanced, // One instanced draw per model
+			Parallel, // Like PerObject, the sorted draws are recorded into secondary command buffers by the worker threads
+		};
+
+		/// <summary>
+		/// The InstanceData struct is the per instance vertex input of the instanced shader (locations 2 to 5).
+		/// </summary>
+		struct InstanceData
+		{
+			glm::mat4 transform{ 1.0f };
+
+			static std::vector<VkVertexInputBindingDescription> GetBindingDescriptions();
+			static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions();
+		};
+
+		// --- Constants ---
+		static constexpr uint32_t INSTANCE_BINDING = 1;
+		static constexpr uint32_t MIN_INSTANCE_CAPACITY = 1024;
+		static constexpr size_t MIN_OBJECTS_PER_TASK = 256;
+		static constexpr uint32_t INSTANCES_PER_JOB = 4096; // Matrices computed per job when FrameInfo has a job system
+
 		// --- Constructors / Destructors ---
-		SimpleRenderSystem(Device& device, VkRenderPass renderPass);
+		SimpleRenderSystem(Device& device, VkRenderPass renderPass, RenderMode renderMode = RenderMode::Instanced);
 		~SimpleRenderSystem();
 
 		SimpleRenderSystem(const SimpleRenderSystem&) = delete;
 		SimpleRenderSystem& operator=(const SimpleRenderSystem&) = delete;
 
-		void RenderGameObjects(VkCommandBuffer commandBuffer, std::vector<GameObject>& gameObjects);
+		inline RenderMode GetRenderMode() const { return _renderMode; }
+		inline void SetRenderMode(RenderMode renderMode) { _renderMode = renderMode; }
+
+		// The contents to begin the render pass with for the current render mode
+		VkSubpassContents GetSubpassContents() const;
+
+		// Renders every entity of the view
+		void RenderEntities(FrameInfo& frameInfo, const RenderView& entities);
+
+		// Renders the view indices listed in visibleEntities, typically the output of a FrustumCuller
+		void RenderEntities(FrameInfo& frameInfo, const RenderView& entities, const std::vector<uint32_t>& visibleEntities);
+
+		// The state changes of the last RenderEntities, with the ones skipped because the state was already bound
+		inline const DrawStateStats& GetStats() const { return _stats; }
 
 	private:
+		/// <summary>
+		/// A run of consecutive instances in the instance buffer sharing the same model and level of detail.
+		/// </summary>
+		struct InstanceBatch
+		{
+			Model* model;
+			uint32_t lod;
+			uint32_t firstInstance;
+			uint32_t instanceCount;
+		};
+
+		struct BatchKey
+		{
+			Model* model;
+			uint32_t lod;
+
+			bool operator==(const BatchKey& other) const { return model == other.model && lod == other.lod; }
+		};
+
+		struct BatchKeyHasher
+		{
+			size_t operator()(const BatchKey& key) const { return std::hash<Model*>{}(key.model) ^ key.lod; }
+		};
+
+		/// <summary>
+		/// A host visible vertex buffer holding the instances of one frame in flight.
+		/// </summary>
+		struct InstanceBuffer
+		{
+			VkBuffer buffer = VK_NULL_HANDLE;
+			Allocation allocation{};
+			uint32_t capacity = 0;
+		};
+
 		// --- Methods ---
 		void CreatePipelineLayout();
-		void CreatePipeline(VkRenderPass renderPass);
+		void CreatePipelines(VkRenderPass renderPass);
+
+		void RenderPerObject(FrameInfo& frameInfo, const RenderView& entities, const std::vector<uint32_t>& objects);
+		void RenderInstanced(FrameInfo& frameInfo, const RenderView& entities, const std::vector<uint32_t>& objects);
+		void RenderParallel(FrameInfo& frameInfo, const RenderView& entities, const std::vector<uint32_t>& objects);
+		// Fills the draw queue with the resident objects and sorts it
+		void SubmitObjects(FrameInfo& frameInfo, const RenderView& entities, const std::vector<uint32_t>& objects);
+		// Records the sorted packets [first, last) of the draw queue
+		void RecordPackets(DrawCommandBuffer& commandBuffer, const RenderView& entities, size_t first, size_t last);
+		void ReserveInstances(InstanceBuffer& instanceBuffer, uint32_t instanceCount);
 
 		// --- Variables ---
 		Device& _device;
+		RenderMode _renderMode;
 
-		std::unique_ptr<Pipeline> _pipeline;
+		std::array<std::unique_ptr<Pipeline>, VERTEX_FORMAT_COUNT> _pipelines; // Indexed by VertexFormat
+		std::array<std::unique_ptr<Pipeline>, VERTEX_FORMAT_COUNT> _instancedPipelines;
 		VkPipelineLayout _pipelineLayout;
+
+		std::array<InstanceBuffer, RenderTarget::MAX_FRAMES_IN_FLIGHT> _instanceBuffers;
+		std::unordered_map<BatchKey, uint32_t, BatchKeyHasher> _batchLookup;
+		std::vector<InstanceBatch> _batches;
+		std::vector<uint32_t> _objectBatches;
+		TransformStore _transformStore;
+		std::vector<uint32_t> _allEntities;
+
+		DrawQueue _drawQueue;
+		std::unordered_map<Model*, uint32_t> _meshIds; // By first appearance in the frame, the mesh field of the sort keys holds it with the LOD
+		std::vector<DrawStateStats> _taskStats; // Of each parallel recording task
+		DrawStateStats _stats;
 	};
-} // namespace DaisyEngine
\ No newline at end of file
+} // namespace DaisyEngine
@@ -0,0 +1,216 @@
+#include "Simulation.hpp"
+#include "CpuProfiler.hpp"
+
+// Libs
+#include <glm/gtc/constants.hpp>
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace DaisyEngine
+{
+	// In steps
+	static constexpr double STEP_EPSILON = 1e-6;
+
+	// Euler angles are blended along the shortest arc, an angle wrapping from 2 pi to 0 must not spin back the long way
+	static glm::vec3 BlendAngles(const glm::vec3& previous, const glm::vec3& current, float alpha)
+	{
+		glm::vec3 delta = current - previous;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			delta[axis] = std::remainder(delta[axis], glm::two_pi<float>());
+		}
+		return previous + delta * alpha;
+	}
+
+	Simulation::Simulation(World& world, StepFunction stepFunction, double timestep)
+		: _world(world), _renderQuery(world.GetQuery<Transform, RenderComponent>()), _stepFunction(std::move(stepFunction)), _timestep(timestep)
+	{
+		assert(timestep > 0.0 && "The simulation timestep must be positive");
+
+		TakeSnapshot(_current);
+		_previous = _current;
+	}
+
+	Simulation::~Simulation()
+	{
+		StopThread();
+	}
+
+	void Simulation::Advance(double elapsedSeconds)
+	{
+		uint64_t dueStepCount = 0;
+		{
+			std::lock_guard<std::mutex> lock(_timeMutex);
+			if (_threadException)
+			{
+				// The thread already returned, the next steps run on the calling thread
+				_thread.join();
+				std::exception_ptr exception = _threadException;
+				_threadException = nullptr;
+				std::rethrow_exception(exception);
+			}
+
+			// The epsilon keeps advancing by whole timesteps from rounding down to one step less
+			_time += elapsedSeconds;
+			_dueStepCount = static_cast<uint64_t>(_time / _timestep + STEP_EPSILON);
+
+			// A long stall, or a simulation slower than real time, would otherwise make every next frame run more steps
+			uint64_t maxDueStepCount = GetStepCount() + MAX_STEPS_BEHIND;
+			if (_dueStepCount > maxDueStepCount)
+			{
+				_time -= static_cast<double>(_dueStepCount - maxDueStepCount) * _timestep;
+				_dueStepCount = maxDueStepCount;
+			}
+
+			dueStepCount = _dueStepCount;
+		}
+
+		if (IsThreaded())
+		{
+			_stepsDueCondition.notify_one();
+			return;
+		}
+
+		while (GetStepCount() < dueStepCount)
+		{
+			Step();
+		}
+	}
+
+	void Simulation::StartThread()
+	{
+		assert(!IsThreaded() && "The simulation thread is already running");
+
+		_isStopping = false;
+		_thread = std::thread(&Simulation::ThreadLoop, this);
+	}
+
+	void Simulation::StopThread()
+	{
+		if (!IsThreaded())
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_timeMutex);
+			_isStopping = true;
+		}
+		_stepsDueCondition.notify_one();
+		_thread.join();
+	}
+
+	RenderView Simulation::Interpolate()
+	{
+		DAISY_PROFILE_ZONE("Interpolate snapshots");
+
+		double renderTime = 0.0;
+		{
+			std::lock_guard<std::mutex> lock(_timeMutex);
+			renderTime = _time - _timestep;
+		}
+
+		// Held while blending, the simulation thread only waits on it to publish its next snapshot
+		std::lock_guard<std::mutex> lock(_snapshotMutex);
+
+		// Clamped: a simulation thread lagging behind shows its latest step rather than extrapolating
+		float alpha = 1.0f;
+		if (_current.step != _previous.step)
+		{
+			double stepTime = static_cast<double>(_previous.step) * _timestep;
+			alpha = static_cast<float>(std::clamp((renderTime - stepTime) / _timestep, 0.0, 1.0));
+		}
+
+		const size_t count = _current.entities.size();
+		const size_t previousCount = _previous.entities.size();
+		_interpolated.entities = _current.entities;
+		_interpolated.renderComponents = _current.renderComponents;
+		_interpolated.transforms.resize(count);
+		_interpolated.step = _current.step;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const Transform& current = _current.transforms[i];
+
+			// Query order only changes with structural changes, an entity that moved or just appeared is not blended
+			if (i >= previousCount || _previous.entities[i] != _current.entities[i])
+			{
+				_interpolated.transforms[i] = current;
+				continue;
+			}
+
+			const Transform& previous = _previous.transforms[i];
+			Transform& transform = _interpolated.transforms[i];
+			transform.translation = previous.translation + (current.translation - previous.translation) * alpha;
+			transform.scale = previous.scale + (current.scale - previous.scale) * alpha;
+			transform.rotation = BlendAngles(previous.rotation, current.rotation, alpha);
+		}
+
+		return RenderView{ _interpolated.transforms.data(), _interpolated.renderComponents.data(), count };
+	}
+
+	void Simulation::Step()
+	{
+		{
+			DAISY_PROFILE_ZONE("Simulation step");
+			_stepFunction(_world, static_cast<float>(_timestep));
+		}
+
+		TakeSnapshot(_back);
+		_back.step = GetStepCount() + 1;
+
+		{
+			std::lock_guard<std::mutex> lock(_snapshotMutex);
+			std::swap(_previous, _current);
+			std::swap(_current, _back);
+		}
+
+		_stepCount.fetch_add(1, std::memory_order_release);
+	}
+
+	void Simulation::TakeSnapshot(SimulationSnapshot& snapshot)
+	{
+		const size_t count = _renderQuery.Size();
+		snapshot.entities.resize(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			snapshot.entities[i] = _renderQuery.GetEntity(i);
+		}
+
+		snapshot.transforms.assign(_renderQuery.Data<Transform>(), _renderQuery.Data<Transform>() + count);
+		snapshot.renderComponents.assign(_renderQuery.Data<RenderComponent>(), _renderQuery.Data<RenderComponent>() + count);
+		snapshot.step = GetStepCount();
+	}
+
+	void Simulation::ThreadLoop()
+	{
+		DAISY_PROFILE_THREAD("Simulation thread");
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(_timeMutex);
+				_stepsDueCondition.wait(lock, [this]() { return _isStopping || GetStepCount() < _dueStepCount; });
+				if (_isStopping)
+				{
+					return;
+				}
+			}
+
+			try
+			{
+				Step();
+			}
+			catch (...)
+			{
+				// Rethrown by the next Advance, the thread stops and the world is left as the failed step left it
+				std::lock_guard<std::mutex> lock(_timeMutex);
+				_threadException = std::current_exception();
+				return;
+			}
+		}
+	}
+} // namespace DaisyEngine
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "World.hpp"
+#include "Components.hpp"
+
+// std
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The SimulationSnapshot struct is the render state of the world after a simulation step: every entity of the RenderQuery
+	/// with its transform and render component, in query order.
+	/// </summary>
+	struct SimulationSnapshot
+	{
+		std::vector<Entity> entities;
+		std::vector<Transform> transforms;
+		std::vector<RenderComponent> renderComponents;
+		uint64_t step = 0; // The snapshot shows the world at step * timestep seconds
+	};
+
+	/// <summary>
+	/// The Simulation class advances a World with a fixed timestep, whatever the frame rate. Real time is accumulated and
+	/// consumed in whole steps, each step publishes a snapshot of the render state. The renderer draws the world one step in
+	/// the past, blended between the last two snapshots, so the motion stays smooth when frames and steps do not line up.
+	/// Once StartThread was called the steps run on a thread of their own and the world belongs to it until StopThread,
+	/// the render thread only reads the snapshots.
+	/// </summary>
+	class Simulation
+	{
+	public:
+		using StepFunction = std::function<void(World& world, float timestep)>;
+
+		// --- Constants ---
+		static constexpr double DEFAULT_TIMESTEP = 1.0 / 60.0;
+		static constexpr uint32_t MAX_STEPS_BEHIND = 8; // Past that, the simulation drops time instead of spiraling into longer frames
+
+		// --- Constructor/ Destructor ---
+		// The first snapshot is taken here, the world should already hold its initial entities
+		Simulation(World& world, StepFunction stepFunction, double timestep = DEFAULT_TIMESTEP);
+		~Simulation();
+
+		Simulation(const Simulation&) = delete;
+		Simulation& operator=(const Simulation&) = delete;
+
+		// --- Methods ---
+		// Adds real time. The steps it makes due run here, or on the simulation thread when it is started.
+		// Rethrows the exception that stopped the simulation thread, if any
+		void Advance(double elapsedSeconds);
+
+		void StartThread();
+		void StopThread();
+		inline bool IsThreaded() const { return _thread.joinable(); }
+
+		// Blends the last two snapshots at the render time, one step behind the advanced time.
+		// The view is owned by the simulation and stays valid until the next call, which must come from the same thread
+		RenderView Interpolate();
+
+		inline double GetTimestep() const { return _timestep; }
+		inline uint64_t GetStepCount() const { return _stepCount.load(std::memory_order_acquire); }
+
+	private:
+		// --- Methods ---
+		void Step();
+		void TakeSnapshot(SimulationSnapshot& snapshot);
+		void ThreadLoop();
+
+		// --- Variables ---
+		World& _world;
+		RenderQuery& _renderQuery;
+		StepFunction _stepFunction;
+		const double _timestep;
+
+		// Time given by Advance and the steps it made due, shared with the simulation thread
+		std::mutex _timeMutex;
+		std::condition_variable _stepsDueCondition;
+		double _time = 0.0;
+		uint64_t _dueStepCount = 0;
+		bool _isStopping = false;
+		std::exception_ptr _threadException;
+
+		std::atomic<uint64_t> _stepCount{ 0 };
+		std::thread _thread;
+
+		// _back is only touched by the stepping thread, it becomes _current when published
+		std::mutex _snapshotMutex;
+		SimulationSnapshot _previous;
+		SimulationSnapshot _current;
+		SimulationSnapshot _back;
+
+		// Render thread only
+		SimulationSnapshot _interpolated;
+	};
+} // namespace DaisyEngine
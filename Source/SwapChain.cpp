@@ -1,5 +1,7 @@
 #include "SwapChain.hpp"
+#include "CpuProfiler.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cstdlib>
 #include <cstring>
@@ -44,8 +46,7 @@ namespace DaisyEngine
 		for (int i = 0; i < imagesCount; ++i)
 		{
 			vkDestroyImageView(_device.GetDevice(), _depthImageViews[i], nullptr);
-			vkDestroyImage(_device.GetDevice(), _depthImages[i], nullptr);
-			vkFreeMemory(_device.GetDevice(), _depthImageMemories[i], nullptr);
+			_device.DestroyImage(_depthImages[i], _depthImageAllocations[i]);
 		}
 
 		for (VkFramebuffer frameBuffer : _swapChainFramebuffers)
@@ -54,6 +55,7 @@ namespace DaisyEngine
 		}
 
 		vkDestroyRenderPass(_device.GetDevice(), _renderPass, nullptr);
+		vkDestroyRenderPass(_device.GetDevice(), _loadRenderPass, nullptr);
 
 		// Cleanup synchronization objects
 		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
@@ -68,7 +70,8 @@ namespace DaisyEngine
 	{
 		CreateSwapChain();
 		CreateImageViews();
-		CreateRenderPass();
+		_renderPass = CreateRenderPass(false);
+		_loadRenderPass = CreateRenderPass(true);
 		CreateDepthResources();
 		CreateFramebuffers();
 		CreateSyncObjects();
@@ -76,15 +79,25 @@ namespace DaisyEngine
 
 	VkResult SwapChain::AcquireNextImage(uint32_t* imageIndex)
 	{
-		vkWaitForFences(_device.GetDevice(), 1, &_inFlightFences[_currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		DAISY_PROFILE_FUNCTION();
+
+		{
+			DAISY_PROFILE_ZONE("Wait for frame fence");
+			vkWaitForFences(_device.GetDevice(), 1, &_inFlightFences[_currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		}
+
+		DAISY_PROFILE_ZONE("vkAcquireNextImageKHR");
 		VkResult result = vkAcquireNextImageKHR(_device.GetDevice(), _swapChain, std::numeric_limits<uint64_t>::max(), _imageAvailableSemaphores[_currentFrame], VK_NULL_HANDLE, imageIndex);
 		return result;
 	}
 
-	VkResult SwapChain::SubmitCommandBuffers(const const VkCommandBuffer* buffers, uint32_t* imageIndex)
+	VkResult SwapChain::SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex)
 	{
+		DAISY_PROFILE_FUNCTION();
+
 		if (_imagesInFlight[*imageIndex] != VK_NULL_HANDLE)
 		{
+			DAISY_PROFILE_ZONE("Wait for image fence");
 			vkWaitForFences(_device.GetDevice(), 1, &_imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
 		}
 
@@ -107,9 +120,12 @@ namespace DaisyEngine
 		submitInfo.pSignalSemaphores = signalSemaphores;
 
 		vkResetFences(_device.GetDevice(), 1, &_inFlightFences[_currentFrame]);
-		if (vkQueueSubmit(_device.GetGraphicsQueue(), 1, &submitInfo, _inFlightFences[_currentFrame]) != VK_SUCCESS)
 		{
-			throw std::runtime_error("Failed to submit draw command buffer!");
+			DAISY_PROFILE_ZONE("vkQueueSubmit");
+			if (vkQueueSubmit(_device.GetGraphicsQueue(), 1, &submitInfo, _inFlightFences[_currentFrame]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to submit draw command buffer!");
+			}
 		}
 
 		VkPresentInfoKHR presentInfo{};
@@ -124,6 +140,7 @@ namespace DaisyEngine
 
 		presentInfo.pImageIndices = imageIndex;
 
+		DAISY_PROFILE_ZONE("vkQueuePresentKHR");
 		VkResult result = vkQueuePresentKHR(_device.GetPresentQueue(), &presentInfo);
 
 		_currentFrame = (_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
@@ -218,16 +235,17 @@ namespace DaisyEngine
 		}
 	}
 
-	void SwapChain::CreateRenderPass()
+	VkRenderPass SwapChain::CreateRenderPass(bool loadContents)
 	{
+		// The depth is stored, a depth pyramid may be built from it between two passes of the frame
 		VkAttachmentDescription depthAttachment{};
 		depthAttachment.format = FindDepthFormat();
 		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.loadOp = loadContents ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		depthAttachment.initialLayout = loadContents ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
 		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
 		VkAttachmentReference depthAttachmentRef{};
@@ -237,11 +255,11 @@ namespace DaisyEngine
 		VkAttachmentDescription colorAttachment = {};
 		colorAttachment.format = GetSwapChainImageFormat();
 		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		colorAttachment.loadOp = loadContents ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
 		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		colorAttachment.initialLayout = loadContents ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_UNDEFINED;
 		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
 		VkAttachmentReference colorAttachmentRef = {};
@@ -261,6 +279,13 @@ namespace DaisyEngine
 		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
 		dependency.srcAccessMask = 0;
 		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		if (loadContents)
+		{
+			// What the previous pass of the frame wrote is loaded
+			dependency.srcStageMask |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			dependency.dstAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+		}
 
 		std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
 		VkRenderPassCreateInfo renderPassInfo = {};
@@ -272,9 +297,12 @@ namespace DaisyEngine
 		renderPassInfo.dependencyCount = 1;
 		renderPassInfo.pDependencies = &dependency;
 
-		if (vkCreateRenderPass(_device.GetDevice(), &renderPassInfo, nullptr, &_renderPass) != VK_SUCCESS) {
+		VkRenderPass renderPass;
+		if (vkCreateRenderPass(_device.GetDevice(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create render pass!");
 		}
+
+		return renderPass;
 	}
 
 	void SwapChain::CreateFramebuffers()
@@ -310,7 +338,7 @@ namespace DaisyEngine
 
 		size_t imageCount = GetImageCount();
 		_depthImages.resize(imageCount);
-		_depthImageMemories.resize(imageCount);
+		_depthImageAllocations.resize(imageCount);
 		_depthImageViews.resize(imageCount);
 
 		size_t depthImagesSize = _depthImages.size();
@@ -327,13 +355,13 @@ namespace DaisyEngine
 			imageInfo.format = depthFormat;
 			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
 			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+			imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 			imageInfo.flags = 0;
 
 			_device.CreateImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-				_depthImages[i], _depthImageMemories[i]);
+				_depthImages[i], _depthImageAllocations[i]);
 
 			VkImageViewCreateInfo viewInfo{};
 			viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -438,7 +466,7 @@ namespace DaisyEngine
 		return _device.FindSupportedFormat(
 			{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
 			VK_IMAGE_TILING_OPTIMAL,
-			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
 	}
 
 } // namespace DaisyEngine
\ No newline at end of file
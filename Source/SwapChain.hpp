@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Device.hpp"
+#include "RenderTarget.hpp"
 
 // Vulkan includes
 #include <vulkan/vulkan.h>
@@ -12,12 +13,9 @@
 
 namespace DaisyEngine
 {
-	class SwapChain
+	class SwapChain : public RenderTarget
 	{
 	public:
-		// --- Constants ---
-		static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
 		// --- Constructors ---
 		SwapChain(Device& device, VkExtent2D windowExtent);
 		SwapChain(Device& device, VkExtent2D windowExtent, std::shared_ptr<SwapChain> previous);
@@ -27,12 +25,16 @@ namespace DaisyEngine
 		SwapChain& operator=(const SwapChain&) = delete;
 
 		// --- Methods ---
-		VkFramebuffer GetFrameBuffer(int index) { return _swapChainFramebuffers[index]; }
-		VkRenderPass GetRenderPass() { return _renderPass; }
+		VkFramebuffer GetFrameBuffer(int index) override { return _swapChainFramebuffers[index]; }
+		VkRenderPass GetRenderPass() override { return _renderPass; }
+		VkRenderPass GetLoadRenderPass() override { return _loadRenderPass; }
+		VkImage GetDepthImage(int index) override { return _depthImages[index]; }
+		VkImageView GetDepthImageView(int index) override { return _depthImageViews[index]; }
+		VkFormat GetDepthFormat() override { return _swapChainDepthFormat; }
 		VkImageView GetImageView(int index) { return _swapChainImageViews[index]; }
-		size_t GetImageCount() { return _swapChainImages.size(); }
+		size_t GetImageCount() override { return _swapChainImages.size(); }
 		VkFormat GetSwapChainImageFormat() { return _swapChainImageFormat; }
-		VkExtent2D GetSwapChainExtent() { return _swapChainExtent; }
+		VkExtent2D GetSwapChainExtent() override { return _swapChainExtent; }
 		uint32_t GetWidth() { return _swapChainExtent.width; }
 		uint32_t GetHeight() { return _swapChainExtent.height; }
 
@@ -43,8 +45,8 @@ namespace DaisyEngine
 
 		VkFormat FindDepthFormat();
 
-		VkResult AcquireNextImage(uint32_t* imageIndex);
-		VkResult SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
+		VkResult AcquireNextImage(uint32_t* imageIndex) override;
+		VkResult SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex) override;
 
 		bool CompareSwapFormat(const SwapChain& swapChain) const
 		{
@@ -58,7 +60,8 @@ namespace DaisyEngine
 		void CreateSwapChain();
 		void CreateImageViews();
 		void CreateDepthResources();
-		void CreateRenderPass();
+		// The load render pass keeps what the frame drew so far, both are compatible with the same framebuffers
+		VkRenderPass CreateRenderPass(bool loadContents);
 		void CreateFramebuffers();
 		void CreateSyncObjects();
 
@@ -74,9 +77,10 @@ namespace DaisyEngine
 
 		std::vector<VkFramebuffer> _swapChainFramebuffers;
 		VkRenderPass _renderPass;
+		VkRenderPass _loadRenderPass;
 
 		std::vector<VkImage> _depthImages;
-		std::vector<VkDeviceMemory> _depthImageMemories;
+		std::vector<Allocation> _depthImageAllocations;
 		std::vector<VkImageView> _depthImageViews;
 		std::vector<VkImage> _swapChainImages;
 		std::vector<VkImageView> _swapChainImageViews;
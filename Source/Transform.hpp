@@ -1,13 +1,8 @@
 #pragma once
 
-#include "Model.hpp"
-
 // Libs
 #include <glm/gtc/matrix_transform.hpp>
 
-// std
-#include <memory>
-
 namespace DaisyEngine
 {
 	struct Transform
@@ -48,27 +43,4 @@ namespace DaisyEngine
                 {translation.x, translation.y, translation.z, 1.0f} };
         }
 	};
-
-	class GameObject
-	{
-	public:
-		using uniqueId = unsigned int;
-
-		static GameObject Instantiate();
-
-		GameObject(const GameObject&) = delete;
-		GameObject& operator=(const GameObject&) = delete;
-		GameObject(GameObject&&) = default;
-		GameObject& operator=(GameObject&&) = default;
-
-		uniqueId GetId() const { return _id; }
-
-		std::shared_ptr<Model> model;
-		glm::vec3 color{};
-		Transform transform{};
-
-	private:
-		GameObject(uniqueId objId) : _id{ objId } {}
-		uniqueId _id;
-	};
-} // namespace DaisyEngine
\ No newline at end of file
+} // namespace DaisyEngine
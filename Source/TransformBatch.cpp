@@ -0,0 +1,143 @@
+#include "TransformBatch.hpp"
+#include "TransformBatchKernel.hpp"
+
+// std
+#include <cassert>
+#include <cmath>
+
+#if defined(DAISY_SIMD_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace DaisyEngine
+{
+	static SimdLevel DetectSimdLevel()
+	{
+#if defined(DAISY_SIMD_X86) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		bool hasSse2 = (info[3] & (1 << 26)) != 0;
+		bool hasFma = (info[2] & (1 << 12)) != 0;
+		bool hasOsxsave = (info[2] & (1 << 27)) != 0;
+
+		// The OS must also save the YMM registers on context switches
+		bool hasAvxState = hasOsxsave && (_xgetbv(0) & 0x6) == 0x6;
+
+		bool hasAvx2 = false;
+		if (maxLeaf >= 7)
+		{
+			__cpuidex(info, 7, 0);
+			hasAvx2 = (info[1] & (1 << 5)) != 0;
+		}
+
+		if (hasAvx2 && hasFma && hasAvxState)
+		{
+			return SimdLevel::Avx2;
+		}
+		return hasSse2 ? SimdLevel::Sse : SimdLevel::Scalar;
+#elif defined(DAISY_SIMD_X86)
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		{
+			return SimdLevel::Avx2;
+		}
+		return __builtin_cpu_supports("sse2") ? SimdLevel::Sse : SimdLevel::Scalar;
+#else
+		return SimdLevel::Scalar;
+#endif
+	}
+
+	SimdLevel GetSimdLevel()
+	{
+		static const SimdLevel level = DetectSimdLevel();
+		return level;
+	}
+
+	const char* GetSimdLevelName(SimdLevel level)
+	{
+		switch (level)
+		{
+		case SimdLevel::Sse:
+			return "SSE2";
+		case SimdLevel::Avx2:
+			return "AVX2";
+		default:
+			return "scalar";
+		}
+	}
+
+	void ComputeTransformMatricesScalar(const TransformArrays& transforms, size_t count, char* output, size_t outputStride)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			// Same as Transform::mat4(), written column by column
+			const float c3 = std::cos(transforms.rotation[2][i]);
+			const float s3 = std::sin(transforms.rotation[2][i]);
+			const float c2 = std::cos(transforms.rotation[0][i]);
+			const float s2 = std::sin(transforms.rotation[0][i]);
+			const float c1 = std::cos(transforms.rotation[1][i]);
+			const float s1 = std::sin(transforms.rotation[1][i]);
+
+			const float scaleX = transforms.scale[0][i];
+			const float scaleY = transforms.scale[1][i];
+			const float scaleZ = transforms.scale[2][i];
+
+			float* matrix = reinterpret_cast<float*>(output + i * outputStride);
+			matrix[0] = scaleX * (c1 * c3 + s1 * s2 * s3);
+			matrix[1] = scaleX * (c2 * s3);
+			matrix[2] = scaleX * (c1 * s2 * s3 - c3 * s1);
+			matrix[3] = 0.0f;
+			matrix[4] = scaleY * (c3 * s1 * s2 - c1 * s3);
+			matrix[5] = scaleY * (c2 * c3);
+			matrix[6] = scaleY * (c1 * c3 * s2 + s1 * s3);
+			matrix[7] = 0.0f;
+			matrix[8] = scaleZ * (c2 * s1);
+			matrix[9] = scaleZ * (-s2);
+			matrix[10] = scaleZ * (c1 * c2);
+			matrix[11] = 0.0f;
+			matrix[12] = transforms.translation[0][i];
+			matrix[13] = transforms.translation[1][i];
+			matrix[14] = transforms.translation[2][i];
+			matrix[15] = 1.0f;
+		}
+	}
+
+	void ComputeTransformMatrices(const TransformStore& store, size_t first, size_t count, void* output, size_t outputStride)
+	{
+		ComputeTransformMatrices(GetSimdLevel(), store, first, count, output, outputStride);
+	}
+
+	void ComputeTransformMatrices(SimdLevel level, const TransformStore& store, size_t first, size_t count, void* output, size_t outputStride)
+	{
+		assert(first + count <= store.Size() && "Transform range out of range");
+		assert(level <= GetSimdLevel() && "Instruction set not supported by this CPU");
+
+		TransformArrays transforms{};
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			transforms.translation[axis] = store.GetComponent(static_cast<TransformStore::Component>(TransformStore::TranslationX + axis)) + first;
+			transforms.scale[axis] = store.GetComponent(static_cast<TransformStore::Component>(TransformStore::ScaleX + axis)) + first;
+			transforms.rotation[axis] = store.GetComponent(static_cast<TransformStore::Component>(TransformStore::RotationX + axis)) + first;
+		}
+
+		char* matrices = static_cast<char*>(output);
+
+		switch (level)
+		{
+#ifdef DAISY_SIMD_X86
+		case SimdLevel::Avx2:
+			ComputeTransformMatricesAvx2(transforms, count, matrices, outputStride);
+			break;
+		case SimdLevel::Sse:
+			ComputeTransformMatricesSse(transforms, count, matrices, outputStride);
+			break;
+#endif
+		default:
+			ComputeTransformMatricesScalar(transforms, count, matrices, outputStride);
+			break;
+		}
+	}
+} // namespace DaisyEngine
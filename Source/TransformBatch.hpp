@@ -0,0 +1,27 @@
+#pragma once
+
+#include "TransformStore.hpp"
+
+// std
+#include <cstddef>
+
+namespace DaisyEngine
+{
+	enum class SimdLevel
+	{
+		Scalar,
+		Sse, // SSE2, 4 transforms per iteration
+		Avx2, // AVX2 and FMA, 8 transforms per iteration
+	};
+
+	// Best instruction set supported by the CPU and the build, detected once
+	SimdLevel GetSimdLevel();
+	const char* GetSimdLevelName(SimdLevel level);
+
+	// Computes the world matrices of the transforms [first, first + count) of the store, the same matrices as Transform::mat4().
+	// Each glm::mat4 is written at output + i * outputStride, so they can go straight into a larger per instance struct.
+	void ComputeTransformMatrices(const TransformStore& store, size_t first, size_t count, void* output, size_t outputStride);
+
+	// Same as above with an explicit instruction set, the level must be supported (see GetSimdLevel)
+	void ComputeTransformMatrices(SimdLevel level, const TransformStore& store, size_t first, size_t count, void* output, size_t outputStride);
+} // namespace DaisyEngine
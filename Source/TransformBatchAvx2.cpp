@@ -0,0 +1,79 @@
+// Compiled with AVX2 and FMA enabled (/arch:AVX2, -mavx2 -mfma), only called once GetSimdLevel detected them
+#include "TransformBatchKernel.hpp"
+
+#ifdef DAISY_SIMD_X86
+
+// std
+#include <immintrin.h>
+
+namespace DaisyEngine
+{
+	namespace
+	{
+		struct Avx2
+		{
+			using Float = __m256;
+			using Int = __m256i;
+
+			static constexpr size_t WIDTH = 8;
+
+			static inline Float Load(const float* data) { return _mm256_loadu_ps(data); }
+			static inline Float Set1(float value) { return _mm256_set1_ps(value); }
+			static inline Int Set1Int(int value) { return _mm256_set1_epi32(value); }
+
+			static inline Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+			static inline Float Sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+			static inline Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+			static inline Float MulAdd(Float a, Float b, Float c) { return _mm256_fmadd_ps(a, b, c); }
+
+			static inline Float And(Float a, Float b) { return _mm256_and_ps(a, b); }
+			static inline Float AndNot(Float a, Float b) { return _mm256_andnot_ps(a, b); }
+			static inline Float Xor(Float a, Float b) { return _mm256_xor_ps(a, b); }
+			static inline Float Select(Float mask, Float a, Float b) { return _mm256_blendv_ps(b, a, mask); }
+
+			static inline Int Add(Int a, Int b) { return _mm256_add_epi32(a, b); }
+			static inline Int Sub(Int a, Int b) { return _mm256_sub_epi32(a, b); }
+			static inline Int And(Int a, Int b) { return _mm256_and_si256(a, b); }
+			static inline Int AndNot(Int a, Int b) { return _mm256_andnot_si256(a, b); }
+
+			static inline Int ConvertTruncate(Float value) { return _mm256_cvttps_epi32(value); }
+			static inline Float ConvertToFloat(Int value) { return _mm256_cvtepi32_ps(value); }
+			static inline Float IsZero(Int value) { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(value, _mm256_setzero_si256())); }
+
+			// Moves bit 2 of each lane to the sign bit
+			static inline Float SignFromBit2(Int value) { return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(value, _mm256_set1_epi32(4)), 29)); }
+
+			static inline void StoreMatrices(Float (&columns)[4][4], char* output, size_t outputStride)
+			{
+				for (int column = 0; column < 4; ++column)
+				{
+					// 4x4 transpose inside each 128 bit half: the low halves hold matrices 0 to 3, the high halves 4 to 7
+					Float t0 = _mm256_unpacklo_ps(columns[column][0], columns[column][1]);
+					Float t1 = _mm256_unpackhi_ps(columns[column][0], columns[column][1]);
+					Float t2 = _mm256_unpacklo_ps(columns[column][2], columns[column][3]);
+					Float t3 = _mm256_unpackhi_ps(columns[column][2], columns[column][3]);
+
+					Float rows[4] = {
+						_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)),
+						_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)),
+						_mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)),
+						_mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)),
+					};
+
+					for (int row = 0; row < 4; ++row)
+					{
+						_mm_storeu_ps(reinterpret_cast<float*>(output + row * outputStride) + column * 4, _mm256_castps256_ps128(rows[row]));
+						_mm_storeu_ps(reinterpret_cast<float*>(output + (row + 4) * outputStride) + column * 4, _mm256_extractf128_ps(rows[row], 1));
+					}
+				}
+			}
+		};
+	}
+
+	void ComputeTransformMatricesAvx2(const TransformArrays& transforms, size_t count, char* output, size_t outputStride)
+	{
+		ComputeTransformMatricesSimd<Avx2>(transforms, count, output, outputStride);
+	}
+} // namespace DaisyEngine
+
+#endif // DAISY_SIMD_X86
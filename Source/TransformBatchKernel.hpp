@@ -0,0 +1,151 @@
+#pragma once
+
+// Internal to TransformBatch*.cpp: the kernel is written once against a small SIMD wrapper and instantiated
+// in one translation unit per instruction set, each compiled with the matching compiler flags.
+// It only includes std headers so no inline function of the engine is emitted with AVX2 instructions.
+
+// std
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DAISY_SIMD_X86 1
+#endif
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The TransformArrays struct points to the component arrays of a TransformStore, offset to the first transform to compute.
+	/// </summary>
+	struct TransformArrays
+	{
+		const float* translation[3];
+		const float* scale[3];
+		const float* rotation[3];
+	};
+
+	void ComputeTransformMatricesScalar(const TransformArrays& transforms, size_t count, char* output, size_t outputStride);
+
+#ifdef DAISY_SIMD_X86
+	void ComputeTransformMatricesSse(const TransformArrays& transforms, size_t count, char* output, size_t outputStride);
+	void ComputeTransformMatricesAvx2(const TransformArrays& transforms, size_t count, char* output, size_t outputStride);
+#endif
+
+	// Cephes single precision sin and cos: reduction to [-pi/4, pi/4] in three steps, then a polynomial per octant
+	template<typename Simd>
+	inline void SinCos(typename Simd::Float x, typename Simd::Float& sin, typename Simd::Float& cos)
+	{
+		using Float = typename Simd::Float;
+		using Int = typename Simd::Int;
+
+		const Float signMask = Simd::Set1(-0.0f);
+		Float signBitSin = Simd::And(x, signMask);
+		x = Simd::AndNot(signMask, x);
+
+		// Octant index, rounded to even so the reduced angle is centered on 0
+		Int octant = Simd::ConvertTruncate(Simd::Mul(x, Simd::Set1(1.27323954473516f)));
+		octant = Simd::And(Simd::Add(octant, Simd::Set1Int(1)), Simd::Set1Int(~1));
+		Float y = Simd::ConvertToFloat(octant);
+
+		Float swapSignBitSin = Simd::SignFromBit2(octant);
+		Float signBitCos = Simd::SignFromBit2(Simd::AndNot(Simd::Sub(octant, Simd::Set1Int(2)), Simd::Set1Int(4)));
+		Float polyMask = Simd::IsZero(Simd::And(octant, Simd::Set1Int(2)));
+		signBitSin = Simd::Xor(signBitSin, swapSignBitSin);
+
+		// Extended precision modular arithmetic, x - y * pi / 4
+		x = Simd::MulAdd(y, Simd::Set1(-0.78515625f), x);
+		x = Simd::MulAdd(y, Simd::Set1(-2.4187564849853515625e-4f), x);
+		x = Simd::MulAdd(y, Simd::Set1(-3.77489497744594108e-8f), x);
+
+		Float z = Simd::Mul(x, x);
+
+		Float cosPoly = Simd::Set1(2.443315711809948e-5f);
+		cosPoly = Simd::MulAdd(cosPoly, z, Simd::Set1(-1.388731625493765e-3f));
+		cosPoly = Simd::MulAdd(cosPoly, z, Simd::Set1(4.166664568298827e-2f));
+		cosPoly = Simd::Mul(Simd::Mul(cosPoly, z), z);
+		cosPoly = Simd::MulAdd(z, Simd::Set1(-0.5f), cosPoly);
+		cosPoly = Simd::Add(cosPoly, Simd::Set1(1.0f));
+
+		Float sinPoly = Simd::Set1(-1.9515295891e-4f);
+		sinPoly = Simd::MulAdd(sinPoly, z, Simd::Set1(8.3321608736e-3f));
+		sinPoly = Simd::MulAdd(sinPoly, z, Simd::Set1(-1.6666654611e-1f));
+		sinPoly = Simd::MulAdd(Simd::Mul(sinPoly, z), x, x);
+
+		sin = Simd::Xor(Simd::Select(polyMask, sinPoly, cosPoly), signBitSin);
+		cos = Simd::Xor(Simd::Select(polyMask, cosPoly, sinPoly), signBitCos);
+	}
+
+	template<typename Simd>
+	void ComputeTransformMatricesSimd(const TransformArrays& transforms, size_t count, char* output, size_t outputStride)
+	{
+		using Float = typename Simd::Float;
+
+		const float* translationX = transforms.translation[0];
+		const float* translationY = transforms.translation[1];
+		const float* translationZ = transforms.translation[2];
+		const float* scaleX = transforms.scale[0];
+		const float* scaleY = transforms.scale[1];
+		const float* scaleZ = transforms.scale[2];
+		const float* rotationX = transforms.rotation[0];
+		const float* rotationY = transforms.rotation[1];
+		const float* rotationZ = transforms.rotation[2];
+
+		const Float zero = Simd::Set1(0.0f);
+		const Float one = Simd::Set1(1.0f);
+
+		size_t i = 0;
+		for (; i + Simd::WIDTH <= count; i += Simd::WIDTH)
+		{
+			// Same naming as Transform::mat4(), T * Ry * Rx * Rz * S
+			Float s1, c1, s2, c2, s3, c3;
+			SinCos<Simd>(Simd::Load(rotationY + i), s1, c1);
+			SinCos<Simd>(Simd::Load(rotationX + i), s2, c2);
+			SinCos<Simd>(Simd::Load(rotationZ + i), s3, c3);
+
+			Float sx = Simd::Load(scaleX + i);
+			Float sy = Simd::Load(scaleY + i);
+			Float sz = Simd::Load(scaleZ + i);
+
+			Float s1s2 = Simd::Mul(s1, s2);
+			Float c1s2 = Simd::Mul(c1, s2);
+
+			Float columns[4][4] = {
+				{
+					Simd::Mul(sx, Simd::MulAdd(s1s2, s3, Simd::Mul(c1, c3))),
+					Simd::Mul(sx, Simd::Mul(c2, s3)),
+					Simd::Mul(sx, Simd::Sub(Simd::Mul(c1s2, s3), Simd::Mul(c3, s1))),
+					zero,
+				},
+				{
+					Simd::Mul(sy, Simd::Sub(Simd::Mul(c3, s1s2), Simd::Mul(c1, s3))),
+					Simd::Mul(sy, Simd::Mul(c2, c3)),
+					Simd::Mul(sy, Simd::MulAdd(c1s2, c3, Simd::Mul(s1, s3))),
+					zero,
+				},
+				{
+					Simd::Mul(sz, Simd::Mul(c2, s1)),
+					Simd::Mul(sz, Simd::Sub(zero, s2)),
+					Simd::Mul(sz, Simd::Mul(c1, c2)),
+					zero,
+				},
+				{
+					Simd::Load(translationX + i),
+					Simd::Load(translationY + i),
+					Simd::Load(translationZ + i),
+					one,
+				},
+			};
+
+			Simd::StoreMatrices(columns, output + i * outputStride, outputStride);
+		}
+
+		// Remaining transforms, fewer than one vector
+		TransformArrays tail{};
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			tail.translation[axis] = transforms.translation[axis] + i;
+			tail.scale[axis] = transforms.scale[axis] + i;
+			tail.rotation[axis] = transforms.rotation[axis] + i;
+		}
+		ComputeTransformMatricesScalar(tail, count - i, output + i * outputStride, outputStride);
+	}
+} // namespace DaisyEngine
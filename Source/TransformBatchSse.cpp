@@ -0,0 +1,71 @@
+#include "TransformBatchKernel.hpp"
+
+#ifdef DAISY_SIMD_X86
+
+// std
+#include <emmintrin.h>
+
+namespace DaisyEngine
+{
+	namespace
+	{
+		struct Sse
+		{
+			using Float = __m128;
+			using Int = __m128i;
+
+			static constexpr size_t WIDTH = 4;
+
+			static inline Float Load(const float* data) { return _mm_loadu_ps(data); }
+			static inline Float Set1(float value) { return _mm_set1_ps(value); }
+			static inline Int Set1Int(int value) { return _mm_set1_epi32(value); }
+
+			static inline Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+			static inline Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+			static inline Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+			static inline Float MulAdd(Float a, Float b, Float c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+
+			static inline Float And(Float a, Float b) { return _mm_and_ps(a, b); }
+			static inline Float AndNot(Float a, Float b) { return _mm_andnot_ps(a, b); }
+			static inline Float Xor(Float a, Float b) { return _mm_xor_ps(a, b); }
+			static inline Float Select(Float mask, Float a, Float b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+
+			static inline Int Add(Int a, Int b) { return _mm_add_epi32(a, b); }
+			static inline Int Sub(Int a, Int b) { return _mm_sub_epi32(a, b); }
+			static inline Int And(Int a, Int b) { return _mm_and_si128(a, b); }
+			static inline Int AndNot(Int a, Int b) { return _mm_andnot_si128(a, b); }
+
+			static inline Int ConvertTruncate(Float value) { return _mm_cvttps_epi32(value); }
+			static inline Float ConvertToFloat(Int value) { return _mm_cvtepi32_ps(value); }
+			static inline Float IsZero(Int value) { return _mm_castsi128_ps(_mm_cmpeq_epi32(value, _mm_setzero_si128())); }
+
+			// Moves bit 2 of each lane to the sign bit
+			static inline Float SignFromBit2(Int value) { return _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(value, _mm_set1_epi32(4)), 29)); }
+
+			static inline void StoreMatrices(Float (&columns)[4][4], char* output, size_t outputStride)
+			{
+				for (int column = 0; column < 4; ++column)
+				{
+					Float row0 = columns[column][0];
+					Float row1 = columns[column][1];
+					Float row2 = columns[column][2];
+					Float row3 = columns[column][3];
+					_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+
+					// After the transpose, row k holds this column of matrix k
+					_mm_storeu_ps(reinterpret_cast<float*>(output + 0 * outputStride) + column * 4, row0);
+					_mm_storeu_ps(reinterpret_cast<float*>(output + 1 * outputStride) + column * 4, row1);
+					_mm_storeu_ps(reinterpret_cast<float*>(output + 2 * outputStride) + column * 4, row2);
+					_mm_storeu_ps(reinterpret_cast<float*>(output + 3 * outputStride) + column * 4, row3);
+				}
+			}
+		};
+	}
+
+	void ComputeTransformMatricesSse(const TransformArrays& transforms, size_t count, char* output, size_t outputStride)
+	{
+		ComputeTransformMatricesSimd<Sse>(transforms, count, output, outputStride);
+	}
+} // namespace DaisyEngine
+
+#endif // DAISY_SIMD_X86
@@ -0,0 +1,57 @@
+#include "TransformStore.hpp"
+
+// std
+#include <cassert>
+
+namespace DaisyEngine
+{
+	size_t TransformStore::Add(const Transform& transform)
+	{
+		size_t index = Size();
+		Resize(index + 1);
+		Set(index, transform);
+		return index;
+	}
+
+	void TransformStore::Set(size_t index, const Transform& transform)
+	{
+		assert(index < Size() && "Transform index out of range");
+
+		_components[TranslationX][index] = transform.translation.x;
+		_components[TranslationY][index] = transform.translation.y;
+		_components[TranslationZ][index] = transform.translation.z;
+		_components[ScaleX][index] = transform.scale.x;
+		_components[ScaleY][index] = transform.scale.y;
+		_components[ScaleZ][index] = transform.scale.z;
+		_components[RotationX][index] = transform.rotation.x;
+		_components[RotationY][index] = transform.rotation.y;
+		_components[RotationZ][index] = transform.rotation.z;
+	}
+
+	Transform TransformStore::Get(size_t index) const
+	{
+		assert(index < Size() && "Transform index out of range");
+
+		Transform transform{};
+		transform.translation = { _components[TranslationX][index], _components[TranslationY][index], _components[TranslationZ][index] };
+		transform.scale = { _components[ScaleX][index], _components[ScaleY][index], _components[ScaleZ][index] };
+		transform.rotation = { _components[RotationX][index], _components[RotationY][index], _components[RotationZ][index] };
+		return transform;
+	}
+
+	void TransformStore::Resize(size_t size)
+	{
+		for (std::vector<float>& component : _components)
+		{
+			component.resize(size);
+		}
+	}
+
+	void TransformStore::Clear()
+	{
+		for (std::vector<float>& component : _components)
+		{
+			component.clear();
+		}
+	}
+} // namespace DaisyEngine
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Transform.hpp"
+
+// std
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The TransformStore class keeps transforms as a structure of arrays, one contiguous float array per component.
+	/// A batch kernel can then load the same component of several transforms with a single vector load.
+	/// </summary>
+	class TransformStore
+	{
+	public:
+		enum Component
+		{
+			TranslationX, TranslationY, TranslationZ,
+			ScaleX, ScaleY, ScaleZ,
+			RotationX, RotationY, RotationZ,
+			COMPONENT_COUNT
+		};
+
+		// --- Methods ---
+		size_t Add(const Transform& transform);
+		void Set(size_t index, const Transform& transform);
+		Transform Get(size_t index) const;
+
+		void Resize(size_t size);
+		void Clear();
+		inline size_t Size() const { return _components[0].size(); }
+
+		inline const float* GetComponent(Component component) const { return _components[component].data(); }
+		inline float* GetComponent(Component component) { return _components[component].data(); }
+
+	private:
+		// --- Variables ---
+		std::array<std::vector<float>, COMPONENT_COUNT> _components;
+	};
+} // namespace DaisyEngine
@@ -0,0 +1,284 @@
+#include "UploadService.hpp"
+
+#include "Device.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace DaisyEngine
+{
+	UploadService::UploadService(Device& device, uint32_t queueFamilyIndex, VkQueue queue)
+		: _device(device), _queueFamilyIndex(queueFamilyIndex), _queue(queue)
+	{
+		CreateCommandPool();
+		CreateBatches();
+		CreateStagingRing();
+	}
+
+	UploadService::~UploadService()
+	{
+		WaitIdle();
+
+		for (Batch& batch : _batches)
+		{
+			vkDestroyFence(_device.GetDevice(), batch.fence, nullptr);
+		}
+
+		vkDestroyCommandPool(_device.GetDevice(), _commandPool, nullptr);
+		_device.DestroyBuffer(_stagingBuffer, _stagingAllocation);
+	}
+
+	UploadService::Ticket UploadService::Upload(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		Ticket ticket = _completedTicket;
+		const char* source = static_cast<const char*>(data);
+
+		// Big uploads are split so that a single copy never needs the whole ring
+		while (size > 0)
+		{
+			VkDeviceSize chunkSize = std::min(size, MAX_UPLOAD_CHUNK_SIZE);
+			VkDeviceSize stagingOffset = ReserveStaging(chunkSize);
+			memcpy(static_cast<char*>(_stagingAllocation.mappedData) + stagingOffset, source, static_cast<size_t>(chunkSize));
+
+			Batch& batch = GetRecordingBatch();
+
+			VkBufferCopy copyRegion{};
+			copyRegion.srcOffset = stagingOffset;
+			copyRegion.dstOffset = dstOffset;
+			copyRegion.size = chunkSize;
+			vkCmdCopyBuffer(batch.commandBuffer, _stagingBuffer, dstBuffer, 1, &copyRegion);
+
+			batch.copyCount++;
+			batch.ringEnd = _ringHead;
+			ticket = batch.ticket;
+
+			source += chunkSize;
+			dstOffset += chunkSize;
+			size -= chunkSize;
+		}
+
+		return ticket;
+	}
+
+	UploadService::Ticket UploadService::Flush()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		Batch& batch = _batches[_currentBatch];
+		if (batch.isRecording)
+		{
+			SubmitBatch(batch);
+		}
+
+		RetireBatches(false);
+		return _nextTicket - 1;
+	}
+
+	bool UploadService::IsComplete(Ticket ticket)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		RetireBatches(false);
+		return ticket <= _completedTicket;
+	}
+
+	void UploadService::Wait(Ticket ticket)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		WaitLocked(ticket);
+	}
+
+	void UploadService::WaitIdle()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		// Read under the lock, the streaming threads take new tickets concurrently
+		WaitLocked(_nextTicket - 1);
+	}
+
+	void UploadService::WaitLocked(Ticket ticket)
+	{
+		Batch& batch = _batches[_currentBatch];
+		if (batch.isRecording && batch.ticket <= ticket)
+		{
+			SubmitBatch(batch);
+		}
+
+		while (_completedTicket < ticket)
+		{
+			RetireBatches(true);
+		}
+	}
+
+	void UploadService::CreateCommandPool()
+	{
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = _queueFamilyIndex;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		if (vkCreateCommandPool(_device.GetDevice(), &poolInfo, nullptr, &_commandPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create upload command pool!");
+		}
+	}
+
+	void UploadService::CreateBatches()
+	{
+		std::array<VkCommandBuffer, MAX_BATCHES_IN_FLIGHT> commandBuffers;
+
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = _commandPool;
+		allocInfo.commandBufferCount = MAX_BATCHES_IN_FLIGHT;
+
+		if (vkAllocateCommandBuffers(_device.GetDevice(), &allocInfo, commandBuffers.data()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate upload command buffers!");
+		}
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		for (uint32_t i = 0; i < MAX_BATCHES_IN_FLIGHT; ++i)
+		{
+			_batches[i].commandBuffer = commandBuffers[i];
+			if (vkCreateFence(_device.GetDevice(), &fenceInfo, nullptr, &_batches[i].fence) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create upload fence!");
+			}
+		}
+	}
+
+	void UploadService::CreateStagingRing()
+	{
+		_device.CreateBuffer(
+			STAGING_RING_SIZE,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			_stagingBuffer,
+			_stagingAllocation);
+	}
+
+	UploadService::Batch& UploadService::GetRecordingBatch()
+	{
+		Batch& batch = _batches[_currentBatch];
+		if (batch.isRecording)
+		{
+			return batch;
+		}
+
+		// Every batch slot is in flight, reuse the oldest one once the GPU is done with it
+		while (batch.isSubmitted)
+		{
+			RetireBatches(true);
+		}
+
+		vkResetFences(_device.GetDevice(), 1, &batch.fence);
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (vkBeginCommandBuffer(batch.commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to begin upload command buffer!");
+		}
+
+		batch.ticket = _nextTicket++;
+		batch.copyCount = 0;
+		batch.isRecording = true;
+		return batch;
+	}
+
+	void UploadService::SubmitBatch(Batch& batch)
+	{
+		assert(batch.isRecording && "Cannot submit an upload batch that is not recording");
+
+		if (vkEndCommandBuffer(batch.commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to record upload command buffer!");
+		}
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &batch.commandBuffer;
+
+		if (vkQueueSubmit(_queue, 1, &submitInfo, batch.fence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to submit upload command buffer!");
+		}
+
+		batch.isRecording = false;
+		batch.isSubmitted = true;
+		_currentBatch = (_currentBatch + 1) % MAX_BATCHES_IN_FLIGHT;
+	}
+
+	void UploadService::RetireBatches(bool wait)
+	{
+		// Batches complete in submission order, so only the oldest one ever needs to be waited on
+		while (_batches[_oldestBatch].isSubmitted)
+		{
+			Batch& batch = _batches[_oldestBatch];
+			if (wait)
+			{
+				vkWaitForFences(_device.GetDevice(), 1, &batch.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+				wait = false;
+			}
+			else if (vkGetFenceStatus(_device.GetDevice(), batch.fence) != VK_SUCCESS)
+			{
+				return;
+			}
+
+			batch.isSubmitted = false;
+			_completedTicket = batch.ticket;
+			_ringTail = batch.ringEnd;
+			_oldestBatch = (_oldestBatch + 1) % MAX_BATCHES_IN_FLIGHT;
+		}
+	}
+
+	VkDeviceSize UploadService::ReserveStaging(VkDeviceSize size)
+	{
+		size = (size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+
+		for (;;)
+		{
+			// A copy source must be contiguous, skip the end of the ring when it is too short
+			uint64_t start = _ringHead;
+			uint64_t physicalOffset = start % STAGING_RING_SIZE;
+			if (physicalOffset + size > STAGING_RING_SIZE)
+			{
+				start += STAGING_RING_SIZE - physicalOffset;
+			}
+
+			if (start + size - _ringTail <= STAGING_RING_SIZE)
+			{
+				_ringHead = start + size;
+				return start % STAGING_RING_SIZE;
+			}
+
+			// The ring is full: submit what is recorded and reclaim the space of the oldest batch
+			Batch& current = _batches[_currentBatch];
+			if (current.isRecording)
+			{
+				SubmitBatch(current);
+			}
+
+			if (!_batches[_oldestBatch].isSubmitted)
+			{
+				throw std::runtime_error("Staging ring is full but no upload is in flight!");
+			}
+
+			RetireBatches(true);
+		}
+	}
+} // namespace DaisyEngine
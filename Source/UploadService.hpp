@@ -0,0 +1,94 @@
+#pragma once
+
+#include "MemoryAllocator.hpp"
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+// std
+#include <array>
+#include <cstdint>
+#include <mutex>
+
+namespace DaisyEngine
+{
+	class Device;
+
+	/// <summary>
+	/// The UploadService class copies data into device local buffers through a persistently mapped staging ring.
+	/// Uploads are packed into batches submitted on the transfer queue, each batch signals a fence so the caller
+	/// can poll its ticket instead of waiting for the queue to go idle.
+	/// </summary>
+	class UploadService
+	{
+	public:
+		using Ticket = uint64_t;
+
+		// --- Constants ---
+		static constexpr VkDeviceSize STAGING_RING_SIZE = 32ull * 1024 * 1024;
+		static constexpr VkDeviceSize MAX_UPLOAD_CHUNK_SIZE = STAGING_RING_SIZE / 4;
+		static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+		static constexpr uint32_t MAX_BATCHES_IN_FLIGHT = 8;
+
+		// --- Constructor/ Destructor ---
+		UploadService(Device& device, uint32_t queueFamilyIndex, VkQueue queue);
+		~UploadService();
+
+		UploadService(const UploadService&) = delete;
+		UploadService& operator=(const UploadService&) = delete;
+
+		// --- Methods ---
+		Ticket Upload(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+		Ticket Flush();
+
+		bool IsComplete(Ticket ticket);
+		void Wait(Ticket ticket);
+		void WaitIdle();
+
+		inline uint32_t GetQueueFamily() const { return _queueFamilyIndex; }
+
+	private:
+		struct Batch
+		{
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE;
+			Ticket ticket = 0;
+			uint64_t ringEnd = 0;
+			uint32_t copyCount = 0;
+			bool isRecording = false;
+			bool isSubmitted = false;
+		};
+
+		// --- Methods ---
+		void CreateCommandPool();
+		void CreateBatches();
+		void CreateStagingRing();
+
+		Batch& GetRecordingBatch();
+		void SubmitBatch(Batch& batch);
+		void RetireBatches(bool wait);
+		void WaitLocked(Ticket ticket); // With _mutex held
+		VkDeviceSize ReserveStaging(VkDeviceSize size);
+
+		// --- Variables ---
+		Device& _device;
+		uint32_t _queueFamilyIndex;
+		VkQueue _queue;
+		VkCommandPool _commandPool = VK_NULL_HANDLE;
+
+		VkBuffer _stagingBuffer = VK_NULL_HANDLE;
+		Allocation _stagingAllocation{};
+
+		// Virtual ring positions, the physical offset is position % STAGING_RING_SIZE
+		uint64_t _ringHead = 0;
+		uint64_t _ringTail = 0;
+
+		std::array<Batch, MAX_BATCHES_IN_FLIGHT> _batches;
+		uint32_t _currentBatch = 0;
+		uint32_t _oldestBatch = 0;
+		Ticket _nextTicket = 1;
+		Ticket _completedTicket = 0;
+
+		std::mutex _mutex;
+	};
+} // namespace DaisyEngine
@@ -0,0 +1,70 @@
+#include "VertexFormat.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+
+namespace DaisyEngine
+{
+	static constexpr float SNORM16_MAX = 32767.0f;
+	static constexpr float UNORM8_MAX = 255.0f;
+
+	static int16_t QuantizeSnorm16(float value)
+	{
+		return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * SNORM16_MAX));
+	}
+
+	// -32768 and -32767 both decode to -1, as the vertex fetch does
+	static float DequantizeSnorm16(int16_t value)
+	{
+		return std::max(static_cast<float>(value) / SNORM16_MAX, -1.0f);
+	}
+
+	static uint8_t QuantizeUnorm8(float value)
+	{
+		return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * UNORM8_MAX));
+	}
+
+	PositionQuantization PositionQuantization::FromBounds(const glm::vec3& min, const glm::vec3& max)
+	{
+		PositionQuantization quantization{};
+		quantization.bias = (min + max) * 0.5f;
+		quantization.scale = (max - min) * 0.5f;
+
+		// A flat axis has a single value, the bias alone restores it
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (quantization.scale[axis] <= 0.0f)
+			{
+				quantization.scale[axis] = 1.0f;
+			}
+		}
+		return quantization;
+	}
+
+	QuantizedVertex QuantizeVertex(const VertexAttributes& attributes, const PositionQuantization& quantization)
+	{
+		QuantizedVertex vertex{};
+
+		glm::vec3 position = (attributes.position - quantization.bias) / quantization.scale;
+		for (int i = 0; i < 3; ++i)
+		{
+			vertex.position[i] = QuantizeSnorm16(position[i]);
+			vertex.color[i] = QuantizeUnorm8(attributes.color[i]);
+		}
+		vertex.position[3] = 0;
+		vertex.color[3] = static_cast<uint8_t>(UNORM8_MAX);
+		return vertex;
+	}
+
+	VertexAttributes DequantizeVertex(const QuantizedVertex& vertex, const PositionQuantization& quantization)
+	{
+		VertexAttributes attributes{};
+		for (int i = 0; i < 3; ++i)
+		{
+			attributes.position[i] = DequantizeSnorm16(vertex.position[i]) * quantization.scale[i] + quantization.bias[i];
+			attributes.color[i] = static_cast<float>(vertex.color[i]) / UNORM8_MAX;
+		}
+		return attributes;
+	}
+} // namespace DaisyEngine
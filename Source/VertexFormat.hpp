@@ -0,0 +1,69 @@
+#pragma once
+
+#include "VertexLayout.hpp"
+
+// Libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstddef>
+#include <cstdint>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The VertexFormat enum selects the layout a Model uploads its vertices in.
+	/// </summary>
+	enum class VertexFormat : uint32_t
+	{
+		PositionColor, // Model::Vertex as is, two float vec3 (24 bytes)
+		Quantized, // QuantizedVertex, the same attributes packed (12 bytes)
+		Count,
+	};
+
+	// --- Constants ---
+	static constexpr uint32_t VERTEX_FORMAT_COUNT = static_cast<uint32_t>(VertexFormat::Count);
+
+	/// <summary>
+	/// The QuantizedVertex struct packs a Model::Vertex in 12 bytes. The position is 16 bit snorm in the box of its mesh,
+	/// the shader dequantizes it with the PositionQuantization of the mesh. The color is RGBA8 unorm. The fourth position
+	/// component only pads the attribute to a format every device can fetch.
+	/// </summary>
+	struct QuantizedVertex
+	{
+		int16_t position[4];
+		uint8_t color[4];
+	};
+
+	static constexpr auto QUANTIZED_VERTEX_LAYOUT = MakeVertexLayout<QuantizedVertex>(
+		VertexElement{ VertexAttribute::Position, VK_FORMAT_R16G16B16A16_SNORM, offsetof(QuantizedVertex, position) },
+		VertexElement{ VertexAttribute::Color, VK_FORMAT_R8G8B8A8_UNORM, offsetof(QuantizedVertex, color) });
+	static_assert(QUANTIZED_VERTEX_LAYOUT.IsValid(), "QuantizedVertex members do not match their formats");
+
+	/// <summary>
+	/// The PositionQuantization struct maps the [-1, 1] snorm positions of a mesh back to model space: position * scale + bias.
+	/// The bias is the center of the bounding box and the scale its half extent, each axis keeps the full 16 bits.
+	/// </summary>
+	struct PositionQuantization
+	{
+		glm::vec3 scale{ 1.0f };
+		glm::vec3 bias{ 0.0f };
+
+		static PositionQuantization FromBounds(const glm::vec3& min, const glm::vec3& max);
+	};
+
+	/// <summary>
+	/// The VertexAttributes struct is a vertex at full precision, what a QuantizedVertex is encoded from and decodes to.
+	/// </summary>
+	struct VertexAttributes
+	{
+		glm::vec3 position{};
+		glm::vec3 color{};
+	};
+
+	QuantizedVertex QuantizeVertex(const VertexAttributes& attributes, const PositionQuantization& quantization);
+	// What the vertex fetch and the shader turn a QuantizedVertex back into
+	VertexAttributes DequantizeVertex(const QuantizedVertex& vertex, const PositionQuantization& quantization);
+} // namespace DaisyEngine
@@ -0,0 +1,143 @@
+#pragma once
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+// std
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace DaisyEngine
+{
+	/// <summary>
+	/// The VertexAttribute enum names the per vertex inputs of the shaders, each value is the location the shaders read it
+	/// from. Locations 2 to 5 are taken by the per instance inputs of the instanced shader.
+	/// </summary>
+	enum class VertexAttribute : uint32_t
+	{
+		Position = 0,
+		Color = 1,
+	};
+
+	/// <summary>
+	/// The VertexElement struct places one attribute in a vertex, with the format the vertex fetch converts it from.
+	/// </summary>
+	struct VertexElement
+	{
+		VertexAttribute attribute;
+		VkFormat format;
+		uint32_t offset;
+	};
+
+	// Size in bytes of the vertex formats the layouts use, 0 for the others
+	constexpr uint32_t GetFormatSize(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_R8G8_SNORM: return 2;
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SNORM:
+		case VK_FORMAT_R16G16_SNORM:
+		case VK_FORMAT_R16G16_SFLOAT: return 4;
+		case VK_FORMAT_R16G16B16A16_SNORM:
+		case VK_FORMAT_R16G16B16A16_UNORM:
+		case VK_FORMAT_R16G16B16A16_SFLOAT:
+		case VK_FORMAT_R32G32_SFLOAT: return 8;
+		case VK_FORMAT_R32G32B32_SFLOAT: return 12;
+		case VK_FORMAT_R32G32B32A32_SFLOAT: return 16;
+		default: return 0;
+		}
+	}
+
+	/// <summary>
+	/// The VertexLayout struct describes a vertex type at compile time: where each attribute lives and in which format. The
+	/// binding and attribute descriptions of a pipeline are generated from it, and IsValid lets the vertex type check its
+	/// layout in a static_assert, so a member resized without updating its format fails to compile.
+	/// </summary>
+	template<typename Vertex, size_t ElementCount>
+	struct VertexLayout
+	{
+		std::array<VertexElement, ElementCount> elements;
+
+		static constexpr uint32_t GetStride() { return static_cast<uint32_t>(sizeof(Vertex)); }
+
+		constexpr bool Has(VertexAttribute attribute) const
+		{
+			for (const VertexElement& element : elements)
+			{
+				if (element.attribute == attribute)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Every element has a known format and fits in the vertex, none overlaps another or repeats its attribute
+		constexpr bool IsValid() const
+		{
+			for (size_t i = 0; i < ElementCount; ++i)
+			{
+				const VertexElement& element = elements[i];
+				uint32_t size = GetFormatSize(element.format);
+				if (size == 0 || element.offset + size > GetStride())
+				{
+					return false;
+				}
+
+				for (size_t j = i + 1; j < ElementCount; ++j)
+				{
+					const VertexElement& other = elements[j];
+					if (other.attribute == element.attribute
+						|| (other.offset < element.offset + size && element.offset < other.offset + GetFormatSize(other.format)))
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		// Bytes the vertex fetch reads per vertex, the stride minus the padding
+		constexpr uint32_t GetFetchSize() const
+		{
+			uint32_t size = 0;
+			for (const VertexElement& element : elements)
+			{
+				size += GetFormatSize(element.format);
+			}
+			return size;
+		}
+
+		std::vector<VkVertexInputBindingDescription> GetBindingDescriptions(uint32_t binding = 0) const
+		{
+			std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+			bindingDescriptions[0].binding = binding;
+			bindingDescriptions[0].stride = GetStride();
+			bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+			return bindingDescriptions;
+		}
+
+		std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions(uint32_t binding = 0) const
+		{
+			std::vector<VkVertexInputAttributeDescription> attributeDescriptions(ElementCount);
+			for (size_t i = 0; i < ElementCount; ++i)
+			{
+				attributeDescriptions[i].binding = binding;
+				attributeDescriptions[i].location = static_cast<uint32_t>(elements[i].attribute);
+				attributeDescriptions[i].format = elements[i].format;
+				attributeDescriptions[i].offset = elements[i].offset;
+			}
+			return attributeDescriptions;
+		}
+	};
+
+	// Deduces the element count: MakeVertexLayout<Vertex>(VertexElement{ ... }, VertexElement{ ... })
+	template<typename Vertex, typename... Elements>
+	constexpr VertexLayout<Vertex, sizeof...(Elements)> MakeVertexLayout(Elements... elements)
+	{
+		return { { { elements... } } };
+	}
+} // namespace DaisyEngine
@@ -17,6 +17,7 @@ namespace DaisyEngine
 		inline bool ShouldClose() const { return glfwWindowShouldClose(_window); }
 		inline bool WasWindowResized() const { return _framebufferResized; }
 		inline VkExtent2D GetExtent() const { return { static_cast<uint32_t>(_width), static_cast<uint32_t>(_height) }; }
+		inline GLFWwindow* GetGLFWWindow() const { return _window; }
 
 		void ResetWindowResizedFlag() { _framebufferResized = false; }
 		void CreateWindowSurface(VkInstance instance, VkSurfaceKHR* surface);
@@ -0,0 +1,141 @@
+#include "World.hpp"
+
+// std
+#include <algorithm>
+#include <atomic>
+
+namespace DaisyEngine
+{
+	QueryBase::QueryBase(std::vector<ComponentPoolBase*> pools)
+		: _pools(std::move(pools))
+	{
+	}
+
+	bool QueryBase::Contains(uint32_t entityIndex) const
+	{
+		return _pools[0]->GetSlot(entityIndex) < _size;
+	}
+
+	bool QueryBase::HasAllComponents(uint32_t entityIndex) const
+	{
+		for (const ComponentPoolBase* pool : _pools)
+		{
+			if (!pool->Contains(entityIndex))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void QueryBase::OnComponentAdded(uint32_t entityIndex)
+	{
+		if (!Contains(entityIndex) && HasAllComponents(entityIndex))
+		{
+			Enter(entityIndex);
+		}
+	}
+
+	void QueryBase::OnComponentRemoving(uint32_t entityIndex)
+	{
+		if (Contains(entityIndex))
+		{
+			Leave(entityIndex);
+		}
+	}
+
+	void QueryBase::Enter(uint32_t entityIndex)
+	{
+		// The entity takes the first slot after the query range in every pool
+		for (ComponentPoolBase* pool : _pools)
+		{
+			pool->Swap(pool->GetSlot(entityIndex), _size);
+		}
+		_size++;
+	}
+
+	void QueryBase::Leave(uint32_t entityIndex)
+	{
+		// The last entity of the query fills the hole, the leaving one ends up right after the query range
+		_size--;
+		for (ComponentPoolBase* pool : _pools)
+		{
+			pool->Swap(pool->GetSlot(entityIndex), _size);
+		}
+	}
+
+	uint32_t World::NextComponentTypeId()
+	{
+		static std::atomic<uint32_t> s_nextTypeId{ 0 };
+		return s_nextTypeId++;
+	}
+
+	uint32_t World::NextQueryTypeId()
+	{
+		static std::atomic<uint32_t> s_nextTypeId{ 0 };
+		return s_nextTypeId++;
+	}
+
+	Entity World::CreateEntity()
+	{
+		if (!_freeIndices.empty())
+		{
+			uint32_t entityIndex = _freeIndices.back();
+			_freeIndices.pop_back();
+			return { entityIndex, _generations[entityIndex] };
+		}
+
+		_generations.push_back(0);
+		return { static_cast<uint32_t>(_generations.size() - 1), 0 };
+	}
+
+	void World::DestroyEntity(Entity entity)
+	{
+		if (!IsAlive(entity))
+		{
+			return;
+		}
+
+		for (const std::unique_ptr<ComponentPoolBase>& pool : _pools)
+		{
+			if (pool == nullptr || !pool->Contains(entity.index))
+			{
+				continue;
+			}
+
+			if (QueryBase* owner = pool->GetOwner())
+			{
+				owner->OnComponentRemoving(entity.index);
+			}
+			pool->Remove(entity.index);
+		}
+
+		// Outstanding handles keep the old generation and are no longer alive
+		_generations[entity.index]++;
+		_freeIndices.push_back(entity.index);
+	}
+
+	void World::BuildQuery(QueryBase& query)
+	{
+		// Walking the smallest pool is enough, Enter only swaps slots that were already visited
+		ComponentPoolBase* smallestPool = nullptr;
+		for (const std::unique_ptr<ComponentPoolBase>& pool : _pools)
+		{
+			if (pool != nullptr && pool->GetOwner() == &query && (smallestPool == nullptr || pool->Size() < smallestPool->Size()))
+			{
+				smallestPool = pool.get();
+			}
+		}
+
+		if (smallestPool == nullptr)
+		{
+			return;
+		}
+
+		for (uint32_t slot = 0; slot < smallestPool->Size(); ++slot)
+		{
+			query.OnComponentAdded(smallestPool->GetEntityIndex(slot));
+		}
+	}
+} // namespace DaisyEngine
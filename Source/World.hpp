@@ -0,0 +1,244 @@
+#pragma once
+
+#include "Entity.hpp"
+#include "ComponentPool.hpp"
+
+// std
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+namespace DaisyEngine
+{
+	class World;
+
+	/// <summary>
+	/// The QueryBase class is the type erased part of a cached query. A query owns the pools of its components and keeps the
+	/// entities having all of them packed in the first Size() slots of every owned pool, in the same order. Component adds and
+	/// removes move entities in and out of that range, so the query never has to be rebuilt and iterating it is a linear walk
+	/// over each component array.
+	/// </summary>
+	class QueryBase
+	{
+	public:
+		// --- Constructor/ Destructor ---
+		explicit QueryBase(std::vector<ComponentPoolBase*> pools);
+		virtual ~QueryBase() = default;
+
+		QueryBase(const QueryBase&) = delete;
+		QueryBase& operator=(const QueryBase&) = delete;
+
+		// --- Methods ---
+		inline size_t Size() const { return _size; }
+		bool Contains(uint32_t entityIndex) const;
+
+		// Called by the World once a component of an owned pool was added, or before one is removed
+		void OnComponentAdded(uint32_t entityIndex);
+		void OnComponentRemoving(uint32_t entityIndex);
+
+	protected:
+		// --- Methods ---
+		bool HasAllComponents(uint32_t entityIndex) const;
+		void Enter(uint32_t entityIndex);
+		void Leave(uint32_t entityIndex);
+
+		// --- Variables ---
+		std::vector<ComponentPoolBase*> _pools;
+		uint32_t _size = 0;
+	};
+
+	/// <summary>
+	/// The Query class gives typed access to the entities having every component in Ts. Index i of the query is slot i of each
+	/// component array, indices stay valid until the next structural change of the world (entity destroyed, component added
+	/// or removed).
+	/// </summary>
+	template <typename... Ts>
+	class Query : public QueryBase
+	{
+	public:
+		// --- Constructor ---
+		Query(const World& world, ComponentPool<Ts>&... pools)
+			: QueryBase({ &pools... }), _world(world), _typedPools(&pools...)
+		{
+		}
+
+		// --- Methods ---
+		// The components of the query, contiguous and in query order
+		template <typename T>
+		inline T* Data() { return std::get<ComponentPool<T>*>(_typedPools)->Data(); }
+
+		template <typename T>
+		inline const T* Data() const { return std::get<ComponentPool<T>*>(_typedPools)->Data(); }
+
+		template <typename T>
+		inline T& Get(size_t index)
+		{
+			assert(index < _size && "Query index out of range");
+			return Data<T>()[index];
+		}
+
+		Entity GetEntity(size_t index) const;
+
+		// Calls function(Ts&...) for every entity of the query, in memory order
+		template <typename Function>
+		void Each(Function&& function)
+		{
+			std::tuple<Ts*...> data(Data<Ts>()...);
+			for (size_t i = 0; i < _size; ++i)
+			{
+				function(std::get<Ts*>(data)[i]...);
+			}
+		}
+
+	private:
+		// --- Variables ---
+		const World& _world;
+		std::tuple<ComponentPool<Ts>*...> _typedPools;
+	};
+
+	/// <summary>
+	/// The World class owns every entity and component. Components of one type live in a sparse set pool, and the cached
+	/// queries returned by GetQuery keep the entities they match packed at the front of their pools.
+	/// References to components are invalidated by any structural change.
+	/// </summary>
+	class World
+	{
+	public:
+		// --- Constructor/ Destructor ---
+		World() = default;
+		~World() = default;
+
+		World(const World&) = delete;
+		World& operator=(const World&) = delete;
+
+		// --- Methods ---
+		Entity CreateEntity();
+		void DestroyEntity(Entity entity);
+
+		inline bool IsAlive(Entity entity) const { return entity.index < _generations.size() && _generations[entity.index] == entity.generation; }
+		inline Entity GetEntity(uint32_t entityIndex) const { return { entityIndex, _generations[entityIndex] }; }
+		inline size_t GetEntityCount() const { return _generations.size() - _freeIndices.size(); }
+
+		template <typename T>
+		T& AddComponent(Entity entity, T component = {})
+		{
+			assert(IsAlive(entity) && "Cannot add a component to a destroyed entity");
+
+			ComponentPool<T>& pool = GetPool<T>();
+			pool.Add(entity.index, std::move(component));
+			if (QueryBase* owner = pool.GetOwner())
+			{
+				owner->OnComponentAdded(entity.index);
+			}
+
+			// Entering a query moves the component, it is fetched again
+			return pool.Get(entity.index);
+		}
+
+		template <typename T>
+		void RemoveComponent(Entity entity)
+		{
+			assert(IsAlive(entity) && "Cannot remove a component from a destroyed entity");
+
+			ComponentPool<T>& pool = GetPool<T>();
+			if (QueryBase* owner = pool.GetOwner())
+			{
+				owner->OnComponentRemoving(entity.index);
+			}
+			pool.Remove(entity.index);
+		}
+
+		template <typename T>
+		bool HasComponent(Entity entity) const
+		{
+			uint32_t typeId = GetComponentTypeId<T>();
+			return IsAlive(entity) && typeId < _pools.size() && _pools[typeId] != nullptr && _pools[typeId]->Contains(entity.index);
+		}
+
+		template <typename T>
+		T& GetComponent(Entity entity)
+		{
+			assert(HasComponent<T>(entity) && "Entity does not have this component");
+			return GetPool<T>().Get(entity.index);
+		}
+
+		template <typename T>
+		ComponentPool<T>& GetPool()
+		{
+			uint32_t typeId = GetComponentTypeId<T>();
+			if (typeId >= _pools.size())
+			{
+				_pools.resize(typeId + 1);
+			}
+			if (_pools[typeId] == nullptr)
+			{
+				_pools[typeId] = std::make_unique<ComponentPool<T>>();
+			}
+
+			return static_cast<ComponentPool<T>&>(*_pools[typeId]);
+		}
+
+		// Returns the cached query of Ts, created on first use. A component type can only be owned by one query
+		template <typename... Ts>
+		Query<Ts...>& GetQuery()
+		{
+			uint32_t queryId = GetQueryTypeId<Ts...>();
+			if (queryId >= _queries.size())
+			{
+				_queries.resize(queryId + 1);
+			}
+
+			if (_queries[queryId] == nullptr)
+			{
+				if (((GetPool<Ts>().GetOwner() != nullptr) || ...))
+				{
+					throw std::runtime_error("Failed to create query, a component is already owned by another query!");
+				}
+
+				auto query = std::make_unique<Query<Ts...>>(*this, GetPool<Ts>()...);
+				(GetPool<Ts>().SetOwner(query.get()), ...);
+				BuildQuery(*query);
+				_queries[queryId] = std::move(query);
+			}
+
+			return static_cast<Query<Ts...>&>(*_queries[queryId]);
+		}
+
+	private:
+		// --- Methods ---
+		static uint32_t NextComponentTypeId();
+		static uint32_t NextQueryTypeId();
+
+		template <typename T>
+		static uint32_t GetComponentTypeId()
+		{
+			static const uint32_t typeId = NextComponentTypeId();
+			return typeId;
+		}
+
+		template <typename... Ts>
+		static uint32_t GetQueryTypeId()
+		{
+			static const uint32_t typeId = NextQueryTypeId();
+			return typeId;
+		}
+
+		void BuildQuery(QueryBase& query);
+
+		// --- Variables ---
+		std::vector<std::unique_ptr<ComponentPoolBase>> _pools; // Indexed by component type id
+		std::vector<std::unique_ptr<QueryBase>> _queries; // Indexed by query type id
+		std::vector<uint32_t> _generations; // Current generation of each entity index
+		std::vector<uint32_t> _freeIndices;
+	};
+
+	template <typename... Ts>
+	Entity Query<Ts...>::GetEntity(size_t index) const
+	{
+		assert(index < _size && "Query index out of range");
+		return _world.GetEntity(_pools[0]->GetEntityIndex(static_cast<uint32_t>(index)));
+	}
+} // namespace DaisyEngine
@@ -2,15 +2,113 @@
 
 // std
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <exception>
+#include <string>
 
-int main()
+// Usage: DaisyEngine [--headless] [--frames N] [--capture output.ppm] [--gpu-profiler] [--trace trace.json] [--sim-thread]
+//                    [--stream mesh.dmesh]... [--mesh-budget MB] [--quantized-vertices] [--gpu-driven] [--occlusion-culling]
+//                    [--mesh-arena] [--vertex-pulling] [--render-mode per-object|instanced|parallel] [--lod]
+static DaisyEngine::ApplicationOptions ParseOptions(int argc, char** argv)
 {
-	DaisyEngine::Application application{};
+	DaisyEngine::ApplicationOptions options{};
 
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--headless") == 0)
+		{
+			options.headless = true;
+		}
+		else if (strcmp(argv[i], "--gpu-profiler") == 0)
+		{
+			options.showGpuProfiler = true;
+		}
+		else if (strcmp(argv[i], "--sim-thread") == 0)
+		{
+			options.simulationThread = true;
+		}
+		else if (strcmp(argv[i], "--quantized-vertices") == 0)
+		{
+			options.vertexFormat = DaisyEngine::VertexFormat::Quantized;
+		}
+		else if (strcmp(argv[i], "--gpu-driven") == 0)
+		{
+			options.gpuDriven = true;
+		}
+		else if (strcmp(argv[i], "--occlusion-culling") == 0)
+		{
+			options.gpuDriven = true;
+			options.occlusionCulling = true;
+		}
+		else if (strcmp(argv[i], "--mesh-arena") == 0)
+		{
+			options.meshArena = true;
+		}
+		else if (strcmp(argv[i], "--vertex-pulling") == 0)
+		{
+			options.gpuDriven = true;
+			options.meshArena = true;
+			options.vertexPulling = true;
+		}
+		else if (strcmp(argv[i], "--lod") == 0)
+		{
+			options.lod = true;
+		}
+		else if (strcmp(argv[i], "--render-mode") == 0 && i + 1 < argc)
+		{
+			const char* renderMode = argv[++i];
+			if (strcmp(renderMode, "per-object") == 0)
+			{
+				options.renderMode = DaisyEngine::SimpleRenderSystem::RenderMode::PerObject;
+			}
+			else if (strcmp(renderMode, "parallel") == 0)
+			{
+				options.renderMode = DaisyEngine::SimpleRenderSystem::RenderMode::Parallel;
+			}
+			else if (strcmp(renderMode, "instanced") == 0)
+			{
+				options.renderMode = DaisyEngine::SimpleRenderSystem::RenderMode::Instanced;
+			}
+			else
+			{
+				std::cerr << "Unknown render mode: " << renderMode << std::endl;
+			}
+		}
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+		{
+			options.frameCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+		{
+			options.tracePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+		{
+			options.capturePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--stream") == 0 && i + 1 < argc)
+		{
+			options.streamedMeshPaths.push_back(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--mesh-budget") == 0 && i + 1 < argc)
+		{
+			options.meshBudgetMegabytes = static_cast<uint32_t>(std::stoul(argv[++i]));
+		}
+		else
+		{
+			std::cerr << "Unknown argument: " << argv[i] << std::endl;
+		}
+	}
+
+	return options;
+}
+
+int main(int argc, char** argv)
+{
 	try
 	{
+		DaisyEngine::Application application{ ParseOptions(argc, argv) };
 		application.Run();
 	}
 	catch (const std::exception& e)
@@ -20,4 +118,4 @@ int main()
 	}
 
 	return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
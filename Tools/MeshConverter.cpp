@@ -0,0 +1,187 @@
+// Converts OBJ or glTF files to the binary mesh format loaded by Model::LoadFromFile.
+// Usage: MeshConverter [--no-optimize] [--lod] [--quantized] input.(obj|gltf|glb) output.dmesh
+//        MeshConverter [--no-optimize] [--lod] [--quantized] --batch outputDirectory input.(obj|gltf|glb)...
+// Identical vertices are welded before writing, the submesh ranges are kept. Unless --no-optimize is given, the mesh is then
+// reordered by OptimizeMesh and its vertex cache (ACMR, ATVR), fetch and overdraw are printed before and after; a batch
+// ends with the totals of the whole set, to validate the gains on a corpus of assets. With --lod, a chain of simplified
+// levels is built last for DEFAULT_LOD_ERRORS, and the triangles and error of each level are printed. With --quantized, the
+// vertices are written as QuantizedVertex, the models loaded from the file then draw with the quantized pipelines.
+
+#include "../Source/MeshFile.hpp"
+#include "../Source/MeshImporter.hpp"
+#include "../Source/MeshOptimizer.hpp"
+#include "../Source/MeshSimplifier.hpp"
+
+// std
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace DaisyEngine;
+
+namespace
+{
+	/// <summary>
+	/// Sums of a batch, the ratios are recomputed from them so large meshes weigh as much as they cost.
+	/// </summary>
+	struct CorpusStats
+	{
+		uint64_t triangleCount = 0;
+		uint64_t vertexCount = 0;
+		uint64_t transformedBefore = 0;
+		uint64_t transformedAfter = 0;
+		uint64_t fetchedBefore = 0;
+		uint64_t fetchedAfter = 0;
+		uint64_t bufferBytes = 0;
+	};
+
+	void PrintOptimization(const MeshOptimizationStats& stats)
+	{
+		std::cout << "  ACMR " << stats.cacheBefore.acmr << " -> " << stats.cacheAfter.acmr
+			<< ", ATVR " << stats.cacheBefore.atvr << " -> " << stats.cacheAfter.atvr
+			<< ", overfetch " << stats.fetchBefore.overfetch << " -> " << stats.fetchAfter.overfetch
+			<< ", overdraw " << stats.overdrawBefore.overdraw << " -> " << stats.overdrawAfter.overdraw << std::endl;
+	}
+
+	void Convert(const std::string& input, const std::string& output, bool optimize, bool lod, VertexFormat vertexFormat, CorpusStats& corpus)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+
+		Model::Builder builder = ImportMesh(input);
+		size_t importedVertexCount = builder.vertices.size();
+		builder.WeldVertices();
+
+		MeshOptimizationStats stats{};
+		if (optimize)
+		{
+			stats = OptimizeMesh(builder);
+		}
+
+		std::vector<SimplificationStats> levels;
+		if (lod)
+		{
+			levels = BuildLods(builder, DEFAULT_LOD_ERRORS, std::size(DEFAULT_LOD_ERRORS));
+		}
+		MeshFile::Write(output, builder, vertexFormat);
+
+		auto end = std::chrono::high_resolution_clock::now();
+
+		// Read back through the loader, so a file the engine would reject is never left behind silently
+		MeshFile meshFile{ output };
+		std::cout << input << " -> " << output << ": "
+			<< meshFile.GetVertexCount() << " vertices (" << importedVertexCount << " before welding), "
+			<< meshFile.GetIndexCount() << " indices of " << meshFile.GetIndexSize() << " bytes, "
+			<< meshFile.GetSubmeshCount() << " submeshes, " << meshFile.GetLodCount() << " LODs, " << meshFile.GetFileSize() << " bytes in "
+			<< std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+
+		for (size_t level = 0; level < levels.size(); ++level)
+		{
+			std::cout << "  LOD " << level + 1 << ": " << levels[level].triangleCountAfter << "/" << levels[level].triangleCountBefore
+				<< " triangles, error " << levels[level].error << std::endl;
+		}
+
+		if (optimize)
+		{
+			PrintOptimization(stats);
+
+			corpus.triangleCount += builder.GetMeshIndexCount() / 3;
+			corpus.vertexCount += builder.vertices.size();
+			corpus.transformedBefore += stats.cacheBefore.transformedCount;
+			corpus.transformedAfter += stats.cacheAfter.transformedCount;
+			corpus.fetchedBefore += stats.fetchBefore.fetchedBytes;
+			corpus.fetchedAfter += stats.fetchAfter.fetchedBytes;
+			corpus.bufferBytes += builder.vertices.size() * sizeof(Model::Vertex);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool optimize = true;
+	bool batch = false;
+	bool lod = false;
+	VertexFormat vertexFormat = VertexFormat::PositionColor;
+	std::vector<std::string> arguments;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--no-optimize") == 0)
+		{
+			optimize = false;
+		}
+		else if (strcmp(argv[i], "--lod") == 0)
+		{
+			lod = true;
+		}
+		else if (strcmp(argv[i], "--quantized") == 0)
+		{
+			vertexFormat = VertexFormat::Quantized;
+		}
+		else if (strcmp(argv[i], "--batch") == 0)
+		{
+			batch = true;
+		}
+		else
+		{
+			arguments.push_back(argv[i]);
+		}
+	}
+
+	if ((batch && arguments.size() < 2) || (!batch && arguments.size() != 2))
+	{
+		std::cerr << "Usage: MeshConverter [--no-optimize] [--lod] [--quantized] input.(obj|gltf|glb) output.dmesh" << std::endl
+			<< "       MeshConverter [--no-optimize] [--lod] [--quantized] --batch outputDirectory input.(obj|gltf|glb)..." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	CorpusStats corpus{};
+	int failureCount = 0;
+	if (!batch)
+	{
+		try
+		{
+			Convert(arguments[0], arguments[1], optimize, lod, vertexFormat, corpus);
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << e.what() << std::endl;
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
+
+	// A file that fails to convert is reported and skipped, the rest of the batch still runs
+	std::filesystem::path outputDirectory = arguments[0];
+	std::filesystem::create_directories(outputDirectory);
+	for (size_t i = 1; i < arguments.size(); ++i)
+	{
+		std::filesystem::path output = outputDirectory / std::filesystem::path(arguments[i]).filename().replace_extension(".dmesh");
+		try
+		{
+			Convert(arguments[i], output.string(), optimize, lod, vertexFormat, corpus);
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << arguments[i] << ": " << e.what() << std::endl;
+			failureCount++;
+		}
+	}
+
+	if (optimize && corpus.triangleCount > 0)
+	{
+		std::cout << arguments.size() - 1 - failureCount << " mesh(es), " << corpus.triangleCount << " triangles: ACMR "
+			<< static_cast<double>(corpus.transformedBefore) / corpus.triangleCount << " -> "
+			<< static_cast<double>(corpus.transformedAfter) / corpus.triangleCount << ", ATVR "
+			<< static_cast<double>(corpus.transformedBefore) / corpus.vertexCount << " -> "
+			<< static_cast<double>(corpus.transformedAfter) / corpus.vertexCount << ", overfetch "
+			<< static_cast<double>(corpus.fetchedBefore) / corpus.bufferBytes << " -> "
+			<< static_cast<double>(corpus.fetchedAfter) / corpus.bufferBytes << std::endl;
+	}
+
+	return failureCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,3 +1,10 @@
 %~dp0\Libraries\VulkanSDK\Bin\glslc.exe %~dp0Shaders\simple_shader.vert -o %~dp0Shaders\simple_shader.vert.spv
 %~dp0\Libraries\VulkanSDK\Bin\glslc.exe %~dp0Shaders\simple_shader.frag -o %~dp0Shaders\simple_shader.frag.spv
+%~dp0\Libraries\VulkanSDK\Bin\glslc.exe -DINSTANCED %~dp0Shaders\simple_shader.vert -o %~dp0Shaders\simple_shader_instanced.vert.spv
+%~dp0\Libraries\VulkanSDK\Bin\glslc.exe -DGPU_DRIVEN %~dp0Shaders\simple_shader.vert -o %~dp0Shaders\simple_shader_gpu_driven.vert.spv
+%~dp0\Libraries\VulkanSDK\Bin\glslc.exe -DGPU_DRIVEN -DVERTEX_PULLING %~dp0Shaders\simple_shader.vert -o %~dp0Shaders\simple_shader_vertex_pulling.vert.spv
+%~dp0\Libraries\VulkanSDK\Bin\glslc.exe %~dp0Shaders\cull_instances.comp -o %~dp0Shaders\cull_instances.comp.spv
+%~dp0\Libraries\VulkanSDK\Bin\glslc.exe %~dp0Shaders\build_draw_commands.comp -o %~dp0Shaders\build_draw_commands.comp.spv
+%~dp0\Libraries\VulkanSDK\Bin\glslc.exe %~dp0Shaders\cull_occluded.comp -o %~dp0Shaders\cull_occluded.comp.spv
+%~dp0\Libraries\VulkanSDK\Bin\glslc.exe %~dp0Shaders\depth_pyramid.comp -o %~dp0Shaders\depth_pyramid.comp.spv
 pause
\ No newline at end of file